@@ -1,8 +1,9 @@
-let updateInterval;const SERIAL_CONFIG_MAP = {
+let updateInterval;let gatewayDataCache = null;// Latest flow counter data (snapshot + pushed port updates)
+let eventSource = null;let eventStreamFailed = false;// Fall back to polling for the rest of the session
+let clockInterval;let deviceClock = { millis: 0,rollover: 0,receivedAt: 0 };const SERIAL_CONFIG_MAP = {
 '0': 'SERIAL_8N1','2': 'SERIAL_8E1','3': 'SERIAL_8O1'
 };document.addEventListener('DOMContentLoaded',() => {
-initializeTabs();initializeForms();loadNetworkConfig();loadGatewayConfig();loadModbusTCPStatus();updateDashboard();setInterval(updateDashboard,2000);// Update every 2 seconds
-});function initializeTabs() {
+initializeTabs();initializeForms();loadNetworkConfig();loadGatewayConfig();pollBusScan();startAutoUpdate()});function initializeTabs() {
 const tabBtns = document.querySelectorAll('.tab-btn');const tabContents = document.querySelectorAll('.tab-content');tabBtns.forEach(btn => {
 btn.addEventListener('click',() => {
 const targetTab = btn.dataset.tab;tabBtns.forEach(b => b.classList.remove('active'));tabContents.forEach(c => c.classList.remove('active'));btn.classList.add('active');document.getElementById(targetTab).classList.add('active');if(targetTab === 'files') {
@@ -11,7 +12,9 @@ loadFileList()}
 function initializeForms() {
 document.getElementById('rs485-form').addEventListener('submit',async (e) => {
 e.preventDefault();await saveRS485Config()});document.getElementById('save-ports-btn').addEventListener('click',async () => {
-await savePortConfig()});document.getElementById('network-form').addEventListener('submit',async (e) => {
+await savePortConfig()});document.getElementById('detect-serial-btn').addEventListener('click',async () => {
+await startSerialDetect()});document.getElementById('scan-bus-btn').addEventListener('click',async () => {
+await startBusScan()});document.getElementById('network-form').addEventListener('submit',async (e) => {
 e.preventDefault();await saveNetworkConfig()});document.getElementById('network-mode').addEventListener('change',(e) => {
 const staticFields = document.querySelector('.static-ip-fields');staticFields.style.display = e.target.value === 'static' ? 'grid' : 'none'});document.getElementById('reboot-btn').addEventListener('click',async () => {
 if(confirm('Are you sure you want to reboot the system?')) {
@@ -25,10 +28,16 @@ console.error('Failed to load system info:',error);document.getElementById('syst
 }
 async function updateDashboard() {
 try {
-const statusResponse = await fetch('/api/system/status');if(!statusResponse.ok) {
-console.warn('System status request failed:',statusResponse.status);return;// Keep existing UI state on error
+const response = await fetch('/api/batch?parts=status,data,tcp');if(!response.ok) {
+console.warn('Dashboard request failed:',response.status);return;// Keep existing UI state on error
 }
-const statusData = await statusResponse.json();if(statusData.busy) {
+const batch = await response.json();if(batch.busy) {
+updateSystemStatus(batch);return}
+updateSystemStatus(batch.status);renderModbusTCPStatus(batch.tcp);if(batch.data) gatewayDataCache = batch.data;setDeviceClock(batch.current_millis,batch.millis_rollover_count);renderFlowCounters()} catch (error) {
+console.error('Failed to update dashboard:',error)}
+}
+function updateSystemStatus(statusData) {
+if(statusData.busy) {
 const uptime = statusData.uptime;const hours = Math.floor(uptime / 3600);const minutes = Math.floor((uptime % 3600) / 60);document.getElementById('system-uptime').textContent = `Uptime: ${hours}h ${minutes}m`;return;// Skip other updates to preserve current UI state
 }
 const uptime = statusData.uptime;const hours = Math.floor(uptime / 3600);const minutes = Math.floor((uptime % 3600) / 60);document.getElementById('system-uptime').textContent = `Uptime: ${hours}h ${minutes}m`;if(statusData.version) {
@@ -40,8 +49,10 @@ document.getElementById('eth-status').textContent = 'Disconnected';document.getE
 }
 if(statusData.sd) {
 if(statusData.sd.ready) {
-const inserted = statusData.sd.inserted ? 'Inserted' : 'Not Inserted';document.getElementById('sd-status').textContent = inserted;document.getElementById('sd-status').className = 'badge success';document.getElementById('sd-size').textContent =
-`${statusData.sd.capacityGB.toFixed(1)} GB (${statusData.sd.freeSpaceGB.toFixed(1)} GB free)`} else if(statusData.sd.inserted) {
+const inserted = statusData.sd.inserted ? 'Inserted' : 'Not Inserted';document.getElementById('sd-status').textContent = inserted;document.getElementById('sd-status').className = 'badge success';const freeText = statusData.sd.freeSpaceKnown === false
+? 'calculating free space'
+: `${statusData.sd.freeSpaceGB.toFixed(1)} GB free`;document.getElementById('sd-size').textContent =
+`${statusData.sd.capacityGB.toFixed(1)} GB (${freeText})`} else if(statusData.sd.inserted) {
 document.getElementById('sd-status').textContent = 'Error';document.getElementById('sd-status').className = 'badge error';document.getElementById('sd-size').textContent = '--'} else {
 document.getElementById('sd-status').textContent = 'Not Inserted';document.getElementById('sd-status').className = 'badge info';document.getElementById('sd-size').textContent = '--'}
 }
@@ -60,9 +71,25 @@ clientList.innerHTML = statusData.modbusTcp.clients.map(client =>
 ).join('')} else {
 clientList.innerHTML = '<div class="client-info no-clients">No connected clients</div>'}
 }
-const gatewayResponse = await fetch('/api/gateway/data');const gatewayData = await gatewayResponse.json();updateFlowCounterGrid(gatewayData.flow_counters,gatewayData.current_millis,gatewayData.millis_rollover_count)} catch (error) {
-console.error('Failed to update dashboard:',error)}
 }
+function setDeviceClock(millis,rollover) {
+deviceClock = { millis: millis,rollover: rollover,receivedAt: performance.now() }}
+function deviceMillisNow() {
+return (deviceClock.millis + Math.floor(performance.now() - deviceClock.receivedAt)) >>> 0}
+function renderFlowCounters() {
+if(gatewayDataCache) {
+updateFlowCounterGrid(gatewayDataCache.flow_counters,deviceMillisNow(),deviceClock.rollover)}
+}
+function startEventStream() {
+eventSource = new EventSource('/api/events');eventSource.addEventListener('snapshot',(e) => {
+gatewayDataCache = JSON.parse(e.data);renderFlowCounters()});eventSource.addEventListener('port',(e) => {
+const update = JSON.parse(e.data);setDeviceClock(update.current_millis,update.millis_rollover_count);if(gatewayDataCache) {
+gatewayDataCache.flow_counters[update.flow_counter.port - 1] = update.flow_counter;renderFlowCounters()}
+});eventSource.addEventListener('status',(e) => {
+const statusData = JSON.parse(e.data);setDeviceClock(statusData.current_millis,statusData.millis_rollover_count);updateSystemStatus(statusData)});eventSource.onerror = () => {
+if(eventSource && eventSource.readyState === EventSource.CLOSED) {
+stopAutoUpdate();eventStreamFailed = true;startAutoUpdate()}
+};clockInterval = setInterval(renderFlowCounters,1000)}
 function formatTimestamp(unixTimestamp) {
 if(!unixTimestamp || unixTimestamp === 0) return 'N/A';const date = new Date(unixTimestamp * 1000);const year = date.getUTCFullYear();const month = String(date.getUTCMonth() + 1).padStart(2,'0');const day = String(date.getUTCDate()).padStart(2,'0');const hours = String(date.getUTCHours()).padStart(2,'0');const minutes = String(date.getUTCMinutes()).padStart(2,'0');const seconds = String(date.getUTCSeconds()).padStart(2,'0');return `${day}/${month}/${year},${hours}:${minutes}:${seconds}`}
 function formatTimeSince(lastUpdateMillis,currentMillis,rolloverCount) {
@@ -128,9 +155,11 @@ ${dataHtml}
 `}).join('')}
 async function loadGatewayConfig() {
 try {
-const response = await fetch('/api/gateway/config');const data = await response.json();document.getElementById('baud-rate').value = data.rs485.baud_rate;const { parity,stopBits } = parseSerialConfig(data.rs485.serial_config);document.getElementById('parity').value = parity;document.getElementById('stop-bits').value = stopBits;document.getElementById('timeout').value = data.rs485.response_timeout;renderPortConfig(data.ports)} catch (error) {
+const response = await fetch('/api/batch?parts=config,tcp');const batch = await response.json();if(batch.busy) return;renderGatewayConfig(batch.config);renderModbusTCPStatus(batch.tcp)} catch (error) {
 console.error('Failed to load gateway config:',error)}
 }
+function renderGatewayConfig(data) {
+document.getElementById('baud-rate').value = data.rs485.baud_rate;const { parity,stopBits } = parseSerialConfig(data.rs485.serial_config);document.getElementById('parity').value = parity;document.getElementById('stop-bits').value = stopBits;document.getElementById('timeout').value = data.rs485.response_timeout;renderPortConfig(data.ports)}
 function parseSerialConfig(serialConfig) {
 let parity = 'none';let stopBits = '1';const parityBits = serialConfig & 0xF;if(parityBits === 0x1) parity = 'even';else if(parityBits === 0x2) parity = 'odd';else if(parityBits === 0x3) parity = 'none';const stopBitField = serialConfig & 0xF0;if(stopBitField === 0x30) stopBits = '2';else if(stopBitField === 0x10) stopBits = '1';return { parity,stopBits }}
 function renderPortConfig(ports) {
@@ -187,6 +216,76 @@ method: 'POST',headers: { 'Content-Type': 'application/json' },body: JSON.string
 });const result = await response.json();showToast(result.message || 'Port configuration saved','success')} catch (error) {
 showToast('Failed to save port configuration','error');console.error(error)}
 }
+async function startSerialDetect() {
+try {
+const response = await fetch('/api/gateway/detect',{ method: 'POST' });const result = await response.json();if(!response.ok) {
+showToast(result.error || 'Failed to start detection','error');return}
+showToast('Serial detection started','info');setTimeout(pollSerialDetect,500)} catch (error) {
+showToast('Failed to start detection','error');console.error(error)}
+}
+async function pollSerialDetect() {
+try {
+const response = await fetch('/api/gateway/detect');const data = await response.json();renderSerialDetect(data);if(data.state === 'starting' || data.state === 'running') {
+setTimeout(pollSerialDetect,500)}
+} catch (error) {
+console.error('Failed to load serial detection:',error)}
+}
+function formatSerialSetting(baudRate,serialConfig) {
+const { parity,stopBits } = parseSerialConfig(serialConfig);return `${baudRate} 8${parity[0].toUpperCase()}${stopBits}`}
+function renderSerialDetect(data) {
+const container = document.getElementById('serial-detect-container');if(data.state === 'idle') {
+container.innerHTML = '';return}
+if(data.state === 'starting') {
+container.innerHTML = '<p>Waiting for the bus to go idle...</p>';return}
+const seconds = (data.elapsed_ms / 1000).toFixed(1);if(data.state === 'running') {
+container.innerHTML = `<p>Detecting... trying ${formatSerialSetting(data.baud_rate,data.serial_config)} (${seconds}s)</p>`;return}
+if(!data.detected) {
+container.innerHTML = `<p>No valid replies at any setting (${seconds}s). Check wiring and slave IDs.</p>`;return}
+const setting = formatSerialSetting(data.detected.baud_rate,data.detected.serial_config);const quality = data.detected.consistent ? 'all replies valid' : 'best partial match';container.innerHTML = `
+<p>Detected ${setting} (${quality},${seconds}s)
+<button class="btn btn-primary" onclick="applySerialDetect()">Use ${setting}</button>
+</p>`}
+async function applySerialDetect() {
+try {
+const response = await fetch('/api/gateway/detect?action=apply',{ method: 'POST' });const result = await response.json();showToast(result.message || result.error,response.ok ? 'success' : 'error');loadGatewayConfig();pollSerialDetect()} catch (error) {
+showToast('Failed to apply detected setting','error');console.error(error)}
+}
+async function startBusScan() {
+try {
+await fetch('/api/gateway/scan',{ method: 'POST' });showToast('Bus scan started','info');setTimeout(pollBusScan,500)} catch (error) {
+showToast('Failed to start bus scan','error');console.error(error)}
+}
+async function pollBusScan() {
+try {
+const response = await fetch('/api/gateway/scan');const data = await response.json();renderBusScan(data);if(data.state === 'running') {
+setTimeout(pollBusScan,500)}
+} catch (error) {
+console.error('Failed to load bus scan:',error)}
+}
+function renderBusScan(data) {
+const container = document.getElementById('bus-scan-container');const seconds = ((data.elapsed_ms || 0) / 1000).toFixed(1);const summary = data.state === 'running'
+? `Scanning... ${data.probed}/${data.total} IDs,${data.responders.length} found (${seconds}s)`
+: `${data.responders.length} device(s) found in ${seconds}s (probe timeout ${data.probe_timeout_ms} ms)`;const portOptions = (selected) => Array.from({ length: 12 },(_,i) =>
+`<option value="${i + 1}" ${i + 1 === selected ? 'selected' : ''}>Port ${i + 1}</option>`).join('');container.innerHTML = `<p>${summary}</p>` + data.responders.map(r => `
+<div class="port-config">
+<div class="port-fields">
+<span>Slave ID ${r.slave_id}</span>
+<span>Unit ${r.unit_id || '--'}</span>
+<span>RTT ${(r.rtt_us / 1000).toFixed(1)} ms</span>
+${r.bound_port
+? `<span class="badge success">Port ${r.bound_port}</span>`
+: `<select id="scan-port-${r.slave_id}">${portOptions(0)}</select>
+<button class="btn btn-primary" onclick="bindScanResult(${r.slave_id})">Bind</button>`}
+</div>
+</div>
+`).join('')}
+async function bindScanResult(slaveId) {
+const port = parseInt(document.getElementById(`scan-port-${slaveId}`).value);try {
+const response = await fetch('/api/gateway/scan/bind',{
+method: 'POST',headers: { 'Content-Type': 'application/json' },body: JSON.stringify({ bindings: [{ port: port,slave_id: slaveId }] })
+});const result = await response.json();showToast(result.message || result.error,response.ok ? 'success' : 'error');loadGatewayConfig();pollBusScan()} catch (error) {
+showToast('Failed to bind port','error');console.error(error)}
+}
 async function loadNetworkConfig() {
 try {
 const response = await fetch('/api/network');const data = await response.json();document.getElementById('network-mode').value = data.mode;document.getElementById('ip-address').value = data.ip;document.getElementById('subnet').value = data.subnet;document.getElementById('gateway').value = data.gateway;document.getElementById('dns').value = data.dns;document.getElementById('hostname').value = data.hostname;document.getElementById('modbus-tcp-port').value = data.modbusTcpPort;const staticFields = document.querySelector('.static-ip-fields');staticFields.style.display = data.mode === 'static' ? 'grid' : 'none'} catch (error) {
@@ -204,18 +303,22 @@ method: 'POST',headers: { 'Content-Type': 'application/json' },body: JSON.string
 window.location.reload()},3000)} catch (error) {
 showToast('Failed to save network configuration','error');console.error(error)}
 }
-async function loadModbusTCPStatus() {
-try {
-const response = await fetch('/api/modbus-tcp/status');const data = await response.json();document.getElementById('modbus-status').textContent = data.running ? 'Running' : 'Stopped';document.getElementById('modbus-status').className = data.running ? 'badge success' : 'badge error';document.getElementById('modbus-port-detail').textContent = data.port;document.getElementById('modbus-connections').textContent = data.connectedClients;const clientsList = document.getElementById('modbus-clients-list');if(data.clients && data.clients.length > 0) {
+function renderModbusTCPStatus(data) {
+document.getElementById('modbus-status').textContent = data.running ? 'Running' : 'Stopped';document.getElementById('modbus-status').className = data.running ? 'badge success' : 'badge error';document.getElementById('modbus-port-detail').textContent = data.port;document.getElementById('modbus-connections').textContent = data.connectedClients;const clientsList = document.getElementById('modbus-clients-list');if(data.clients && data.clients.length > 0) {
 clientsList.innerHTML = '<h4 style="margin-bottom: 10px;">Connected Clients:</h4>' +
 data.clients.map(client => `<div class="client-item">${client}</div>`).join('')} else {
 clientsList.innerHTML = '<p style="color: var(--text-secondary);">No connected clients</p>'}
-} catch (error) {
-console.error('Failed to load Modbus TCP status:',error)}
+}
+async function fetchDirectory(path) {
+const pageSize = 50;let listing = null;for(let offset = 0;;offset += pageSize) {
+const response = await fetch(`/api/sd/list?path=${encodeURIComponent(path)}&offset=${offset}&limit=${pageSize}`);const page = await response.json();if(page.error) return page;if(listing === null) {
+listing = page} else {
+listing.directories.push(...page.directories);listing.files.push(...page.files)}
+if(page.incomplete || offset + pageSize >= page.total) return listing}
 }
 async function loadFileList() {
 try {
-const response = await fetch('/api/sd/list?path=/');const data = await response.json();const fileList = document.getElementById('file-list');const sdInfo = document.getElementById('sd-info');if(data.error) {
+const data = await fetchDirectory('/');const fileList = document.getElementById('file-list');const sdInfo = document.getElementById('sd-info');if(data.error) {
 fileList.innerHTML = `<p style="color: var(--accent-red);">${data.error}</p>`;return}
 if(data.free_space_mb && data.total_space_mb) {
 sdInfo.textContent = `${data.free_space_mb.toFixed(1)} MB free of ${data.total_space_mb.toFixed(1)} MB`}
@@ -237,7 +340,18 @@ let html = '<div class="file-section"><h4 style="color: var(--text-secondary);fo
 </div>
 </div>
 </div>`;if(data.files && data.files.length > 0) {
-html += '<div class="file-section" style="margin-top: 16px;"><h4 style="color: var(--text-secondary);font-size: 0.9em;margin: 0 0 8px 0;">Recording Files</h4>';html += data.files.map(file => `
+html += '<div class="file-section" style="margin-top: 16px;"><h4 style="color: var(--text-secondary);font-size: 0.9em;margin: 0 0 8px 0;">Recording Files</h4>';html += `
+<div class="file-item">
+<div class="file-info">
+<span class="file-name"><i class="mdi mdi-folder-zip"></i> All recordings</span>
+<span class="file-size">.tar.gz</span>
+</div>
+<div class="file-actions">
+<button class="btn btn-secondary btn-icon" onclick="downloadArchive('/','*.csv')" title="Download all">
+<i class="mdi mdi-download-box"></i>
+</button>
+</div>
+</div>`;html += data.files.map(file => `
 <div class="file-item">
 <div class="file-info">
 <a href="#" class="file-name" onclick="previewFile('${file.path}','${file.name}');return false;">
@@ -260,6 +374,8 @@ console.error('Failed to load file list:',error);document.getElementById('file-l
 }
 function downloadFile(path,name) {
 const url = `/api/sd/download?path=${encodeURIComponent(path)}`;const a = document.createElement('a');a.href = url;a.download = name;document.body.appendChild(a);a.click();document.body.removeChild(a)}
+function downloadArchive(path,glob) {
+const a = document.createElement('a');a.href = `/api/sd/archive?path=${encodeURIComponent(path)}&glob=${encodeURIComponent(glob)}&gzip=1`;document.body.appendChild(a);a.click();document.body.removeChild(a)}
 function previewFile(path,name) {
 const url = `/api/sd/view?path=${encodeURIComponent(path)}`;window.open(url,'_blank')}
 async function deleteFile(path,name) {
@@ -297,11 +413,17 @@ function showToast(message,type = 'info') {
 const toast = document.getElementById('toast');toast.textContent = message;toast.className = `toast ${type} show`;setTimeout(() => {
 toast.classList.remove('show')},4000)}
 function startAutoUpdate() {
+if(window.EventSource && !eventStreamFailed) {
+startEventStream();return}
 updateDashboard();updateInterval = setInterval(() => {
 updateDashboard()},2000);// Update every 2 seconds
 }
+function stopAutoUpdate() {
+if(eventSource) {
+eventSource.close();eventSource = null}
+clearInterval(updateInterval);clearInterval(clockInterval)}
 document.addEventListener('visibilitychange',() => {
 if(document.hidden) {
-clearInterval(updateInterval)} else {
+stopAutoUpdate()} else {
 startAutoUpdate()}
 });
\ No newline at end of file
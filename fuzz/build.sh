@@ -0,0 +1,47 @@
+#!/bin/sh
+# Builds the fuzz targets as Linux programs: the firmware and lib/modbus-rtu-master on top of
+# lib/native-hal (with HAL_NO_MAIN), instrumented with AddressSanitizer and UBSan.
+#
+#   fuzz/build.sh [OUT]         libFuzzer build with clang++, default OUT .pio/fuzz
+#   FUZZ_STANDALONE=1 fuzz/build.sh
+#                               Any compiler ($CXX, default g++): links fuzz/standaloneMain.cpp,
+#                               which replays files instead of fuzzing
+#   ARDUINOJSON=DIR             ArduinoJson source dir, default .pio/libdeps/native/ArduinoJson/src
+#                               (pio run -e native downloads it)
+#
+# Then, from the repository root:
+#   .pio/fuzz/fuzzRtuResponse -max_len=512 fuzz/corpus/rtu_response
+#   .pio/fuzz/fuzzMbapRequest -max_len=4096 fuzz/corpus/mbap_request
+set -e
+cd "$(dirname "$0")/.."
+
+OUT=${1:-.pio/fuzz}
+ARDUINOJSON=${ARDUINOJSON:-.pio/libdeps/native/ArduinoJson/src}
+SANITIZE="-fsanitize=address,undefined -fno-sanitize-recover=undefined"
+if [ -n "$FUZZ_STANDALONE" ]; then
+    CXX=${CXX:-g++}
+    COVERAGE=""
+    LINK="fuzz/standaloneMain.cpp"
+else
+    CXX=${CXX:-clang++}
+    COVERAGE="-fsanitize=fuzzer-no-link"
+    LINK="-fsanitize=fuzzer"
+fi
+FLAGS="-std=gnu++17 -g -O1 -DHAL_NO_MAIN $SANITIZE $COVERAGE \
+    -DARDUINOJSON_ENABLE_ARDUINO_STRING=1 -DARDUINOJSON_ENABLE_ARDUINO_STREAM=1 \
+    -DARDUINOJSON_ENABLE_ARDUINO_PRINT=1 -DARDUINOJSON_ENABLE_PROGMEM=0 \
+    -Ilib/native-hal/src -Ilib/modbus-rtu-master/src -Isrc -I$ARDUINOJSON"
+
+mkdir -p "$OUT/obj"
+OBJECTS=""
+for source in lib/native-hal/src/*.cpp lib/modbus-rtu-master/src/*.cpp src/*.cpp src/*/*.cpp; do
+    object="$OUT/obj/$(echo "$source" | tr '/' '_').o"
+    echo "CXX $source"
+    $CXX $FLAGS -c "$source" -o "$object"
+    OBJECTS="$OBJECTS $object"
+done
+
+for target in fuzzRtuResponse fuzzMbapRequest; do
+    echo "LINK $OUT/$target"
+    $CXX $FLAGS "fuzz/$target.cpp" $OBJECTS $LINK -o "$OUT/$target"
+done
@@ -0,0 +1,77 @@
+/* Description: libFuzzer target for the Modbus TCP request parser
+ * Writes the fuzz input into one end of a socket pair and runs
+ * ModbusTCPServer::processModbusRequest() on the other end until the stream is used up,
+ * so pipelined and truncated requests are covered. Ports 1-12 are enabled as slave IDs
+ * 1-12 with valid data, so reads reach the register map. Replies are drained and
+ * checked for a well formed MBAP header.
+ */
+
+#include <Arduino.h>
+#include "network/modbus_tcp.h"
+#include "gateway/flowCounterConfig.h"
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define FUZZ_MAX_INPUT 4096
+#define FUZZ_MAX_REQUESTS 600       // More than a 4KB stream of 7 byte headers can hold
+
+static void setupPorts() {
+    for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
+        gatewayConfig.ports[i].enabled = true;
+        gatewayConfig.ports[i].slaveId = i + 1;
+        flowCounterData[i].dataValid = true;
+        flowCounterData[i].volume = 1234.5f * (i + 1);
+        snprintf(flowCounterData[i].unit_ID, sizeof(flowCounterData[i].unit_ID), "FC%08d", i + 1);
+    }
+}
+
+static uint8_t replies[65536];
+static size_t replyLength;
+
+// Reads the replies and checks that each one's MBAP length matches what follows
+static void drainReplies(int fd) {
+    size_t& length = replyLength;
+    ssize_t count;
+    while ((count = recv(fd, replies + length, sizeof(replies) - length, MSG_DONTWAIT)) > 0) {
+        length += count;
+    }
+    size_t position = 0;
+    while (length - position >= 7) {
+        uint16_t mbapLength = (replies[position + 4] << 8) | replies[position + 5];
+        if (mbapLength < 2 || mbapLength > 254) abort();
+        if (length - position < 6u + mbapLength) break;
+        position += 6 + mbapLength;
+    }
+    memmove(replies, replies + position, length - position);
+    length -= position;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static bool initialized = false;
+    if (!initialized) {
+        setupPorts();
+        initialized = true;
+    }
+    if (size > FUZZ_MAX_INPUT) return 0;
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) abort();
+    if (size > 0 && write(fds[0], data, size) != (ssize_t)size) abort();
+    shutdown(fds[0], SHUT_WR);      // A truncated request ends the stream instead of waiting
+    replyLength = 0;
+
+    ModbusClientConnection connection;
+    connection.client = WiFiClient(fds[1]);
+    connection.active = true;
+    connection.requestCount = 0;
+    connection.exceptionCount = 0;
+
+    for (int i = 0; i < FUZZ_MAX_REQUESTS && connection.client.available() >= 7; i++) {
+        modbusServer.processModbusRequest(connection);
+        drainReplies(fds[0]);
+    }
+
+    connection.client.stop();
+    close(fds[0]);
+    return 0;
+}
@@ -0,0 +1,105 @@
+/* Description: libFuzzer target for the Modbus RTU master's response parser
+ * Runs ModbusRTUMaster::manage() on a transport that plays back the fuzz input as the
+ * slave's side of the line. Input layout:
+ *   [0]    request: function code index (low 3 bits, MODBUS_FC_* in order)
+ *   [1]    quantity (registers or coils, 1..256)
+ *   [2]    slave ID
+ *   [3]    bytes handed over per manage() pass (low 6 bits, 1..64), so frames also arrive
+ *          split; bit 7 set hands each chunk over as one frame, as a framed transport does
+ *   [4..]  bytes on the line
+ * The request's data buffer is allocated at exactly its size, so a reply that writes past
+ * it is caught by AddressSanitizer. When a request completes, the same request is queued
+ * again and parsing continues with the remaining bytes.
+ */
+
+#include <Arduino.h>
+#include <modbus-rtu-master.h>
+
+#define FUZZ_MAX_REQUESTS 8
+
+static const uint8_t functionCodes[8] = {
+    MODBUS_FC_READ_COILS, MODBUS_FC_READ_DISCRETE_INPUTS, MODBUS_FC_READ_HOLDING_REGISTERS,
+    MODBUS_FC_READ_INPUT_REGISTERS, MODBUS_FC_WRITE_SINGLE_COIL, MODBUS_FC_WRITE_SINGLE_REGISTER,
+    MODBUS_FC_WRITE_MULTIPLE_COILS, MODBUS_FC_WRITE_MULTIPLE_REGISTERS
+};
+
+// The slave's side of the line, played back from the fuzz input
+class FuzzTransport : public ModbusRTUTransport {
+public:
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    size_t position = 0;
+    size_t released = 0;            // Bytes the master may read so far
+    bool frames = false;            // Hand released bytes over with readFrame()
+
+    void release(size_t count) { released = std::min(size, released + count); }
+    bool begin(uint32_t baudrate, uint32_t config) override { return true; }
+    size_t write(const uint8_t* frame, size_t length) override { return length; }
+    int available() override { return (int)(released - position); }
+    size_t read(uint8_t* buffer, size_t length) override {
+        size_t count = std::min(length, released - position);
+        memcpy(buffer, data + position, count);
+        position += count;
+        return count;
+    }
+    bool txComplete() override { return true; }
+    uint32_t idleTime() override { return UINT32_MAX; }
+    bool framed() override { return frames; }
+    bool readFrame(const uint8_t** frame, uint16_t* length) override {
+        if (position == released) return false;
+        *frame = data + position;
+        *length = released - position;
+        position = released;
+        return true;
+    }
+};
+
+static int completed;
+
+static void fuzzCallback(bool valid, uint16_t* data, uint32_t requestId) {
+    completed++;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size < 4) return 0;
+
+    uint8_t functionCode = functionCodes[data[0] & 0x07];
+    uint16_t quantity = data[1] + 1;
+    uint8_t slaveId = data[2];
+    size_t chunk = data[3] % 64 + 1;
+
+    // Registers take a word each, coils a bit
+    bool bits = functionCode == MODBUS_FC_READ_COILS || functionCode == MODBUS_FC_READ_DISCRETE_INPUTS ||
+                functionCode == MODBUS_FC_WRITE_MULTIPLE_COILS;
+    size_t words = bits ? (quantity + 15) / 16 : quantity;
+    if (functionCode == MODBUS_FC_WRITE_SINGLE_COIL || functionCode == MODBUS_FC_WRITE_SINGLE_REGISTER) {
+        quantity = 1;
+        words = 1;
+    }
+    uint16_t* buffer = new uint16_t[words]();
+
+    FuzzTransport transport;
+    transport.data = data + 4;
+    transport.size = size - 4;
+    transport.frames = data[3] & 0x80;
+    ModbusRTUMaster* master = new ModbusRTUMaster();
+    master->begin(&transport, 9600, SERIAL_8N1);
+
+    completed = 0;
+    int queued = 0;
+    while (queued < FUZZ_MAX_REQUESTS && transport.position < transport.size) {
+        if (completed == queued) {
+            master->pushRequest(slaveId, functionCode, 0, buffer, quantity, fuzzCallback, queued);
+            queued++;
+        }
+        master->manage();           // Sends the request
+        master->manage();           // Transmission complete
+        transport.release(chunk);
+        master->manage();           // Parses what has arrived
+    }
+    master->clearQueue();
+
+    delete master;
+    delete[] buffer;
+    return 0;
+}
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""
+Writes the seed corpus for the fuzz targets (fuzz/corpus/)
+The frames are the ones the gateway sees in service: flow counter replies over the 23
+register map (CDAB floats, unit_ID low byte first), temperature/pressure reads, exception
+replies, write echoes, and the Modbus TCP requests that the bench script and SCADA clients
+send. Rerun after changing the harness input layout.
+"""
+
+import os
+import struct
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "corpus")
+
+FC_INDEX = {0x01: 0, 0x02: 1, 0x03: 2, 0x04: 3, 0x05: 4, 0x06: 5, 0x0F: 6, 0x10: 7}
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def rtu(body):
+    return body + struct.pack("<H", crc16(body))
+
+
+def cdab(value):
+    high, low = struct.unpack(">HH", struct.pack(">f", value))
+    return struct.pack(">HH", low, high)
+
+
+def register_map(unit_id="SIMFC00001"):
+    data = b"".join(cdab(v) for v in (12345.678, 11876.5, 3.25, 3.1, 21.5, 1.013))
+    data += struct.pack(">HH", 0x5F5E, 0x6A00)          # timestamp, CDAB
+    data += cdab(24.1) + cdab(3.6)
+    raw = unit_id.encode().ljust(10, b"\0")
+    data += b"".join(bytes([raw[i + 1], raw[i]]) for i in range(0, 10, 2))
+    return data
+
+
+def rtu_seed(fc, quantity, slave, chunk, line):
+    return bytes([FC_INDEX[fc], quantity - 1, slave, chunk - 1]) + line
+
+
+def rtu_seeds():
+    full = rtu(bytes([1, 0x03, 46]) + register_map())
+    temp_pressure = rtu(bytes([3, 0x03, 8]) + cdab(21.5) + cdab(1.013))
+    unit_id = rtu(bytes([7, 0x03, 10]) + register_map("SIMFC00007")[36:])
+    yield "read_full_map", rtu_seed(0x03, 23, 1, 64, full)
+    yield "read_full_map_split", rtu_seed(0x03, 23, 1, 3, full)
+    yield "read_full_map_twice", rtu_seed(0x03, 23, 1, 16, full + full)
+    yield "read_temp_pressure", rtu_seed(0x03, 4, 3, 64, temp_pressure)
+    yield "read_unit_id", rtu_seed(0x03, 5, 7, 8, unit_id)
+    yield "read_input_registers", rtu_seed(0x04, 2, 2, 64, rtu(bytes([2, 0x04, 4]) + cdab(3.25)))
+    yield "exception_busy", rtu_seed(0x03, 23, 1, 64, rtu(bytes([1, 0x83, 0x06])))
+    yield "exception_address", rtu_seed(0x04, 23, 4, 64, rtu(bytes([4, 0x84, 0x02])))
+    bad_crc = bytearray(full)
+    bad_crc[10] ^= 0x08
+    yield "crc_error_then_retry", rtu_seed(0x03, 23, 1, 64, bytes(bad_crc) + full)
+    other = rtu(bytes([2, 0x03, 46]) + register_map("SIMFC00002"))
+    yield "late_reply_other_slave", rtu_seed(0x03, 23, 1, 64, other + full)
+    yield "noise_then_reply", rtu_seed(0x03, 23, 1, 64, b"\x00\xff\x55" + full)
+    yield "read_coils", rtu_seed(0x01, 10, 5, 64, rtu(bytes([5, 0x01, 2, 0xA5, 0x02])))
+    yield "read_discrete_inputs", rtu_seed(0x02, 16, 5, 64, rtu(bytes([5, 0x02, 2, 0xFF, 0x00])))
+    yield "write_single_register", rtu_seed(0x06, 1, 9, 64, rtu(bytes([9, 0x06, 0, 0, 0, 42])))
+    yield "write_single_coil", rtu_seed(0x05, 1, 9, 64, rtu(bytes([9, 0x05, 0, 0, 0xFF, 0])))
+    yield "write_multiple_registers", rtu_seed(0x10, 4, 9, 64, rtu(bytes([9, 0x10, 0, 0, 0, 4])))
+    yield "write_multiple_coils", rtu_seed(0x0F, 20, 9, 64, rtu(bytes([9, 0x0F, 0, 0, 0, 20])))
+
+
+def mbap(transaction, unit, pdu, protocol=0, length=None):
+    if length is None:
+        length = len(pdu) + 1
+    return struct.pack(">HHHB", transaction, protocol, length, unit) + pdu
+
+
+def read(transaction, unit, address, count, fc=0x03):
+    return mbap(transaction, unit, struct.pack(">BHH", fc, address, count))
+
+
+def mbap_seeds():
+    yield "read_full_map", read(1, 1, 0, 23)
+    yield "read_temp_pressure", read(2, 3, 8, 4)
+    yield "read_live_temp_pressure", read(3, 12, 30, 4, fc=0x04)
+    yield "read_unit_id", read(4, 7, 18, 5)
+    yield "read_odd_start", read(5, 2, 1, 3)
+    yield "read_past_map", read(6, 1, 30, 10)
+    yield "write_single_register", mbap(7, 1, struct.pack(">BHH", 0x06, 0, 42))
+    yield "unknown_unit", read(8, 247, 0, 23)
+    yield "broadcast_unit", read(9, 0, 0, 1)
+    yield "tcp_unit", read(10, 0xFF, 0, 1)
+    yield "bad_protocol", mbap(11, 1, struct.pack(">BHH", 0x03, 0, 23), protocol=1)
+    yield "length_zero", mbap(12, 1, b"", length=0)
+    yield "length_one", mbap(13, 1, b"", length=1)
+    yield "short_pdu", mbap(14, 1, b"\x03\x00")
+    yield "truncated_pdu", read(15, 1, 0, 23)[:9]
+    yield "pipelined", b"".join(read(100 + i, i % 12 + 1, 0, 23) for i in range(8))
+    yield "pipelined_mix", read(200, 1, 0, 23) + read(201, 247, 0, 23) + \
+        mbap(202, 2, struct.pack(">BHH", 0x06, 0, 1)) + read(203, 3, 8, 4)
+
+
+def write(directory, seeds):
+    path = os.path.join(ROOT, directory)
+    os.makedirs(path, exist_ok=True)
+    for name, data in seeds:
+        with open(os.path.join(path, name + ".bin"), "wb") as file:
+            file.write(data)
+
+
+if __name__ == "__main__":
+    write("rtu_response", rtu_seeds())
+    write("mbap_request", mbap_seeds())
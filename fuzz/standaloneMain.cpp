@@ -0,0 +1,51 @@
+/* Description: Replay driver for the fuzz targets when libFuzzer is not available
+ * Runs LLVMFuzzerTestOneInput() once per file (directories are expanded one level), so a
+ * build with any compiler and -fsanitize=address,undefined can check the seed corpus or
+ * reproduce a crash file. It does not generate new inputs.
+ */
+
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+static bool runFile(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t block[4096];
+    size_t count;
+    while ((count = fread(block, 1, sizeof(block), file)) > 0) data.insert(data.end(), block, block + count);
+    fclose(file);
+    LLVMFuzzerTestOneInput(data.data(), data.size());
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int runs = 0;
+    bool ok = true;
+    for (int i = 1; i < argc; i++) {
+        struct stat info;
+        if (stat(argv[i], &info) == 0 && S_ISDIR(info.st_mode)) {
+            DIR* dir = opendir(argv[i]);
+            while (struct dirent* entry = dir ? readdir(dir) : nullptr) {
+                if (entry->d_name[0] == '.') continue;
+                ok &= runFile(std::string(argv[i]) + "/" + entry->d_name);
+                runs++;
+            }
+            if (dir) closedir(dir);
+        } else {
+            ok &= runFile(argv[i]);
+            runs++;
+        }
+    }
+    printf("%d inputs run\n", runs);
+    return ok ? 0 : 1;
+}
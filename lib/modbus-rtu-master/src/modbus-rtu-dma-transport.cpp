@@ -0,0 +1,153 @@
+#include "modbus-rtu-dma-transport.h"
+
+#if __has_include(<hardware/dma.h>)
+
+/**
+ * @brief Constructor
+ */
+ModbusRTUDmaTransport::ModbusRTUDmaTransport(HardwareSerial* serial, uart_inst_t* uart, int8_t dePin)
+    : _tx(serial, dePin) {
+    _uart = uart;
+#ifdef MODBUS_DE_ALARM
+    _tx.setUart(uart);
+#endif
+    _channel = -1;
+    _received = 0;
+    _frameStart = 0;
+    _lastRxAt = 0;
+    _rxActivity = false;
+    _frameGap = MODBUS_FIXED_FRAME_GAP_US;
+}
+
+/**
+ * @brief Open the serial port and start the receive channel
+ */
+bool ModbusRTUDmaTransport::begin(uint32_t baudrate, uint32_t config) {
+    if (_uart == nullptr || !_tx.begin(baudrate, config)) {
+        return false;
+    }
+
+    // The serial driver's RX interrupt would empty the FIFO before DREQ fires.
+    // The UART's DMA requests themselves are enabled by uart_init().
+    uart_set_irq_enables(_uart, false, false);
+
+    if (_channel < 0) {
+        _channel = dma_claim_unused_channel(false);
+        if (_channel < 0) {
+            return false;
+        }
+    }
+
+    _frameGap = baudrate > MODBUS_FIXED_FRAME_GAP_BAUD ? MODBUS_FIXED_FRAME_GAP_US : _tx.byteTime() * 7 / 2;
+    _restart();
+    return true;
+}
+
+/**
+ * @brief Start the channel over at the start of the buffer
+ */
+void ModbusRTUDmaTransport::_restart() {
+    dma_channel_abort(_channel);
+
+    dma_channel_config config = dma_channel_get_default_config(_channel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+    channel_config_set_read_increment(&config, false);
+    channel_config_set_write_increment(&config, true);
+    channel_config_set_dreq(&config, uart_get_dreq(_uart, false));
+    dma_channel_configure(_channel, &config, _rxBuffer, &uart_get_hw(_uart)->dr, MODBUS_DMA_RX_BUFFER, true);
+
+    _received = 0;
+    _frameStart = 0;
+    _lastRxAt = micros();
+    _rxActivity = false;
+}
+
+/**
+ * @brief Read how far the channel has got
+ */
+void ModbusRTUDmaTransport::_poll() {
+    if (_channel < 0) {
+        return;
+    }
+    uint16_t received = MODBUS_DMA_RX_BUFFER - dma_channel_hw_addr(_channel)->transfer_count;
+    if (received != _received) {
+        _received = received;
+        _lastRxAt = micros();
+        _rxActivity = true;
+    }
+}
+
+/**
+ * @brief Start sending a frame; whatever is left of the last reply is dropped
+ */
+size_t ModbusRTUDmaTransport::write(const uint8_t* frame, size_t length) {
+    if (_channel < 0) {
+        return 0;
+    }
+    _restart();
+    return _tx.write(frame, length);
+}
+
+/**
+ * @brief Get the number of received bytes not yet handed out
+ */
+int ModbusRTUDmaTransport::available() {
+    _poll();
+    return _received - _frameStart;
+}
+
+/**
+ * @brief Read received bytes without waiting for the end of the frame
+ */
+size_t ModbusRTUDmaTransport::read(uint8_t* buffer, size_t length) {
+    _poll();
+    size_t count = min((size_t)(_received - _frameStart), length);
+    memcpy(buffer, _rxBuffer + _frameStart, count);
+    _frameStart += count;
+    return count;
+}
+
+/**
+ * @brief Hand out the received bytes once the line has gone quiet for T3.5
+ */
+bool ModbusRTUDmaTransport::readFrame(const uint8_t** frame, uint16_t* length) {
+    _poll();
+    if (_received == _frameStart) {
+        return false;
+    }
+    if (_received < MODBUS_DMA_RX_BUFFER && (uint32_t)(micros() - _lastRxAt) < _frameGap) {
+        return false;
+    }
+
+    *frame = _rxBuffer + _frameStart;
+    *length = _received - _frameStart;
+    _frameStart = _received;
+    return true;
+}
+
+/**
+ * @brief Report whether bytes have landed since the last call
+ */
+bool ModbusRTUDmaTransport::rxActivity() {
+    _poll();
+    bool activity = _rxActivity;
+    _rxActivity = false;
+    return activity;
+}
+
+/**
+ * @brief Check whether the frame has gone out (the TX side releases DE by itself)
+ */
+bool ModbusRTUDmaTransport::txComplete() {
+    return _tx.txComplete();
+}
+
+/**
+ * @brief Get the time the line has been quiet in either direction
+ */
+uint32_t ModbusRTUDmaTransport::idleTime() {
+    _poll();
+    return min(_tx.idleTime(), (uint32_t)(micros() - _lastRxAt));
+}
+
+#endif // __has_include(<hardware/dma.h>)
@@ -0,0 +1,82 @@
+#pragma once
+
+/**
+ * @file modbus-rtu-dma-transport.h
+ * @brief DMA receive transport for the Modbus RTU master (RP2040)
+ *
+ * A DMA channel paced by the UART's RX DREQ copies every received byte into a frame
+ * buffer, so no code runs per byte. A frame ends when the line has been idle for
+ * 3.5 character times (T3.5, or 1750us above 19200 baud as the Modbus serial line
+ * specification allows), and is handed to the master in place as one span.
+ */
+
+#ifndef MODBUS_RTU_DMA_TRANSPORT_H
+#define MODBUS_RTU_DMA_TRANSPORT_H
+
+#if __has_include(<hardware/dma.h>)
+
+#include "modbus-rtu-transport.h"
+#include <hardware/dma.h>
+#include <hardware/uart.h>
+
+// Largest Modbus RTU frame
+#define MODBUS_DMA_RX_BUFFER 256
+
+// T3.5 above this baud rate is fixed rather than scaled with the character time
+#define MODBUS_FIXED_FRAME_GAP_BAUD 19200
+#define MODBUS_FIXED_FRAME_GAP_US 1750
+
+/**
+ * @brief A UART whose receive side is served by DMA
+ *
+ * Sending, DE/RE and the serial settings are those of ModbusRTUSerialTransport, which
+ * is given the UART so the DE release alarm also waits for its busy flag. The
+ * channel is restarted at the start of the buffer with every frame sent: a master only
+ * listens for the one reply, so a reply never wraps and is always contiguous. The
+ * UART's receive interrupt is switched off so the serial driver does not take the
+ * bytes first.
+ */
+class ModbusRTUDmaTransport : public ModbusRTUTransport {
+public:
+    /**
+     * @param serial Serial port used for settings and sending
+     * @param uart The serial port's UART (uart0 for Serial1, uart1 for Serial2)
+     * @param dePin Pin connected to DE/RE of the RS485 transceiver (-1 if not used)
+     */
+    ModbusRTUDmaTransport(HardwareSerial* serial, uart_inst_t* uart, int8_t dePin = -1);
+
+    bool begin(uint32_t baudrate, uint32_t config) override;
+    size_t write(const uint8_t* frame, size_t length) override;
+    int available() override;
+    size_t read(uint8_t* buffer, size_t length) override;
+    bool txComplete() override;
+    uint32_t idleTime() override;
+    bool framed() override { return true; }
+    bool readFrame(const uint8_t** frame, uint16_t* length) override;
+    bool rxActivity() override;
+
+private:
+    ModbusRTUSerialTransport _tx;      ///< Settings, sending and DE/RE
+    uart_inst_t* _uart;                ///< UART the channel reads from
+    int _channel;                      ///< DMA channel (-1 until begin())
+    uint8_t _rxBuffer[MODBUS_DMA_RX_BUFFER]; ///< DMA target
+    uint16_t _received;                ///< Bytes the channel has written so far
+    uint16_t _frameStart;              ///< Start of the bytes not yet handed out
+    uint32_t _lastRxAt;                ///< micros() when _received last grew
+    bool _rxActivity;                  ///< _received grew since the last rxActivity()
+    uint32_t _frameGap;                ///< T3.5 in microseconds
+
+    /**
+     * @brief Point the channel at the start of the buffer and drop what it holds
+     */
+    void _restart();
+
+    /**
+     * @brief Pick up the channel's progress
+     */
+    void _poll();
+};
+
+#endif // __has_include(<hardware/dma.h>)
+
+#endif // MODBUS_RTU_DMA_TRANSPORT_H
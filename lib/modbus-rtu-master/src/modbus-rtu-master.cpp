@@ -4,15 +4,20 @@
  * @brief Constructor
  */
 ModbusRTUMaster::ModbusRTUMaster() {
-    _serial = nullptr;
+    _transport = nullptr;
     _queueCount = 0;
     _currentRequest = 0;
     _timeout = MODBUS_DEFAULT_TIMEOUT;
     _lastActivity = 0;
+    _sentAt = 0;
+    _lastRoundTrip = 0;
+    _rxBytes = 0;
+    _queueHighWater = 0;
+    _lastResult = MODBUS_RESULT_SUCCESS;
+    _crcMismatch = false;
     _interframeDelay = MODBUS_DEFAULT_INTERFRAME_DELAY;
     _bufferLength = 0;
     _state = IDLE;
-    _dePin = -1; // Default to no DE pin
     
     // Initialize queue to inactive state
     for (uint8_t i = 0; i < MODBUS_QUEUE_SIZE; i++) {
@@ -28,20 +33,21 @@ bool ModbusRTUMaster::begin(HardwareSerial* serial, uint32_t baudrate, uint32_t
         return false;
     }
     
-    _serial = serial;
-    
-    // Initialize the serial port directly
-    _serial->begin(baudrate, config);
+    _uart = ModbusRTUSerialTransport(serial, dePin);
+    return begin(&_uart, baudrate, config);
+}
+
+/**
+ * @brief Initialize the Modbus master on a transport
+ */
+bool ModbusRTUMaster::begin(ModbusRTUTransport* transport, uint32_t baudrate, uint32_t config) {
+    if (transport == nullptr || !transport->begin(baudrate, config)) {
+        return false;
+    }
     
+    _transport = transport;
     _interframeDelay = _calculateInterframeDelay(baudrate);
     
-    // Initialize DE pin if provided
-    _dePin = dePin;
-    if (_dePin >= 0) {
-        pinMode(_dePin, OUTPUT);
-        digitalWrite(_dePin, LOW); // Default to receive mode
-    }
-    
     return true;
 }
 
@@ -49,8 +55,8 @@ bool ModbusRTUMaster::begin(HardwareSerial* serial, uint32_t baudrate, uint32_t
  * @brief Set the serial configuration during runtime
  */
 void ModbusRTUMaster::setSerialConfig(uint32_t baudrate, uint32_t config) {
-    if (_serial != nullptr) {
-        _serial->begin(baudrate, config);
+    if (_transport != nullptr) {
+        _transport->begin(baudrate, config);
         _interframeDelay = _calculateInterframeDelay(baudrate);
     }
 }
@@ -66,183 +72,94 @@ void ModbusRTUMaster::setTimeout(uint16_t timeout) {
  * @brief Process the command queue
  */
 void ModbusRTUMaster::manage() {
-    if (_serial == nullptr) {
+    if (_transport == nullptr) {
         return;
     }
     
-    // If in waiting mode, ensure DE pin is LOW (receive mode)
-    if (_state == WAITING_FOR_REPLY && _dePin >= 0) {
-        digitalWrite(_dePin, LOW);
+    // The response timeout starts when the last byte has gone out. The transport has
+    // released the line by itself, so the reply may already be in when this runs late.
+    if (_state == SENDING && _transport->txComplete()) {
+        _lastActivity = millis();
+        _sentAt = micros();
+        _state = WAITING_FOR_REPLY;
     }
     
     // Process any received data
-    while (_serial->available() > 0) {
-        if (_bufferLength < MODBUS_MAX_BUFFER) {
-            _buffer[_bufferLength++] = _serial->read();
+    if (_transport->framed()) {
+        // Whole frames, parsed where the transport received them
+        const uint8_t* frame;
+        uint16_t length;
+        while (_transport->readFrame(&frame, &length)) {
+            _rxBytes += length;
+            _lastActivity = millis();
+            if (_state == WAITING_FOR_REPLY) {
+                _receiveFrame(frame, length);
+            }
+        }
+        // A frame still arriving keeps the response timeout from running out under it
+        if (_transport->rxActivity()) {
             _lastActivity = millis();
-        } else {
-            // Buffer overflow, discard the byte
-            _serial->read();
+        }
+    } else {
+        while (_transport->available() > 0) {
+            uint16_t count;
+            if (_bufferLength < MODBUS_MAX_BUFFER) {
+                count = _transport->read(_buffer + _bufferLength, MODBUS_MAX_BUFFER - _bufferLength);
+                _bufferLength += count;
+                _lastActivity = millis();
+            } else {
+                // Buffer overflow, discard the bytes
+                uint8_t discard[16];
+                count = _transport->read(discard, sizeof(discard));
+            }
+            if (count == 0) {
+                break;
+            }
+            _rxBytes += count;
         }
     }
     
     // Check the current state
     switch (_state) {
         case IDLE:
-            // If there are requests in the queue, send the next one
-            {
+            // If there are requests in the queue, send the next one once the line
+            // has been quiet for the inter-frame delay (a frame cut short by clearQueue()
+            // still has to finish first)
+            if (_queueCount > 0 && _transport->txComplete() &&
+                _transport->idleTime() >= _interframeDelay) {
                 ModbusRequest* request = _getNextRequest();
                 if (request != nullptr) {
                     _bufferLength = 0; // Clear the buffer before sending
-                    if (_sendRequest(request)) {
-                        _state = WAITING_FOR_REPLY;
-                        _lastActivity = millis();
-                    }
+                    _sendRequest(request);
                 }
             }
             break;
             
+        case SENDING:
+            // Handled above, before the receive side
+            break;
+            
         case WAITING_FOR_REPLY:
             // Check if we've received a complete message or timed out
+            if (_bufferLength >= 2 && !_matchesRequest(_buffer, _bufferLength)) {
+                _bufferLength = 0;
+            }
             if (_bufferLength > 0) {
-                // We need at least 5 bytes for a minimal valid Modbus RTU response
-                // (slave id, function code, at least 1 data byte, and 2 CRC bytes)
-                if (_bufferLength >= 5) {
-                    // Check if we've received the expected response length
-                    //uint8_t slaveId = _buffer[0];
-                    uint8_t functionCode = _buffer[1];
-                    
-                    // Determine the expected message length based on the function code
-                    uint16_t expectedLength = 0;
-                    
-                    // Is this an exception response?
-                    if (functionCode & 0x80) {
-                        expectedLength = 5; // ID, FC, Exception code, 2 CRC bytes
-                    } else {
-                        switch (functionCode) {
-                            case MODBUS_FC_READ_COILS:
-                            case MODBUS_FC_READ_DISCRETE_INPUTS:
-                            case MODBUS_FC_READ_HOLDING_REGISTERS:
-                            case MODBUS_FC_READ_INPUT_REGISTERS:
-                                // For read functions, the second byte gives us the data length
-                                if (_bufferLength >= 3) {
-                                    expectedLength = 5 + _buffer[2]; // ID, FC, len, data, 2 CRC bytes
-                                }
-                                break;
-                                
-                            case MODBUS_FC_WRITE_SINGLE_COIL:
-                            case MODBUS_FC_WRITE_SINGLE_REGISTER:
-                                expectedLength = 8; // ID, FC, addr (2), value (2), 2 CRC bytes
-                                break;
-                                
-                            case MODBUS_FC_WRITE_MULTIPLE_COILS:
-                            case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
-                                expectedLength = 8; // ID, FC, addr (2), quantity (2), 2 CRC bytes
-                                break;
-                                
-                            default:
-                                // Unknown function code, wait for timeout
-                                break;
-                        }
-                    }
-                    
-                    // If we know the expected length and have received enough bytes, process the message
-                    if (expectedLength > 0 && _bufferLength >= expectedLength) {
-                        // Check CRC
-                        uint16_t receivedCrc = (_buffer[expectedLength - 1] << 8) | _buffer[expectedLength - 2];
-                        uint16_t calculatedCrc = _calculateCRC(_buffer, expectedLength - 2);
-                        
-                        if (receivedCrc == calculatedCrc) {
-                            // Valid CRC, process the response
-                            _state = PROCESSING_REPLY;
-                            
-                            // Process based on function code
-                            uint8_t dataOffset = 2; // Default data offset (after ID and FC)
-                            uint16_t dataLength = expectedLength - 4; // Excluding ID, FC, and CRC (2 bytes)
-                            
-                            if (functionCode & 0x80) {
-                                // Exception response, treat as invalid
-                                if (_queue[_currentRequest].callback) {
-                                    _queue[_currentRequest].callback(false, _queue[_currentRequest].data, _queue[_currentRequest].requestId);
-                                }
-                            } else {
-                                switch (functionCode) {
-                                    case MODBUS_FC_READ_COILS:
-                                    case MODBUS_FC_READ_DISCRETE_INPUTS:
-                                    case MODBUS_FC_READ_HOLDING_REGISTERS:
-                                    case MODBUS_FC_READ_INPUT_REGISTERS:
-                                        // Data length is in the byte after function code
-                                        dataOffset = 3;
-                                        dataLength = _buffer[2];
-                                        
-                                        // For read functions, we need to fill the data buffer with received values
-                                        if (functionCode == MODBUS_FC_READ_HOLDING_REGISTERS ||
-                                            functionCode == MODBUS_FC_READ_INPUT_REGISTERS) {
-                                            // For register reads, convert byte array to uint16_t array
-                                            for (uint16_t i = 0; i < (dataLength / 2); i++) {
-                                                if (_queue[_currentRequest].data != nullptr) {
-                                                    _queue[_currentRequest].data[i] = (_buffer[dataOffset + i*2] << 8) | 
-                                                                                     _buffer[dataOffset + i*2 + 1];
-                                                }
-                                            }
-                                        } else {
-                                            // For coil/discrete input reads, convert byte array to bit packed uint16_t array
-                                            for (uint16_t i = 0; i < (dataLength * 8); i++) {
-                                                if (i < _queue[_currentRequest].length && _queue[_currentRequest].data != nullptr) {
-                                                    uint16_t byteIndex = i / 8;
-                                                    uint8_t bitIndex = i % 8;
-                                                    
-                                                    if (i / 16 < _queue[_currentRequest].length) {
-                                                        if (_buffer[dataOffset + byteIndex] & (1 << bitIndex)) {
-                                                            _queue[_currentRequest].data[i / 16] |= (1 << (i % 16));
-                                                        } else {
-                                                            _queue[_currentRequest].data[i / 16] &= ~(1 << (i % 16));
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                        }
-                                        break;
-                                        
-                                    case MODBUS_FC_WRITE_SINGLE_COIL:
-                                    case MODBUS_FC_WRITE_SINGLE_REGISTER:
-                                    case MODBUS_FC_WRITE_MULTIPLE_COILS:
-                                    case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
-                                        // For write functions, we don't need to modify the data buffer
-                                        break;
-                                        
-                                    default:
-                                        // Unknown function code, treat as invalid
-                                        if (_queue[_currentRequest].callback) {
-                                            _queue[_currentRequest].callback(false, _queue[_currentRequest].data, _queue[_currentRequest].requestId);
-                                        }
-                                        break;
-                                }
-                                
-                                // Call the callback with the result
-                                if (_queue[_currentRequest].callback) {
-                                    _queue[_currentRequest].callback(true, _queue[_currentRequest].data, _queue[_currentRequest].requestId);
-                                }
-                            }
-                            
-                            // Mark the request as processed
-                            _queue[_currentRequest].active = false;
-                            _queueCount--;
-                            
-                            // Ensure inter-frame delay before allowing next request
-                            delayMicroseconds(_interframeDelay);
-                            
-                            // Reset the state
-                            _state = IDLE;
-                            _bufferLength = 0;
-                        }
+                // If we know the expected length and have received enough bytes, process the message
+                uint16_t expectedLength = _expectedLength(_buffer, _bufferLength);
+                if (expectedLength > 0 && _bufferLength >= expectedLength) {
+                    if (!_completeRequest(_buffer, expectedLength)) {
+                        // Keep waiting - a timeout on this request is then reported as a CRC error
+                        _crcMismatch = true;
                     }
                 }
             }
             
             // Check for timeout
-            if (_state == WAITING_FOR_REPLY && (millis() - _lastActivity) > _timeout) {
+            if (_state == WAITING_FOR_REPLY && (millis() - _lastActivity) >
+                (_queue[_currentRequest].timeout ? _queue[_currentRequest].timeout : _timeout)) {
                 // Timeout occurred, call the callback with invalid result
+                _lastResult = _crcMismatch ? MODBUS_RESULT_CRC_ERROR : MODBUS_RESULT_TIMEOUT;
                 if (_queue[_currentRequest].callback) {
                     _queue[_currentRequest].callback(false, _queue[_currentRequest].data, _queue[_currentRequest].requestId);
                 }
@@ -251,9 +168,6 @@ void ModbusRTUMaster::manage() {
                 _queue[_currentRequest].active = false;
                 _queueCount--;
                 
-                // Ensure inter-frame delay before allowing next request
-                delayMicroseconds(_interframeDelay);
-                
                 // Reset the state
                 _state = IDLE;
                 _bufferLength = 0;
@@ -267,16 +181,197 @@ void ModbusRTUMaster::manage() {
     }
 }
 
+/**
+ * @brief Check that a (partial) reply belongs to the current request
+ */
+bool ModbusRTUMaster::_matchesRequest(const uint8_t* frame, uint16_t length) {
+    // A reply from another slave or to another function (e.g. a late reply to a
+    // request that already timed out) does not belong to this request
+    if (length < 2 || frame[0] != _queue[_currentRequest].slaveId ||
+        (frame[1] & 0x7F) != _queue[_currentRequest].functionCode) {
+        return false;
+    }
+    
+    if (length >= 3 && !(frame[1] & 0x80)) {
+        // A read reply must carry exactly the requested data, or it would be copied
+        // past the end of the request's data buffer
+        uint16_t requested = _queue[_currentRequest].length;
+        switch (frame[1]) {
+            case MODBUS_FC_READ_COILS:
+            case MODBUS_FC_READ_DISCRETE_INPUTS:
+                return frame[2] == (requested + 7) / 8;
+            case MODBUS_FC_READ_HOLDING_REGISTERS:
+            case MODBUS_FC_READ_INPUT_REGISTERS:
+                return frame[2] == requested * 2;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Get the length of a reply from its first bytes
+ */
+uint16_t ModbusRTUMaster::_expectedLength(const uint8_t* frame, uint16_t length) {
+    // We need at least 5 bytes for a minimal valid Modbus RTU response
+    // (slave id, function code, at least 1 data byte, and 2 CRC bytes)
+    if (length < 5) {
+        return 0;
+    }
+    
+    // Is this an exception response?
+    if (frame[1] & 0x80) {
+        return 5; // ID, FC, Exception code, 2 CRC bytes
+    }
+    
+    switch (frame[1]) {
+        case MODBUS_FC_READ_COILS:
+        case MODBUS_FC_READ_DISCRETE_INPUTS:
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+        case MODBUS_FC_READ_INPUT_REGISTERS:
+            // For read functions, the third byte gives us the data length
+            return 5 + frame[2]; // ID, FC, len, data, 2 CRC bytes
+            
+        case MODBUS_FC_WRITE_SINGLE_COIL:
+        case MODBUS_FC_WRITE_SINGLE_REGISTER:
+            return 8; // ID, FC, addr (2), value (2), 2 CRC bytes
+            
+        case MODBUS_FC_WRITE_MULTIPLE_COILS:
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            return 8; // ID, FC, addr (2), quantity (2), 2 CRC bytes
+            
+        default:
+            // Unknown function code, wait for timeout
+            return 0;
+    }
+}
+
+/**
+ * @brief Handle a frame from a framed transport
+ */
+void ModbusRTUMaster::_receiveFrame(const uint8_t* frame, uint16_t length) {
+    if (!_matchesRequest(frame, length)) {
+        return;
+    }
+    
+    // The frame ended at a line idle, so it has to be exactly one reply; a short or
+    // overlong one was garbled on the line
+    if (_expectedLength(frame, length) != length || !_completeRequest(frame, length)) {
+        _crcMismatch = true;
+    }
+}
+
+/**
+ * @brief Check the CRC of a complete reply and finish the current request with it
+ */
+bool ModbusRTUMaster::_completeRequest(const uint8_t* frame, uint16_t length) {
+    // Check CRC
+    uint16_t receivedCrc = (frame[length - 1] << 8) | frame[length - 2];
+    uint16_t calculatedCrc = _calculateCRC(frame, length - 2);
+    if (receivedCrc != calculatedCrc) {
+        return false;
+    }
+    
+    // Valid CRC, process the response
+    uint8_t functionCode = frame[1];
+    ModbusRequest* request = &_queue[_currentRequest];
+    _state = PROCESSING_REPLY;
+    _lastRoundTrip = micros() - _sentAt;
+    _lastResult = (functionCode & 0x80) ? MODBUS_RESULT_EXCEPTION : MODBUS_RESULT_SUCCESS;
+    
+    if (functionCode & 0x80) {
+        // Exception response, treat as invalid
+        if (request->callback) {
+            request->callback(false, request->data, request->requestId);
+        }
+    } else {
+        // Data length is in the byte after function code for reads
+        const uint8_t* data = frame + 3;
+        uint16_t dataLength = frame[2];
+        
+        switch (functionCode) {
+            case MODBUS_FC_READ_HOLDING_REGISTERS:
+            case MODBUS_FC_READ_INPUT_REGISTERS:
+                // For register reads, convert byte array to uint16_t array
+                if (request->data != nullptr) {
+                    for (uint16_t i = 0; i < (dataLength / 2); i++) {
+                        request->data[i] = (data[i*2] << 8) | data[i*2 + 1];
+                    }
+                }
+                break;
+                
+            case MODBUS_FC_READ_COILS:
+            case MODBUS_FC_READ_DISCRETE_INPUTS:
+                // For coil/discrete input reads, convert byte array to bit packed uint16_t array
+                if (request->data != nullptr) {
+                    for (uint16_t i = 0; i < (dataLength * 8) && i < request->length; i++) {
+                        if (data[i / 8] & (1 << (i % 8))) {
+                            request->data[i / 16] |= (1 << (i % 16));
+                        } else {
+                            request->data[i / 16] &= ~(1 << (i % 16));
+                        }
+                    }
+                }
+                break;
+                
+            default:
+                // For write functions, we don't need to modify the data buffer
+                break;
+        }
+        
+        // Call the callback with the result
+        if (request->callback) {
+            request->callback(true, request->data, request->requestId);
+        }
+    }
+    
+    // Mark the request as processed
+    request->active = false;
+    _queueCount--;
+    
+    // Reset the state
+    _state = IDLE;
+    _bufferLength = 0;
+    return true;
+}
+
 /**
  * @brief Push a request to the queue
  */
 bool ModbusRTUMaster::pushRequest(uint8_t slaveId, uint8_t functionCode, uint16_t address, 
-                                 uint16_t* data, uint16_t length, ModbusResponseCallback callback, uint32_t requestId) {
+                                 uint16_t* data, uint16_t length, ModbusResponseCallback callback, uint32_t requestId,
+                                 uint16_t timeout) {
     // Check if the queue is full
     if (_queueCount >= MODBUS_QUEUE_SIZE) {
         return false;
     }
     
+    // Reject what _sendRequest() cannot frame: a longer request would overrun its buffer,
+    // an unknown function code would never leave the queue
+    uint16_t maxLength = 0;
+    switch (functionCode) {
+        case MODBUS_FC_READ_COILS:
+        case MODBUS_FC_READ_DISCRETE_INPUTS:
+            maxLength = MODBUS_MAX_READ_BITS;
+            break;
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+        case MODBUS_FC_READ_INPUT_REGISTERS:
+            maxLength = MODBUS_MAX_READ_REGISTERS;
+            break;
+        case MODBUS_FC_WRITE_SINGLE_COIL:
+        case MODBUS_FC_WRITE_SINGLE_REGISTER:
+            maxLength = 1;
+            break;
+        case MODBUS_FC_WRITE_MULTIPLE_COILS:
+            maxLength = MODBUS_MAX_WRITE_BITS;
+            break;
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            maxLength = MODBUS_MAX_WRITE_REGISTERS;
+            break;
+    }
+    if (length == 0 || length > maxLength) {
+        return false;
+    }
+    
     // Find an empty slot in the queue
     for (uint8_t i = 0; i < MODBUS_QUEUE_SIZE; i++) {
         if (!_queue[i].active) {
@@ -289,9 +384,13 @@ bool ModbusRTUMaster::pushRequest(uint8_t slaveId, uint8_t functionCode, uint16_
             _queue[i].callback = callback;
             _queue[i].requestId = requestId;
             _queue[i].timestamp = millis();
+            _queue[i].timeout = timeout;
             _queue[i].active = true;
             
             _queueCount++;
+            if (_queueCount > _queueHighWater) {
+                _queueHighWater = _queueCount;
+            }
             return true;
         }
     }
@@ -304,8 +403,9 @@ bool ModbusRTUMaster::pushRequest(uint8_t slaveId, uint8_t functionCode, uint16_
  * @brief Read holding registers
  */
 bool ModbusRTUMaster::readHoldingRegisters(uint8_t slaveId, uint16_t address, uint16_t* data, 
-                                          uint16_t length, ModbusResponseCallback callback, uint32_t requestId) {
-    return pushRequest(slaveId, MODBUS_FC_READ_HOLDING_REGISTERS, address, data, length, callback, requestId);
+                                          uint16_t length, ModbusResponseCallback callback, uint32_t requestId,
+                                          uint16_t timeout) {
+    return pushRequest(slaveId, MODBUS_FC_READ_HOLDING_REGISTERS, address, data, length, callback, requestId, timeout);
 }
 
 /**
@@ -375,6 +475,34 @@ uint8_t ModbusRTUMaster::getQueueCount() {
     return _queueCount;
 }
 
+/**
+ * @brief Get the round trip time of the last valid response
+ */
+uint32_t ModbusRTUMaster::getLastRoundTrip() {
+    return _lastRoundTrip;
+}
+
+/**
+ * @brief Get the highest queue count seen
+ */
+uint8_t ModbusRTUMaster::getQueueHighWater() {
+    return _queueHighWater;
+}
+
+/**
+ * @brief Get the outcome of the last completed request
+ */
+uint8_t ModbusRTUMaster::getLastResult() {
+    return _lastResult;
+}
+
+/**
+ * @brief Get the total number of bytes received
+ */
+uint32_t ModbusRTUMaster::getRxByteCount() {
+    return _rxBytes;
+}
+
 /**
  * @brief Clear all requests in the queue
  */
@@ -389,7 +517,7 @@ void ModbusRTUMaster::clearQueue() {
 /**
  * @brief Calculate the Modbus RTU CRC
  */
-uint16_t ModbusRTUMaster::_calculateCRC(uint8_t* buffer, uint16_t length) {
+uint16_t ModbusRTUMaster::_calculateCRC(const uint8_t* buffer, uint16_t length) {
     uint16_t crc = 0xFFFF;
     
     for (uint16_t i = 0; i < length; i++) {
@@ -412,15 +540,10 @@ uint16_t ModbusRTUMaster::_calculateCRC(uint8_t* buffer, uint16_t length) {
  * @brief Send a request
  */
 bool ModbusRTUMaster::_sendRequest(ModbusRequest* request) {
-    if (_serial == nullptr || request == nullptr) {
+    if (_transport == nullptr || request == nullptr) {
         return false;
     }
     
-    // Set DE pin HIGH for transmission if it's defined
-    if (_dePin >= 0) {
-        digitalWrite(_dePin, HIGH);
-    }
-    
     // Create the Modbus RTU message
     uint8_t messageBuffer[MODBUS_MAX_BUFFER];
     uint16_t messageLength = 0;
@@ -515,25 +638,16 @@ bool ModbusRTUMaster::_sendRequest(ModbusRequest* request) {
     messageBuffer[messageLength++] = crc & 0xFF;         // CRC low byte
     messageBuffer[messageLength++] = (crc >> 8) & 0xFF; // CRC high byte
     
-    // Ensure inter-frame delay before sending
-    delayMicroseconds(_interframeDelay);
-    
-    // Send the message
-    _serial->write(messageBuffer, messageLength);
-    _serial->flush();
-    
-    // Switch to receive mode (DE pin LOW) after sending if DE pin is defined
-    if (_dePin >= 0) {
-        // Keep DE pin HIGH for a brief moment after transmission
-        delayMicroseconds(50);
-        digitalWrite(_dePin, LOW);
-    }
+    // Send the message; the inter-frame delay was already waited out in manage().
+    // A frame the transport did not take times out like an unanswered one.
+    _transport->write(messageBuffer, messageLength);
     
     // Update last activity timestamp
     _lastActivity = millis();
+    _crcMismatch = false;
     
-    // Move to waiting state
-    _state = WAITING_FOR_REPLY;
+    // Wait for the transmission to end
+    _state = SENDING;
     
     return true;
 }
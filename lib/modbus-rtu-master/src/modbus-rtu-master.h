@@ -13,6 +13,7 @@
 #define MODBUS_RTU_MASTER_H
 
 #include <Arduino.h>
+#include "modbus-rtu-transport.h"
 
 // Maximum queue size
 #define MODBUS_QUEUE_SIZE 10
@@ -38,9 +39,21 @@
 #define MODBUS_EX_GATEWAY_PATH_UNAVAILABLE 0x0A
 #define MODBUS_EX_GATEWAY_TARGET_FAILED   0x0B
 
+// Request outcomes, see getLastResult()
+#define MODBUS_RESULT_SUCCESS             0
+#define MODBUS_RESULT_TIMEOUT             1   ///< No complete reply
+#define MODBUS_RESULT_CRC_ERROR           2   ///< A reply arrived but its CRC never matched
+#define MODBUS_RESULT_EXCEPTION           3   ///< The slave answered with an exception code
+
 // Maximum buffer size for Modbus messages
 #define MODBUS_MAX_BUFFER 256
 
+// Largest quantities one request can carry (Modbus application protocol limits)
+#define MODBUS_MAX_READ_BITS              2000
+#define MODBUS_MAX_READ_REGISTERS         125
+#define MODBUS_MAX_WRITE_BITS             1968
+#define MODBUS_MAX_WRITE_REGISTERS        123
+
 // Response timeout in milliseconds
 #define MODBUS_DEFAULT_TIMEOUT 1000
 // Inter-frame silent interval (3.5 character times) - calculated at runtime
@@ -68,6 +81,7 @@ typedef struct {
     ModbusResponseCallback callback; ///< Callback function for response
     uint32_t requestId;           ///< User-defined ID to match response to request
     uint32_t timestamp;           ///< Timestamp when request was queued
+    uint16_t timeout;             ///< Response timeout in ms for this request (0 = use setTimeout value)
     bool active;                  ///< Flag to indicate if this entry is active
 } ModbusRequest;
 
@@ -91,6 +105,17 @@ public:
      */
     bool begin(HardwareSerial* serial, uint32_t baudrate = 9600, uint32_t config = SERIAL_8N1, int8_t dePin = -1);
     
+    /**
+     * @brief Initialize the Modbus master on another transport
+     * 
+     * @param transport Transport to use, e.g. ModbusRTUSerialTransport or ModbusRTUTcpTransport
+     *                  (must outlive the master)
+     * @param baudrate Baud rate for serial communication (default: 9600)
+     * @param config Serial configuration (default: SERIAL_8N1)
+     * @return true if initialization was successful
+     */
+    bool begin(ModbusRTUTransport* transport, uint32_t baudrate = 9600, uint32_t config = SERIAL_8N1);
+    
     /**
      * @brief Set the serial configuration
      * 
@@ -124,10 +149,13 @@ public:
      * @param length Length of data in 16-bit units
      * @param callback Callback function for response
      * @param requestId User-defined ID to match response (default: 0)
-     * @return true if request was successfully queued
+     * @param timeout Response timeout in ms for this request only (default: 0, use setTimeout value)
+     * @return true if request was successfully queued (false also for an unsupported function
+     *         code or a length outside the MODBUS_MAX_* limits)
      */
     bool pushRequest(uint8_t slaveId, uint8_t functionCode, uint16_t address, 
-                   uint16_t* data, uint16_t length, ModbusResponseCallback callback, uint32_t requestId = 0);
+                   uint16_t* data, uint16_t length, ModbusResponseCallback callback, uint32_t requestId = 0,
+                   uint16_t timeout = 0);
     
     /**
      * @brief Read holding registers (function code 0x03)
@@ -138,10 +166,12 @@ public:
      * @param length Number of registers to read
      * @param callback Callback function for response
      * @param requestId User-defined ID to match response (default: 0)
+     * @param timeout Response timeout in ms for this request only (default: 0, use setTimeout value)
      * @return true if request was successfully queued
      */
     bool readHoldingRegisters(uint8_t slaveId, uint16_t address, uint16_t* data, 
-                            uint16_t length, ModbusResponseCallback callback, uint32_t requestId = 0);
+                            uint16_t length, ModbusResponseCallback callback, uint32_t requestId = 0,
+                            uint16_t timeout = 0);
     
     /**
      * @brief Read input registers (function code 0x04)
@@ -240,24 +270,69 @@ public:
      */
     uint8_t getQueueCount();
     
+    /**
+     * @brief Get the highest number of requests queued at once
+     * 
+     * @return Queue high-water mark since construction
+     */
+    uint8_t getQueueHighWater();
+    
+    /**
+     * @brief Get the outcome of the last completed request
+     * 
+     * Valid inside a response callback, where valid = false alone does not say
+     * whether the slave was silent, garbled or answered with an exception.
+     * 
+     * @return One of the MODBUS_RESULT_* values
+     */
+    uint8_t getLastResult();
+    
+    /**
+     * @brief Get the round trip time of the last valid response
+     * 
+     * Measured from the end of the request transmission to the last byte of the
+     * response. Valid inside a response callback.
+     * 
+     * @return Round trip time in microseconds
+     */
+    uint32_t getLastRoundTrip();
+    
+    /**
+     * @brief Get the total number of bytes received
+     * 
+     * Counts every byte read from the serial port, including bytes of frames that
+     * were discarded, so a change across a failed request shows that something
+     * answered but could not be decoded.
+     * 
+     * @return Received byte count
+     */
+    uint32_t getRxByteCount();
+    
     /**
      * @brief Clear all requests in the queue
      */
     void clearQueue();
 
 private:
-    HardwareSerial* _serial;           ///< Serial port for communication
+    ModbusRTUTransport* _transport;    ///< Line the frames go over
+    ModbusRTUSerialTransport _uart;    ///< Transport behind begin(HardwareSerial*, ...)
     ModbusRequest _queue[MODBUS_QUEUE_SIZE]; ///< Request queue
     uint8_t _queueCount;               ///< Number of active items in the queue
     uint8_t _currentRequest;           ///< Index of the current request
     uint16_t _timeout;                 ///< Response timeout in milliseconds
     uint32_t _lastActivity;            ///< Timestamp of last activity
+    uint32_t _sentAt;                  ///< micros() when the current request finished transmitting
+    uint32_t _lastRoundTrip;           ///< Round trip of the last valid response in microseconds
+    uint32_t _rxBytes;                 ///< Total bytes received
+    uint8_t _queueHighWater;           ///< Highest _queueCount seen
+    uint8_t _lastResult;               ///< MODBUS_RESULT_* of the last completed request
+    bool _crcMismatch;                 ///< A reply to the current request failed its CRC check
     uint16_t _interframeDelay;         ///< Delay between frames in microseconds
     uint8_t _buffer[MODBUS_MAX_BUFFER]; ///< Buffer for message processing
     uint16_t _bufferLength;            ///< Current length of data in the buffer
-    int8_t _dePin;                     ///< DE/RE pin for RS485 control (-1 if not used)
     enum {
         IDLE,                         ///< No active transaction
+        SENDING,                      ///< Request handed to the transport, still on the line
         WAITING_FOR_REPLY,            ///< Waiting for a response
         PROCESSING_REPLY              ///< Processing a response
     } _state;                          ///< Current state of the master
@@ -269,7 +344,7 @@ private:
      * @param length Length of data
      * @return Calculated CRC
      */
-    uint16_t _calculateCRC(uint8_t* buffer, uint16_t length);
+    uint16_t _calculateCRC(const uint8_t* buffer, uint16_t length);
     
     /**
      * @brief Send a request
@@ -279,6 +354,36 @@ private:
      */
     bool _sendRequest(ModbusRequest* request);
     
+    /**
+     * @brief Check that a reply, or its first bytes, belongs to the current request
+     * 
+     * @param frame Reply bytes
+     * @param length Number of bytes received so far (at least 2)
+     * @return false for another slave or function, or a read reply with the wrong byte count
+     */
+    bool _matchesRequest(const uint8_t* frame, uint16_t length);
+    
+    /**
+     * @brief Get the length a reply will have from its first bytes
+     * 
+     * @return Expected length including the CRC, 0 if not known yet
+     */
+    uint16_t _expectedLength(const uint8_t* frame, uint16_t length);
+    
+    /**
+     * @brief Handle one complete frame from a framed transport
+     */
+    void _receiveFrame(const uint8_t* frame, uint16_t length);
+    
+    /**
+     * @brief Check a complete reply's CRC and finish the current request with it
+     * 
+     * @param frame Reply bytes
+     * @param length Reply length including the CRC
+     * @return false if the CRC does not match (the request stays pending)
+     */
+    bool _completeRequest(const uint8_t* frame, uint16_t length);
+    
     /**
      * @brief Process a response
      * 
@@ -0,0 +1,102 @@
+#include "modbus-rtu-tcp-transport.h"
+
+/**
+ * @brief Constructor
+ */
+ModbusRTUTcpTransport::ModbusRTUTcpTransport(IPAddress host, uint16_t port) {
+    _host = host;
+    _port = port;
+    _lastConnect = 0;
+    _attempted = false;
+    _connected = false;
+}
+
+/**
+ * @brief Drop any old connection; the next connect() makes a new one
+ */
+bool ModbusRTUTcpTransport::begin(uint32_t baudrate, uint32_t config) {
+    // The serial settings belong to the device server
+    (void)baudrate;
+    (void)config;
+
+    // connect() may be running on the other core, so the client is left to it
+    _connected = false;
+    _attempted = false;
+    return true;
+}
+
+/**
+ * @brief Connect to the server (blocking)
+ */
+bool ModbusRTUTcpTransport::connect() {
+    if (_connected) {
+        return true;
+    }
+    if (_attempted && millis() - _lastConnect < MODBUS_TCP_RECONNECT_INTERVAL) {
+        return false;
+    }
+    _attempted = true;
+    _lastConnect = millis();
+    _client.stop();
+    if (!_client.connect(_host, _port)) {
+        return false;
+    }
+    _client.setNoDelay(true);
+    _connected = true;
+    return true;
+}
+
+/**
+ * @brief Check the connection from the master's side
+ *
+ * The client belongs to connect() while _connected is false, and to the master while it
+ * is true, so the two never use it at the same time.
+ */
+bool ModbusRTUTcpTransport::_up() {
+    if (_connected && !_client.connected()) {
+        _connected = false;
+    }
+    return _connected;
+}
+
+/**
+ * @brief Send a frame over the open connection
+ */
+size_t ModbusRTUTcpTransport::write(const uint8_t* frame, size_t length) {
+    if (!_up()) {
+        return 0;
+    }
+    return _client.write(frame, length);
+}
+
+/**
+ * @brief Get the number of received bytes
+ */
+int ModbusRTUTcpTransport::available() {
+    return _up() ? _client.available() : 0;
+}
+
+/**
+ * @brief Read received bytes
+ */
+size_t ModbusRTUTcpTransport::read(uint8_t* buffer, size_t length) {
+    if (!_up()) {
+        return 0;
+    }
+    int count = _client.read(buffer, length);
+    return count > 0 ? count : 0;
+}
+
+/**
+ * @brief TCP hands the frame over at once
+ */
+bool ModbusRTUTcpTransport::txComplete() {
+    return true;
+}
+
+/**
+ * @brief No silent interval is needed between frames; none is sent until connected
+ */
+uint32_t ModbusRTUTcpTransport::idleTime() {
+    return _up() ? UINT32_MAX : 0;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+/**
+ * @file modbus-rtu-tcp-transport.h
+ * @brief RTU over TCP transport for the Modbus RTU master
+ *
+ * Sends the unchanged RTU frames (address, PDU, CRC) over a TCP connection, as serial
+ * device servers in transparent mode expect. TCP keeps the frames apart, so there is no
+ * 3.5 character silence to wait for.
+ */
+
+#ifndef MODBUS_RTU_TCP_TRANSPORT_H
+#define MODBUS_RTU_TCP_TRANSPORT_H
+
+#include "modbus-rtu-transport.h"
+#include <WiFiClient.h>
+
+// Minimum time between connection attempts while the server is unreachable
+#define MODBUS_TCP_RECONNECT_INTERVAL 1000
+
+/**
+ * @brief A TCP connection to a serial device server or RTU over TCP slave
+ *
+ * Connecting blocks until the server answers or the client's timeout runs out (the
+ * lwIP client has no asynchronous connect), so it is not done from manage(). The
+ * application calls connect() from a loop that may block, e.g. the other core's, and
+ * again after the connection drops. Until it is up the line reports no idle time, so
+ * requests wait in the queue with their timeouts not yet started. A frame that cannot
+ * be sent is reported as not accepted and the request times out.
+ */
+class ModbusRTUTcpTransport : public ModbusRTUTransport {
+public:
+    /**
+     * @param host Server address
+     * @param port Server port
+     */
+    ModbusRTUTcpTransport(IPAddress host, uint16_t port);
+
+    /**
+     * @brief Make the connection if it is down and the reconnect interval has passed
+     *
+     * Blocks for the connection attempt: call it from a loop other than manage()'s.
+     *
+     * @return true if the connection is up
+     */
+    bool connect();
+
+    bool begin(uint32_t baudrate, uint32_t config) override;
+    size_t write(const uint8_t* frame, size_t length) override;
+    int available() override;
+    size_t read(uint8_t* buffer, size_t length) override;
+    bool txComplete() override;
+    uint32_t idleTime() override;
+
+private:
+    WiFiClient _client;                ///< Connection to the server
+    IPAddress _host;                   ///< Server address
+    uint16_t _port;                    ///< Server port
+    uint32_t _lastConnect;             ///< millis() of the last connection attempt
+    bool _attempted;                   ///< A connection attempt has been made
+    volatile bool _connected;          ///< connect() has handed _client over to the master's side
+
+    bool _up();
+};
+
+#endif // MODBUS_RTU_TCP_TRANSPORT_H
@@ -0,0 +1,173 @@
+#include "modbus-rtu-transport.h"
+
+/**
+ * @brief Constructor
+ */
+ModbusRTUSerialTransport::ModbusRTUSerialTransport(HardwareSerial* serial, int8_t dePin) {
+    _serial = serial;
+    _dePin = dePin;
+    _byteTime = 0;
+    _txStart = 0;
+    _txTime = 0;
+    _lastByteAt = 0;
+    _sending = false;
+#ifdef MODBUS_DE_ALARM
+    _uart = nullptr;
+    _alarm = 0;
+#endif
+}
+
+#ifdef MODBUS_DE_ALARM
+/**
+ * @brief Destructor - a pending alarm must not fire into a dead transport
+ */
+ModbusRTUSerialTransport::~ModbusRTUSerialTransport() {
+    _cancelAlarm();
+}
+
+/**
+ * @brief Drop the DE release alarm if it is still pending
+ */
+void ModbusRTUSerialTransport::_cancelAlarm() {
+    if (_alarm > 0) {
+        cancel_alarm(_alarm);
+    }
+    _alarm = 0;
+}
+
+/**
+ * @brief Timer alarm at the estimated end of the frame (interrupt context)
+ *
+ * A negative return value runs the alarm again that many microseconds later.
+ */
+int64_t ModbusRTUSerialTransport::_txDoneAlarm(alarm_id_t id, void* user) {
+    ModbusRTUSerialTransport* transport = (ModbusRTUSerialTransport*)user;
+    if (!transport->_sending) {
+        return 0;
+    }
+
+    // An alarm left over from an earlier frame waits for the end of this one
+    uint32_t elapsed = micros() - transport->_txStart;
+    if (elapsed < transport->_txTime) {
+        return -(int64_t)(transport->_txTime - elapsed);
+    }
+
+    // The estimate only misses on a slower clock than assumed
+    if (transport->_uart != nullptr && (uart_get_hw(transport->_uart)->fr & UART_UARTFR_BUSY_BITS)) {
+        return -(int64_t)MODBUS_DE_HOLD_US;
+    }
+
+    transport->_releaseLine();
+    return 0;
+}
+#endif
+
+/**
+ * @brief Open the serial port and put the transceiver in receive mode
+ */
+bool ModbusRTUSerialTransport::begin(uint32_t baudrate, uint32_t config) {
+    if (_serial == nullptr || baudrate == 0) {
+        return false;
+    }
+
+    _serial->begin(baudrate, config);
+
+    // Start bit, data bits, parity bit and stop bits
+    // Arduino constants: parity in bits 0-3, stop bits in bits 4-7, data bits in bits 8-11
+    uint32_t bits = 1 + 4 + ((config & SERIAL_DATA_MASK) >> 8);
+    if ((config & SERIAL_PARITY_MASK) != SERIAL_PARITY_NONE) bits++;
+    bits += ((config & SERIAL_STOP_BIT_MASK) == SERIAL_STOP_BIT_2) ? 2 : 1;
+    _byteTime = (bits * 1000000UL + baudrate - 1) / baudrate;
+
+    if (_dePin >= 0) {
+        pinMode(_dePin, OUTPUT);
+        digitalWrite(_dePin, LOW); // Default to receive mode
+    }
+
+#ifdef MODBUS_DE_ALARM
+    _cancelAlarm();
+#endif
+    _sending = false;
+    _lastByteAt = micros();
+    return true;
+}
+
+/**
+ * @brief Start sending a frame
+ */
+size_t ModbusRTUSerialTransport::write(const uint8_t* frame, size_t length) {
+    if (_serial == nullptr || _byteTime == 0) {
+        return 0;
+    }
+
+    // Set DE pin HIGH for transmission if it's defined
+    if (_dePin >= 0) {
+        digitalWrite(_dePin, HIGH);
+    }
+
+    _txStart = micros();
+    _txTime = length * _byteTime + MODBUS_DE_HOLD_US;
+    _sending = true;
+    size_t written = _serial->write(frame, length);
+
+#ifdef MODBUS_DE_ALARM
+    // Released from the timer interrupt, however long the caller takes to poll again
+    uint32_t elapsed = micros() - _txStart;
+    _alarm = add_alarm_in_us(elapsed < _txTime ? _txTime - elapsed : 0, _txDoneAlarm, this, false);
+    if (_alarm > 0) {
+        return written;
+    }
+#endif
+
+    // No alarm (none free, or the frame is already out): finish the frame here
+    _serial->flush();
+    delayMicroseconds(MODBUS_DE_HOLD_US);
+    _releaseLine();
+    return written;
+}
+
+/**
+ * @brief Get the number of received bytes
+ */
+int ModbusRTUSerialTransport::available() {
+    return _serial != nullptr ? _serial->available() : 0;
+}
+
+/**
+ * @brief Read received bytes
+ */
+size_t ModbusRTUSerialTransport::read(uint8_t* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length && _serial->available() > 0) {
+        buffer[count++] = _serial->read();
+    }
+    if (count > 0) {
+        _lastByteAt = micros();
+    }
+    return count;
+}
+
+/**
+ * @brief Check whether the frame has gone out and DE is released
+ */
+bool ModbusRTUSerialTransport::txComplete() {
+    return !_sending;
+}
+
+/**
+ * @brief Switch to receive mode (DE pin LOW) at the end of the frame
+ */
+void ModbusRTUSerialTransport::_releaseLine() {
+    if (_dePin >= 0) {
+        digitalWrite(_dePin, LOW);
+    }
+    _lastByteAt = micros();
+    _sending = false;
+}
+
+/**
+ * @brief Get the time the line has been quiet
+ */
+uint32_t ModbusRTUSerialTransport::idleTime() {
+    return _sending ? 0 : micros() - _lastByteAt;
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+/**
+ * @file modbus-rtu-transport.h
+ * @brief Byte transports for the Modbus RTU master
+ *
+ * ModbusRTUMaster keeps the queue, framing and timing; a transport only moves bytes.
+ * All calls are non-blocking and polled from manage(), so the TX-complete and
+ * line-idle notifications are queries rather than callbacks into the master. Anything
+ * that cannot wait for the next poll (releasing DE) the transport does on its own.
+ */
+
+#ifndef MODBUS_RTU_TRANSPORT_H
+#define MODBUS_RTU_TRANSPORT_H
+
+#include <Arduino.h>
+
+// With the pico SDK, DE is released from a timer alarm rather than from the next poll
+#if __has_include(<pico/time.h>) && __has_include(<hardware/uart.h>)
+#include <pico/time.h>
+#include <hardware/uart.h>
+#define MODBUS_DE_ALARM
+#endif
+
+// DE stays asserted this long past the estimated end of the last stop bit
+#define MODBUS_DE_HOLD_US 50
+
+/**
+ * @brief Interface between the master and the line
+ */
+class ModbusRTUTransport {
+public:
+    virtual ~ModbusRTUTransport() {}
+
+    /**
+     * @brief Open or reconfigure the line
+     *
+     * @param baudrate Baud rate (ignored by transports without a serial line)
+     * @param config Serial configuration, SERIAL_8N1 etc.
+     * @return true if the transport is usable
+     */
+    virtual bool begin(uint32_t baudrate, uint32_t config) = 0;
+
+    /**
+     * @brief Start sending one complete frame without waiting for it to go out
+     *
+     * @param frame Frame bytes including the CRC
+     * @param length Frame length
+     * @return Number of bytes accepted; less than length means the frame was not sent
+     */
+    virtual size_t write(const uint8_t* frame, size_t length) = 0;
+
+    /**
+     * @brief Get the number of received bytes ready to read
+     */
+    virtual int available() = 0;
+
+    /**
+     * @brief Read up to length received bytes
+     *
+     * @return Number of bytes copied into buffer
+     */
+    virtual size_t read(uint8_t* buffer, size_t length) = 0;
+
+    /**
+     * @brief TX-complete notification
+     *
+     * A query only: the transport finishes the frame (for RS485: releases DE) by itself,
+     * however late the master polls.
+     *
+     * @return true once the last frame has left the line and the transport is
+     *         listening again
+     */
+    virtual bool txComplete() = 0;
+
+    /**
+     * @brief Line-idle notification
+     *
+     * @return Microseconds since the last byte was sent or received. Transports that
+     *         keep frames apart themselves (TCP) report the line as idle for good.
+     */
+    virtual uint32_t idleTime() = 0;
+
+    /**
+     * @brief Whether the transport delimits frames itself
+     *
+     * A framed transport is read with readFrame() instead of available()/read().
+     */
+    virtual bool framed() { return false; }
+
+    /**
+     * @brief Get the next complete frame
+     *
+     * @param frame Set to the frame bytes, in the transport's own buffer (valid until the
+     *              next call on the transport)
+     * @param length Set to the frame length
+     * @return true if a frame was ready
+     */
+    virtual bool readFrame(const uint8_t** frame, uint16_t* length) { return false; }
+
+    /**
+     * @brief Receive activity of a framed transport
+     *
+     * The master restarts the response timeout on it, so a long reply at a low baud rate
+     * is timed from its last byte rather than from the request.
+     *
+     * @return true if bytes have landed since the last call
+     */
+    virtual bool rxActivity() { return false; }
+};
+
+/**
+ * @brief A UART (Serial1, Serial2 ...) with an optional RS485 DE/RE pin
+ *
+ * The frame is handed to the UART in one go so its bytes stay back to back, which
+ * only blocks for frames longer than the TX FIFO. The end of the frame is estimated
+ * from the baud rate and framing, and a timer alarm releases DE then (once the UART's
+ * busy flag has cleared too, if setUart() named the UART), so a slave that answers
+ * within a millisecond is heard even while the caller is busy elsewhere. Without the
+ * pico SDK, or with no alarm free, write() waits for the frame and releases DE itself.
+ */
+class ModbusRTUSerialTransport : public ModbusRTUTransport {
+public:
+    /**
+     * @param serial Serial port (nullptr leaves the transport unusable)
+     * @param dePin Pin connected to DE/RE of the RS485 transceiver (-1 if not used)
+     */
+    ModbusRTUSerialTransport(HardwareSerial* serial = nullptr, int8_t dePin = -1);
+
+    bool begin(uint32_t baudrate, uint32_t config) override;
+    size_t write(const uint8_t* frame, size_t length) override;
+    int available() override;
+    size_t read(uint8_t* buffer, size_t length) override;
+    bool txComplete() override;
+    uint32_t idleTime() override;
+
+    /**
+     * @brief Get the time one character takes on the line at the current settings
+     */
+    uint32_t byteTime() const { return _byteTime; }
+
+#ifdef MODBUS_DE_ALARM
+    ~ModbusRTUSerialTransport();
+
+    /**
+     * @brief Name the UART behind the serial port, so DE also waits for its busy flag
+     */
+    void setUart(uart_inst_t* uart) { _uart = uart; }
+#endif
+
+private:
+    HardwareSerial* _serial;           ///< Serial port for communication
+    int8_t _dePin;                     ///< DE/RE pin for RS485 control (-1 if not used)
+    uint32_t _byteTime;                ///< Microseconds per character at the current settings
+    volatile uint32_t _txStart;        ///< micros() when the current frame was handed over
+    volatile uint32_t _txTime;         ///< Expected wire time of the current frame incl. DE hold
+    volatile uint32_t _lastByteAt;     ///< micros() of the last byte sent or received
+    volatile bool _sending;            ///< A frame is still on the line (DE asserted)
+#ifdef MODBUS_DE_ALARM
+    uart_inst_t* _uart;                ///< UART behind _serial (nullptr: timing only)
+    alarm_id_t _alarm;                 ///< Last DE release alarm (may have fired already)
+
+    static int64_t _txDoneAlarm(alarm_id_t id, void* user);
+    void _cancelAlarm();
+#endif
+
+    void _releaseLine();
+};
+
+#endif // MODBUS_RTU_TRANSPORT_H
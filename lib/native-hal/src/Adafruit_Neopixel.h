@@ -0,0 +1,32 @@
+/* Description: NeoPixel strip for the host build - keeps the pixel colours for host tools */
+
+#pragma once
+
+#include <Arduino.h>
+#include <vector>
+
+#define NEO_GRB 0x52
+#define NEO_KHZ800 0x0000
+
+class Adafruit_NeoPixel {
+public:
+    Adafruit_NeoPixel(uint16_t count, int16_t pin, uint16_t type) : _pixels(count, 0), _brightness(255), _shows(0) {}
+    void begin() {}
+    void show() { _shows++; }
+    void setBrightness(uint8_t brightness) { _brightness = brightness; }
+    void setPixelColor(uint16_t index, uint32_t colour) { if (index < _pixels.size()) _pixels[index] = colour; }
+    void fill(uint32_t colour, uint16_t first = 0, uint16_t count = 0);
+    uint32_t getPixelColor(uint16_t index) const { return index < _pixels.size() ? _pixels[index] : 0; }
+    uint16_t numPixels() const { return (uint16_t)_pixels.size(); }
+    uint32_t showCount() const { return _shows; }
+
+private:
+    std::vector<uint32_t> _pixels;
+    uint8_t _brightness;
+    uint32_t _shows;
+};
+
+inline void Adafruit_NeoPixel::fill(uint32_t colour, uint16_t first, uint16_t count) {
+    size_t end = count ? std::min<size_t>(first + count, _pixels.size()) : _pixels.size();
+    for (size_t i = first; i < end; i++) _pixels[i] = colour;
+}
@@ -0,0 +1,110 @@
+/* Description: Host build of the Arduino core API used by the gateway (see hal.h) */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef uint8_t pin_size_t;
+typedef uint8_t PinStatus;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define INPUT_PULLDOWN 3
+
+#define PROGMEM
+#define F(string) (string)
+#define __not_in_flash_func(function) function
+
+// Serial configuration (same encoding as the arduino-pico core)
+#define SERIAL_PARITY_EVEN 0x1
+#define SERIAL_PARITY_ODD 0x2
+#define SERIAL_PARITY_NONE 0x3
+#define SERIAL_PARITY_MASK 0xF
+#define SERIAL_STOP_BIT_1 0x10
+#define SERIAL_STOP_BIT_2 0x30
+#define SERIAL_STOP_BIT_MASK 0xF0
+#define SERIAL_DATA_7 0x300
+#define SERIAL_DATA_8 0x400
+#define SERIAL_DATA_MASK 0xF00
+#define SERIAL_8N1 (SERIAL_STOP_BIT_1 | SERIAL_PARITY_NONE | SERIAL_DATA_8)
+#define SERIAL_8N2 (SERIAL_STOP_BIT_2 | SERIAL_PARITY_NONE | SERIAL_DATA_8)
+#define SERIAL_8E1 (SERIAL_STOP_BIT_1 | SERIAL_PARITY_EVEN | SERIAL_DATA_8)
+#define SERIAL_8E2 (SERIAL_STOP_BIT_2 | SERIAL_PARITY_EVEN | SERIAL_DATA_8)
+#define SERIAL_8O1 (SERIAL_STOP_BIT_1 | SERIAL_PARITY_ODD | SERIAL_DATA_8)
+#define SERIAL_8O2 (SERIAL_STOP_BIT_2 | SERIAL_PARITY_ODD | SERIAL_DATA_8)
+
+#ifdef __cplusplus
+
+#include <algorithm>
+
+// Mixed type min/max, as in ArduinoCore-API
+template <class T, class L>
+auto min(const T& a, const L& b) -> decltype((b < a) ? b : a) { return (b < a) ? b : a; }
+template <class T, class L>
+auto max(const T& a, const L& b) -> decltype((b < a) ? b : a) { return (a < b) ? b : a; }
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// Time (virtual unless --realtime, see hal.h)
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// GPIO
+void pinMode(pin_size_t pin, int mode);
+void digitalWrite(pin_size_t pin, int level);
+int digitalRead(pin_size_t pin);
+
+// Random numbers - seeded identically on every run
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+size_t strlcpy(char* dst, const char* src, size_t size);
+#endif
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "IPAddress.h"
+#include "HardwareSerial.h"
+
+// Chip services the gateway uses from the arduino-pico core
+class RP2040 {
+public:
+    uint32_t getFreeHeap();
+    uint32_t getTotalHeap();
+    uint32_t getUsedHeap() { return getTotalHeap() - getFreeHeap(); }
+    int cpuid();
+    uint32_t hwrand32();
+    uint32_t f_cpu() { return 200000000; }
+    [[noreturn]] void restart();
+    [[noreturn]] void reboot() { restart(); }
+};
+
+extern RP2040 rp2040;
+
+int get_core_num();
+
+// Firmware entry points
+void setup();
+void loop();
+void setup1();
+void loop1();
+
+#endif
@@ -0,0 +1,174 @@
+#include "Arduino.h"
+#include "hal.h"
+#include "hardware/uart.h"
+#include "hardware/dma.h"
+#include <poll.h>
+#include <unistd.h>
+
+static uart_inst_t uartInstances[2];
+uart_inst_t* const uart0 = &uartInstances[0];
+uart_inst_t* const uart1 = &uartInstances[1];
+
+HardwareSerial Serial(-1);
+HardwareSerial Serial1(0);
+HardwareSerial Serial2(1);
+
+HardwareSerial::HardwareSerial(int8_t uart)
+    : _uart(uart), _baud(0), _config(SERIAL_8N1), _fifoSize(32), _overflow(false), _txIdleAt(0) {}
+
+void HardwareSerial::begin(unsigned long baud, uint16_t config) {
+    _baud = baud;
+    _config = config;
+    _pending.clear();
+    _fifo.clear();
+    _overflow = false;
+}
+
+void HardwareSerial::end() {
+    _baud = 0;
+    _pending.clear();
+    _fifo.clear();
+}
+
+bool HardwareSerial::setFIFOSize(size_t size) {
+    if (size == 0) return false;
+    _fifoSize = size;
+    return true;
+}
+
+bool HardwareSerial::overflow() {
+    bool overflowed = _overflow;
+    _overflow = false;
+    return overflowed;
+}
+
+uint32_t HardwareSerial::byteTimeUs() const {
+    if (_baud == 0) return 0;
+    uint32_t bits = 1 + ((_config & SERIAL_DATA_MASK) == SERIAL_DATA_7 ? 7 : 8);
+    if ((_config & SERIAL_PARITY_MASK) != SERIAL_PARITY_NONE) bits++;
+    bits += (_config & SERIAL_STOP_BIT_MASK) == SERIAL_STOP_BIT_2 ? 2 : 1;
+    return (bits * 1000000UL + _baud - 1) / _baud;
+}
+
+void HardwareSerial::receive(uint8_t c, uint64_t atUs, uint32_t errors) {
+    rxByte_t byte = {atUs, c, errors};
+    auto position = _pending.end();
+    while (position != _pending.begin() && (position - 1)->atUs > atUs) position--;
+    _pending.insert(position, byte);
+
+    // Delivered at arrival, so a DMA channel fills without the firmware calling in
+    halSchedule(atUs, [this] { receiveDue(); });
+}
+
+// Moves bytes whose stop bit has ended into the FIFO, or to a DMA channel paced by RX DREQ
+void HardwareSerial::receiveDue() {
+    if (_uart < 0) {
+        // Console input
+        struct pollfd input = {STDIN_FILENO, POLLIN, 0};
+        while (_fifo.size() < _fifoSize && poll(&input, 1, 0) > 0 && (input.revents & POLLIN)) {
+            uint8_t c;
+            if (::read(STDIN_FILENO, &c, 1) != 1) break;
+            _fifo.push_back(c);
+        }
+        return;
+    }
+    uint64_t now = halNowUs();
+    uart_inst_t* uart = _uart == 0 ? uart0 : uart1;
+    uart_hw_t* hw = uart_get_hw(uart);
+    unsigned int dreq = uart_get_dreq(uart, false);
+
+    // A channel started since the last delivery first drains what waits in the FIFO
+    while (!_fifo.empty() && halDmaTransfer(dreq, &hw->dr, _fifo.front())) _fifo.pop_front();
+
+    while (!_pending.empty() && _pending.front().atUs <= now) {
+        const rxByte_t& byte = _pending.front();
+        hw->ris = hw->ris | byte.errors;
+        if (_baud == 0) {
+            // Not listening
+        } else if (_fifo.empty() && halDmaTransfer(dreq, &hw->dr, byte.value)) {
+            // Taken by DMA
+        } else if (_fifo.size() < _fifoSize) {
+            _fifo.push_back(byte.value);
+        } else {
+            _overflow = true;
+            hw->ris = hw->ris | UART_UARTRIS_OERIS_BITS;
+        }
+        _pending.pop_front();
+    }
+}
+
+int HardwareSerial::available() {
+    receiveDue();
+    return (int)_fifo.size();
+}
+
+int HardwareSerial::peek() {
+    receiveDue();
+    return _fifo.empty() ? -1 : _fifo.front();
+}
+
+int HardwareSerial::read() {
+    receiveDue();
+    if (_fifo.empty()) return -1;
+    uint8_t c = _fifo.front();
+    _fifo.pop_front();
+    return c;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    if (_uart < 0) {
+        if (!halGetOptions().quiet) {
+            fputc(c, stdout);
+            if (c == '\n') fflush(stdout);
+        }
+        return 1;
+    }
+    if (_baud == 0) return 0;
+
+    // Blocks while the TX FIFO is full, then the byte goes out after the ones ahead of it
+    uint32_t byteTime = byteTimeUs();
+    uint64_t fifoSpaceAt = _txIdleAt > (uint64_t)HAL_UART_TX_FIFO * byteTime ? _txIdleAt - (uint64_t)HAL_UART_TX_FIFO * byteTime : 0;
+    if (fifoSpaceAt > halNowUs()) halSleepUntilUs(fifoSpaceAt);
+    uint64_t start = std::max(halNowUs(), _txIdleAt);
+    _txIdleAt = start + byteTime;
+    if (_onTransmit) _onTransmit(c, _txIdleAt);
+
+    // BUSY stays set until the stop bit of the last byte written has gone
+    uart_hw_t* hw = uart_get_hw(_uart == 0 ? uart0 : uart1);
+    hw->fr = hw->fr | UART_UARTFR_BUSY_BITS;
+    uint64_t idleAt = _txIdleAt;
+    halSchedule(idleAt, [this, hw, idleAt]() {
+        if (_txIdleAt == idleAt) hw->fr = hw->fr & ~UART_UARTFR_BUSY_BITS;
+    });
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (_uart < 0) {
+        if (!halGetOptions().quiet) {
+            fwrite(buffer, 1, size, stdout);
+            fflush(stdout);
+        }
+        return size;
+    }
+    size_t written = 0;
+    while (written < size && write(buffer[written])) written++;
+    return written;
+}
+
+int HardwareSerial::availableForWrite() {
+    if (_uart < 0) return 256;
+    uint32_t byteTime = byteTimeUs();
+    uint64_t now = halNowUs();
+    if (byteTime == 0 || _txIdleAt <= now) return HAL_UART_TX_FIFO;
+    uint64_t queued = (_txIdleAt - now + byteTime - 1) / byteTime;
+    return queued >= HAL_UART_TX_FIFO ? 0 : (int)(HAL_UART_TX_FIFO - queued);
+}
+
+void HardwareSerial::flush() {
+    if (_uart < 0) {
+        fflush(stdout);
+        return;
+    }
+    if (_txIdleAt > halNowUs()) halSleepUntilUs(_txIdleAt);
+}
@@ -0,0 +1,69 @@
+/* Description: Serial ports for the host build
+ * Serial is the console: stdout, and stdin when input is waiting. Serial1 and Serial2 are
+ * virtual UARTs (uart0 and uart1). Written bytes leave one byte time apart at the configured
+ * baud rate and framing, and are handed to the transmit handler with the time their stop bit
+ * ends. The host side schedules incoming bytes with receive(). Arrived bytes wait in a FIFO
+ * of setFIFOSize() bytes (32 by default, as the arduino-pico core). A byte that arrives at a
+ * full FIFO is lost and flagged as an overrun, as on the chip. A DMA channel paced by the
+ * UART's RX DREQ (hardware/dma.h) takes the bytes instead, as they arrive.
+ */
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include "Stream.h"
+
+#define HAL_UART_TX_FIFO 32
+
+class HardwareSerial : public Stream {
+public:
+    explicit HardwareSerial(int8_t uart);   // -1 = console
+    void begin(unsigned long baud, uint16_t config = SERIAL_8N1);
+    void end();
+    void setRX(pin_size_t) {}
+    void setTX(pin_size_t) {}
+    bool setFIFOSize(size_t size);
+    bool overflow();                        // Clears the flag
+    operator bool() { return true; }
+
+    int available() override;
+    int peek() override;
+    int read() override;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int availableForWrite() override;
+    void flush() override;                  // Waits until the last stop bit has gone
+
+    // Host side
+    unsigned long getBaudRate() const { return _baud; }
+    uint16_t getConfig() const { return _config; }
+    uint32_t byteTimeUs() const;            // Start, data, parity and stop bits
+    uint64_t txIdleAtUs() const { return _txIdleAt; }
+    void onTransmit(std::function<void(uint8_t c, uint64_t endUs)> handler) { _onTransmit = handler; }
+    void receive(uint8_t c, uint64_t atUs, uint32_t errors = 0);  // errors: UART_UARTRIS_*_BITS
+
+private:
+    struct rxByte_t {
+        uint64_t atUs;                      // End of the stop bit
+        uint8_t value;
+        uint32_t errors;
+    };
+
+    int8_t _uart;
+    unsigned long _baud;
+    uint16_t _config;
+    size_t _fifoSize;
+    bool _overflow;
+    uint64_t _txIdleAt;
+    std::deque<rxByte_t> _pending;          // Still on the wire
+    std::deque<uint8_t> _fifo;
+    std::function<void(uint8_t, uint64_t)> _onTransmit;
+
+    void receiveDue();
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
@@ -0,0 +1,18 @@
+#include "Arduino.h"
+
+bool IPAddress::fromString(const char* address) {
+    unsigned int octets[4];
+    char tail;
+    if (sscanf(address, "%u.%u.%u.%u%c", &octets[0], &octets[1], &octets[2], &octets[3], &tail) != 4) return false;
+    for (int i = 0; i < 4; i++) {
+        if (octets[i] > 255) return false;
+    }
+    *this = IPAddress(octets[0], octets[1], octets[2], octets[3]);
+    return true;
+}
+
+String IPAddress::toString() const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+    return String(buffer);
+}
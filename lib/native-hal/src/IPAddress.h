@@ -0,0 +1,26 @@
+/* Description: Arduino IPAddress (IPv4 only) for the host build */
+
+#pragma once
+
+#include <stdint.h>
+#include "WString.h"
+
+class IPAddress {
+public:
+    IPAddress() : _address(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _address(a | (b << 8) | (c << 16) | ((uint32_t)d << 24)) {}
+    IPAddress(uint32_t address) : _address(address) {}     // Network byte order, as lwIP
+
+    bool fromString(const char* address);
+    bool fromString(const String& address) { return fromString(address.c_str()); }
+    String toString() const;
+    bool isSet() const { return _address != 0; }
+
+    operator uint32_t() const { return _address; }
+    bool operator==(const IPAddress& other) const { return _address == other._address; }
+    bool operator!=(const IPAddress& other) const { return _address != other._address; }
+    uint8_t operator[](int index) const { return (_address >> (index * 8)) & 0xFF; }
+
+private:
+    uint32_t _address;
+};
@@ -0,0 +1,117 @@
+#include "LittleFS.h"
+#include "hal.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+FS LittleFS;
+
+static std::string flashPath(const char* path) {
+    return halFsPath("littlefs", path);
+}
+
+// File -------------------------------------------------------------------->
+
+size_t File::size() const {
+    struct stat info;
+    if (!_file || fstat(fileno(_file.get()), &info) != 0) return 0;
+    return info.st_size;
+}
+
+size_t File::position() const {
+    return _file ? (size_t)ftell(_file.get()) : 0;
+}
+
+bool File::seek(uint32_t position, SeekMode mode) {
+    static const int whence[] = {SEEK_SET, SEEK_CUR, SEEK_END};
+    return _file && fseek(_file.get(), position, whence[mode]) == 0;
+}
+
+int File::available() {
+    return _file ? (int)(size() - position()) : 0;
+}
+
+int File::read() {
+    return _file ? fgetc(_file.get()) : -1;
+}
+
+int File::peek() {
+    if (!_file) return -1;
+    int c = fgetc(_file.get());
+    if (c != EOF) ungetc(c, _file.get());
+    return c;
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+    return _file ? fread(buffer, 1, size, _file.get()) : 0;
+}
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+    return _file ? fwrite(buffer, 1, size, _file.get()) : 0;
+}
+
+// FS ---------------------------------------------------------------------->
+
+bool FS::begin() {
+    return halMakeDirs(flashPath("/"));
+}
+
+bool FS::format() {
+    std::string root = flashPath("/");
+    std::string command = "rm -rf '" + root + "'";
+    if (system(command.c_str()) != 0) return false;
+    return begin();
+}
+
+bool FS::info(FSInfo& info) {
+    info.totalBytes = HAL_LITTLEFS_TOTAL_BYTES;
+    info.usedBytes = 0;
+    info.blockSize = 4096;
+    info.pageSize = 256;
+    info.maxOpenFiles = 16;
+    info.maxPathLength = 255;
+
+    // Whole blocks per file, like the flash file system
+    DIR* dir = opendir(flashPath("/").c_str());
+    if (!dir) return false;
+    while (struct dirent* entry = readdir(dir)) {
+        struct stat stats;
+        std::string path = flashPath("/") + "/" + entry->d_name;
+        if (stat(path.c_str(), &stats) == 0 && S_ISREG(stats.st_mode)) {
+            info.usedBytes += (stats.st_size + info.blockSize - 1) / info.blockSize * info.blockSize;
+        }
+    }
+    closedir(dir);
+    return true;
+}
+
+File FS::open(const char* path, const char* mode) {
+    File file;
+    FILE* handle = fopen(flashPath(path).c_str(), mode);
+    if (!handle) return file;
+    file._file = std::shared_ptr<FILE>(handle, fclose);
+    const char* slash = strrchr(path, '/');
+    file._name = slash ? slash + 1 : path;
+    return file;
+}
+
+bool FS::exists(const char* path) {
+    struct stat info;
+    return stat(flashPath(path).c_str(), &info) == 0;
+}
+
+bool FS::remove(const char* path) {
+    return unlink(flashPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* oldPath, const char* newPath) {
+    return ::rename(flashPath(oldPath).c_str(), flashPath(newPath).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+    return ::mkdir(flashPath(path).c_str(), 0755) == 0;
+}
+
+bool FS::rmdir(const char* path) {
+    return ::rmdir(flashPath(path).c_str()) == 0;
+}
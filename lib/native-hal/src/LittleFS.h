@@ -0,0 +1,73 @@
+/* Description: LittleFS for the host build
+ * The flash file system is the directory <fs root>/littlefs. Files are opened with the
+ * Arduino FS modes ("r", "w", "a" and their "+" forms); rename replaces the target in one
+ * step, as LittleFS does.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <memory>
+#include <stdio.h>
+
+#define HAL_LITTLEFS_TOTAL_BYTES (128 * 1024)        // board_build.filesystem_size
+
+enum SeekMode {
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+struct FSInfo {
+    size_t totalBytes;
+    size_t usedBytes;
+    size_t blockSize;
+    size_t pageSize;
+    size_t maxOpenFiles;
+    size_t maxPathLength;
+};
+
+class File : public Stream {
+public:
+    File() = default;
+
+    operator bool() const { return (bool)_file; }
+    void close() { _file.reset(); }
+    size_t size() const;
+    size_t position() const;
+    bool seek(uint32_t position, SeekMode mode = SeekSet);
+    const char* name() const { return _name.c_str(); }
+    void flush() override {}
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t read(uint8_t* buffer, size_t size);
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+
+private:
+    friend class FS;
+    std::shared_ptr<FILE> _file;
+    String _name;
+};
+
+class FS {
+public:
+    bool begin();
+    void end() {}
+    bool format();
+    bool info(FSInfo& info);
+    File open(const char* path, const char* mode);
+    File open(const String& path, const char* mode) { return open(path.c_str(), mode); }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* oldPath, const char* newPath);
+    bool rename(const String& oldPath, const String& newPath) { return rename(oldPath.c_str(), newPath.c_str()); }
+    bool mkdir(const char* path);
+    bool rmdir(const char* path);
+};
+
+extern FS LittleFS;
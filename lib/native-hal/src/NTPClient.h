@@ -0,0 +1,32 @@
+/* Description: NTP client for the host build
+ * No NTP traffic is sent. With --realtime the time is the host's; otherwise it is a fixed
+ * epoch plus virtual time, so timestamps in logs and records repeat from run to run.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include "WiFiUdp.h"
+#include "hal.h"
+
+#define HAL_VIRTUAL_EPOCH 1767225600UL  // 2026-01-01 00:00:00 UTC
+
+class NTPClient {
+public:
+    NTPClient(WiFiUDP& udp, const char* server = "pool.ntp.org", long offset = 0, unsigned long interval = 60000)
+        : _offset(offset) {}
+    void begin() {}
+    void end() {}
+    bool update() { return true; }
+    bool forceUpdate() { return true; }
+    bool isTimeSet() const { return true; }
+    unsigned long getEpochTime() const {
+        unsigned long now = halGetOptions().realtime ? (unsigned long)time(nullptr) : HAL_VIRTUAL_EPOCH + (unsigned long)(halNowUs() / 1000000);
+        return now + _offset;
+    }
+    void setTimeOffset(long offset) { _offset = offset; }
+    void setPoolServerName(const char* server) {}
+
+private:
+    long _offset;
+};
@@ -0,0 +1,26 @@
+#include "Arduino.h"
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t written = 0;
+    while (size--) {
+        if (write(*buffer++) == 0) break;
+        written++;
+    }
+    return written;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char stackBuffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(stackBuffer, sizeof(stackBuffer), format, args);
+    va_end(args);
+    if (length < 0) return 0;
+    if ((size_t)length < sizeof(stackBuffer)) return write((const uint8_t*)stackBuffer, length);
+
+    std::string buffer(length + 1, '\0');
+    va_start(args, format);
+    vsnprintf(&buffer[0], buffer.size(), format, args);
+    va_end(args);
+    return write((const uint8_t*)buffer.data(), length);
+}
@@ -0,0 +1,18 @@
+/* Description: SPI pin setup for the host build (there is no SPI bus) */
+
+#pragma once
+
+#include <Arduino.h>
+
+class SPIClassRP2040 {
+public:
+    bool setMISO(pin_size_t) { return true; }
+    bool setMOSI(pin_size_t) { return true; }
+    bool setSCK(pin_size_t) { return true; }
+    bool setCS(pin_size_t) { return true; }
+    void begin() {}
+    void end() {}
+};
+
+extern SPIClassRP2040 SPI;
+extern SPIClassRP2040 SPI1;
@@ -0,0 +1,234 @@
+#include "SdFat.h"
+#include "hal.h"
+#include <algorithm>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+void (*FsDateTime::_callback)(uint16_t* date, uint16_t* time) = nullptr;
+
+static std::string sdPath(const char* path) {
+    return halFsPath("sd", path);
+}
+
+// FsFile ------------------------------------------------------------------>
+
+FsFile::handle_t::~handle_t() {
+    ::close(fd);
+    if (!written || !FsDateTime::_callback) return;
+
+    // Stamp the modify time from the firmware's clock, as SdFat does on sync
+    uint16_t date, time;
+    FsDateTime::_callback(&date, &time);
+    struct tm stamp = {};
+    stamp.tm_year = FS_YEAR(date) - 1900;
+    stamp.tm_mon = FS_MONTH(date) - 1;
+    stamp.tm_mday = FS_DAY(date);
+    stamp.tm_hour = FS_HOUR(time);
+    stamp.tm_min = FS_MINUTE(time);
+    stamp.tm_sec = FS_SECOND(time);
+    struct timespec times[2];
+    times[0].tv_sec = times[1].tv_sec = timegm(&stamp);
+    times[0].tv_nsec = times[1].tv_nsec = 0;
+    utimensat(AT_FDCWD, path.c_str(), times, 0);
+}
+
+bool FsFile::openHost(const std::string& path, const std::string& name, oflag_t flags) {
+    close();
+    struct stat info;
+    bool found = stat(path.c_str(), &info) == 0;
+
+    if (found && S_ISDIR(info.st_mode)) {
+        DIR* dir = opendir(path.c_str());
+        if (!dir) return false;
+        auto entries = std::make_shared<std::vector<std::string>>();
+        while (struct dirent* entry = readdir(dir)) {
+            if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) entries->push_back(entry->d_name);
+        }
+        closedir(dir);
+        std::sort(entries->begin(), entries->end());
+        _entries = entries;
+    } else {
+        if (!found && !(flags & O_CREAT)) return false;
+        int fd = ::open(path.c_str(), flags & ~(O_AT_END | O_APPEND), 0644);
+        if (fd < 0) return false;
+        _handle = std::make_shared<handle_t>();
+        _handle->fd = fd;
+        _handle->path = path;
+        _handle->written = false;
+        _append = flags & O_APPEND;
+        if (flags & O_AT_END) _position = fileSize();
+    }
+    _path = path;
+    _name = name;
+    return true;
+}
+
+bool FsFile::open(const char* path, oflag_t flags) {
+    const char* slash = strrchr(path, '/');
+    return openHost(sdPath(path), slash ? slash + 1 : path, flags);
+}
+
+bool FsFile::open(FsFile* dir, const char* name, oflag_t flags) {
+    if (!dir || !dir->isDirectory()) return false;
+    return openHost(dir->_path + "/" + name, name, flags);
+}
+
+bool FsFile::open(FsFile* dir, uint32_t index, oflag_t flags) {
+    if (!dir || !dir->isDirectory() || index >= dir->_entries->size()) return false;
+    if (!open(dir, (*dir->_entries)[index].c_str(), flags)) return false;
+    _dirIndex = index;
+    return true;
+}
+
+bool FsFile::openNext(FsFile* dir, oflag_t flags) {
+    if (!dir || !dir->isDirectory()) return false;
+    // Entries removed since the snapshot are skipped
+    while (dir->_next < dir->_entries->size()) {
+        uint32_t index = dir->_next++;
+        if (open(dir, index, flags)) return true;
+    }
+    close();
+    return false;
+}
+
+bool FsFile::close() {
+    bool wasOpen = isOpen();
+    _handle.reset();
+    _entries.reset();
+    _position = 0;
+    _next = 0;
+    _append = false;
+    return wasOpen;
+}
+
+size_t FsFile::getName(char* name, size_t size) {
+    if (!isOpen() || size == 0) return 0;
+    size_t length = std::min(_name.size(), size - 1);
+    memcpy(name, _name.c_str(), length);
+    name[length] = '\0';
+    return length;
+}
+
+bool FsFile::getModifyDateTime(uint16_t* date, uint16_t* time) {
+    struct stat info;
+    if (!isOpen() || stat(_path.c_str(), &info) != 0) return false;
+    struct tm stamp;
+    gmtime_r(&info.st_mtime, &stamp);
+    int year = std::max(stamp.tm_year + 1900, 1980);
+    *date = FS_DATE(year, stamp.tm_mon + 1, stamp.tm_mday);
+    *time = FS_TIME(stamp.tm_hour, stamp.tm_min, stamp.tm_sec);
+    return true;
+}
+
+bool FsFile::rewindDirectory() {
+    if (!isDirectory()) return false;
+    _next = 0;
+    return true;
+}
+
+uint64_t FsFile::fileSize() const {
+    struct stat info;
+    if (!_handle || fstat(_handle->fd, &info) != 0) return 0;
+    return info.st_size;
+}
+
+bool FsFile::seekSet(uint64_t position) {
+    if (!isFile() || position > fileSize()) return false;
+    _position = position;
+    return true;
+}
+
+int FsFile::available() {
+    uint64_t left = isFile() ? fileSize() - std::min(_position, fileSize()) : 0;
+    return left > INT32_MAX ? INT32_MAX : (int)left;
+}
+
+int FsFile::read(void* buffer, size_t count) {
+    if (!isFile()) return -1;
+    ssize_t result = pread(_handle->fd, buffer, count, _position);
+    if (result < 0) return -1;
+    _position += result;
+    return (int)result;
+}
+
+int FsFile::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int FsFile::peek() {
+    uint8_t c;
+    if (!isFile() || pread(_handle->fd, &c, 1, _position) != 1) return -1;
+    return c;
+}
+
+size_t FsFile::write(const uint8_t* buffer, size_t count) {
+    if (!isFile()) return 0;
+    if (halGetOptions().sdWriteUs) halSleepUs(halGetOptions().sdWriteUs);  // The writing core is held meanwhile
+    if (_append) _position = fileSize();
+    ssize_t result = pwrite(_handle->fd, buffer, count, _position);
+    if (result <= 0) return 0;
+    _position += result;
+    _handle->written = true;
+    return result;
+}
+
+// Card and volume --------------------------------------------------------->
+
+uint32_t SdCard::sectorCount() {
+    struct statvfs info;
+    if (statvfs(sdPath("/").c_str(), &info) != 0) return 0;
+    uint64_t sectors = (uint64_t)info.f_blocks * info.f_frsize / 512;
+    return sectors > UINT32_MAX ? UINT32_MAX : (uint32_t)sectors;
+}
+
+uint32_t FsVolume::clusterCount() {
+    struct statvfs info;
+    if (statvfs(sdPath("/").c_str(), &info) != 0) return 0;
+    uint64_t clusters = (uint64_t)info.f_blocks * info.f_frsize / HAL_SD_BYTES_PER_CLUSTER;
+    return clusters > UINT32_MAX ? UINT32_MAX : (uint32_t)clusters;
+}
+
+// SdFs -------------------------------------------------------------------->
+
+bool SdFs::mount() {
+    return halMakeDirs(sdPath("/"));
+}
+
+int32_t SdFs::freeClusterCount() {
+    struct statvfs info;
+    if (statvfs(sdPath("/").c_str(), &info) != 0) return -1;
+    uint64_t clusters = (uint64_t)info.f_bavail * info.f_frsize / HAL_SD_BYTES_PER_CLUSTER;
+    return clusters > INT32_MAX ? INT32_MAX : (int32_t)clusters;
+}
+
+FsFile SdFs::open(const char* path, oflag_t flags) {
+    FsFile file;
+    file.open(path, flags);
+    return file;
+}
+
+bool SdFs::exists(const char* path) {
+    struct stat info;
+    return stat(sdPath(path).c_str(), &info) == 0;
+}
+
+bool SdFs::mkdir(const char* path, bool parents) {
+    std::string hostPath = sdPath(path);
+    if (parents) return halMakeDirs(hostPath);
+    return ::mkdir(hostPath.c_str(), 0755) == 0;
+}
+
+bool SdFs::remove(const char* path) {
+    return unlink(sdPath(path).c_str()) == 0;
+}
+
+bool SdFs::rmdir(const char* path) {
+    return ::rmdir(sdPath(path).c_str()) == 0;
+}
+
+bool SdFs::rename(const char* oldPath, const char* newPath) {
+    return ::rename(sdPath(oldPath).c_str(), sdPath(newPath).c_str()) == 0;
+}
@@ -0,0 +1,160 @@
+/* Description: SD card for the host build
+ * The card is the directory <fs root>/sd. FsFile follows SdFat's copy semantics: copies share
+ * the open file but each has its own position and open state, so a copy handed to a send job
+ * keeps working after the original is closed. Opening a directory takes a snapshot of its
+ * entries (sorted by name) for openNext() and dirIndex(). Files written through FsFile get
+ * their modify time from the FsDateTime callback, as SdFat does. With --sd-write-us every
+ * write holds the calling core for that long, as a slow card does.
+ *
+ * The volume reports itself as exFAT, so the firmware takes freeClusterCount() (statvfs of
+ * the host file system) instead of scanning a FAT.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+typedef int oflag_t;
+
+#define O_WRITE O_WRONLY
+#define O_AT_END (1 << 30)          // Not a Linux flag; handled here
+
+#define DEDICATED_SPI 1
+#define SHARED_SPI 0
+#define SD_SCK_MHZ(mhz) (1000000UL * (mhz))
+
+// FAT date and time encoding
+#define FS_DATE(year, month, day) ((uint16_t)((((year) - 1980) << 9) | ((month) << 5) | (day)))
+#define FS_TIME(hour, minute, second) ((uint16_t)(((hour) << 11) | ((minute) << 5) | ((second) >> 1)))
+#define FS_YEAR(date) (1980 + ((date) >> 9))
+#define FS_MONTH(date) (((date) >> 5) & 0x0F)
+#define FS_DAY(date) ((date) & 0x1F)
+#define FS_HOUR(time) ((time) >> 11)
+#define FS_MINUTE(time) (((time) >> 5) & 0x3F)
+#define FS_SECOND(time) (2 * ((time) & 0x1F))
+
+#define HAL_SD_BYTES_PER_CLUSTER 32768
+
+struct SdioConfig {
+    SdioConfig(pin_size_t clk, pin_size_t cmd, pin_size_t d0) {}
+};
+
+struct SdSpiConfig {
+    SdSpiConfig(pin_size_t cs, uint8_t options, uint32_t maxSck, SPIClassRP2040* spi = &SPI) {}
+};
+
+class FsDateTime {
+public:
+    static void setCallback(void (*callback)(uint16_t* date, uint16_t* time)) { _callback = callback; }
+    static void clearCallback() { _callback = nullptr; }
+    static void (*_callback)(uint16_t* date, uint16_t* time);
+};
+
+class FsFile : public Stream {
+public:
+    FsFile() = default;
+
+    bool open(const char* path, oflag_t flags = O_RDONLY);
+    bool open(FsFile* dir, const char* name, oflag_t flags = O_RDONLY);
+    bool open(FsFile* dir, uint32_t index, oflag_t flags = O_RDONLY);
+    bool openNext(FsFile* dir, oflag_t flags = O_RDONLY);
+    bool close();
+    bool isOpen() const { return _handle || _entries; }
+    operator bool() const { return isOpen(); }
+    bool isDirectory() const { return (bool)_entries; }
+    bool isFile() const { return (bool)_handle; }
+    bool isHidden() const { return false; }
+
+    size_t getName(char* name, size_t size);
+    uint32_t dirIndex() const { return _dirIndex; }
+    bool getModifyDateTime(uint16_t* date, uint16_t* time);
+    bool rewindDirectory();
+
+    uint64_t fileSize() const;
+    uint64_t size() const { return fileSize(); }
+    uint64_t curPosition() const { return _position; }
+    uint32_t firstSector() const { return 0; }                       // No cluster chains on the host
+    bool seekSet(uint64_t position);
+    bool seekEnd(int64_t offset = 0) { return seekSet(fileSize() + offset); }
+    bool sync() { return isFile(); }
+    bool preAllocate(uint64_t length) { return isFile(); }
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    int read(void* buffer, size_t count);
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t count) override;
+    size_t write(const void* buffer, size_t count) { return write((const uint8_t*)buffer, count); }
+    size_t write(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+
+private:
+    struct handle_t {
+        int fd;
+        std::string path;
+        bool written;
+        ~handle_t();
+    };
+
+    std::shared_ptr<handle_t> _handle;                              // Open file
+    std::shared_ptr<const std::vector<std::string>> _entries;       // Open directory snapshot
+    std::string _path;                                              // Host path
+    std::string _name;
+    uint64_t _position = 0;
+    uint32_t _next = 0;                                             // Directory cursor
+    uint32_t _dirIndex = 0;
+    bool _append = false;
+
+    bool openHost(const std::string& path, const std::string& name, oflag_t flags);
+};
+
+class SdCard {
+public:
+    uint8_t errorCode() const { return 0; }
+    uint8_t errorData() const { return 0; }
+    uint32_t sectorCount();
+    bool readSector(uint32_t sector, uint8_t* buffer) { return false; }     // No raw sectors on the host
+    bool readSectors(uint32_t sector, uint8_t* buffer, size_t count) { return false; }
+};
+
+class FsVolume {
+public:
+    uint8_t fatType() const { return 64; }        // exFAT
+    uint32_t bytesPerCluster() const { return HAL_SD_BYTES_PER_CLUSTER; }
+    uint32_t bytesPerSector() const { return 512; }
+    uint32_t sectorsPerCluster() const { return HAL_SD_BYTES_PER_CLUSTER / 512; }
+    uint8_t sectorsPerClusterShift() const { return 6; }
+    uint32_t clusterCount();
+    uint32_t fatStartSector() const { return 0; }
+    uint32_t dataStartSector() const { return 0; }
+};
+
+class SdFs {
+public:
+    bool begin(SdioConfig config) { return mount(); }
+    bool begin(SdSpiConfig config) { return mount(); }
+    void end() {}
+    SdCard* card() { return &_card; }
+    FsVolume* vol() { return &_volume; }
+    uint8_t fatType() const { return _volume.fatType(); }
+    int32_t freeClusterCount();
+
+    FsFile open(const char* path, oflag_t flags = O_RDONLY);
+    FsFile open(const String& path, oflag_t flags = O_RDONLY) { return open(path.c_str(), flags); }
+    bool exists(const char* path);
+    bool mkdir(const char* path, bool parents = true);
+    bool remove(const char* path);
+    bool rmdir(const char* path);
+    bool rename(const char* oldPath, const char* newPath);
+
+private:
+    SdCard _card;
+    FsVolume _volume;
+
+    bool mount();
+};
@@ -0,0 +1,59 @@
+/* Description: W5500 Ethernet interface for the host build
+ * The link is always up and the firmware's sockets are host sockets (WiFiServer.h), so
+ * the interface only reports addresses: 127.0.0.1, or whatever config() was given.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "WiFiServer.h"
+
+enum EthernetLinkStatus {
+    Unknown,
+    LinkON,
+    LinkOFF
+};
+
+enum wl_status_t {
+    WL_IDLE_STATUS = 0,
+    WL_CONNECTED = 3,
+    WL_DISCONNECTED = 6
+};
+
+class Wiznet5500lwIP {
+public:
+    Wiznet5500lwIP(int8_t cs, SPIClassRP2040& spi, int8_t intr)
+        : _ip(127, 0, 0, 1), _gateway(127, 0, 0, 1), _subnet(255, 0, 0, 0), _dns(127, 0, 0, 1), _begun(false) {}
+
+    bool begin() { _begun = true; return true; }
+    void end() { _begun = false; }
+    bool config(IPAddress ip, IPAddress gateway = IPAddress(), IPAddress subnet = IPAddress(), IPAddress dns = IPAddress()) {
+        _ip = ip;
+        _gateway = gateway;
+        _subnet = subnet;
+        _dns = dns;
+        return true;
+    }
+    EthernetLinkStatus linkStatus() { return LinkON; }
+    wl_status_t status() { return _begun ? WL_CONNECTED : WL_DISCONNECTED; }
+    bool connected() { return _begun; }
+    IPAddress localIP() { return _ip; }
+    IPAddress gatewayIP() { return _gateway; }
+    IPAddress subnetMask() { return _subnet; }
+    IPAddress dnsIP(int n = 0) { return _dns; }
+    void hostname(const char* name) {}
+    uint8_t* macAddress(uint8_t* mac) {
+        static const uint8_t hostMac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};  // Locally administered
+        memcpy(mac, hostMac, 6);
+        return mac;
+    }
+    void setSPISpeed(int speed) {}
+
+private:
+    IPAddress _ip;
+    IPAddress _gateway;
+    IPAddress _subnet;
+    IPAddress _dns;
+    bool _begun;
+};
@@ -0,0 +1,112 @@
+#include "Arduino.h"
+
+static std::string formatInteger(unsigned long long value, bool negative, unsigned char base) {
+    if (base < 2 || base > 36) base = 10;
+    char buffer[72];
+    char* p = buffer + sizeof(buffer);
+    *--p = '\0';
+    do {
+        uint8_t digit = value % base;
+        *--p = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        value /= base;
+    } while (value);
+    if (negative) *--p = '-';
+    return p;
+}
+
+static std::string formatSigned(long long value, unsigned char base) {
+    // Like the Arduino core, only base 10 prints a sign
+    if (base == 10 && value < 0) return formatInteger(0ULL - (unsigned long long)value, true, base);
+    return formatInteger((unsigned long long)value, false, base);
+}
+
+String::String(unsigned char value, unsigned char base) : _s(formatInteger(value, false, base)) {}
+String::String(int value, unsigned char base) : _s(formatSigned(value, base)) {}
+String::String(unsigned int value, unsigned char base) : _s(formatInteger(value, false, base)) {}
+String::String(long value, unsigned char base) : _s(formatSigned(value, base)) {}
+String::String(unsigned long value, unsigned char base) : _s(formatInteger(value, false, base)) {}
+String::String(long long value, unsigned char base) : _s(formatSigned(value, base)) {}
+String::String(unsigned long long value, unsigned char base) : _s(formatInteger(value, false, base)) {}
+String::String(float value, unsigned char decimals) : String((double)value, decimals) {}
+
+String::String(double value, unsigned char decimals) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+    _s = buffer;
+}
+
+bool String::equalsIgnoreCase(const String& other) const {
+    if (_s.size() != other._s.size()) return false;
+    for (size_t i = 0; i < _s.size(); i++) {
+        if (tolower((unsigned char)_s[i]) != tolower((unsigned char)other._s[i])) return false;
+    }
+    return true;
+}
+
+bool String::endsWith(const String& suffix) const {
+    return _s.size() >= suffix._s.size() &&
+           _s.compare(_s.size() - suffix._s.size(), suffix._s.size(), suffix._s) == 0;
+}
+
+void String::toCharArray(char* buffer, unsigned int size, unsigned int index) const {
+    if (size == 0) return;
+    size_t count = index < _s.size() ? std::min<size_t>(size - 1, _s.size() - index) : 0;
+    if (count) memcpy(buffer, _s.data() + index, count);
+    buffer[count] = '\0';
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= _s.size()) return String();
+    if (to > _s.size()) to = _s.size();
+    return String(_s.c_str() + from, to - from);
+}
+
+void String::replace(const String& find, const String& replace) {
+    if (find._s.empty()) return;
+    size_t position = 0;
+    while ((position = _s.find(find._s, position)) != std::string::npos) {
+        _s.replace(position, find._s.size(), replace._s);
+        position += replace._s.size();
+    }
+}
+
+void String::toLowerCase() {
+    for (char& c : _s) c = tolower((unsigned char)c);
+}
+
+void String::toUpperCase() {
+    for (char& c : _s) c = toupper((unsigned char)c);
+}
+
+void String::trim() {
+    size_t first = 0;
+    while (first < _s.size() && isspace((unsigned char)_s[first])) first++;
+    size_t last = _s.size();
+    while (last > first && isspace((unsigned char)_s[last - 1])) last--;
+    _s = _s.substr(first, last - first);
+}
+
+StringSumHelper operator+(const String& lhs, const String& rhs) {
+    StringSumHelper sum(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+StringSumHelper operator+(const String& lhs, const char* rhs) {
+    StringSumHelper sum(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+StringSumHelper operator+(const char* lhs, const String& rhs) {
+    StringSumHelper sum(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+StringSumHelper operator+(const String& lhs, char rhs) {
+    StringSumHelper sum(lhs);
+    sum.concat(rhs);
+    return sum;
+}
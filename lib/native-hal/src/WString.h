@@ -0,0 +1,101 @@
+/* Description: Arduino String for the host build, backed by std::string */
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+class StringSumHelper;
+
+class String {
+public:
+    String(const char* value = "") : _s(value ? value : "") {}
+    String(const char* value, unsigned int length) : _s(value, length) {}
+    String(const String& value) = default;
+    String(String&& value) = default;
+    explicit String(char c) : _s(1, c) {}
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(long long value, unsigned char base = 10);
+    explicit String(unsigned long long value, unsigned char base = 10);
+    explicit String(float value, unsigned char decimals = 2);
+    explicit String(double value, unsigned char decimals = 2);
+
+    String& operator=(const String& rhs) = default;
+    String& operator=(String&& rhs) = default;
+    String& operator=(const char* rhs) { _s = rhs ? rhs : ""; return *this; }
+
+    const char* c_str() const { return _s.c_str(); }
+    unsigned int length() const { return (unsigned int)_s.size(); }
+    bool isEmpty() const { return _s.empty(); }
+    bool reserve(unsigned int size) { _s.reserve(size); return true; }
+    char* begin() { return &_s[0]; }
+    char* end() { return &_s[0] + _s.size(); }
+
+    bool concat(const String& value) { _s += value._s; return true; }
+    bool concat(const char* value) { if (value) _s += value; return true; }
+    bool concat(const char* value, unsigned int length) { if (value) _s.append(value, length); return true; }
+    bool concat(char c) { _s += c; return true; }
+    template <typename T> bool concat(T value) { return concat(String(value)); }
+    template <typename T> String& operator+=(const T& value) { concat(value); return *this; }
+
+    bool equals(const String& other) const { return _s == other._s; }
+    bool equals(const char* other) const { return _s == (other ? other : ""); }
+    bool equalsIgnoreCase(const String& other) const;
+    int compareTo(const String& other) const { return _s.compare(other._s); }
+    bool operator==(const String& rhs) const { return equals(rhs); }
+    bool operator==(const char* rhs) const { return equals(rhs); }
+    bool operator!=(const String& rhs) const { return !equals(rhs); }
+    bool operator!=(const char* rhs) const { return !equals(rhs); }
+    bool operator<(const String& rhs) const { return _s < rhs._s; }
+    bool startsWith(const String& prefix) const { return _s.compare(0, prefix._s.size(), prefix._s) == 0; }
+    bool endsWith(const String& suffix) const;
+
+    char charAt(unsigned int index) const { return index < _s.size() ? _s[index] : 0; }
+    void setCharAt(unsigned int index, char c) { if (index < _s.size()) _s[index] = c; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index) { return _s[index]; }
+    void toCharArray(char* buffer, unsigned int size, unsigned int index = 0) const;
+    void getBytes(unsigned char* buffer, unsigned int size, unsigned int index = 0) const {
+        toCharArray((char*)buffer, size, index);
+    }
+
+    int indexOf(char c, unsigned int from = 0) const { return find(_s.find(c, from)); }
+    int indexOf(const String& value, unsigned int from = 0) const { return find(_s.find(value._s, from)); }
+    int lastIndexOf(char c) const { return find(_s.rfind(c)); }
+    int lastIndexOf(const String& value) const { return find(_s.rfind(value._s)); }
+    String substring(unsigned int from) const { return substring(from, length()); }
+    String substring(unsigned int from, unsigned int to) const;
+
+    void replace(const String& find, const String& replace);
+    void remove(unsigned int index) { if (index < _s.size()) _s.erase(index); }
+    void remove(unsigned int index, unsigned int count) { if (index < _s.size()) _s.erase(index, count); }
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+    long toInt() const { return atol(_s.c_str()); }
+    float toFloat() const { return (float)atof(_s.c_str()); }
+    double toDouble() const { return atof(_s.c_str()); }
+
+private:
+    std::string _s;
+
+    static int find(size_t position) { return position == std::string::npos ? -1 : (int)position; }
+};
+
+class StringSumHelper : public String {
+public:
+    using String::String;
+    StringSumHelper(const String& value) : String(value) {}
+};
+
+StringSumHelper operator+(const String& lhs, const String& rhs);
+StringSumHelper operator+(const String& lhs, const char* rhs);
+StringSumHelper operator+(const char* lhs, const String& rhs);
+StringSumHelper operator+(const String& lhs, char rhs);
+template <typename T>
+StringSumHelper operator+(const String& lhs, T rhs) { return lhs + String(rhs); }
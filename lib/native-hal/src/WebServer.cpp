@@ -0,0 +1,274 @@
+#include "WebServer.h"
+#include "hal.h"
+
+#define HTTP_READ_TIMEOUT_MS 2000
+#define HTTP_WRITE_TIMEOUT_MS 5000
+
+// Socket waits use the host clock - peers run in real time even when the firmware does not
+static uint64_t hostMillis() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static const char* reasonPhrase(int code) {
+    switch (code) {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 202: return "Accepted";
+        case 204: return "No Content";
+        case 206: return "Partial Content";
+        case 301: return "Moved Permanently";
+        case 302: return "Found";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
+        case 413: return "Payload Too Large";
+        case 416: return "Range Not Satisfiable";
+        case 423: return "Locked";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        default: return "";
+    }
+}
+
+static HTTPMethod parseMethod(const char* name) {
+    static const struct { const char* name; HTTPMethod method; } methods[] = {
+        {"GET", HTTP_GET}, {"HEAD", HTTP_HEAD}, {"POST", HTTP_POST}, {"PUT", HTTP_PUT},
+        {"PATCH", HTTP_PATCH}, {"DELETE", HTTP_DELETE}, {"OPTIONS", HTTP_OPTIONS}};
+    for (const auto& entry : methods) {
+        if (strcmp(name, entry.name) == 0) return entry.method;
+    }
+    return HTTP_ANY;
+}
+
+static String urlDecode(const char* text, size_t length) {
+    String decoded;
+    for (size_t i = 0; i < length; i++) {
+        char c = text[i];
+        if (c == '+') {
+            c = ' ';
+        } else if (c == '%' && i + 2 < length && isxdigit((unsigned char)text[i + 1]) && isxdigit((unsigned char)text[i + 2])) {
+            char hex[3] = {text[i + 1], text[i + 2], '\0'};
+            c = (char)strtol(hex, nullptr, 16);
+            i += 2;
+        }
+        decoded += c;
+    }
+    return decoded;
+}
+
+// Request ----------------------------------------------------------------->
+
+void WebServer::handleClient() {
+    WiFiClient client = _server.accept();
+    if (!client) return;
+
+    _client = client;
+    _args.clear();
+    _requestHeaders.clear();
+    _responseHeaders = String();
+    _contentLength = CONTENT_LENGTH_NOT_SET;
+    _chunked = false;
+
+    if (readRequest()) {
+        bool handled = false;
+        for (const route_t& route : _routes) {
+            if (route.uri == _uri && (route.method == HTTP_ANY || route.method == _method)) {
+                route.handler();
+                handled = true;
+                break;
+            }
+        }
+        if (!handled) {
+            if (_notFound) _notFound();
+            else send(404, "text/plain", "Not found");
+        }
+    } else {
+        send(400, "text/plain", "Bad request");
+    }
+
+    // Let go of the connection; it closes unless a handler kept a copy
+    _client = WiFiClient();
+}
+
+bool WebServer::readRequest() {
+    std::string head;
+    uint64_t deadline = hostMillis() + HTTP_READ_TIMEOUT_MS;
+    size_t headEnd;
+    char buffer[512];
+    while ((headEnd = head.find("\r\n\r\n")) == std::string::npos) {
+        if (head.size() > HTTP_MAX_REQUEST_HEAD) return false;
+        int count = _client.read((uint8_t*)buffer, sizeof(buffer));
+        if (count > 0) {
+            head.append(buffer, count);
+            continue;
+        }
+        if (!_client.connected() || hostMillis() > deadline) return false;
+        yield();
+    }
+    std::string body = head.substr(headEnd + 4);
+    head.resize(headEnd);
+
+    // Request line
+    size_t lineEnd = head.find("\r\n");
+    std::string requestLine = head.substr(0, lineEnd);
+    char methodName[16];
+    char target[2048];
+    if (sscanf(requestLine.c_str(), "%15s %2047s", methodName, target) != 2) return false;
+    _method = parseMethod(methodName);
+    const char* query = strchr(target, '?');
+    _uri = urlDecode(target, query ? (size_t)(query - target) : strlen(target));
+
+    // Headers
+    size_t position = lineEnd == std::string::npos ? head.size() : lineEnd + 2;
+    size_t bodyLength = 0;
+    while (position < head.size()) {
+        size_t end = head.find("\r\n", position);
+        if (end == std::string::npos) end = head.size();
+        std::string line = head.substr(position, end - position);
+        size_t colon = line.find(':');
+        if (colon != std::string::npos) {
+            size_t valueStart = line.find_first_not_of(' ', colon + 1);
+            String name(line.c_str(), colon);
+            String value(valueStart == std::string::npos ? "" : line.c_str() + valueStart);
+            if (name.equalsIgnoreCase("Content-Length")) bodyLength = strtoul(value.c_str(), nullptr, 10);
+            _requestHeaders.push_back({name, value});
+        }
+        position = end + 2;
+    }
+
+    // Body
+    if (bodyLength > HTTP_MAX_REQUEST_BODY) return false;
+    while (body.size() < bodyLength) {
+        int count = _client.read((uint8_t*)buffer, std::min(sizeof(buffer), bodyLength - body.size()));
+        if (count > 0) {
+            body.append(buffer, count);
+            continue;
+        }
+        if (!_client.connected() || hostMillis() > deadline) return false;
+        yield();
+    }
+
+    if (query) parseArguments(query + 1);
+    if (bodyLength) {
+        if (header("Content-Type").startsWith("application/x-www-form-urlencoded")) {
+            parseArguments(String(body.c_str(), (unsigned int)body.size()));
+        } else {
+            _args.push_back({"plain", String(body.c_str(), (unsigned int)body.size())});
+        }
+    }
+    return true;
+}
+
+void WebServer::parseArguments(const String& query) {
+    const char* p = query.c_str();
+    while (*p) {
+        const char* end = strchr(p, '&');
+        size_t length = end ? (size_t)(end - p) : strlen(p);
+        const char* equals = (const char*)memchr(p, '=', length);
+        if (equals) {
+            _args.push_back({urlDecode(p, equals - p), urlDecode(equals + 1, length - (equals - p) - 1)});
+        } else if (length) {
+            _args.push_back({urlDecode(p, length), String()});
+        }
+        p += length;
+        if (*p == '&') p++;
+    }
+}
+
+String WebServer::arg(const String& name) const {
+    for (const pair_t& arg : _args) {
+        if (arg.name == name) return arg.value;
+    }
+    return String();
+}
+
+bool WebServer::hasArg(const String& name) const {
+    for (const pair_t& arg : _args) {
+        if (arg.name == name) return true;
+    }
+    return false;
+}
+
+String WebServer::header(const String& name) const {
+    for (const pair_t& header : _requestHeaders) {
+        if (header.name.equalsIgnoreCase(name)) return header.value;
+    }
+    return String();
+}
+
+bool WebServer::hasHeader(const String& name) const {
+    for (const pair_t& header : _requestHeaders) {
+        if (header.name.equalsIgnoreCase(name)) return true;
+    }
+    return false;
+}
+
+// Response ---------------------------------------------------------------->
+
+void WebServer::sendHeader(const String& name, const String& value, bool first) {
+    String line = name + ": " + value + "\r\n";
+    if (first) _responseHeaders = line + _responseHeaders;
+    else _responseHeaders += line;
+}
+
+void WebServer::sendHead(int code, const char* contentType, size_t contentLength) {
+    String head = String("HTTP/1.1 ") + String(code) + " " + reasonPhrase(code) + "\r\n";
+    if (contentType && contentType[0]) head += String("Content-Type: ") + contentType + "\r\n";
+    if (contentLength == CONTENT_LENGTH_UNKNOWN) {
+        head += "Transfer-Encoding: chunked\r\n";
+        _chunked = true;
+    } else {
+        head += String("Content-Length: ") + String((unsigned long)contentLength) + "\r\n";
+    }
+    head += _responseHeaders;
+    head += "Connection: close\r\n\r\n";
+    writeAll(head.c_str(), head.length());
+    _responseHeaders = String();
+}
+
+void WebServer::send(int code, const char* contentType, const String& content) {
+    size_t length = _contentLength == CONTENT_LENGTH_NOT_SET ? content.length() : _contentLength;
+    _contentLength = CONTENT_LENGTH_NOT_SET;
+    sendHead(code, contentType, length);
+    if (content.length()) sendContent(content);
+}
+
+void WebServer::send_P(int code, const char* contentType, const char* content, size_t length) {
+    setContentLength(length);
+    sendHead(code, contentType, length);
+    _contentLength = CONTENT_LENGTH_NOT_SET;
+    writeAll(content, length);
+}
+
+void WebServer::sendContent(const char* content, size_t length) {
+    if (!_chunked) {
+        writeAll(content, length);
+        return;
+    }
+    char size[20];
+    int sizeLength = snprintf(size, sizeof(size), "%zx\r\n", length);
+    writeAll(size, sizeLength);
+    writeAll(content, length);
+    writeAll("\r\n", 2);
+    if (length == 0) _chunked = false;      // Terminating chunk
+}
+
+// The firmware expects blocking writes, so keep going until the socket takes everything
+void WebServer::writeAll(const char* data, size_t length) {
+    uint64_t deadline = hostMillis() + HTTP_WRITE_TIMEOUT_MS;
+    while (length) {
+        size_t written = _client.write((const uint8_t*)data, length);
+        if (written) {
+            data += written;
+            length -= written;
+            continue;
+        }
+        if (!_client.connected() || hostMillis() > deadline) return;
+        yield();
+    }
+}
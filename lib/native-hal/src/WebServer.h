@@ -0,0 +1,112 @@
+/* Description: HTTP server for the host build
+ * Serves one request per connection (Connection: close) on a WiFiServer socket, with the
+ * arduino-pico WebServer API the firmware uses: routes, query and form arguments, the raw
+ * body as "plain", request headers, Content-Length or chunked responses, and client() for
+ * handlers that keep streaming after they return.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+#include "WiFiServer.h"
+
+enum HTTPMethod {
+    HTTP_ANY,
+    HTTP_GET,
+    HTTP_HEAD,
+    HTTP_POST,
+    HTTP_PUT,
+    HTTP_PATCH,
+    HTTP_DELETE,
+    HTTP_OPTIONS
+};
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+#define HTTP_MAX_REQUEST_HEAD 8192
+#define HTTP_MAX_REQUEST_BODY (64 * 1024)
+
+class WebServer {
+public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    explicit WebServer(int port = 80) : _server(port) {}
+
+    void begin() { _server.begin(); }
+    void close() { _server.stop(); }
+    void stop() { close(); }
+    void handleClient();
+    void on(const String& uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+    void on(const String& uri, HTTPMethod method, THandlerFunction handler) { _routes.push_back({uri, method, handler}); }
+    void onNotFound(THandlerFunction handler) { _notFound = handler; }
+
+    // Request
+    String uri() const { return _uri; }
+    HTTPMethod method() const { return _method; }
+    int args() const { return (int)_args.size(); }
+    String arg(int index) const { return index < args() ? _args[index].value : String(); }
+    String argName(int index) const { return index < args() ? _args[index].name : String(); }
+    String arg(const String& name) const;
+    bool hasArg(const String& name) const;
+    String header(const String& name) const;
+    bool hasHeader(const String& name) const;
+    void collectHeaders(const char* headerKeys[], size_t count) {}   // Every header is kept
+    WiFiClient client() { return _client; }
+
+    // Response
+    void sendHeader(const String& name, const String& value, bool first = false);
+    void setContentLength(size_t length) { _contentLength = length; }
+    void send(int code, const char* contentType = nullptr, const String& content = String());
+    void send(int code, const String& contentType, const String& content) { send(code, contentType.c_str(), content); }
+    void send(int code, const char* contentType, const char* content) { send(code, contentType, String(content)); }
+    void send_P(int code, const char* contentType, const char* content, size_t length);
+    void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+    void sendContent(const char* content, size_t length);
+    void sendContent(const char* content) { sendContent(content, strlen(content)); }
+    template <typename T>
+    size_t streamFile(T& file, const String& contentType, int code = 200);
+
+private:
+    struct route_t {
+        String uri;
+        HTTPMethod method;
+        THandlerFunction handler;
+    };
+    struct pair_t {
+        String name;
+        String value;
+    };
+
+    WiFiServer _server;
+    std::vector<route_t> _routes;
+    THandlerFunction _notFound;
+    WiFiClient _client;
+    String _uri;
+    HTTPMethod _method = HTTP_GET;
+    std::vector<pair_t> _args;
+    std::vector<pair_t> _requestHeaders;
+    String _responseHeaders;
+    size_t _contentLength = CONTENT_LENGTH_NOT_SET;
+    bool _chunked = false;
+
+    bool readRequest();
+    void parseArguments(const String& query);
+    void sendHead(int code, const char* contentType, size_t contentLength);
+    void writeAll(const char* data, size_t length);
+};
+
+template <typename T>
+size_t WebServer::streamFile(T& file, const String& contentType, int code) {
+    setContentLength(file.size());
+    send(code, contentType.c_str(), String());
+    uint8_t buffer[1024];
+    size_t total = 0;
+    int count;
+    while ((count = file.read(buffer, sizeof(buffer))) > 0) {
+        writeAll((const char*)buffer, count);
+        total += count;
+    }
+    return total;
+}
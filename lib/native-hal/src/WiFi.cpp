@@ -0,0 +1,195 @@
+#include "WiFiServer.h"
+#include "hal.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static void setNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+// WiFiClient -------------------------------------------------------------->
+
+WiFiClient::socket_t::~socket_t() {
+    if (fd >= 0) ::close(fd);
+}
+
+WiFiClient::WiFiClient(int fd) : _socket(std::make_shared<socket_t>(fd)) {
+    setNonBlocking(fd);
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+    stop();
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return 0;
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = (uint32_t)ip;
+    if (::connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        ::close(fd);
+        return 0;
+    }
+    _socket = std::make_shared<socket_t>(fd);
+    setNonBlocking(fd);
+    return 1;
+}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+    IPAddress ip;
+    if (ip.fromString(host)) return connect(ip, port);
+    struct addrinfo hints = {};
+    struct addrinfo* result = nullptr;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, nullptr, &hints, &result) != 0 || result == nullptr) return 0;
+    ip = IPAddress(((struct sockaddr_in*)result->ai_addr)->sin_addr.s_addr);
+    freeaddrinfo(result);
+    return connect(ip, port);
+}
+
+// Connected while data is waiting, even after the peer has closed
+uint8_t WiFiClient::connected() {
+    if (!_socket || _socket->fd < 0) return 0;
+    uint8_t c;
+    ssize_t result = recv(_socket->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (result > 0) return 1;
+    if (result == 0) return 0;
+    return errno == EAGAIN || errno == EWOULDBLOCK ? 1 : 0;
+}
+
+void WiFiClient::stop() {
+    if (_socket && _socket->fd >= 0) {
+        ::close(_socket->fd);
+        _socket->fd = -1;
+    }
+    _socket.reset();
+}
+
+int WiFiClient::available() {
+    if (!_socket || _socket->fd < 0) return 0;
+    int count = 0;
+    if (ioctl(_socket->fd, FIONREAD, &count) != 0) return 0;
+    return count;
+}
+
+int WiFiClient::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t* buffer, size_t size) {
+    if (!_socket || _socket->fd < 0) return -1;
+    ssize_t result = recv(_socket->fd, buffer, size, MSG_DONTWAIT);
+    return result > 0 ? (int)result : -1;
+}
+
+int WiFiClient::peek() {
+    if (!_socket || _socket->fd < 0) return -1;
+    uint8_t c;
+    return recv(_socket->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 1 ? c : -1;
+}
+
+size_t WiFiClient::readBytes(uint8_t* buffer, size_t length) {
+    size_t count = 0;
+    unsigned long start = millis();
+    while (count < length) {
+        int result = read(buffer + count, length - count);
+        if (result > 0) {
+            count += result;
+            continue;
+        }
+        if (!connected() || millis() - start >= _timeout) break;
+        yield();
+    }
+    return count;
+}
+
+// Like lwIP, writes what fits in the send buffer and returns the count
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+    if (!_socket || _socket->fd < 0) return 0;
+    ssize_t result = send(_socket->fd, buffer, size, MSG_DONTWAIT | MSG_NOSIGNAL);
+    return result > 0 ? (size_t)result : 0;
+}
+
+int WiFiClient::availableForWrite() {
+    if (!_socket || _socket->fd < 0) return 0;
+    int bufferSize = 0;
+    int queued = 0;
+    socklen_t length = sizeof(bufferSize);
+    if (getsockopt(_socket->fd, SOL_SOCKET, SO_SNDBUF, &bufferSize, &length) != 0) return 0;
+    if (ioctl(_socket->fd, TIOCOUTQ, &queued) != 0) return 0;
+    return bufferSize > queued ? bufferSize - queued : 0;
+}
+
+IPAddress WiFiClient::remoteIP() {
+    struct sockaddr_in address = {};
+    socklen_t length = sizeof(address);
+    if (!_socket || _socket->fd < 0 || getpeername(_socket->fd, (struct sockaddr*)&address, &length) != 0) return IPAddress();
+    return IPAddress(address.sin_addr.s_addr);
+}
+
+uint16_t WiFiClient::remotePort() {
+    struct sockaddr_in address = {};
+    socklen_t length = sizeof(address);
+    if (!_socket || _socket->fd < 0 || getpeername(_socket->fd, (struct sockaddr*)&address, &length) != 0) return 0;
+    return ntohs(address.sin_port);
+}
+
+void WiFiClient::setNoDelay(bool noDelay) {
+    if (!_socket || _socket->fd < 0) return;
+    int value = noDelay ? 1 : 0;
+    setsockopt(_socket->fd, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+}
+
+bool WiFiClient::getNoDelay() {
+    if (!_socket || _socket->fd < 0) return false;
+    int value = 0;
+    socklen_t length = sizeof(value);
+    getsockopt(_socket->fd, IPPROTO_TCP, TCP_NODELAY, &value, &length);
+    return value != 0;
+}
+
+// WiFiServer -------------------------------------------------------------->
+
+void WiFiServer::begin(uint16_t port) {
+    if (port) _port = port;
+    stop();
+    uint16_t hostPort = _port + halGetOptions().portOffset;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return;
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(hostPort);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 8) != 0) {
+        fprintf(stderr, "[hal] cannot listen on port %u: %s (try --port-offset)\n", hostPort, strerror(errno));
+        ::close(fd);
+        return;
+    }
+    setNonBlocking(fd);
+    _fd = fd;
+}
+
+void WiFiServer::stop() {
+    if (_fd >= 0) ::close(_fd);
+    _fd = -1;
+}
+
+WiFiClient WiFiServer::accept() {
+    if (_fd < 0 || halNowUs() < _nextPollUs) return WiFiClient();
+    _nextPollUs = halNowUs() + HAL_ACCEPT_POLL_US;
+    int fd = ::accept(_fd, nullptr, nullptr);
+    if (fd < 0) return WiFiClient();
+    WiFiClient client(fd);
+    if (_noDelay) client.setNoDelay(true);
+    return client;
+}
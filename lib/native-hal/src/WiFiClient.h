@@ -0,0 +1,47 @@
+/* Description: TCP client for the host build, on a non-blocking host socket
+ * Copies share one connection, which closes on stop() or when the last copy goes, as with
+ * the lwIP client in the arduino-pico core.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <memory>
+
+class WiFiClient : public Stream {
+public:
+    WiFiClient() {}
+    explicit WiFiClient(int fd);
+
+    int connect(IPAddress ip, uint16_t port);
+    int connect(const char* host, uint16_t port);
+    uint8_t connected();
+    void stop();
+    operator bool() { return _socket && _socket->fd >= 0; }
+    bool operator==(const WiFiClient& other) const { return _socket == other._socket; }
+
+    int available() override;
+    int read() override;
+    int read(uint8_t* buffer, size_t size);
+    int peek() override;
+    size_t readBytes(uint8_t* buffer, size_t length) override;
+    using Stream::readBytes;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int availableForWrite() override;
+    void flush() override {}
+
+    IPAddress remoteIP();
+    uint16_t remotePort();
+    void setNoDelay(bool noDelay);
+    bool getNoDelay();
+
+private:
+    struct socket_t {
+        int fd;
+        explicit socket_t(int fd) : fd(fd) {}
+        ~socket_t();
+    };
+    std::shared_ptr<socket_t> _socket;
+};
@@ -0,0 +1,33 @@
+/* Description: TCP listening socket for the host build
+ * The port is offset by --port-offset, so the Modbus TCP server (502) and the web server
+ * (80) can run without root and side by side with other instances. accept() looks at the
+ * socket at most every HAL_ACCEPT_POLL_US, so an idle server costs no system call per loop()
+ * pass.
+ */
+
+#pragma once
+
+#include "WiFiClient.h"
+
+#define HAL_ACCEPT_POLL_US 1000
+
+class WiFiServer {
+public:
+    explicit WiFiServer(uint16_t port) : _port(port), _fd(-1), _noDelay(false), _nextPollUs(0) {}
+    ~WiFiServer() { stop(); }
+
+    void begin(uint16_t port = 0);
+    void stop();
+    void close() { stop(); }
+    WiFiClient accept();
+    WiFiClient available() { return accept(); }
+    void setNoDelay(bool noDelay) { _noDelay = noDelay; }
+    uint16_t port() const { return _port; }         // As configured, before the offset
+    operator bool() { return _fd >= 0; }
+
+private:
+    uint16_t _port;
+    int _fd;
+    bool _noDelay;
+    uint64_t _nextPollUs;
+};
@@ -0,0 +1,11 @@
+/* Description: UDP for the host build - nothing is sent, so NTP never syncs */
+
+#pragma once
+
+#include <Arduino.h>
+
+class WiFiUDP {
+public:
+    uint8_t begin(uint16_t port) { return 1; }
+    void stop() {}
+};
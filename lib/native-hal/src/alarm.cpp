@@ -0,0 +1,50 @@
+#include "pico/time.h"
+#include "hal.h"
+#include <map>
+
+struct alarm_t {
+    alarm_callback_t callback;
+    void* userData;
+    uint64_t targetUs;
+};
+
+static std::map<alarm_id_t, alarm_t> alarms;
+static alarm_id_t nextId = 1;
+
+static void scheduleAlarm(alarm_id_t id, uint64_t atUs) {
+    halSchedule(atUs, [id]() {
+        auto it = alarms.find(id);
+        if (it == alarms.end()) return;  // Cancelled
+        alarm_t alarm = it->second;
+        int64_t again = alarm.callback(id, alarm.userData);
+        it = alarms.find(id);
+        if (it == alarms.end()) return;  // Cancelled from its own callback
+        if (again == 0) {
+            alarms.erase(it);
+            return;
+        }
+        it->second.targetUs = again < 0 ? halNowUs() - again : alarm.targetUs + again;
+        scheduleAlarm(id, it->second.targetUs);
+    });
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void* user_data, bool fire_if_past) {
+    if (us == 0) {
+        if (!fire_if_past) return 0;
+        int64_t again = callback(0, user_data);
+        if (again == 0) return 0;
+        us = again < 0 ? -again : again;
+    }
+    if (alarms.size() >= PICO_TIME_DEFAULT_ALARM_POOL_MAX_TIMERS) return -1;
+
+    alarm_id_t id = nextId;
+    nextId = nextId == INT32_MAX ? 1 : nextId + 1;
+    uint64_t atUs = halNowUs() + us;
+    alarms[id] = {callback, user_data, atUs};
+    scheduleAlarm(id, atUs);
+    return id;
+}
+
+bool cancel_alarm(alarm_id_t alarm_id) {
+    return alarms.erase(alarm_id) > 0;
+}
@@ -0,0 +1,70 @@
+#include "hardware/dma.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct dmaChannel_t {
+    bool claimed;
+    dma_channel_config config;
+};
+
+static dmaChannel_t channels[NUM_DMA_CHANNELS];
+static dma_channel_hw_t channelRegisters[NUM_DMA_CHANNELS];
+
+int dma_claim_unused_channel(bool required) {
+    for (int i = 0; i < NUM_DMA_CHANNELS; i++) {
+        if (!channels[i].claimed) {
+            channels[i].claimed = true;
+            return i;
+        }
+    }
+    if (required) abort();
+    return -1;
+}
+
+void dma_channel_unclaim(unsigned int channel) {
+    dma_channel_abort(channel);
+    channels[channel].claimed = false;
+}
+
+dma_channel_config dma_channel_get_default_config(unsigned int channel) {
+    // As the SDK: 32 bit transfers, read and write increment, unpaced
+    dma_channel_config config = {DMA_SIZE_32, true, true, 0x3f};
+    return config;
+}
+
+void dma_channel_configure(unsigned int channel, const dma_channel_config* config, volatile void* write_addr,
+                           const volatile void* read_addr, unsigned int transfer_count, bool trigger) {
+    channels[channel].config = *config;
+    dma_channel_hw_t* hw = &channelRegisters[channel];
+    hw->read_addr = (uintptr_t)read_addr;
+    hw->write_addr = (uintptr_t)write_addr;
+    hw->transfer_count = transfer_count;
+    hw->busy = trigger && transfer_count > 0;
+}
+
+void dma_channel_abort(unsigned int channel) {
+    channelRegisters[channel].busy = 0;
+}
+
+bool dma_channel_is_busy(unsigned int channel) {
+    return channelRegisters[channel].busy;
+}
+
+dma_channel_hw_t* dma_channel_hw_addr(unsigned int channel) {
+    return &channelRegisters[channel];
+}
+
+bool halDmaTransfer(unsigned int dreq, const volatile void* source, uint32_t value) {
+    for (int i = 0; i < NUM_DMA_CHANNELS; i++) {
+        dma_channel_hw_t* hw = &channelRegisters[i];
+        const dma_channel_config& config = channels[i].config;
+        if (!hw->busy || config.dreq != dreq || hw->read_addr != (uintptr_t)source) continue;
+
+        size_t size = (size_t)1 << config.size;
+        memcpy((void*)hw->write_addr, &value, size);   // Little endian, as the chip
+        if (config.writeIncrement) hw->write_addr = hw->write_addr + size;
+        if (--hw->transfer_count == 0) hw->busy = 0;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,412 @@
+// Cores switch with _setjmp/_longjmp between stacks, which the fortified longjmp rejects
+#undef _FORTIFY_SOURCE
+
+#include "Arduino.h"
+#include "hal.h"
+#include "SPI.h"
+#include "pico/mutex.h"
+#include "rs485Sim.h"
+#include <errno.h>
+#include <malloc.h>
+#include <queue>
+#include <setjmp.h>
+#include <vector>
+#include <sys/stat.h>
+#include <ucontext.h>
+
+#define HAL_CORE_STACK_SIZE (1024 * 1024)
+#define HAL_TOTAL_HEAP (256 * 1024)     // Reported by rp2040.getTotalHeap(), as on the chip
+
+RP2040 rp2040;
+SPIClassRP2040 SPI;
+SPIClassRP2040 SPI1;
+
+// Clock and cores --------------------------------------------------------->
+
+struct halCore_t {
+    ucontext_t context;                 // Entry only; switches use jump (no signal mask syscalls)
+    jmp_buf jump;
+    bool started;
+    uint64_t wakeUs;
+    std::vector<uint8_t> stack;
+};
+
+struct halEvent_t {
+    uint64_t atUs;
+    uint64_t sequence;
+    std::function<void()> run;
+    bool operator>(const halEvent_t& other) const {
+        return atUs != other.atUs ? atUs > other.atUs : sequence > other.sequence;
+    }
+};
+
+static halOptions_t options = {false, 0, 10, "native_fs", 0, false, 0};
+static jmp_buf schedulerJump;
+static halCore_t cores[HAL_CORES];
+static int currentCore = -1;
+static uint64_t virtualNowUs = 0;
+static struct timespec realStart;   // Set when --realtime is parsed
+static std::priority_queue<halEvent_t, std::vector<halEvent_t>, std::greater<halEvent_t>> events;
+static uint64_t eventSequence = 0;
+static bool exitRequested = false;
+static int exitCode = 0;
+static std::vector<std::function<void()>> exitHandlers;
+static size_t heapBaseline = 0;         // Host allocations made before the firmware started
+
+uint64_t halNowUs() {
+    if (!options.realtime) return virtualNowUs;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - realStart.tv_sec) * 1000000 + (now.tv_nsec - realStart.tv_nsec) / 1000;
+}
+
+// Moves the clock forward to atUs when nothing is runnable before then
+static void advanceTo(uint64_t atUs) {
+    if (!options.realtime) {
+        if (atUs > virtualNowUs) virtualNowUs = atUs;
+        return;
+    }
+    uint64_t now = halNowUs();
+    if (atUs <= now) return;
+    struct timespec wait;
+    wait.tv_sec = (atUs - now) / 1000000;
+    wait.tv_nsec = ((atUs - now) % 1000000) * 1000;
+    nanosleep(&wait, nullptr);
+}
+
+void halSleepUntilUs(uint64_t atUs) {
+    if (currentCore < 0) {
+        // Outside the cores (host tools, static initialisation) nothing else can run
+        advanceTo(atUs);
+        return;
+    }
+    halCore_t* core = &cores[currentCore];
+    core->wakeUs = atUs;
+    if (_setjmp(core->jump) == 0) _longjmp(schedulerJump, 1);
+}
+
+void halSleepUs(uint32_t us) {
+    halSleepUntilUs(halNowUs() + us);
+}
+
+void halSchedule(uint64_t atUs, std::function<void()> event) {
+    events.push({atUs, eventSequence++, event});
+}
+
+int halCurrentCore() {
+    return currentCore;
+}
+
+const halOptions_t& halGetOptions() {
+    return options;
+}
+
+void halRequestExit(int code) {
+    exitRequested = true;
+    exitCode = code;
+}
+
+void halAtExit(std::function<void()> handler) {
+    exitHandlers.push_back(handler);
+}
+
+static void coreEntry(int core) {
+    if (core == 0) {
+        setup();
+        for (;;) {
+            loop();
+            halSleepUs(options.realtime ? 0 : options.tickUs);
+        }
+    } else {
+        setup1();
+        for (;;) {
+            loop1();
+            halSleepUs(options.realtime ? 0 : options.tickUs);
+        }
+    }
+}
+
+int halRun() {
+    heapBaseline = mallinfo2().uordblks;
+    for (int i = 0; i < HAL_CORES; i++) {
+        halCore_t* core = &cores[i];
+        core->stack.resize(HAL_CORE_STACK_SIZE);
+        getcontext(&core->context);
+        core->context.uc_stack.ss_sp = core->stack.data();
+        core->context.uc_stack.ss_size = core->stack.size();
+        core->context.uc_link = nullptr;   // coreEntry() never returns
+        makecontext(&core->context, (void (*)())coreEntry, 1, i);
+        core->wakeUs = halNowUs();
+    }
+
+    // Earliest wake time runs next; on a tie host events go first, then the cores alternate.
+    // Volatile because it is written between _setjmp() and the _longjmp() back into this frame
+    volatile int lastCore = HAL_CORES - 1;
+    while (!exitRequested) {
+        int next = -1;
+        for (int i = 1; i <= HAL_CORES; i++) {
+            int candidate = (lastCore + i) % HAL_CORES;
+            if (next < 0 || cores[candidate].wakeUs < cores[next].wakeUs) next = candidate;
+        }
+        uint64_t atUs = cores[next].wakeUs;
+        bool runEvent = !events.empty() && events.top().atUs <= atUs;
+        if (runEvent) atUs = events.top().atUs;
+
+        if (options.runLimitUs && atUs >= options.runLimitUs) {
+            advanceTo(options.runLimitUs);
+            break;
+        }
+        advanceTo(atUs);
+
+        if (runEvent) {
+            std::function<void()> event = events.top().run;
+            events.pop();
+            event();
+            continue;
+        }
+        currentCore = next;
+        lastCore = next;
+        if (_setjmp(schedulerJump) == 0) {
+            if (!cores[next].started) {
+                cores[next].started = true;
+                setcontext(&cores[next].context);
+            }
+            _longjmp(cores[next].jump, 1);
+        }
+        currentCore = -1;
+    }
+
+    for (auto& handler : exitHandlers) handler();
+    fflush(stdout);
+    return exitCode;
+}
+
+// Arduino time functions -------------------------------------------------->
+
+unsigned long millis() {
+    return (unsigned long)(uint32_t)(halNowUs() / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)(uint32_t)halNowUs();
+}
+
+void delay(unsigned long ms) {
+    halSleepUs(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    halSleepUs(us);
+}
+
+// At least 1us, so a core spinning on yield() cannot stall virtual time
+void yield() {
+    halSleepUs(1);
+}
+
+int get_core_num() {
+    return currentCore < 0 ? 0 : currentCore;
+}
+
+// GPIO -------------------------------------------------------------------->
+
+struct halPin_t {
+    uint8_t mode;
+    uint8_t output;
+    bool driven;                        // Driven from the host side
+    uint8_t drivenLevel;
+};
+
+static halPin_t pins[HAL_MAX_PINS];
+static std::vector<std::function<void(uint8_t, uint8_t)>> pinWriteHandlers;
+
+void pinMode(pin_size_t pin, int mode) {
+    if (pin < HAL_MAX_PINS) pins[pin].mode = mode;
+}
+
+void digitalWrite(pin_size_t pin, int level) {
+    if (pin >= HAL_MAX_PINS) return;
+    pins[pin].output = level ? HIGH : LOW;
+    for (auto& handler : pinWriteHandlers) handler(pin, pins[pin].output);
+}
+
+int digitalRead(pin_size_t pin) {
+    if (pin >= HAL_MAX_PINS) return LOW;
+    const halPin_t* p = &pins[pin];
+    if (p->mode == OUTPUT) return p->output;
+    if (p->driven) return p->drivenLevel;
+    return p->mode == INPUT_PULLUP ? HIGH : LOW;
+}
+
+void halDrivePin(uint8_t pin, uint8_t level) {
+    if (pin >= HAL_MAX_PINS) return;
+    pins[pin].driven = true;
+    pins[pin].drivenLevel = level ? HIGH : LOW;
+}
+
+void halReleasePin(uint8_t pin) {
+    if (pin < HAL_MAX_PINS) pins[pin].driven = false;
+}
+
+uint8_t halPinOutput(uint8_t pin) {
+    return pin < HAL_MAX_PINS ? pins[pin].output : LOW;
+}
+
+void halOnPinWrite(std::function<void(uint8_t pin, uint8_t level)> handler) {
+    pinWriteHandlers.push_back(handler);
+}
+
+// Pulls the pin low for HAL_PIN_PULSE_US from atUs, then again every periodUs
+static void pulsePin(uint8_t pin, uint64_t periodUs, uint64_t atUs) {
+    halSchedule(atUs, [pin, periodUs, atUs]() {
+        halDrivePin(pin, LOW);
+        halSchedule(atUs + HAL_PIN_PULSE_US, [pin]() { halDrivePin(pin, HIGH); });
+        pulsePin(pin, periodUs, atUs + periodUs);
+    });
+}
+
+// Mutexes ----------------------------------------------------------------->
+
+bool mutex_try_enter(mutex_t* mutex, uint32_t* owner_out) {
+    if (mutex->owner >= 0 && mutex->owner != get_core_num()) {
+        if (owner_out) *owner_out = mutex->owner;
+        return false;
+    }
+    mutex->owner = get_core_num();
+    return true;
+}
+
+void mutex_enter_blocking(mutex_t* mutex) {
+    while (!mutex_try_enter(mutex, nullptr)) yield();
+}
+
+void mutex_exit(mutex_t* mutex) {
+    mutex->owner = -1;
+}
+
+// File systems ----------------------------------------------------------->
+
+std::string halFsPath(const char* area, const char* path) {
+    std::string hostPath = std::string(options.fsRoot) + "/" + area;
+    if (path[0] != '/') hostPath += '/';
+    hostPath += path;
+    while (hostPath.size() > 1 && hostPath.back() == '/') hostPath.pop_back();
+    return hostPath;
+}
+
+bool halMakeDirs(const std::string& path) {
+    for (size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+        std::string part = path.substr(0, slash);
+        if (::mkdir(part.c_str(), 0755) != 0 && errno != EEXIST) return false;
+        if (slash == std::string::npos) return true;
+    }
+}
+
+// Chip services ----------------------------------------------------------->
+
+static uint32_t randomState = 0x12345678;
+
+static uint32_t nextRandom() {
+    // xorshift32 - the same sequence on every run
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+uint32_t RP2040::getTotalHeap() {
+    return HAL_TOTAL_HEAP;
+}
+
+// Only what the firmware allocated counts, not the host's own allocations
+uint32_t RP2040::getFreeHeap() {
+    size_t used = mallinfo2().uordblks;
+    used = used > heapBaseline ? used - heapBaseline : 0;
+    return used < HAL_TOTAL_HEAP ? HAL_TOTAL_HEAP - (uint32_t)used : 0;
+}
+
+int RP2040::cpuid() {
+    return get_core_num();
+}
+
+uint32_t RP2040::hwrand32() {
+    return nextRandom();
+}
+
+void RP2040::restart() {
+    printf("\n[hal] restart requested, exiting\n");
+    halRequestExit(0);
+    for (;;) halSleepUs(1000000);
+}
+
+long random(long max) {
+    return max > 0 ? (long)(nextRandom() % (uint32_t)max) : 0;
+}
+
+long random(long min, long max) {
+    return max > min ? min + random(max - min) : min;
+}
+
+void randomSeed(unsigned long seed) {
+    randomState = seed ? (uint32_t)seed : 0x12345678;
+}
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t length = strlen(src);
+    if (size) {
+        size_t count = length < size - 1 ? length : size - 1;
+        memcpy(dst, src, count);
+        dst[count] = '\0';
+    }
+    return length;
+}
+#endif
+
+// Entry point ------------------------------------------------------------->
+
+__attribute__((weak)) void halInit(int argc, char** argv) {}
+
+#ifndef HAL_NO_MAIN
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (strcmp(arg, "--realtime") == 0) {
+            options.realtime = true;
+            clock_gettime(CLOCK_MONOTONIC, &realStart);
+        } else if (strcmp(arg, "--quiet") == 0) {
+            options.quiet = true;
+        } else if (strcmp(arg, "--run-ms") == 0 && value) {
+            options.runLimitUs = strtoull(value, nullptr, 10) * 1000;
+            i++;
+        } else if (strcmp(arg, "--tick-us") == 0 && value) {
+            options.tickUs = strtoul(value, nullptr, 10);
+            i++;
+        } else if (strcmp(arg, "--fs") == 0 && value) {
+            options.fsRoot = value;
+            i++;
+        } else if (strcmp(arg, "--port-offset") == 0 && value) {
+            options.portOffset = (uint16_t)strtoul(value, nullptr, 10);
+            i++;
+        } else if (strcmp(arg, "--sd-write-us") == 0 && value) {
+            options.sdWriteUs = strtoul(value, nullptr, 10);
+            i++;
+        } else if (strcmp(arg, "--pin") == 0 && value) {
+            unsigned int pin, level;
+            if (sscanf(value, "%u=%u", &pin, &level) == 2) halDrivePin(pin, level);
+            i++;
+        } else if (strcmp(arg, "--pin-pulse") == 0 && value) {
+            unsigned int pin, periodMs;
+            if (sscanf(value, "%u=%u", &pin, &periodMs) == 2 && pin < HAL_MAX_PINS && periodMs * 1000 > HAL_PIN_PULSE_US) {
+                halDrivePin(pin, HIGH);
+                pulsePin(pin, periodMs * 1000ULL, periodMs * 1000ULL);
+            }
+            i++;
+        }
+    }
+    rs485SimInit(argc, argv);
+    halInit(argc, argv);
+    return halRun();
+}
+#endif
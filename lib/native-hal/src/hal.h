@@ -0,0 +1,72 @@
+/* Description: Host (Linux) hardware abstraction for the [env:native] build
+ * The firmware runs unchanged as a Linux process. Both cores are coroutines on one thread,
+ * switched whenever a core waits (delay(), delayMicroseconds(), yield(), flush(), a held
+ * mutex) and after every loop() pass. By default time is virtual: it only moves when every
+ * core is waiting, so a run is deterministic and independent of host speed. --realtime uses
+ * the host clock instead, which is what real sockets and external tools need.
+ *
+ * Peripherals: Serial is the console, Serial1/Serial2 are virtual UARTs with wire timing at
+ * the configured baud rate, GPIO inputs can be driven from the host side, LittleFS and the SD
+ * card are host directories, and WiFiServer/WiFiClient/WebServer are TCP sockets.
+ *
+ * Command line (all optional):
+ *   --realtime          Use the host clock instead of virtual time
+ *   --run-ms N          Stop after N ms of (virtual or real) time
+ *   --tick-us N         Virtual time charged per loop() pass, default 10
+ *   --fs DIR            Root for the littlefs/ and sd/ directories, default ./native_fs
+ *   --port-offset N     Added to every listening TCP port (502 -> 502 + N)
+ *   --pin P=L           Drive input pin P to level L (e.g. --pin 18=1 removes the SD card)
+ *   --pin-pulse P=MS    Pull input pin P low for 100 ms every MS ms, as a flow counter trigger
+ *   --quiet             Discard console output
+ *   --sd-write-us N     Time each SD card write takes, to model a slow card holding a core
+ *   --sim-...           Simulated RS485 bus on Serial1, see rs485Sim.h
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+
+#define HAL_MAX_PINS 64
+#define HAL_CORES 2
+#define HAL_PIN_PULSE_US 100000     // Low time of a --pin-pulse
+
+struct halOptions_t {
+    bool realtime;
+    uint64_t runLimitUs;        // 0 = run until exit is requested
+    uint32_t tickUs;
+    const char* fsRoot;
+    uint16_t portOffset;
+    bool quiet;
+    uint32_t sdWriteUs;
+};
+
+// Clock
+uint64_t halNowUs();                                  // 64 bit micros(), never wraps
+void halSleepUntilUs(uint64_t atUs);                  // Current core waits; the other core runs
+void halSleepUs(uint32_t us);
+
+// Host side events, run between core switches in time order (ties: scheduling order)
+void halSchedule(uint64_t atUs, std::function<void()> event);
+
+// GPIO - inputs read the driven level, else their pull (INPUT_PULLUP high, otherwise low)
+void halDrivePin(uint8_t pin, uint8_t level);
+void halReleasePin(uint8_t pin);
+uint8_t halPinOutput(uint8_t pin);                    // Last digitalWrite() level
+void halOnPinWrite(std::function<void(uint8_t pin, uint8_t level)> handler);
+
+// File systems - host path of a firmware path on "littlefs" or "sd", and mkdir -p
+std::string halFsPath(const char* area, const char* path);
+bool halMakeDirs(const std::string& path);
+
+// Run control
+void halRequestExit(int code);
+void halAtExit(std::function<void()> handler);        // Run after the cores stop, in order
+int halCurrentCore();                                 // -1 outside the cores
+const halOptions_t& halGetOptions();
+int halRun();                                         // Starts setup()/setup1() and runs until exit
+
+// Optional hook for host tools linked with the firmware: called after the HAL options are
+// parsed and before the cores start. Unknown arguments are left for it to parse.
+void halInit(int argc, char** argv);
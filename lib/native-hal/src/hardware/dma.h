@@ -0,0 +1,64 @@
+/* Description: Host model of the RP2040 DMA channels, for peripheral to memory transfers
+ * Covers the pico SDK calls a receive path needs: claim a channel, configure it to read a
+ * peripheral register paced by its DREQ into a buffer, and watch transfer_count. The
+ * peripheral side calls halDmaTransfer() as each item arrives (HardwareSerial does for
+ * UART RX), so the buffer fills in the background at the item's arrival time, as the DMA
+ * engine does on the chip. Memory to memory and TX transfers are not modelled.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define NUM_DMA_CHANNELS 12
+
+enum dma_channel_transfer_size {
+    DMA_SIZE_8 = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2
+};
+
+typedef struct {
+    enum dma_channel_transfer_size size;
+    bool readIncrement;
+    bool writeIncrement;
+    unsigned int dreq;
+} dma_channel_config;
+
+// Host pointers do not fit the chip's 32 bit address registers, so these are wider
+typedef struct {
+    volatile uintptr_t read_addr;
+    volatile uintptr_t write_addr;
+    volatile uint32_t transfer_count;
+    volatile uint32_t busy;
+} dma_channel_hw_t;
+
+int dma_claim_unused_channel(bool required);
+void dma_channel_unclaim(unsigned int channel);
+dma_channel_config dma_channel_get_default_config(unsigned int channel);
+void dma_channel_configure(unsigned int channel, const dma_channel_config* config, volatile void* write_addr,
+                           const volatile void* read_addr, unsigned int transfer_count, bool trigger);
+void dma_channel_abort(unsigned int channel);
+bool dma_channel_is_busy(unsigned int channel);
+dma_channel_hw_t* dma_channel_hw_addr(unsigned int channel);
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config* config, enum dma_channel_transfer_size size) {
+    config->size = size;
+}
+
+static inline void channel_config_set_read_increment(dma_channel_config* config, bool increment) {
+    config->readIncrement = increment;
+}
+
+static inline void channel_config_set_write_increment(dma_channel_config* config, bool increment) {
+    config->writeIncrement = increment;
+}
+
+static inline void channel_config_set_dreq(dma_channel_config* config, unsigned int dreq) {
+    config->dreq = dreq;
+}
+
+// Peripheral side: hands one item read from source to the busy channel paced by dreq that
+// reads source. Returns false if no channel takes it (the item then stays in the FIFO).
+bool halDmaTransfer(unsigned int dreq, const volatile void* source, uint32_t value);
@@ -0,0 +1,58 @@
+/* Description: Host model of the RP2040 UART registers the firmware reads directly
+ * Only the raw interrupt status and the BUSY flag are modelled. BUSY is set while
+ * HardwareSerial has bytes on the wire, until the last stop bit has gone. HardwareSerial sets the error bits of received
+ * bytes as they arrive, and writing ICR clears them (write 1 to clear), as on the chip.
+ * DR is only an address here: a DMA channel reading it with the UART's RX DREQ gets the
+ * received bytes (see hardware/dma.h).
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define UART_UARTFR_BUSY_BITS 0x00000008
+#define UART_UARTRIS_OERIS_BITS 0x00000400
+#define UART_UARTRIS_BERIS_BITS 0x00000200
+#define UART_UARTRIS_PERIS_BITS 0x00000100
+#define UART_UARTRIS_FERIS_BITS 0x00000080
+#define UART_UARTICR_OEIC_BITS 0x00000400
+#define UART_UARTICR_BEIC_BITS 0x00000200
+#define UART_UARTICR_PEIC_BITS 0x00000100
+#define UART_UARTICR_FEIC_BITS 0x00000080
+
+#define DREQ_UART0_TX 20
+#define DREQ_UART0_RX 21
+#define DREQ_UART1_TX 22
+#define DREQ_UART1_RX 23
+
+struct uart_hw_t {
+    volatile uint32_t dr;
+    volatile uint32_t fr;
+    volatile uint32_t ris;
+
+    struct clearRegister_t {
+        volatile uint32_t* target;
+        clearRegister_t& operator=(uint32_t bits) { *target = *target & ~bits; return *this; }
+    } icr;
+
+    uart_hw_t() : dr(0), fr(0), ris(0), icr{&ris} {}
+    uart_hw_t(const uart_hw_t&) = delete;
+};
+
+typedef struct uart_inst {
+    uart_hw_t hw;
+} uart_inst_t;
+
+extern uart_inst_t* const uart0;
+extern uart_inst_t* const uart1;
+
+static inline uart_hw_t* uart_get_hw(uart_inst_t* uart) { return &uart->hw; }
+
+static inline unsigned int uart_get_index(uart_inst_t* uart) { return uart == uart0 ? 0 : 1; }
+
+static inline unsigned int uart_get_dreq(uart_inst_t* uart, bool is_tx) {
+    return uart_get_index(uart) == 0 ? (is_tx ? DREQ_UART0_TX : DREQ_UART0_RX) : (is_tx ? DREQ_UART1_TX : DREQ_UART1_RX);
+}
+
+// The host UARTs have no interrupts; received bytes wait in the FIFO or go to DMA
+static inline void uart_set_irq_enables(uart_inst_t* uart, bool rx_has_data, bool tx_needs_data) {}
@@ -0,0 +1,18 @@
+/* Description: Pico SDK mutexes for the host build
+ * The cores are coroutines on one thread, so a mutex only records its owner core; a core
+ * that blocks on a mutex held by the other core yields until it is released.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+    int8_t owner;                       // Core number, -1 = free
+} mutex_t;
+
+#define auto_init_mutex(name) static mutex_t name = {-1}
+
+bool mutex_try_enter(mutex_t* mutex, uint32_t* owner_out);
+void mutex_enter_blocking(mutex_t* mutex);
+void mutex_exit(mutex_t* mutex);
@@ -0,0 +1,20 @@
+/* Description: Host model of the pico SDK timer alarms (default alarm pool)
+ * An alarm callback runs as a host event at its time, between core switches, so it lands
+ * while a core is held (delay(), an SD write ...) as the timer interrupt does on the chip.
+ * A callback that returns non-zero runs again: <0 that many us after it ran, >0 that many
+ * us after its last target time. The pool holds PICO_TIME_DEFAULT_ALARM_POOL_MAX_TIMERS
+ * alarms, as on the chip.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define PICO_TIME_DEFAULT_ALARM_POOL_MAX_TIMERS 16
+
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void* user_data);
+
+// > 0 the alarm, 0 if the time has already passed (the callback ran first if fire_if_past), -1 if no slot is free
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void* user_data, bool fire_if_past);
+bool cancel_alarm(alarm_id_t alarm_id);
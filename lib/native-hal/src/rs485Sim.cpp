@@ -0,0 +1,348 @@
+#include "rs485Sim.h"
+#include "hal.h"
+#include "NTPClient.h"
+#include <math.h>
+#include <memory>
+#include <vector>
+
+struct simSlave_t {
+    bool present;
+    simSlaveConfig_t config;
+    simSlaveStats_t stats;
+};
+
+static simSlave_t slaves[SIM_MAX_SLAVES + 1];
+static HardwareSerial* busPort = nullptr;
+static unsigned long busBaud = 9600;
+static uint16_t busConfig = SERIAL_8N1;
+static std::vector<uint8_t> rxFrame;
+static bool rxGarbled = false;          // Part of the frame was sent at another baud rate or framing
+static uint64_t rxSequence = 0;
+static uint32_t badFrames = 0;
+static uint32_t unansweredFrames = 0;   // Valid frames for IDs with no slave
+static uint64_t busBusyUs = 0;
+static uint32_t simRandomState = 1;
+static int masterDePin = -1;
+
+// Helpers ----------------------------------------------------------------->
+
+static uint32_t simRandom() {
+    // xorshift32, separate from the firmware's random() so the firmware cannot shift the draws
+    simRandomState ^= simRandomState << 13;
+    simRandomState ^= simRandomState >> 17;
+    simRandomState ^= simRandomState << 5;
+    return simRandomState;
+}
+
+static bool simChance(float probability) {
+    return probability > 0 && (simRandom() / 4294967296.0) < probability;
+}
+
+static uint16_t simCrc(const uint8_t* data, size_t length) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+    return crc;
+}
+
+static uint32_t busByteTimeUs() {
+    uint32_t bits = 1 + ((busConfig & SERIAL_DATA_MASK) == SERIAL_DATA_7 ? 7 : 8);
+    if ((busConfig & SERIAL_PARITY_MASK) != SERIAL_PARITY_NONE) bits++;
+    bits += (busConfig & SERIAL_STOP_BIT_MASK) == SERIAL_STOP_BIT_2 ? 2 : 1;
+    return (bits * 1000000UL + busBaud - 1) / busBaud;
+}
+
+// 3.5 character times, fixed at 1750us above 19200 baud as the Modbus spec allows
+static uint32_t busFrameGapUs() {
+    return busBaud > 19200 ? 1750 : busByteTimeUs() * 7 / 2;
+}
+
+// Register map ------------------------------------------------------------>
+
+static void putFloat(uint16_t* registers, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    registers[0] = bits & 0xFFFF;       // CDAB: low word first
+    registers[1] = bits >> 16;
+}
+
+static void putUint32(uint16_t* registers, uint32_t value) {
+    registers[0] = value & 0xFFFF;
+    registers[1] = value >> 16;
+}
+
+// Values drift slowly with time, and differ per slave so swapped ports show up
+static void fillRegisters(uint8_t id, uint16_t* registers) {
+    double seconds = halNowUs() / 1000000.0;
+    float flow = (10.0f + id) * (1.0f + 0.1f * (float)sin(seconds / 60.0));
+    float volume = (float)(1000.0 * id + (10.0 + id) * seconds / 3600.0);
+    uint32_t epoch = halGetOptions().realtime ? (uint32_t)time(nullptr) : HAL_VIRTUAL_EPOCH + (uint32_t)seconds;
+
+    putFloat(&registers[0], volume);
+    putFloat(&registers[2], volume * 0.98f);
+    putFloat(&registers[4], flow);
+    putFloat(&registers[6], flow * 0.98f);
+    putFloat(&registers[8], 15.0f + 0.5f * id + (float)sin(seconds / 300.0));
+    putFloat(&registers[10], 1.01325f + 0.01f * id);
+    putUint32(&registers[12], epoch);
+    putFloat(&registers[14], 24.0f);
+    putFloat(&registers[16], 3.6f);
+
+    // unit_ID, 10 characters, low byte first in each register
+    char unitId[11];
+    snprintf(unitId, sizeof(unitId), "SIMFC%05u", id);
+    for (int i = 0; i < 5; i++) registers[18 + i] = (uint8_t)unitId[i * 2] | ((uint8_t)unitId[i * 2 + 1] << 8);
+}
+
+// Request handling -------------------------------------------------------->
+
+static void sendReply(uint8_t id, const std::vector<uint8_t>& pdu, uint64_t requestEndUs) {
+    simSlave_t* slave = &slaves[id];
+    std::vector<uint8_t> reply;
+    reply.push_back(id);
+    reply.insert(reply.end(), pdu.begin(), pdu.end());
+    uint16_t crc = simCrc(reply.data(), reply.size());
+    reply.push_back(crc & 0xFF);
+    reply.push_back(crc >> 8);
+
+    if (simChance(slave->config.crcErrorRate)) {
+        reply[simRandom() % reply.size()] ^= 1 << (simRandom() % 8);
+        slave->stats.corrupted++;
+    }
+
+    uint32_t byteTime = busByteTimeUs();
+    uint64_t atUs = requestEndUs + slave->config.latencyUs;
+    if (slave->config.jitterUs) atUs += simRandom() % (slave->config.jitterUs + 1);
+    atUs = std::max(atUs, halNowUs());  // Not before the slave has seen the end of the request
+    auto collided = std::make_shared<bool>(false);
+    for (size_t i = 0; i < reply.size(); i++) {
+        if (i) atUs += slave->config.byteGapUs;
+        atUs += byteTime;
+        if (masterDePin < 0) {
+            busPort->receive(reply[i], atUs);
+            continue;
+        }
+        // The master's receiver is off while its driver is on, so the byte is decided at its start bit
+        uint8_t value = reply[i];
+        halSchedule(atUs - byteTime, [slave, value, atUs, collided]() {
+            if (halPinOutput(masterDePin) == HIGH) {
+                if (!*collided) slave->stats.collided++;
+                *collided = true;
+                return;
+            }
+            busPort->receive(value, atUs);
+        });
+    }
+    busBusyUs += reply.size() * (uint64_t)byteTime;
+    slave->stats.replies++;
+}
+
+static void handleFrame(uint64_t requestEndUs) {
+    std::vector<uint8_t> frame;
+    frame.swap(rxFrame);
+    bool garbled = rxGarbled;
+    rxGarbled = false;
+
+    if (garbled || frame.size() < 4 || simCrc(frame.data(), frame.size() - 2) != (frame[frame.size() - 2] | (frame[frame.size() - 1] << 8))) {
+        badFrames++;
+        return;
+    }
+    uint8_t id = frame[0];
+    if (id == 0) return;                // Broadcast: never answered
+    if (!slaves[id].present) {
+        unansweredFrames++;
+        return;
+    }
+    simSlave_t* slave = &slaves[id];
+    slave->stats.requests++;
+
+    if (simChance(slave->config.silenceRate)) {
+        slave->stats.silent++;
+        return;
+    }
+
+    uint8_t function = frame[1];
+    std::vector<uint8_t> pdu;
+    auto exception = [&](uint8_t code) {
+        pdu = {(uint8_t)(function | 0x80), code};
+        slave->stats.exceptions++;
+    };
+
+    if (simChance(slave->config.exceptionRate)) {
+        exception(slave->config.exceptionCode);
+    } else if ((function == 0x03 || function == 0x04) && frame.size() == 8) {
+        uint16_t address = (frame[2] << 8) | frame[3];
+        uint16_t count = (frame[4] << 8) | frame[5];
+        if (count == 0 || count > 125) {
+            exception(0x03);
+        } else if (address + count > SIM_REGISTER_COUNT) {
+            exception(0x02);
+        } else {
+            uint16_t registers[SIM_REGISTER_COUNT];
+            fillRegisters(id, registers);
+            pdu.push_back(function);
+            pdu.push_back(count * 2);
+            for (uint16_t i = 0; i < count; i++) {
+                pdu.push_back(registers[address + i] >> 8);
+                pdu.push_back(registers[address + i] & 0xFF);
+            }
+        }
+    } else {
+        exception(0x01);
+    }
+    sendReply(id, pdu, requestEndUs);
+}
+
+// Called for every byte the master sends, with the time its stop bit ends
+static void onMasterByte(uint8_t c, uint64_t endUs) {
+    if (busPort->getBaudRate() != busBaud || busPort->getConfig() != busConfig) rxGarbled = true;
+    rxFrame.push_back(c);
+    busBusyUs += busByteTimeUs();
+    uint64_t sequence = ++rxSequence;
+    halSchedule(endUs + busFrameGapUs(), [sequence, endUs]() {
+        if (sequence == rxSequence) handleFrame(endUs);
+    });
+}
+
+// Setup ------------------------------------------------------------------->
+
+void rs485SimAttach(HardwareSerial* port, unsigned long baud, uint16_t config) {
+    busPort = port;
+    busBaud = baud;
+    busConfig = config;
+    port->onTransmit(onMasterByte);
+}
+
+void rs485SimAddSlave(uint8_t id, const simSlaveConfig_t& config) {
+    if (id == 0 || id > SIM_MAX_SLAVES) return;
+    slaves[id].present = true;
+    slaves[id].config = config;
+}
+
+void rs485SimSetDePin(int pin) {
+    masterDePin = pin;
+}
+
+void rs485SimSeed(uint32_t seed) {
+    simRandomState = seed ? seed : 1;
+}
+
+const simSlaveStats_t* rs485SimStats(uint8_t id) {
+    return id <= SIM_MAX_SLAVES && slaves[id].present ? &slaves[id].stats : nullptr;
+}
+
+void rs485SimPrintStats() {
+    if (!busPort) return;
+    double elapsed = halNowUs() / 1000000.0;
+    fprintf(stderr, "\n[sim] RS485 bus: %lu baud, %.1f s, %.1f%% busy, %lu bad frames, %lu frames for absent IDs\n",
+            busBaud, elapsed, elapsed > 0 ? busBusyUs / 10000.0 / elapsed : 0.0,
+            (unsigned long)badFrames, (unsigned long)unansweredFrames);
+    fprintf(stderr, "[sim]  id  requests   replies    silent corrupted exceptions  collided\n");
+    for (int id = 1; id <= SIM_MAX_SLAVES; id++) {
+        if (!slaves[id].present) continue;
+        const simSlaveStats_t& s = slaves[id].stats;
+        fprintf(stderr, "[sim] %3d %9lu %9lu %9lu %9lu %9lu %9lu\n", id, (unsigned long)s.requests, (unsigned long)s.replies,
+                (unsigned long)s.silent, (unsigned long)s.corrupted, (unsigned long)s.exceptions, (unsigned long)s.collided);
+    }
+}
+
+// Command line ------------------------------------------------------------>
+
+static bool parseFormat(const char* text, uint16_t* config) {
+    if (strlen(text) != 3) return false;
+    uint16_t data = text[0] == '7' ? SERIAL_DATA_7 : text[0] == '8' ? SERIAL_DATA_8 : 0;
+    uint16_t parity = text[1] == 'N' ? SERIAL_PARITY_NONE : text[1] == 'E' ? SERIAL_PARITY_EVEN : text[1] == 'O' ? SERIAL_PARITY_ODD : 0;
+    uint16_t stop = text[2] == '1' ? SERIAL_STOP_BIT_1 : text[2] == '2' ? SERIAL_STOP_BIT_2 : 0;
+    if (!data || !parity || !stop) return false;
+    *config = data | parity | stop;
+    return true;
+}
+
+static bool setConfigValue(simSlaveConfig_t* config, const char* key, const char* value) {
+    if (strcmp(key, "latency") == 0) config->latencyUs = strtoul(value, nullptr, 10);
+    else if (strcmp(key, "jitter") == 0) config->jitterUs = strtoul(value, nullptr, 10);
+    else if (strcmp(key, "gap") == 0) config->byteGapUs = strtoul(value, nullptr, 10);
+    else if (strcmp(key, "silence") == 0) config->silenceRate = strtof(value, nullptr);
+    else if (strcmp(key, "crc") == 0) config->crcErrorRate = strtof(value, nullptr);
+    else if (strcmp(key, "exception") == 0) config->exceptionRate = strtof(value, nullptr);
+    else if (strcmp(key, "code") == 0) config->exceptionCode = strtoul(value, nullptr, 0);
+    else return false;
+    return true;
+}
+
+// "1-12,20" -> marks the IDs in ids[]
+static bool parseIdList(const char* text, bool* ids) {
+    while (*text) {
+        char* end;
+        unsigned long first = strtoul(text, &end, 10);
+        unsigned long last = first;
+        if (*end == '-') last = strtoul(end + 1, &end, 10);
+        if (end == text || first == 0 || last > SIM_MAX_SLAVES || first > last) return false;
+        for (unsigned long id = first; id <= last; id++) ids[id] = true;
+        if (*end == ',') end++;
+        else if (*end) return false;
+        text = end;
+    }
+    return true;
+}
+
+void rs485SimInit(int argc, char** argv) {
+    simSlaveConfig_t defaults = {2000, 0, 0, 0.0f, 0.0f, 0.0f, 0x06};
+    static bool ids[SIM_MAX_SLAVES + 1];
+    std::vector<std::pair<uint8_t, std::string>> overrides;
+    unsigned long baud = 9600;
+    uint16_t config = SERIAL_8N1;
+    bool enabled = false;
+
+    for (int i = 1; i + 1 < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = argv[i + 1];
+        if (strncmp(arg, "--sim-", 6) != 0) continue;
+        const char* option = arg + 6;
+        bool ok = true;
+        if (strcmp(option, "slaves") == 0) ok = enabled = parseIdList(value, ids);
+        else if (strcmp(option, "baud") == 0) ok = (baud = strtoul(value, nullptr, 10)) > 0;
+        else if (strcmp(option, "format") == 0) ok = parseFormat(value, &config);
+        else if (strcmp(option, "seed") == 0) rs485SimSeed(strtoul(value, nullptr, 10));
+        else if (strcmp(option, "de-pin") == 0) ok = (masterDePin = atoi(value)) >= 0 && masterDePin < HAL_MAX_PINS;
+        else if (strcmp(option, "exception-code") == 0) defaults.exceptionCode = strtoul(value, nullptr, 0);
+        else if (strcmp(option, "slave") == 0) {
+            char* end;
+            unsigned long id = strtoul(value, &end, 10);
+            ok = *end == ':' && id > 0 && id <= SIM_MAX_SLAVES;
+            if (ok) overrides.push_back({(uint8_t)id, end + 1});
+        } else {
+            ok = setConfigValue(&defaults, option, value);
+        }
+        if (!ok) {
+            fprintf(stderr, "[sim] bad option %s %s\n", arg, value);
+            exit(2);
+        }
+        i++;
+    }
+    if (!enabled) return;
+
+    for (int id = 1; id <= SIM_MAX_SLAVES; id++) {
+        if (ids[id]) rs485SimAddSlave(id, defaults);
+    }
+    for (const auto& entry : overrides) {
+        simSlave_t* slave = &slaves[entry.first];
+        if (!slave->present) rs485SimAddSlave(entry.first, defaults);
+        std::string settings = entry.second;
+        char* save = nullptr;
+        for (char* pair = strtok_r(&settings[0], ",", &save); pair; pair = strtok_r(nullptr, ",", &save)) {
+            char* equals = strchr(pair, '=');
+            if (!equals) continue;
+            *equals = '\0';
+            if (!setConfigValue(&slave->config, pair, equals + 1)) {
+                fprintf(stderr, "[sim] unknown slave setting %s\n", pair);
+                exit(2);
+            }
+        }
+    }
+
+    rs485SimAttach(&Serial1, baud, config);
+    halAtExit(rs485SimPrintStats);
+}
@@ -0,0 +1,68 @@
+/* Description: Simulated RS485 bus with virtual flow counter slaves for the host build
+ * Attaches to a virtual UART (Serial1, the port ModbusRTUMaster is given) and answers Modbus
+ * RTU requests the way the flow counters do: FC03/FC04 over the 23 register map that
+ * modbusResponseCallback() decodes (CDAB floats, unit_ID low byte first). Requests are framed
+ * by 3.5 character times of silence, and replies go back byte by byte at the bus baud rate,
+ * so the master sees real wire timing in virtual time. A master configured for another baud
+ * rate or framing gets no answer, as on a real bus.
+ *
+ * Each slave has its own response latency and jitter, an extra gap between reply bytes, and
+ * rates for silence (no reply), a corrupted reply (one bit flipped, so the CRC fails) and an
+ * exception reply. Random draws come from a seeded generator, so with virtual time a run
+ * repeats exactly. A per slave summary is printed at exit.
+ *
+ * Command line (the bus is off unless --sim-slaves is given):
+ *   --sim-slaves LIST       Slave IDs, e.g. 1-12 or 1,2,7
+ *   --sim-baud N            Bus baud rate, default 9600
+ *   --sim-format F          Bus framing: 8N1, 8E1, 8O1, 8N2, 7E1 ..., default 8N1
+ *   --sim-latency US        Reply latency after the request, default 2000
+ *   --sim-jitter US         Random extra latency, 0..US, default 0
+ *   --sim-gap US            Extra silence between reply bytes, default 0
+ *   --sim-silence P         Probability of no reply, 0..1
+ *   --sim-crc P             Probability of a corrupted reply
+ *   --sim-exception P       Probability of an exception reply
+ *   --sim-exception-code C  Code used for those, default 6 (slave device busy)
+ *   --sim-slave ID:K=V,...  Per slave override of latency, jitter, gap, silence, crc,
+ *                           exception and code, e.g. --sim-slave 3:silence=1 for a dead slave
+ *   --sim-seed N            Seed for the random draws, default 1
+ *   --sim-de-pin P          The master's DE pin. A reply byte that starts while P is still
+ *                           high meets the master's driver and is lost; such replies are
+ *                           counted as collided. Off by default.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#define SIM_MAX_SLAVES 247
+#define SIM_REGISTER_COUNT 23
+
+struct simSlaveConfig_t {
+    uint32_t latencyUs;
+    uint32_t jitterUs;
+    uint32_t byteGapUs;
+    float silenceRate;
+    float crcErrorRate;
+    float exceptionRate;
+    uint8_t exceptionCode;
+};
+
+struct simSlaveStats_t {
+    uint32_t requests;
+    uint32_t replies;
+    uint32_t silent;
+    uint32_t corrupted;
+    uint32_t exceptions;        // Injected and protocol (bad function or address) exceptions
+    uint32_t collided;          // Replies that lost bytes to the master still driving the bus
+};
+
+// Parses the --sim-* options and attaches the bus to Serial1 when slaves are configured
+void rs485SimInit(int argc, char** argv);
+
+// For host tools that build the bus themselves
+void rs485SimAttach(HardwareSerial* port, unsigned long baud, uint16_t config);
+void rs485SimAddSlave(uint8_t id, const simSlaveConfig_t& config);
+void rs485SimSeed(uint32_t seed);
+void rs485SimSetDePin(int pin);                       // -1 = don't check the master's DE
+const simSlaveStats_t* rs485SimStats(uint8_t id);     // nullptr if there is no such slave
+void rs485SimPrintStats();
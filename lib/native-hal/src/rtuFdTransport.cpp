@@ -0,0 +1,100 @@
+#include "rtuFdTransport.h"
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+static speed_t termiosSpeed(uint32_t baudrate) {
+    switch (baudrate) {
+        case 1200: return B1200;
+        case 2400: return B2400;
+        case 4800: return B4800;
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        default: return B0;
+    }
+}
+
+bool ModbusRTUFdTransport::open(const char* path) {
+    close();
+    if (strcmp(path, "pty") == 0) {
+        _fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (_fd < 0 || grantpt(_fd) != 0 || unlockpt(_fd) != 0) {
+            close();
+            return false;
+        }
+        _peer = ptsname(_fd);
+    } else {
+        _fd = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (_fd < 0) return false;
+    }
+    _lastByteAt = micros();
+    return true;
+}
+
+void ModbusRTUFdTransport::close() {
+    if (_fd >= 0) ::close(_fd);
+    _fd = -1;
+    _peer.clear();
+}
+
+bool ModbusRTUFdTransport::begin(uint32_t baudrate, uint32_t config) {
+    if (_fd < 0) return false;
+
+    struct termios settings;
+    if (tcgetattr(_fd, &settings) != 0) return false;
+    cfmakeraw(&settings);
+    speed_t speed = termiosSpeed(baudrate);
+    if (speed == B0) return false;
+    cfsetispeed(&settings, speed);
+    cfsetospeed(&settings, speed);
+    settings.c_cflag &= ~(CSIZE | PARENB | PARODD | CSTOPB);
+    settings.c_cflag |= CLOCAL | CREAD | ((config & SERIAL_DATA_MASK) == SERIAL_DATA_7 ? CS7 : CS8);
+    if ((config & SERIAL_PARITY_MASK) == SERIAL_PARITY_EVEN) settings.c_cflag |= PARENB;
+    if ((config & SERIAL_PARITY_MASK) == SERIAL_PARITY_ODD) settings.c_cflag |= PARENB | PARODD;
+    if ((config & SERIAL_STOP_BIT_MASK) == SERIAL_STOP_BIT_2) settings.c_cflag |= CSTOPB;
+    settings.c_cc[VMIN] = 0;
+    settings.c_cc[VTIME] = 0;
+    if (tcsetattr(_fd, TCSANOW, &settings) != 0) return false;
+
+    tcflush(_fd, TCIOFLUSH);
+    _lastByteAt = micros();
+    return true;
+}
+
+size_t ModbusRTUFdTransport::write(const uint8_t* frame, size_t length) {
+    if (_fd < 0) return 0;
+    ssize_t written = ::write(_fd, frame, length);
+    if (written <= 0) return 0;
+    _lastByteAt = micros();
+    return written;
+}
+
+int ModbusRTUFdTransport::available() {
+    int count = 0;
+    if (_fd < 0 || ioctl(_fd, FIONREAD, &count) != 0) return 0;
+    return count;
+}
+
+size_t ModbusRTUFdTransport::read(uint8_t* buffer, size_t length) {
+    if (_fd < 0) return 0;
+    ssize_t count = ::read(_fd, buffer, length);
+    if (count <= 0) return 0;
+    _lastByteAt = micros();
+    return count;
+}
+
+bool ModbusRTUFdTransport::txComplete() {
+    int queued = 0;
+    if (_fd < 0 || ioctl(_fd, TIOCOUTQ, &queued) != 0 || queued == 0) return true;
+    _lastByteAt = micros();
+    return false;
+}
+
+uint32_t ModbusRTUFdTransport::idleTime() {
+    return micros() - _lastByteAt;
+}
@@ -0,0 +1,39 @@
+/* Description: Modbus RTU master transport on a host serial device or pseudo terminal
+ * Puts the master on a real line (a USB RS485 adapter, /dev/ttyUSB0) or on a pty that an
+ * external slave simulator opens, e.g. for benchmarks against other Modbus stacks. The
+ * host line only has real timing, so use it with --realtime.
+ *
+ * A host tool linked with the firmware switches the bus over from halInit():
+ *   static ModbusRTUFdTransport bus;
+ *   void halInit(int argc, char** argv) {
+ *       if (bus.open("pty")) { printf("Slave side: %s\n", bus.peerName()); setRS485Transport(&bus); }
+ *   }
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <modbus-rtu-transport.h>
+#include <string>
+
+class ModbusRTUFdTransport : public ModbusRTUTransport {
+public:
+    ModbusRTUFdTransport() : _fd(-1), _lastByteAt(0) {}
+    ~ModbusRTUFdTransport() override { close(); }
+
+    bool open(const char* path);                // A device path, or "pty" for a new pseudo terminal
+    void close();
+    const char* peerName() const { return _peer.c_str(); }  // Slave side of a pty, else ""
+
+    bool begin(uint32_t baudrate, uint32_t config) override;
+    size_t write(const uint8_t* frame, size_t length) override;
+    int available() override;
+    size_t read(uint8_t* buffer, size_t length) override;
+    bool txComplete() override;                 // Output queue of the device drained
+    uint32_t idleTime() override;
+
+private:
+    int _fd;
+    std::string _peer;
+    uint32_t _lastByteAt;
+};
@@ -1,9 +1,12 @@
 #!/usr/bin/env python3
 """
 PlatformIO Build Script for Web Asset Minification
-Minifies JS and CSS files from /web folder and copies to /data folder
+Minifies JS and CSS files from /web folder and copies to /data folder,
+then embeds gzipped copies of /data in the firmware (webAssets.h)
 """
 
+import gzip
+import hashlib
 import os
 import shutil
 import subprocess
@@ -104,6 +107,87 @@ def minify_css_python(input_file, output_file):
     with open(output_file, 'w', encoding='utf-8') as f:
         f.write(content.strip())
 
+# Content types served for embedded assets (matches handleFile)
+ASSET_CONTENT_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".ico": "image/x-icon",
+    ".woff2": "font/woff2",
+    ".woff": "font/woff",
+}
+
+def embed_web_assets(data_dir, output_file):
+    """Gzip every file in /data into a C header served from flash by handleFile.
+
+    Each asset gets a content hash used as its ETag. HTML pages are rewritten so
+    their references to other assets carry ?v=<hash>, which lets those assets be
+    cached as immutable while the page itself is revalidated.
+    """
+    data_dir = Path(data_dir)
+    output_file = Path(output_file)
+    if not data_dir.exists():
+        print(f"Warning: {data_dir} does not exist - no web assets embedded")
+        return
+
+    files = sorted(f for f in data_dir.rglob("*")
+                   if f.is_file() and f.suffix in ASSET_CONTENT_TYPES)
+    pages = [f for f in files if f.suffix == ".html"]
+    others = [f for f in files if f.suffix != ".html"]
+
+    assets = []
+    hashes = {}
+    versioned = set()  # Assets some page references with ?v=<hash>
+    for f in others + pages:
+        url = "/" + f.relative_to(data_dir).as_posix()
+        content = f.read_bytes()
+        if f.suffix == ".html":
+            text = content.decode("utf-8")
+            for ref, digest in hashes.items():
+                if f'"{ref}"' in text:
+                    text = text.replace(f'"{ref}"', f'"{ref}?v={digest}"')
+                    versioned.add(ref)
+            content = text.encode("utf-8")
+        digest = hashlib.sha256(content).hexdigest()[:16]
+        hashes[url] = digest
+        # mtime=0 keeps the output (and so the header) identical between builds
+        compressed = gzip.compress(content, compresslevel=9, mtime=0)
+        assets.append([url, ASSET_CONTENT_TYPES[f.suffix], compressed, digest, False])
+    for asset in assets:
+        asset[4] = asset[0] in versioned
+
+    lines = [
+        "// Generated by scripts/minify_web.py from /data - do not edit",
+        "#pragma once",
+        "",
+    ]
+    for i, (url, _, compressed, _, _) in enumerate(assets):
+        lines.append(f"// {url} ({len(compressed)} bytes gzipped)")
+        lines.append(f"static const uint8_t webAsset{i}[] = {{")
+        for offset in range(0, len(compressed), 24):
+            chunk = compressed[offset:offset + 24]
+            lines.append("    " + ",".join(f"0x{b:02x}" for b in chunk) + ",")
+        lines.append("};")
+        lines.append("")
+    lines.append("static const WebAsset webAssets[] = {")
+    for i, (url, content_type, compressed, digest, immutable) in enumerate(assets):
+        lines.append(f'    {{"{url}", "{content_type}", webAsset{i}, {len(compressed)}, "\\"{digest}\\"", {"true" if immutable else "false"}}},')
+    lines.append("};")
+    lines.append(f"#define WEB_ASSET_COUNT {len(assets)}")
+    header = "\n".join(lines) + "\n"
+
+    # Only touch the file when it changes so the firmware isn't rebuilt needlessly
+    if output_file.exists() and output_file.read_text() == header:
+        return
+    output_file.parent.mkdir(parents=True, exist_ok=True)
+    output_file.write_text(header)
+    total = sum(len(a[2]) for a in assets)
+    print(f"Embedded {len(assets)} web assets ({total} bytes gzipped) in {output_file}")
+
+def generated_header_path(env):
+    return Path(env.subst("$BUILD_DIR")) / "generated" / "webAssets.h"
+
 def minify_files(target=None, source=None, env=None):
     """Main minification function"""
     # Use the global env if not passed as parameter
@@ -201,6 +285,8 @@ def minify_files(target=None, source=None, env=None):
     
     print("Web asset minification completed!")
     
+    embed_web_assets(data_dir, generated_header_path(env))
+    
     # Clean up package files
     for file in ["package.json", "package-lock.json"]:
         if os.path.exists(file):
@@ -279,6 +365,10 @@ env.AddCustomTarget(
     description="Minify web assets, build filesystem image, and upload to device"
 )
 
+# Embed the current /data on every build; the header lives in the build dir, not the source tree
+embed_web_assets(Path(env.subst("$PROJECT_DIR")) / "data", generated_header_path(env))
+env.Append(CPPPATH=[str(generated_header_path(env).parent)])
+
 print("Web minification script loaded. Available commands:")
 print("  pio run -t minify        # Minify web assets only")
 print("  pio run -t minify-fs     # Minify assets and build filesystem")
@@ -0,0 +1,337 @@
+#!/usr/bin/env python3
+"""
+Modbus TCP load generator and latency benchmark
+Opens N concurrent connections to the gateway's Modbus TCP server (a device, or the
+[env:native] build with the simulated RS485 bus) and issues a mix of requests for a fixed
+time, then reports throughput, latency percentiles, exceptions, errors and reconnects.
+
+Request types for --mix:
+  read      FC03, the full 23 register map of a configured unit
+  read-tp   FC03, temperature and pressure only (registers 8-11)
+  write     FC06 to register 0 (the gateway answers with an exception)
+  unknown   FC03 to a unit ID with no port (answered with an exception)
+
+Typical run against the native build:
+  .pio/build/native/program --realtime --port-offset 8000 --sim-slaves 1-12 &
+  scripts/modbus_tcp_bench.py 127.0.0.1 --port 8502 --setup-ports http://127.0.0.1:8080 \\
+      --compare scripts/modbus_tcp_baseline.json
+"""
+
+import argparse
+import json
+import math
+import platform
+import random
+import socket
+import struct
+import sys
+import threading
+import time
+import urllib.request
+
+REQUEST_TYPES = ("read", "read-tp", "write", "unknown")
+
+
+def parse_units(text):
+    """'1-12,20' -> [1, ..., 12, 20]"""
+    units = []
+    for part in text.split(","):
+        first, _, last = part.partition("-")
+        units.extend(range(int(first), int(last or first) + 1))
+    return units
+
+
+def parse_mix(text):
+    """'read=90,unknown=10' -> [('read', 90), ('unknown', 10)]"""
+    mix = []
+    for part in text.split(","):
+        name, _, weight = part.partition("=")
+        if name not in REQUEST_TYPES:
+            raise argparse.ArgumentTypeError(f"unknown request type '{name}'")
+        mix.append((name, float(weight or 1)))
+    return mix
+
+
+def percentile(sorted_values, q):
+    if not sorted_values:
+        return 0.0
+    index = min(len(sorted_values) - 1, max(0, math.ceil(q * len(sorted_values)) - 1))
+    return sorted_values[index]
+
+
+def build_request(kind, tid, unit, unknown_unit):
+    if kind == "read":
+        unit_id, pdu = unit, struct.pack(">BHH", 0x03, 0, 23)
+    elif kind == "read-tp":
+        unit_id, pdu = unit, struct.pack(">BHH", 0x03, 8, 4)
+    elif kind == "write":
+        unit_id, pdu = unit, struct.pack(">BHH", 0x06, 0, 0)
+    else:
+        unit_id, pdu = unknown_unit, struct.pack(">BHH", 0x03, 0, 23)
+    return struct.pack(">HHHB", tid, 0, len(pdu) + 1, unit_id) + pdu
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.latencies = {kind: [] for kind in REQUEST_TYPES}
+        self.outcomes = {kind: {"sent": 0, "ok": 0, "exception": 0, "timeout": 0, "bad": 0} for kind in REQUEST_TYPES}
+        self.reconnects = 0
+        self.connect_failures = 0
+
+    def record(self, kind, outcome, latency=None):
+        with self.lock:
+            self.outcomes[kind][outcome] += 1
+            if latency is not None:
+                self.latencies[kind].append(latency)
+
+
+class Connection(threading.Thread):
+    """One TCP connection keeping up to `pipeline` requests in flight"""
+
+    def __init__(self, index, args, stats, measure_from, stop_at):
+        super().__init__(daemon=True)
+        self.args = args
+        self.stats = stats
+        self.measure_from = measure_from
+        self.stop_at = stop_at
+        self.random = random.Random(args.seed * 1000 + index)
+        self.tid = self.random.randrange(65536)
+        self.kinds = [kind for kind, _ in args.mix]
+        self.weights = [weight for _, weight in args.mix]
+        self.sock = None
+        self.buffer = b""
+        self.outstanding = {}               # tid -> (kind, send time, measured)
+
+    def connect(self):
+        while time.monotonic() < self.stop_at:
+            try:
+                self.sock = socket.create_connection((self.args.host, self.args.port), timeout=self.args.timeout)
+                self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+                self.sock.settimeout(0.01)
+                self.buffer = b""
+                return True
+            except OSError:
+                with self.stats.lock:
+                    self.stats.connect_failures += 1
+                time.sleep(0.1)
+        return False
+
+    def drop(self, outcome):
+        """Fails every request in flight and closes the connection"""
+        for kind, _, measured in self.outstanding.values():
+            if measured:
+                self.stats.record(kind, outcome)
+        self.outstanding.clear()
+        if self.sock:
+            self.sock.close()
+        self.sock = None
+
+    def send_next(self):
+        kind = self.random.choices(self.kinds, self.weights)[0]
+        self.tid = (self.tid + 1) & 0xFFFF
+        unit = self.random.choice(self.args.units)
+        frame = build_request(kind, self.tid, unit, self.args.unknown_unit)
+        now = time.monotonic()
+        measured = now >= self.measure_from
+        self.outstanding[self.tid] = (kind, now, measured)
+        if measured:
+            with self.stats.lock:
+                self.stats.outcomes[kind]["sent"] += 1
+        self.sock.sendall(frame)
+
+    def receive(self):
+        try:
+            data = self.sock.recv(4096)
+        except socket.timeout:
+            return True
+        if not data:
+            return False
+        self.buffer += data
+        while len(self.buffer) >= 7:
+            tid, protocol, length = struct.unpack(">HHH", self.buffer[:6])
+            if protocol != 0 or length < 2 or length > 254:
+                return False                # Lost framing
+            if len(self.buffer) < 6 + length:
+                break
+            frame, self.buffer = self.buffer[:6 + length], self.buffer[6 + length:]
+            now = time.monotonic()
+            entry = self.outstanding.pop(tid, None)
+            if entry is None:
+                continue                    # Late reply to a request already counted as a timeout
+            kind, sent, measured = entry
+            if not measured:
+                continue
+            function = frame[7]
+            if function & 0x80:
+                self.stats.record(kind, "exception", now - sent)
+            elif kind in ("read", "read-tp") and (length < 3 or frame[8] != length - 3):
+                self.stats.record(kind, "bad")
+            else:
+                self.stats.record(kind, "ok", now - sent)
+        return True
+
+    def run(self):
+        first = True
+        while time.monotonic() < self.stop_at:
+            if self.sock is None:
+                if not first:
+                    with self.stats.lock:
+                        self.stats.reconnects += 1
+                first = False
+                if not self.connect():
+                    break
+            try:
+                while len(self.outstanding) < self.args.pipeline and time.monotonic() < self.stop_at:
+                    self.send_next()
+                if not self.receive():
+                    self.drop("bad")
+                    continue
+            except OSError:
+                self.drop("bad")
+                continue
+            oldest = min((sent for _, sent, _ in self.outstanding.values()), default=None)
+            if oldest is not None and time.monotonic() - oldest > self.args.timeout:
+                self.drop("timeout")
+
+        # Let the last requests finish
+        drain_until = time.monotonic() + self.args.timeout
+        while self.sock and self.outstanding and time.monotonic() < drain_until:
+            try:
+                if not self.receive():
+                    break
+            except OSError:
+                break
+        self.drop("timeout")
+
+
+def setup_ports(url, units):
+    """Enables one port per unit on the gateway and asks for a first read of each"""
+    ports = [{"port": port, "enabled": True, "slave_id": unit} for port, unit in enumerate(units[:12], 1)]
+    request = urllib.request.Request(url.rstrip("/") + "/api/gateway/config", data=json.dumps({"ports": ports}).encode(),
+                                     headers={"Content-Type": "application/json"}, method="POST")
+    urllib.request.urlopen(request, timeout=5).read()
+    for port in range(1, len(ports) + 1):
+        request = urllib.request.Request(url.rstrip("/") + f"/api/gateway/manual-read?port={port}", data=b"", method="POST")
+        urllib.request.urlopen(request, timeout=5).read()
+
+
+def run_benchmark(args):
+    stats = Stats()
+    start = time.monotonic()
+    measure_from = start + args.warmup
+    stop_at = measure_from + args.duration
+    connections = [Connection(i, args, stats, measure_from, stop_at) for i in range(args.connections)]
+    for connection in connections:
+        connection.start()
+    for connection in connections:
+        connection.join()
+
+    all_latencies = sorted(value for values in stats.latencies.values() for value in values)
+    by_type = {}
+    for kind in REQUEST_TYPES:
+        counts = stats.outcomes[kind]
+        if counts["sent"] == 0:
+            continue
+        latencies = sorted(stats.latencies[kind])
+        by_type[kind] = dict(counts, p50_ms=round(percentile(latencies, 0.5) * 1000, 3),
+                             p99_ms=round(percentile(latencies, 0.99) * 1000, 3))
+    answered = len(all_latencies)
+    return {
+        "label": args.label,
+        "config": {
+            "host": args.host, "port": args.port, "connections": args.connections, "pipeline": args.pipeline,
+            "duration_s": args.duration, "mix": ",".join(f"{kind}={weight:g}" for kind, weight in args.mix),
+            "units": args.units_text, "timeout_s": args.timeout, "seed": args.seed,
+        },
+        "results": {
+            "answered": answered,
+            "throughput_per_s": round(answered / args.duration, 1),
+            "latency_ms": {name: round(percentile(all_latencies, q) * 1000, 3)
+                           for name, q in (("p50", 0.5), ("p90", 0.9), ("p99", 0.99), ("p999", 0.999), ("max", 1.0))},
+            "errors": sum(counts["timeout"] + counts["bad"] for counts in stats.outcomes.values()),
+            "exceptions": sum(counts["exception"] for counts in stats.outcomes.values()),
+            "reconnects": stats.reconnects,
+            "connect_failures": stats.connect_failures,
+            "by_type": by_type,
+        },
+        "host": {"python": platform.python_version(), "machine": platform.machine(), "system": platform.system()},
+    }
+
+
+def print_report(report):
+    config, results = report["config"], report["results"]
+    print(f"Modbus TCP benchmark: {config['host']}:{config['port']}, {config['connections']} connections, "
+          f"pipeline {config['pipeline']}, {config['duration_s']:g} s, mix {config['mix']}")
+    print(f"  answered     {results['answered']} ({results['throughput_per_s']:.1f}/s)")
+    latency = results["latency_ms"]
+    print("  latency ms   " + "  ".join(f"{name} {value:.3f}" for name, value in latency.items()))
+    print(f"  errors       {results['errors']} (timeouts and bad replies), exceptions {results['exceptions']}")
+    print(f"  reconnects   {results['reconnects']}, connect failures {results['connect_failures']}")
+    print(f"  {'type':<10}{'sent':>9}{'ok':>9}{'exception':>11}{'timeout':>9}{'bad':>6}{'p50 ms':>9}{'p99 ms':>9}")
+    for kind, counts in results["by_type"].items():
+        print(f"  {kind:<10}{counts['sent']:>9}{counts['ok']:>9}{counts['exception']:>11}{counts['timeout']:>9}"
+              f"{counts['bad']:>6}{counts['p50_ms']:>9.3f}{counts['p99_ms']:>9.3f}")
+
+
+def print_comparison(report, baseline):
+    def change(now, then, higher_is_better):
+        if not then:
+            return ""
+        delta = (now - then) / then * 100
+        better = delta > 0 if higher_is_better else delta < 0
+        return f"{delta:+.1f}%" + (" better" if better and abs(delta) >= 1 else " worse" if abs(delta) >= 1 else "")
+
+    now, then = report["results"], baseline["results"]
+    if report["config"] != baseline["config"]:
+        print("\nNote: the baseline was taken with different settings:", json.dumps(baseline["config"]))
+    print("\nAgainst baseline:")
+    print(f"  throughput   {now['throughput_per_s']:.1f}/s vs {then['throughput_per_s']:.1f}/s "
+          f"{change(now['throughput_per_s'], then['throughput_per_s'], True)}")
+    for name in ("p50", "p99", "p999"):
+        print(f"  {name:<12} {now['latency_ms'][name]:.3f} ms vs {then['latency_ms'][name]:.3f} ms "
+              f"{change(now['latency_ms'][name], then['latency_ms'][name], False)}")
+    print(f"  errors       {now['errors']} vs {then['errors']}, reconnects {now['reconnects']} vs {then['reconnects']}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Modbus TCP load generator and latency benchmark",
+                                     formatter_class=argparse.RawDescriptionHelpFormatter, epilog=__doc__)
+    parser.add_argument("host", nargs="?", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=502)
+    parser.add_argument("-c", "--connections", type=int, default=4, help="concurrent connections (default 4, the server's limit)")
+    parser.add_argument("-d", "--duration", type=float, default=10.0, help="measured seconds (default 10)")
+    parser.add_argument("--warmup", type=float, default=2.0, help="unmeasured seconds first (default 2)")
+    parser.add_argument("--pipeline", type=int, default=1, help="requests in flight per connection (default 1)")
+    parser.add_argument("--mix", type=parse_mix, default="read=100", help="weighted request types, e.g. read=80,write=10,unknown=10")
+    parser.add_argument("--units", default="1-12", help="unit IDs with a port (default 1-12)")
+    parser.add_argument("--unknown-unit", type=int, default=247, help="unit ID with no port, for 'unknown' (default 247)")
+    parser.add_argument("--timeout", type=float, default=1.0, help="seconds before a request counts as timed out (default 1)")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--setup-ports", metavar="URL", help="enable a port per unit through the web API first, e.g. http://127.0.0.1:80")
+    parser.add_argument("--label", default="", help="what was measured, stored with --json results")
+    parser.add_argument("--json", metavar="FILE", help="write the results as JSON (use for a new baseline)")
+    parser.add_argument("--compare", metavar="FILE", help="compare with a baseline JSON file")
+    args = parser.parse_args()
+    if isinstance(args.mix, str):
+        args.mix = parse_mix(args.mix)
+    args.units_text = args.units
+    args.units = parse_units(args.units)
+
+    if args.setup_ports:
+        setup_ports(args.setup_ports, args.units)
+
+    report = run_benchmark(args)
+    print_report(report)
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(report, f, indent=2)
+            f.write("\n")
+    if args.compare:
+        with open(args.compare) as f:
+            print_comparison(report, json.load(f))
+    return 1 if report["results"]["answered"] == 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""
+Timing checks of the RS485 side against the simulated bus
+Runs the [env:native] build with --sim-slaves and checks that the gateway keeps up with
+replies that take longer on the wire than the response timeout, and with fast ones:
+  poll        The bus and the gateway at 2400 baud (a 23-register reply is ~212 ms on the
+              wire against the default 200 ms timeout). Every port must be read without a
+              failed read.
+  detect      The bus at 1200 baud, the gateway left at its default. Serial detect must find
+              1200 baud (a unit_ID reply is ~159 ms on the wire against a 100 ms probe timeout).
+  turnaround  Slaves that answer 1 ms after the request while every SD write holds core 1
+              for 20 ms. Triggers keep the bus busy and 30% silent replies keep core 1
+              appending "recovered" lines to the system log. A reply that starts while DE
+              is still high is lost on the bus, so DE has to drop at the end of the request
+              however busy core 1 is: no reply may collide with it.
+
+The gateway is configured through the web API in real time, then the poll and turnaround
+checks run in virtual time from the saved config, so their results do not depend on host load.
+
+  pio run -e native && scripts/rs485_sim_test.py
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import time
+import urllib.request
+
+PORT_OFFSET = 8700
+SLAVES = 12
+TRIGGER_PINS = [6, 7, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29]  # PIN_TRIG_1..12
+DE_PIN = 9  # PIN_RS485_DE
+
+
+def api(method, path, body=None, timeout=5):
+    data = json.dumps(body).encode() if body is not None else (b"" if method == "POST" else None)
+    request = urllib.request.Request(f"http://127.0.0.1:{80 + PORT_OFFSET}{path}", data=data, method=method,
+                                     headers={"Content-Type": "application/json"})
+    return json.loads(urllib.request.urlopen(request, timeout=timeout).read() or b"{}")
+
+
+def start_realtime(program, fs, baud):
+    """Starts the firmware in real time and waits for the web server"""
+    process = subprocess.Popen([program, "--realtime", "--quiet", "--fs", fs, "--port-offset", str(PORT_OFFSET),
+                                "--sim-slaves", f"1-{SLAVES}", "--sim-baud", str(baud)],
+                               stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    deadline = time.monotonic() + 10
+    while time.monotonic() < deadline:
+        try:
+            api("GET", "/api/gateway/config", timeout=1)
+            return process
+        except OSError:
+            time.sleep(0.2)
+    process.kill()
+    raise RuntimeError("web server did not come up")
+
+
+def configure(baud=None):
+    """Enables port N for slave N; optionally sets the gateway's baud rate"""
+    config = {"ports": [{"port": port, "enabled": True, "slave_id": port} for port in range(1, SLAVES + 1)]}
+    if baud:
+        config["rs485"] = {"baud_rate": baud}
+    api("POST", "/api/gateway/config", config)
+
+
+def check_poll(program, fs):
+    process = start_realtime(program, fs, 2400)
+    try:
+        configure(2400)
+    finally:
+        process.kill()
+        process.wait()
+
+    output = subprocess.run([program, "--run-ms", "20000", "--fs", fs, "--port-offset", str(PORT_OFFSET),
+                             "--sim-slaves", f"1-{SLAVES}", "--sim-baud", "2400"],
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True, timeout=300).stdout
+    failures = []
+    failed_ports = sorted(set(int(port) for port in re.findall(r"Modbus read failed for port (\d+)", output)))
+    if failed_ports:
+        failures.append(f"failed reads on ports {failed_ports}")
+    replies = {int(m.group(1)): int(m.group(2)) for m in re.finditer(r"\[sim\]\s+(\d+)\s+\d+\s+(\d+)", output)}
+    unread = [slave for slave in range(1, SLAVES + 1) if replies.get(slave, 0) == 0]
+    if unread:
+        failures.append(f"slaves never read: {unread}")
+    ready = re.search(r"Startup discovery complete: (\d+) of (\d+)", output)
+    return failures, f"startup discovery {ready.group(1)} of {ready.group(2)}" if ready else "no startup discovery"
+
+
+def check_detect(program, fs):
+    process = start_realtime(program, fs, 1200)
+    try:
+        configure()
+        api("POST", "/api/gateway/detect?action=start")
+        deadline = time.monotonic() + 120
+        status = {}
+        while time.monotonic() < deadline:
+            status = api("GET", "/api/gateway/detect")
+            if status.get("state") == "done":
+                break
+            time.sleep(0.5)
+    finally:
+        process.kill()
+        process.wait()
+
+    detected = status.get("detected", {})
+    if status.get("state") != "done":
+        return ["serial detect did not finish"], ""
+    if detected.get("baud_rate") != 1200:
+        return [f"detected {detected.get('baud_rate')} instead of 1200 baud"], ""
+    return [], f"detected 1200 baud in {status.get('elapsed_ms')} ms"
+
+
+def check_turnaround(program, fs):
+    process = start_realtime(program, fs, 9600)
+    try:
+        configure()
+    finally:
+        process.kill()
+        process.wait()
+
+    pulses = [arg for pin in TRIGGER_PINS for arg in ("--pin-pulse", f"{pin}=1000")]
+    output = subprocess.run([program, "--run-ms", "600000", "--fs", fs, "--port-offset", str(PORT_OFFSET),
+                             "--sim-slaves", f"1-{SLAVES}", "--sim-latency", "1000", "--sim-silence", "0.3",
+                             "--sim-de-pin", str(DE_PIN), "--sd-write-us", "20000", *pulses],
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True, timeout=600).stdout
+    # [sim]  id  requests  replies  silent  corrupted  exceptions  collided
+    rows = [[int(value) for value in m.groups()]
+            for m in re.finditer(r"\[sim\]\s+(\d+)\s+(\d+)\s+(\d+)\s+(\d+)\s+(\d+)\s+(\d+)\s+(\d+)", output)]
+    failures = []
+    collided = sum(row[6] for row in rows)
+    if collided:
+        failures.append(f"{collided} replies collided with DE")
+    replies = sum(row[2] for row in rows)
+    if replies == 0:
+        failures.append("no replies")
+    return failures, f"{replies} replies, none collided"
+
+
+CHECKS = {"poll": check_poll, "detect": check_detect, "turnaround": check_turnaround}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Timing checks against the simulated RS485 bus",
+                                     formatter_class=argparse.RawDescriptionHelpFormatter, epilog=__doc__)
+    parser.add_argument("--program", default=".pio/build/native/program", help="native build to run")
+    parser.add_argument("checks", nargs="*", help=f"checks to run: {', '.join(CHECKS)} (default all)")
+    args = parser.parse_args()
+    unknown = [name for name in args.checks if name not in CHECKS]
+    if unknown:
+        parser.error(f"unknown check {', '.join(unknown)}")
+
+    if not os.access(args.program, os.X_OK):
+        sys.exit(f"{args.program} not found, run 'pio run -e native' first")
+
+    failed = False
+    for name in args.checks or list(CHECKS):
+        with tempfile.TemporaryDirectory(prefix="rs485sim-") as fs:
+            failures, summary = CHECKS[name](args.program, fs)
+        print(f"{name:10s} {'FAIL' if failures else 'ok'}  {'; '.join(failures) or summary}")
+        failed |= bool(failures)
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,298 @@
+#define LOG_MODULE LOG_MODULE_GATEWAY
+#include "busScanManager.h"
+#include "flowCounterManager.h"
+#include "serialDetectManager.h"
+#include "../network/network.h"
+
+// Global variables
+volatile busScanState_t busScanState = BUS_SCAN_IDLE;
+
+// Requests from the API (core 0), picked up by manageBusScan() on core 1
+static volatile bool scanStartRequested = false;
+static volatile bool scanCancelRequested = false;
+
+// Scan state - only written on core 1
+static uint8_t scanRun = 0;                  // Upper byte of the requestId, so replies to an old scan are ignored
+static uint8_t probed[(BUS_SCAN_LAST_ID + 8) / 8];
+static uint16_t nextId = BUS_SCAN_FIRST_ID;
+static bool probePending = false;
+static uint16_t probesSent = 0;
+static uint16_t probeTimeout = BUS_SCAN_TIMEOUT_MAX;
+static uint16_t probeTimeoutFloor = BUS_SCAN_TIMEOUT_MIN;
+static uint16_t probeTimeoutCeiling = BUS_SCAN_TIMEOUT_MAX;
+static uint32_t slowestLatencyUs = 0;
+static uint32_t scanStartTime = 0;
+static uint32_t scanFinishTime = 0;
+static uint16_t probeBuffer[FC_UNIT_ID_COUNT];
+
+// Append-only while a scan runs: the entry is written before the count moves, so
+// core 0 can serialize the results without a lock
+static busScanResult_t results[BUS_SCAN_MAX_RESULTS];
+static volatile uint8_t resultCount = 0;
+
+static inline bool isProbed(uint8_t id) { return probed[id >> 3] & (1 << (id & 7)); }
+static inline void setProbed(uint8_t id) { probed[id >> 3] |= (1 << (id & 7)); }
+
+// Scan control ------------------------------------------------------------>
+
+void startBusScan() {
+    scanStartRequested = true;
+}
+
+void cancelBusScan() {
+    scanCancelRequested = true;
+}
+
+static void beginScan() {
+    scanRun++;
+    resultCount = 0;
+    memset(probed, 0, sizeof(probed));
+    nextId = BUS_SCAN_FIRST_ID;
+    probePending = false;
+    probesSent = 0;
+    slowestLatencyUs = 0;
+
+    // Never shorter than a few characters at the current baud rate (11 bits per character)
+    probeTimeoutFloor = 44000 / gatewayConfig.rs485.baudRate + 1;
+    if (probeTimeoutFloor < BUS_SCAN_TIMEOUT_MIN) probeTimeoutFloor = BUS_SCAN_TIMEOUT_MIN;
+    probeTimeoutCeiling = gatewayConfig.rs485.responseTimeout < BUS_SCAN_TIMEOUT_MAX ?
+                          gatewayConfig.rs485.responseTimeout : BUS_SCAN_TIMEOUT_MAX;
+    if (probeTimeoutCeiling < probeTimeoutFloor) probeTimeoutCeiling = probeTimeoutFloor;
+    probeTimeout = probeTimeoutCeiling;
+
+    scanStartTime = millis();
+    scanFinishTime = 0;
+    busScanState = BUS_SCAN_RUNNING;
+    LOG(LOG_INFO, true, "Bus scan started (IDs %d-%d, probe timeout %d ms)\n",
+        BUS_SCAN_FIRST_ID, BUS_SCAN_LAST_ID, probeTimeout);
+}
+
+static void finishScan(bool cancelled) {
+    busScanState = BUS_SCAN_DONE;
+    scanFinishTime = millis();
+    LOG(LOG_INFO, true, "Bus scan %s: %d responders, %d probes in %" PRIu32 " ms (probe timeout %d ms)\n",
+        cancelled ? "cancelled" : "complete", resultCount, probesSent,
+        scanFinishTime - scanStartTime, probeTimeout);
+}
+
+// Configured IDs go first, so the probe timeout adapts to real devices early on
+static int16_t nextProbeId() {
+    for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
+        uint8_t id = gatewayConfig.ports[i].slaveId;
+        if (gatewayConfig.ports[i].enabled && id >= BUS_SCAN_FIRST_ID && id <= BUS_SCAN_LAST_ID && !isProbed(id)) {
+            return id;
+        }
+    }
+    while (nextId <= BUS_SCAN_LAST_ID && isProbed(nextId)) nextId++;
+    return nextId <= BUS_SCAN_LAST_ID ? nextId : -1;
+}
+
+static void busScanCallback(bool valid, uint16_t* data, uint32_t requestId) {
+    if (((requestId >> 8) & 0xFF) != scanRun) return;  // Reply to a cancelled scan
+    probePending = false;
+    if (!valid || data == nullptr) return;
+
+    uint8_t slaveId = requestId & 0xFF;
+    uint32_t rtt = modbusRTU.getLastRoundTrip();
+
+    if (resultCount < BUS_SCAN_MAX_RESULTS) {
+        busScanResult_t* result = &results[resultCount];
+        result->slaveId = slaveId;
+        result->rttUs = rtt;
+        // Same byte order as the unit_ID read in modbusResponseCallback (low byte first)
+        for (int i = 0; i < FC_UNIT_ID_COUNT; i++) {
+            result->unit_ID[i * 2] = data[i] & 0xFF;
+            result->unit_ID[i * 2 + 1] = (data[i] >> 8) & 0xFF;
+        }
+        result->unit_ID[10] = '\0';
+        resultCount++;
+    }
+
+    // The timeout runs from the last byte seen, so it only has to cover the slave's
+    // turnaround - take the response frame time out of the round trip
+    uint32_t frameUs = (uint32_t)(5 + 2 * FC_UNIT_ID_COUNT) * 11000000UL / gatewayConfig.rs485.baudRate;
+    uint32_t latencyUs = rtt > frameUs ? rtt - frameUs : 0;
+    if (latencyUs > slowestLatencyUs) slowestLatencyUs = latencyUs;
+    uint32_t timeout = slowestLatencyUs * BUS_SCAN_RTT_MARGIN / 1000 + 1;
+    if (timeout < probeTimeoutFloor) timeout = probeTimeoutFloor;
+    if (timeout > probeTimeoutCeiling) timeout = probeTimeoutCeiling;
+    probeTimeout = timeout;
+
+    LOG(LOG_INFO, false, "Bus scan: slave %d responded, RTT %" PRIu32 " us\n", slaveId, rtt);
+}
+
+// Called from manage_flowCounterManager() once startup discovery is done.
+// One probe is queued at a time, and only while the production queue is short, so the
+// master's round-robin interleaves probes with polls and trigger reads.
+void manageBusScan() {
+    if (scanCancelRequested) {
+        scanCancelRequested = false;
+        scanStartRequested = false;
+        if (busScanState == BUS_SCAN_RUNNING) {
+            scanRun++;  // Drop the reply to any probe still queued
+            finishScan(true);
+        }
+    }
+    if (scanStartRequested) {
+        scanStartRequested = false;
+        beginScan();
+    }
+
+    if (busScanState != BUS_SCAN_RUNNING || probePending || serialDetectPausesPolling()) return;
+    if (modbusRTU.getQueueCount() > MODBUS_QUEUE_SIZE - BUS_SCAN_QUEUE_RESERVE) return;
+
+    int16_t id = nextProbeId();
+    if (id < 0) {
+        finishScan(false);
+        return;
+    }
+
+    if (modbusRTU.readHoldingRegisters(id, FC_UNIT_ID_ADDRESS, probeBuffer, FC_UNIT_ID_COUNT,
+                                       busScanCallback, id | ((uint32_t)scanRun << 8), probeTimeout)) {
+        setProbed(id);
+        probePending = true;
+        probesSent++;
+    }
+}
+
+// Serialization ----------------------------------------------------------->
+
+void serializeBusScan(JsonObject obj) {
+    busScanState_t state = busScanState;
+    obj["state"] = state == BUS_SCAN_RUNNING ? "running" : (state == BUS_SCAN_DONE ? "done" : "idle");
+    obj["probed"] = probesSent;
+    obj["total"] = BUS_SCAN_LAST_ID - BUS_SCAN_FIRST_ID + 1;
+    obj["probe_timeout_ms"] = probeTimeout;
+    if (state != BUS_SCAN_IDLE) {
+        obj["elapsed_ms"] = (state == BUS_SCAN_RUNNING ? millis() : scanFinishTime) - scanStartTime;
+    }
+
+    JsonArray responders = obj.createNestedArray("responders");
+    uint8_t count = resultCount;
+    for (uint8_t r = 0; r < count; r++) {
+        JsonObject entry = responders.createNestedObject();
+        entry["slave_id"] = results[r].slaveId;
+        entry["unit_id"] = results[r].unit_ID;
+        entry["rtt_us"] = results[r].rttUs;
+        // Port already configured with this ID, 0 = unbound
+        uint8_t boundPort = 0;
+        for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
+            if (gatewayConfig.ports[i].enabled && gatewayConfig.ports[i].slaveId == results[r].slaveId) {
+                boundPort = i + 1;
+                break;
+            }
+        }
+        entry["bound_port"] = boundPort;
+    }
+}
+
+// API --------------------------------------------------------------------->
+
+void setupBusScanAPI() {
+    // Scan progress and responders so far
+    server.on("/api/gateway/scan", HTTP_GET, []() {
+        static StaticJsonDocument<3072> doc;
+        doc.clear();
+        serializeBusScan(doc.to<JsonObject>());
+
+        sendJsonChunked(200, doc);
+    });
+
+    // Start a scan, or cancel the running one with ?action=cancel
+    server.on("/api/gateway/scan", HTTP_POST, []() {
+        if (server.hasArg("action") && server.arg("action") == "cancel") {
+            cancelBusScan();
+            server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"Bus scan cancelled\"}");
+            return;
+        }
+        if (serialDetectPausesPolling()) {
+            server.send(409, "application/json", "{\"error\":\"Serial detect running\"}");
+            return;
+        }
+        startBusScan();
+        server.send(202, "application/json", "{\"status\":\"success\",\"message\":\"Bus scan started\"}");
+    });
+
+    // Bind responders to ports: {"bindings":[{"port":1,"slave_id":12}, ...]}
+    server.on("/api/gateway/scan/bind", HTTP_POST, []() {
+        if (!server.hasArg("plain")) {
+            server.send(400, "application/json", "{\"error\":\"No data received\"}");
+            return;
+        }
+
+        StaticJsonDocument<1024> doc;
+        DeserializationError error = deserializeJson(doc, server.arg("plain"));
+        if (error || !doc["bindings"].is<JsonArray>()) {
+            server.send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+            return;
+        }
+
+        // Validate everything before changing anything
+        JsonArray bindings = doc["bindings"];
+        bool enabled[MAX_FLOW_COUNTERS];
+        uint8_t slaveIds[MAX_FLOW_COUNTERS];
+        bool rebound[MAX_FLOW_COUNTERS];
+        for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
+            rebound[i] = false;
+            enabled[i] = gatewayConfig.ports[i].enabled;
+            slaveIds[i] = gatewayConfig.ports[i].slaveId;
+        }
+        for (JsonObject binding : bindings) {
+            int port = binding["port"] | 0;
+            int slaveId = binding["slave_id"] | 0;
+            if (port < 1 || port > MAX_FLOW_COUNTERS || slaveId < BUS_SCAN_FIRST_ID || slaveId > BUS_SCAN_LAST_ID) {
+                server.send(400, "application/json", "{\"error\":\"Invalid port or slave ID\"}");
+                return;
+            }
+            rebound[port - 1] = true;
+            enabled[port - 1] = true;
+            slaveIds[port - 1] = slaveId;
+        }
+
+        // All ports share one bus, so two enabled ports can't poll the same slave
+        for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
+            for (int j = i + 1; j < MAX_FLOW_COUNTERS; j++) {
+                if ((rebound[i] || rebound[j]) && enabled[i] && enabled[j] && slaveIds[i] == slaveIds[j]) {
+                    char response[96];
+                    snprintf(response, sizeof(response),
+                             "{\"error\":\"Slave ID %d would be used by ports %d and %d\"}", slaveIds[i], i + 1, j + 1);
+                    server.send(409, "application/json", response);
+                    return;
+                }
+            }
+        }
+
+        // The port data is reset together with the binding, so core 1 must not be in it
+        int retries = BUS_SCAN_BIND_LOCK_RETRIES;
+        while (flowCounterDataLocked && retries-- > 0) delay(2);
+        if (flowCounterDataLocked) {
+            server.send(503, "application/json", "{\"error\":\"Port data busy, try again\"}");
+            return;
+        }
+        flowCounterDataLocked = true;
+
+        uint8_t bound = 0;
+        for (JsonObject binding : bindings) {
+            int idx = (binding["port"] | 0) - 1;
+            gatewayConfig.ports[idx].slaveId = binding["slave_id"] | 0;
+            gatewayConfig.ports[idx].enabled = true;
+            flowCounterData[idx].dataValid = false;
+            flowCounterData[idx].commError = false;
+            flowCounterData[idx].pendingInitialRead = true;
+            markPortDataChanged(idx);
+            bound++;
+        }
+        flowCounterDataLocked = false;
+
+        for (JsonObject binding : bindings) {
+            LOG(LOG_INFO, true, "Port %d bound to slave ID %d from bus scan\n", (binding["port"] | 0), (binding["slave_id"] | 0));
+        }
+        saveGatewayConfig();
+
+        char response[96];
+        snprintf(response, sizeof(response),
+                 "{\"status\":\"success\",\"message\":\"%d port%s bound. Configuration saved.\"}",
+                 bound, bound == 1 ? "" : "s");
+        server.send(200, "application/json", response);
+    });
+}
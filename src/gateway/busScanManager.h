@@ -0,0 +1,35 @@
+#pragma once
+
+#include "flowCounterConfig.h"
+
+// Bus scan - probes every slave ID for a flow counter, between normal polls
+#define BUS_SCAN_FIRST_ID 1
+#define BUS_SCAN_LAST_ID 247
+#define BUS_SCAN_MAX_RESULTS 32
+#define BUS_SCAN_TIMEOUT_MIN 15          // Floor for the adaptive probe timeout (ms)
+#define BUS_SCAN_TIMEOUT_MAX 100         // Probe timeout until a responder has been timed (ms)
+#define BUS_SCAN_RTT_MARGIN 2            // Probe timeout = slowest slave turnaround seen * margin
+#define BUS_SCAN_QUEUE_RESERVE 4         // Modbus queue slots kept free for production reads
+#define BUS_SCAN_BIND_LOCK_RETRIES 10    // 2 ms waits for the port data lock before a bind gives up
+
+enum busScanState_t {
+  BUS_SCAN_IDLE,
+  BUS_SCAN_RUNNING,
+  BUS_SCAN_DONE
+};
+
+struct busScanResult_t {
+  uint8_t slaveId;
+  char unit_ID[11];
+  uint32_t rttUs;               // Request sent -> last response byte
+};
+
+// Function prototypes
+void startBusScan();            // Safe from either core, the scan starts on core 1
+void cancelBusScan();
+void manageBusScan();
+void serializeBusScan(JsonObject obj);
+void setupBusScanAPI();
+
+// Global variables
+extern volatile busScanState_t busScanState;
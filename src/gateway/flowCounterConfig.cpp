@@ -1,3 +1,4 @@
+#define LOG_MODULE LOG_MODULE_GATEWAY
 #include "flowCounterConfig.h"
 #include "flowCounterManager.h"
 #include "../network/network.h"
@@ -6,6 +7,14 @@
 GatewayConfig gatewayConfig;
 FlowCounterData flowCounterData[MAX_FLOW_COUNTERS];
 volatile bool flowCounterDataLocked = false;
+volatile uint32_t flowCounterDataGeneration = 1;
+volatile uint32_t flowCounterPortGeneration[MAX_FLOW_COUNTERS];
+
+static bool importLegacyGatewayConfig();
+
+static char gatewayDataCache[GATEWAY_DATA_CACHE_SIZE];
+static size_t gatewayDataCacheLength = 0;
+static uint32_t gatewayDataCacheGeneration = 0;
 
 void init_gatewayConfig() {
     // Initialize flow counter data FIRST
@@ -21,9 +30,9 @@ void init_gatewayConfig() {
         memset(flowCounterData[i].unit_ID, 0, sizeof(flowCounterData[i].unit_ID));
     }
     
-    // Load configuration from LittleFS to get correct pin assignments
+    // Load configuration record to get correct pin assignments
     if (!loadGatewayConfig()) {
-        log(LOG_WARNING, false, "Failed to load gateway config, using defaults\n");
+        LOG(LOG_WARNING, false, "Failed to load gateway config, using defaults\n");
         setDefaultGatewayConfig();
         saveGatewayConfig();
     }
@@ -33,11 +42,11 @@ void init_gatewayConfig() {
         pinMode(gatewayConfig.ports[i].triggerPin, INPUT_PULLUP);
         delay(1);  // Allow pull-up to settle
         int pinState = digitalRead(gatewayConfig.ports[i].triggerPin);
-        log(LOG_INFO, false, "Port %d: Trigger pin %d set to INPUT_PULLUP, reads as %d (%s)\n",
+        LOG(LOG_INFO, false, "Port %d: Trigger pin %d set to INPUT_PULLUP, reads as %d (%s)\n",
             i + 1, gatewayConfig.ports[i].triggerPin, pinState, pinState == HIGH ? "HIGH/idle" : "LOW/triggered");
     }
     
-    log(LOG_INFO, false, "Gateway configuration initialized\n");
+    LOG(LOG_INFO, false, "Gateway configuration initialized\n");
 }
 
 void setDefaultGatewayConfig() {
@@ -64,40 +73,37 @@ void setDefaultGatewayConfig() {
 }
 
 bool loadGatewayConfig() {
-    log(LOG_INFO, true, "Loading gateway configuration\n");
-    
-    if (!LittleFS.begin()) {
-        log(LOG_WARNING, true, "Failed to mount LittleFS\n");
-        return false;
-    }
+    LOG(LOG_INFO, true, "Loading gateway configuration\n");
     
-    if (!LittleFS.exists(GATEWAY_CONFIG_FILENAME)) {
-        log(LOG_WARNING, true, "Gateway config file not found\n");
-        LittleFS.end();
-        return false;
+    if (!loadConfigRecord(GATEWAY_CONFIG_FILENAME, GATEWAY_CONFIG_VERSION, &gatewayConfig, sizeof(gatewayConfig))) {
+        // Firmware before the binary record kept the config as JSON
+        if (!importLegacyGatewayConfig()) {
+            LOG(LOG_WARNING, true, "Gateway config not found\n");
+            return false;
+        }
+        saveGatewayConfig();
+        removeLegacyConfig(GATEWAY_CONFIG_LEGACY_FILENAME);
+        LOG(LOG_INFO, true, "Gateway configuration imported from %s\n", GATEWAY_CONFIG_LEGACY_FILENAME);
     }
     
-    File configFile = LittleFS.open(GATEWAY_CONFIG_FILENAME, "r");
-    if (!configFile) {
-        log(LOG_WARNING, true, "Failed to open gateway config file\n");
-        LittleFS.end();
-        return false;
+    // Validate serial config - must not be 0
+    if (gatewayConfig.rs485.serialConfig == 0) {
+        LOG(LOG_WARNING, false, "Invalid serial config (0x0), using default SERIAL_8N1\n");
+        gatewayConfig.rs485.serialConfig = SERIAL_8N1;
     }
     
+    LOG(LOG_INFO, true, "Gateway configuration loaded successfully\n");
+    return true;
+}
+
+static bool importLegacyGatewayConfig() {
     StaticJsonDocument<2048> doc;
-    DeserializationError error = deserializeJson(doc, configFile);
-    configFile.close();
-    LittleFS.end();
-    
-    if (error) {
-        log(LOG_WARNING, true, "Failed to parse gateway config: %s\n", error.c_str());
-        return false;
-    }
+    if (!readLegacyConfig(GATEWAY_CONFIG_LEGACY_FILENAME, doc)) return false;
     
     // Check magic number
     uint8_t magicNumber = doc["magic_number"] | 0;
     if (magicNumber != GATEWAY_CONFIG_MAGIC_NUMBER) {
-        log(LOG_WARNING, true, "Invalid magic number in gateway config\n");
+        LOG(LOG_WARNING, true, "Invalid magic number in gateway config\n");
         return false;
     }
     
@@ -106,12 +112,6 @@ bool loadGatewayConfig() {
     gatewayConfig.rs485.serialConfig = doc["rs485"]["serial_config"] | DEFAULT_MODBUS_CONFIG;
     gatewayConfig.rs485.responseTimeout = doc["rs485"]["response_timeout"] | 200;
     
-    // Validate serial config - must not be 0
-    if (gatewayConfig.rs485.serialConfig == 0) {
-        log(LOG_WARNING, false, "Invalid serial config (0x0), using default SERIAL_8N1\n");
-        gatewayConfig.rs485.serialConfig = SERIAL_8N1;
-    }
-    
     // Parse port configurations
     JsonArray portsArray = doc["ports"];
     if (portsArray) {
@@ -130,82 +130,122 @@ bool loadGatewayConfig() {
             idx++;
         }
     }
-    
-    log(LOG_INFO, true, "Gateway configuration loaded successfully\n");
     return true;
 }
 
 void saveGatewayConfig() {
-    log(LOG_INFO, true, "Saving gateway configuration\n");
+    if (saveConfigRecord(GATEWAY_CONFIG_FILENAME, GATEWAY_CONFIG_VERSION, &gatewayConfig, sizeof(gatewayConfig))) {
+        LOG(LOG_INFO, true, "Gateway configuration saved\n");
+    }
+}
+
+// Called by whoever changes a port's reported data (holding flowCounterDataLocked)
+void markPortDataChanged(int portIndex) {
+    flowCounterPortGeneration[portIndex]++;
+    flowCounterDataGeneration++;
+}
+
+// Fields of one port as reported by /api/gateway/data and the event stream
+void serializeFlowCounterPort(JsonObject fcObj, int portIndex) {
+    fcObj["port"] = portIndex + 1;
+    fcObj["enabled"] = gatewayConfig.ports[portIndex].enabled;
+    fcObj["slave_id"] = gatewayConfig.ports[portIndex].slaveId;
+    fcObj["name"] = gatewayConfig.ports[portIndex].portName;
+    fcObj["data_valid"] = flowCounterData[portIndex].dataValid;
+    fcObj["comm_error"] = flowCounterData[portIndex].commError;
+    fcObj["trigger_count"] = flowCounterData[portIndex].triggerCount;
     
-    if (!LittleFS.begin()) {
-        log(LOG_WARNING, true, "Failed to mount LittleFS\n");
-        return;
+    if (flowCounterData[portIndex].dataValid) {
+        JsonObject data = fcObj.createNestedObject("data");
+        data["volume"] = flowCounterData[portIndex].volume;
+        data["volume_normalised"] = flowCounterData[portIndex].volume_normalised;
+        data["flow"] = flowCounterData[portIndex].flow;
+        data["flow_normalised"] = flowCounterData[portIndex].flow_normalised;
+        data["temperature"] = flowCounterData[portIndex].temperature;  // Snapshot temp (regs 8-9)
+        data["pressure"] = flowCounterData[portIndex].pressure;  // Snapshot pressure (regs 10-11)
+        data["current_temperature"] = flowCounterData[portIndex].currentTemperature;  // Live temp (regs 30-31)
+        data["current_pressure"] = flowCounterData[portIndex].currentPressure;  // Live pressure (regs 32-33)
+        data["timestamp"] = flowCounterData[portIndex].timestamp;
+        data["psu_volts"] = flowCounterData[portIndex].psu_volts;
+        data["batt_volts"] = flowCounterData[portIndex].batt_volts;
+        data["unit_id"] = flowCounterData[portIndex].unit_ID;
+        data["last_update"] = flowCounterData[portIndex].lastUpdate;
     }
+}
+
+// Serialize all ports into gatewayDataCache and tag it with the generation it reflects.
+// Caller holds flowCounterDataLocked.
+static void buildGatewayDataCache() {
+    uint32_t generation = flowCounterDataGeneration;
     
-    StaticJsonDocument<2048> doc;
+    // Static: 12 ports with copied name/unit strings need more than a 4KB document
+    static StaticJsonDocument<6144> doc;
+    doc.clear();
     
-    // Store magic number
-    doc["magic_number"] = GATEWAY_CONFIG_MAGIC_NUMBER;
+    JsonArray dataArray = doc.createNestedArray("flow_counters");
+    for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
+        serializeFlowCounterPort(dataArray.createNestedObject(), i);
+    }
     
-    // Store RS485 configuration
-    JsonObject rs485 = doc.createNestedObject("rs485");
+    size_t length = serializeJson(doc, gatewayDataCache, sizeof(gatewayDataCache));
+    if (doc.overflowed() || length >= sizeof(gatewayDataCache) - 1) {
+        LOG(LOG_ERROR, false, "Gateway data response truncated (%d bytes)\n", (int)length);
+    }
+    gatewayDataCacheLength = length;
+    gatewayDataCacheGeneration = generation;
+}
+
+// Current /api/gateway/data body, rebuilt if stale. Returns nullptr if it has never been built
+// and the data is locked right now. lockHeld: the caller already holds flowCounterDataLocked.
+const char* getGatewayDataBody(size_t* length, uint32_t* generation, bool lockHeld) {
+    if (gatewayDataCacheGeneration != flowCounterDataGeneration) {
+        if (lockHeld) {
+            buildGatewayDataCache();
+        } else if (!flowCounterDataLocked) {
+            flowCounterDataLocked = true;
+            buildGatewayDataCache();
+            flowCounterDataLocked = false;
+        }
+    }
+    if (gatewayDataCacheLength == 0) return nullptr;
+    *length = gatewayDataCacheLength;
+    *generation = gatewayDataCacheGeneration;
+    return gatewayDataCache;
+}
+
+// The body as last built, never rebuilt - for a reader still part way through writing it out
+const char* peekGatewayDataBody(size_t* length, uint32_t* generation) {
+    if (gatewayDataCacheLength == 0) return nullptr;
+    *length = gatewayDataCacheLength;
+    *generation = gatewayDataCacheGeneration;
+    return gatewayDataCache;
+}
+
+// RS485 and port settings as reported by /api/gateway/config
+void serializeGatewayConfig(JsonObject config) {
+    // RS485 configuration
+    JsonObject rs485 = config.createNestedObject("rs485");
     rs485["baud_rate"] = gatewayConfig.rs485.baudRate;
-    rs485["serial_config"] = (uint32_t)gatewayConfig.rs485.serialConfig;
+    rs485["serial_config"] = gatewayConfig.rs485.serialConfig;
     rs485["response_timeout"] = gatewayConfig.rs485.responseTimeout;
     
-    // Store port configurations
-    JsonArray portsArray = doc.createNestedArray("ports");
+    // Port configurations
+    JsonArray portsArray = config.createNestedArray("ports");
     for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
         JsonObject portObj = portsArray.createNestedObject();
+        portObj["port"] = i + 1;
         portObj["enabled"] = gatewayConfig.ports[i].enabled;
         portObj["slave_id"] = gatewayConfig.ports[i].slaveId;
         portObj["name"] = gatewayConfig.ports[i].portName;
         portObj["log_to_sd"] = gatewayConfig.ports[i].logToSD;
-        portObj["trigger_pin"] = gatewayConfig.ports[i].triggerPin;
     }
-    
-    File configFile = LittleFS.open(GATEWAY_CONFIG_FILENAME, "w");
-    if (!configFile) {
-        log(LOG_WARNING, true, "Failed to open gateway config file for writing\n");
-        LittleFS.end();
-        return;
-    }
-    
-    size_t bytesWritten = serializeJson(doc, configFile);
-    if (bytesWritten == 0) {
-        log(LOG_WARNING, true, "Failed to serialize gateway config\n");
-        configFile.close();
-        LittleFS.end();
-        return;
-    }
-    
-    configFile.close();
-    LittleFS.end();
-    log(LOG_INFO, true, "Gateway configuration saved\n");
 }
 
 void setupGatewayConfigAPI() {
     // Get gateway configuration
     server.on("/api/gateway/config", HTTP_GET, []() {
         StaticJsonDocument<2048> doc;
-        
-        // RS485 configuration
-        JsonObject rs485 = doc.createNestedObject("rs485");
-        rs485["baud_rate"] = gatewayConfig.rs485.baudRate;
-        rs485["serial_config"] = gatewayConfig.rs485.serialConfig;
-        rs485["response_timeout"] = gatewayConfig.rs485.responseTimeout;
-        
-        // Port configurations
-        JsonArray portsArray = doc.createNestedArray("ports");
-        for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
-            JsonObject portObj = portsArray.createNestedObject();
-            portObj["port"] = i + 1;
-            portObj["enabled"] = gatewayConfig.ports[i].enabled;
-            portObj["slave_id"] = gatewayConfig.ports[i].slaveId;
-            portObj["name"] = gatewayConfig.ports[i].portName;
-            portObj["log_to_sd"] = gatewayConfig.ports[i].logToSD;
-        }
+        serializeGatewayConfig(doc.to<JsonObject>());
         
         String response;
         serializeJson(doc, response);
@@ -286,7 +326,7 @@ void setupGatewayConfigAPI() {
         
         // Apply RS485 changes immediately - reinitialize Modbus RTU if needed
         if (rs485Changed || timeoutChanged) {
-            log(LOG_INFO, true, "RS485 configuration changed: baud=%d, config=0x%X, timeout=%d ms\n",
+            LOG(LOG_INFO, true, "RS485 configuration changed: baud=%d, config=0x%X, timeout=%d ms\n",
                 gatewayConfig.rs485.baudRate, gatewayConfig.rs485.serialConfig, 
                 gatewayConfig.rs485.responseTimeout);
             reinit_modbusRTU();
@@ -315,58 +355,42 @@ void setupGatewayConfigAPI() {
             }
             flowCounterDataLocked = false;
         }
+        
+        // Port names/enables are part of /api/gateway/data and the event stream
+        for (int i = 0; i < MAX_FLOW_COUNTERS; i++) markPortDataChanged(i);
     });
     
     // Get flow counter data
     server.on("/api/gateway/data", HTTP_GET, []() {
-        if (flowCounterDataLocked) {
+        // Rebuild the cached body only if a callback or config change has touched the data.
+        // While core 1 holds the lock, the previous body is served rather than failing the poll.
+        size_t length;
+        uint32_t generation;
+        const char* body = getGatewayDataBody(&length, &generation);
+        if (body == nullptr) {
             server.send(423, "application/json", "{\"error\":\"Data locked\"}");
             return;
         }
-        
-        flowCounterDataLocked = true;
-        
-        StaticJsonDocument<4096> doc;
-        
-        // Add system timing info for client-side calculations
-        doc["current_millis"] = millis();
-        doc["millis_rollover_count"] = millisRolloverCount;
-        
-        JsonArray dataArray = doc.createNestedArray("flow_counters");
-        
-        for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
-            JsonObject fcObj = dataArray.createNestedObject();
-            fcObj["port"] = i + 1;
-            fcObj["enabled"] = gatewayConfig.ports[i].enabled;
-            fcObj["slave_id"] = gatewayConfig.ports[i].slaveId;
-            fcObj["name"] = gatewayConfig.ports[i].portName;
-            fcObj["data_valid"] = flowCounterData[i].dataValid;
-            fcObj["comm_error"] = flowCounterData[i].commError;
-            fcObj["trigger_count"] = flowCounterData[i].triggerCount;
-            
-            if (flowCounterData[i].dataValid) {
-                JsonObject data = fcObj.createNestedObject("data");
-                data["volume"] = flowCounterData[i].volume;
-                data["volume_normalised"] = flowCounterData[i].volume_normalised;
-                data["flow"] = flowCounterData[i].flow;
-                data["flow_normalised"] = flowCounterData[i].flow_normalised;
-                data["temperature"] = flowCounterData[i].temperature;  // Snapshot temp (regs 8-9)
-                data["pressure"] = flowCounterData[i].pressure;  // Snapshot pressure (regs 10-11)
-                data["current_temperature"] = flowCounterData[i].currentTemperature;  // Live temp (regs 30-31)
-                data["current_pressure"] = flowCounterData[i].currentPressure;  // Live pressure (regs 32-33)
-                data["timestamp"] = flowCounterData[i].timestamp;
-                data["psu_volts"] = flowCounterData[i].psu_volts;
-                data["batt_volts"] = flowCounterData[i].batt_volts;
-                data["unit_id"] = flowCounterData[i].unit_ID;
-                data["last_update"] = flowCounterData[i].lastUpdate;
-            }
+
+        // Boot tag keeps ETags from one boot matching a different body after a restart
+        static uint32_t bootTag = rp2040.hwrand32();
+        char etag[24];
+        snprintf(etag, sizeof(etag), "\"%08" PRIx32 "-%" PRIu32 "\"", bootTag, generation);
+        server.sendHeader("ETag", etag);
+        server.sendHeader("Cache-Control", "no-cache");
+
+        // Live clock for "time since" calculations - outside the body so the body stays cacheable
+        server.sendHeader("X-Current-Millis", String(millis()));
+        server.sendHeader("X-Millis-Rollover-Count", String(millisRolloverCount));
+
+        if (server.hasHeader("If-None-Match") && server.header("If-None-Match") == etag) {
+            server.send(304, "application/json", "");
+            return;
         }
-        
-        flowCounterDataLocked = false;
-        
-        String response;
-        serializeJson(doc, response);
-        server.send(200, "application/json", response);
+
+        server.setContentLength(length);
+        server.send(200, "application/json", "");
+        server.sendContent(body, length);
     });
     
     // Manual read trigger for a specific port
@@ -5,8 +5,10 @@
 
 #include "../sys_init.h"
 
-// LittleFS configuration file
-#define GATEWAY_CONFIG_FILENAME "/gateway_config.json"
+// LittleFS configuration record (see configStore.h)
+#define GATEWAY_CONFIG_FILENAME "/gateway_config.bin"
+#define GATEWAY_CONFIG_VERSION 1
+#define GATEWAY_CONFIG_LEGACY_FILENAME "/gateway_config.json"   // Imported once, then removed
 #define GATEWAY_CONFIG_MAGIC_NUMBER 0xFC
 
 // Modbus RTU configuration defaults
@@ -62,14 +64,24 @@ struct GatewayConfig {
     FlowCounterPortConfig ports[MAX_FLOW_COUNTERS];
 };
 
+// Serialized /api/gateway/data body, rebuilt only when flowCounterDataGeneration moves
+#define GATEWAY_DATA_CACHE_SIZE 6144
+
 // Function prototypes
 void init_gatewayConfig();
 bool loadGatewayConfig();
 void saveGatewayConfig();
 void setDefaultGatewayConfig();
 void setupGatewayConfigAPI();
+void markPortDataChanged(int portIndex);
+void serializeFlowCounterPort(JsonObject fcObj, int portIndex);
+const char* getGatewayDataBody(size_t* length, uint32_t* generation, bool lockHeld = false);
+const char* peekGatewayDataBody(size_t* length, uint32_t* generation);
+void serializeGatewayConfig(JsonObject config);
 
 // Global variables
 extern GatewayConfig gatewayConfig;
 extern FlowCounterData flowCounterData[MAX_FLOW_COUNTERS];
 extern volatile bool flowCounterDataLocked;
+extern volatile uint32_t flowCounterDataGeneration;  // Bumped whenever /api/gateway/data output would change
+extern volatile uint32_t flowCounterPortGeneration[MAX_FLOW_COUNTERS];  // Same, per port
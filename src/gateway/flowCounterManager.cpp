@@ -1,21 +1,32 @@
+#define LOG_MODULE LOG_MODULE_GATEWAY
 #include "flowCounterManager.h"
 #include "../storage/sdManager.h"
 #include "../utils/statusManager.h"
 
 // Global variables
 ModbusRTUMaster modbusRTU;
+static ModbusRTUDmaTransport rs485Uart(&Serial1, uart0, PIN_RS485_DE);  // Replies arrive by DMA
+static ModbusRTUTransport* rs485Transport = &rs485Uart;
 volatile bool triggerFlags[MAX_FLOW_COUNTERS] = {false};
 volatile bool triggerStates[MAX_FLOW_COUNTERS] = {false};  // Track previous state
-static uint32_t lastTriggerCheck = 0;
 // lastOfflineCheck removed - checkOfflineDevices() no longer used
 static uint32_t lastPeriodicPoll = 0;
 static uint8_t nextPeriodicPollChannel = 0;  // Track which channel to poll next
 static uint16_t modbusBuffer[FC_REGISTER_COUNT];
 static uint16_t modbusTempPressureBuffer[FC_TEMP_PRESSURE_COUNT];
 
-#define TRIGGER_CHECK_INTERVAL 10        // Check triggers every 10ms
 #define PERIODIC_POLL_INTERVAL 833       // Staggered polling: 10000ms / 12 channels = 833ms per channel
 
+// Startup discovery - one read per enabled port, back to back, from the normal loop
+static bool discoveryActive = false;
+static int8_t discoveryPort = -1;            // Port of the discovery read in flight (-1 = none yet)
+static uint32_t discoveryStartTime = 0;
+static uint32_t discoveryRequestTime = 0;
+static uint8_t discoveryAttempts[MAX_FLOW_COUNTERS];
+static uint32_t discoveryLastAttempt[MAX_FLOW_COUNTERS];
+
+static void manageStartupDiscovery();
+
 void init_flowCounterManager() {
     // Initialize ModbusRTU on Serial1 (UART0)
     Serial1.setRX(PIN_RS485_RX);
@@ -30,9 +41,9 @@ void init_flowCounterManager() {
     digitalWrite(PIN_RS485_TERM, HIGH);
     
     // Initialize Modbus RTU Master
-    if (!modbusRTU.begin(&Serial1, gatewayConfig.rs485.baudRate, 
-                         gatewayConfig.rs485.serialConfig, PIN_RS485_DE)) {
-        log(LOG_ERROR, false, "Failed to initialize Modbus RTU Master\n");
+    if (!modbusRTU.begin(rs485Transport, gatewayConfig.rs485.baudRate, 
+                         gatewayConfig.rs485.serialConfig)) {
+        LOG(LOG_ERROR, false, "Failed to initialize Modbus RTU Master\n");
         return;
     }
     
@@ -53,7 +64,7 @@ void init_flowCounterManager() {
     if (stopBitField == 0x3) stopBits = "2";
     else if (stopBitField == 0x1) stopBits = "1";
     
-    log(LOG_INFO, false, "Flow Counter Manager initialized (Baud: %d, Format: 8%s%s, Timeout: %d ms, DE pin: %d)\n", 
+    LOG(LOG_INFO, false, "Flow Counter Manager initialized (Baud: %d, Format: 8%s%s, Timeout: %d ms, DE pin: %d)\n", 
         gatewayConfig.rs485.baudRate, parity, stopBits,
         gatewayConfig.rs485.responseTimeout, PIN_RS485_DE);
     
@@ -62,26 +73,28 @@ void init_flowCounterManager() {
     for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
         if (gatewayConfig.ports[i].enabled) {
             triggerStates[i] = (digitalRead(gatewayConfig.ports[i].triggerPin) == LOW);
-            log(LOG_INFO, false, "Port %d: Trigger pin %d initialized to state %d\n", 
+            LOG(LOG_INFO, false, "Port %d: Trigger pin %d initialized to state %d\n", 
                 i + 1, gatewayConfig.ports[i].triggerPin, triggerStates[i]);
         }
     }
     
-    // Poll all configured devices on startup (after a longer delay to allow hardware to stabilize)
-    // Flow counter devices need time to initialize their Modbus interface after power-up
-    log(LOG_INFO, false, "Waiting for flow counters to initialize...\n");
-    delay(1000);  // Increased from 100ms to 1000ms
-    pollAllConfiguredDevices();
+    // Ports are discovered from manage_flowCounterManager(), so nothing waits here
+    startStartupDiscovery();
+}
+
+// Puts the bus on another transport from the next (re)init, nullptr = back to Serial1
+void setRS485Transport(ModbusRTUTransport* transport) {
+    rs485Transport = transport != nullptr ? transport : &rs485Uart;
 }
 
 // Reinitialize Modbus RTU with new configuration (e.g., after settings change)
 void reinit_modbusRTU() {
-    log(LOG_INFO, false, "Reinitializing Modbus RTU with new configuration...\n");
+    LOG(LOG_INFO, false, "Reinitializing Modbus RTU with new configuration...\n");
     
     // Reinitialize Modbus RTU Master with new settings
-    if (!modbusRTU.begin(&Serial1, gatewayConfig.rs485.baudRate, 
-                         gatewayConfig.rs485.serialConfig, PIN_RS485_DE)) {
-        log(LOG_ERROR, false, "Failed to reinitialize Modbus RTU Master\n");
+    if (!modbusRTU.begin(rs485Transport, gatewayConfig.rs485.baudRate, 
+                         gatewayConfig.rs485.serialConfig)) {
+        LOG(LOG_ERROR, false, "Failed to reinitialize Modbus RTU Master\n");
         return;
     }
     
@@ -102,7 +115,7 @@ void reinit_modbusRTU() {
     if (stopBitField == 0x3) stopBits = "2";
     else if (stopBitField == 0x1) stopBits = "1";
     
-    log(LOG_INFO, false, "Modbus RTU reinitialized (Baud: %d, Format: 8%s%s, Timeout: %d ms)\n", 
+    LOG(LOG_INFO, false, "Modbus RTU reinitialized (Baud: %d, Format: 8%s%s, Timeout: %d ms)\n", 
         gatewayConfig.rs485.baudRate, parity, stopBits, 
         gatewayConfig.rs485.responseTimeout);
 }
@@ -110,13 +123,17 @@ void reinit_modbusRTU() {
 void manage_flowCounterManager() {
     // Always call modbusRTU.manage() to process queue
     modbusRTU.manage();
-    
-    // Check for triggers periodically
-    if (millis() - lastTriggerCheck >= TRIGGER_CHECK_INTERVAL) {
-        lastTriggerCheck = millis();
-        checkTriggers();
+    manageStartupDiscovery();
+    if (!discoveryActive) {
+        manageBusScan();
+        manageSerialDetect();
     }
     
+    // Triggers are checked by their own scheduler task (TRIGGER_CHECK_INTERVAL)
+    
+    // Serial detect has the bus at trial settings - triggers stay flagged until it is done
+    if (serialDetectPausesPolling()) return;
+    
     // NOTE: checkOfflineDevices() is now redundant - periodicPollConfiguredDevices() handles:
     //   - Never-connected devices (full reads to get initial data)
     //   - Connected devices (temp/pressure reads)
@@ -125,7 +142,8 @@ void manage_flowCounterManager() {
     
     // Staggered periodic polling: polls one channel every 833ms (complete cycle in ~10 seconds)
     // This prevents queue overflow (queue holds 10 items, we have 12 channels)
-    if (millis() - lastPeriodicPoll >= PERIODIC_POLL_INTERVAL) {
+    // Discovery already covers every port while it runs
+    if (!discoveryActive && millis() - lastPeriodicPoll >= PERIODIC_POLL_INTERVAL) {
         lastPeriodicPoll = millis();
         periodicPollConfiguredDevices();
     }
@@ -134,7 +152,7 @@ void manage_flowCounterManager() {
     for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
         if (triggerFlags[i] && gatewayConfig.ports[i].enabled) {
             // Clear flag immediately after queuing to prevent multiple reads
-            log(LOG_DEBUG, false, "Processing trigger for port %d (triggerState:%d)\n", 
+            LOG_RATE_LIMITED(LOG_DEBUG, false, "Processing trigger for port %d (triggerState:%d)\n", 
                 i + 1, triggerStates[i]);
             triggerFlags[i] = false;
             readFlowCounter(i, true);  // fromTrigger = true
@@ -149,7 +167,7 @@ void manage_flowCounterManager() {
         
         for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
             if (flowCounterData[i].pendingInitialRead && gatewayConfig.ports[i].enabled) {
-                log(LOG_INFO, false, "Processing pending initial read for port %d\n", i + 1);
+                LOG(LOG_INFO, false, "Processing pending initial read for port %d\n", i + 1);
                 flowCounterData[i].pendingInitialRead = false;
                 readFlowCounter(i);
                 break;  // Process one at a time
@@ -168,7 +186,7 @@ void checkTriggers() {
         
         // Debug: Log any state changes
         if (currentState != triggerStates[i]) {
-            log(LOG_INFO, false, "Port %d: GPIO pin %d changed from %d to %d (state:%d->%d)\n",
+            LOG_RATE_LIMITED(LOG_INFO, false, "Port %d: GPIO pin %d changed from %d to %d (state:%d->%d)\n",
                 i + 1, gatewayConfig.ports[i].triggerPin, 
                 triggerStates[i] ? LOW : HIGH, pinValue,
                 triggerStates[i], currentState);
@@ -178,14 +196,14 @@ void checkTriggers() {
         if (currentState && !triggerStates[i]) {
             // Falling edge detected - set trigger flag to queue a read
             triggerFlags[i] = true;
-            log(LOG_INFO, false, "Trigger FALLING edge on port %d (was:%d now:%d)\n", 
+            LOG_RATE_LIMITED(LOG_INFO, false, "Trigger FALLING edge on port %d (was:%d now:%d)\n", 
                 i + 1, triggerStates[i], currentState);
         }
         
         // Detect rising edge (LOW -> HIGH transition)
         if (!currentState && triggerStates[i]) {
             // Rising edge - trigger released
-            log(LOG_INFO, false, "Trigger RISING edge on port %d (was:%d now:%d)\n", 
+            LOG_RATE_LIMITED(LOG_INFO, false, "Trigger RISING edge on port %d (was:%d now:%d)\n", 
                 i + 1, triggerStates[i], currentState);
         }
         
@@ -207,7 +225,7 @@ void readFlowCounter(uint8_t portIndex, bool fromTrigger) {
     if (!modbusRTU.readHoldingRegisters(slaveId, FC_START_ADDRESS, modbusBuffer, 
                                         FC_REGISTER_COUNT, modbusResponseCallback, 
                                         requestId)) {
-        log(LOG_WARNING, false, "Failed to queue read request for port %d\n", portIndex + 1);
+        LOG(LOG_WARNING, false, "Failed to queue read request for port %d\n", portIndex + 1);
         
         // Mark as comm error only if device was previously connected
         if (!flowCounterDataLocked) {
@@ -219,6 +237,7 @@ void readFlowCounter(uint8_t portIndex, bool fromTrigger) {
                 leds.setPixelColor(portIndex + 2, LED_COLOR_PURPLE);  // Purple for not yet connected
             }
             flowCounterData[portIndex].modbusRequestPending = false;
+            markPortDataChanged(portIndex);
             flowCounterDataLocked = false;
             leds.show();
         }
@@ -227,6 +246,7 @@ void readFlowCounter(uint8_t portIndex, bool fromTrigger) {
         leds.setPixelColor(portIndex + 2, LED_COLOR_CYAN);  // Cyan
         leds.setPixelColor(1, LED_COLOR_CYAN);  // Com LED
         leds.show();
+        portMetrics[portIndex].requests++;
         // Request successfully queued - set pending flag
         if (!flowCounterDataLocked) {
             flowCounterDataLocked = true;
@@ -243,20 +263,21 @@ void readFlowCounterTempPressure(uint8_t portIndex) {
     
     uint8_t slaveId = gatewayConfig.ports[portIndex].slaveId;
     
-    log(LOG_DEBUG, false, "Reading temp/pressure on port %d (Slave ID: %d)\n", 
+    LOG_RATE_LIMITED(LOG_DEBUG, false, "Reading temp/pressure on port %d (Slave ID: %d)\n", 
         portIndex + 1, slaveId);
     
     // Queue the read request for registers 8-11 (temperature and pressure only)
     if (!modbusRTU.readHoldingRegisters(slaveId, FC_TEMP_PRESSURE_ADDRESS, modbusTempPressureBuffer, 
                                         FC_TEMP_PRESSURE_COUNT, modbusTempPressureCallback, 
                                         portIndex)) {
-        log(LOG_WARNING, false, "Failed to queue temp/pressure read request for port %d\n", portIndex + 1);
+        LOG(LOG_WARNING, false, "Failed to queue temp/pressure read request for port %d\n", portIndex + 1);
         
         // Mark as comm error
         if (!flowCounterDataLocked) {
             flowCounterDataLocked = true;
             flowCounterData[portIndex].commError = true;
             flowCounterData[portIndex].modbusRequestPending = false;
+            markPortDataChanged(portIndex);
             flowCounterDataLocked = false;
             
             // Set LED state immediately to show red if device was previously connected
@@ -268,6 +289,7 @@ void readFlowCounterTempPressure(uint8_t portIndex) {
             leds.show();
         }
     } else {
+        portMetrics[portIndex].requests++;
         // Request successfully queued - set pending flag
         if (!flowCounterDataLocked) {
             flowCounterDataLocked = true;
@@ -288,12 +310,13 @@ void modbusResponseCallback(bool valid, uint16_t* data, uint32_t requestId) {
     bool fromTrigger = (requestId & 0x100) != 0;
     
     if (portIndex >= MAX_FLOW_COUNTERS) {
-        log(LOG_ERROR, false, "Invalid port index in callback: %d\n", portIndex);
+        LOG(LOG_ERROR, false, "Invalid port index in callback: %d\n", portIndex);
         return;
     }
+    recordModbusResult(portIndex, valid && data != nullptr);
     
     if (!valid || data == nullptr) {
-        log(LOG_WARNING, false, "Modbus read failed for port %d\n", portIndex + 1);
+        LOG_RATE_LIMITED_BY(portIndex, MAX_FLOW_COUNTERS, LOG_WARNING, false, "Modbus read failed for port %d\n", portIndex + 1);
         
         if (!flowCounterDataLocked) {
             flowCounterDataLocked = true;
@@ -302,6 +325,7 @@ void modbusResponseCallback(bool valid, uint16_t* data, uint32_t requestId) {
                 flowCounterData[portIndex].commError = true;
             }
             flowCounterData[portIndex].modbusRequestPending = false;
+            markPortDataChanged(portIndex);
             flowCounterDataLocked = false;
             if (flowCounterData[portIndex].dataValid) {
                 leds.setPixelColor(portIndex + 2, LED_COLOR_RED);  // Red for error
@@ -374,7 +398,7 @@ void modbusResponseCallback(bool valid, uint16_t* data, uint32_t requestId) {
         flowCounterData[portIndex].unit_ID[10] = '\0';  // Null terminate (buffer is 11 bytes)
         
         // Debug: log the raw register values
-        log(LOG_DEBUG, false, "Unit ID registers: 0x%04X 0x%04X 0x%04X 0x%04X 0x%04X -> '%s'\\n",
+        LOG_RATE_LIMITED(LOG_DEBUG, false, "Unit ID registers: 0x%04X 0x%04X 0x%04X 0x%04X 0x%04X -> '%s'\n",
             data[regIdx], data[regIdx+1], data[regIdx+2], data[regIdx+3], data[regIdx+4],
             flowCounterData[portIndex].unit_ID);
         
@@ -391,6 +415,7 @@ void modbusResponseCallback(bool valid, uint16_t* data, uint32_t requestId) {
         
         flowCounterData[portIndex].modbusRequestPending = false;  // Clear pending flag
         
+        markPortDataChanged(portIndex);
         flowCounterDataLocked = false;
         
         // Set LED to green - data is valid
@@ -398,10 +423,11 @@ void modbusResponseCallback(bool valid, uint16_t* data, uint32_t requestId) {
         leds.show();
         
         if (wasFirstConnection) {
-            log(LOG_INFO, true, "Port %d: Device '%s' connected for the first time\n", portIndex + 1, flowCounterData[portIndex].unit_ID);
+            if (bootFirstDataMs == 0) bootFirstDataMs = millis();
+            LOG(LOG_INFO, true, "Port %d: Device '%s' connected for the first time\n", portIndex + 1, flowCounterData[portIndex].unit_ID);
         }
         
-        log(LOG_DEBUG, false, "Port %d TRIGGER: Unit='%s', Vol=%.2f, Vol_N=%.2f, Flow=%.2f, Flow_N=%.2f, Temp=%.1f°C, Press=%.1fkPa\n",
+        LOG_RATE_LIMITED(LOG_DEBUG, false, "Port %d TRIGGER: Unit='%s', Vol=%.2f, Vol_N=%.2f, Flow=%.2f, Flow_N=%.2f, Temp=%.1f°C, Press=%.1fkPa\n",
             portIndex + 1,
             flowCounterData[portIndex].unit_ID,
             flowCounterData[portIndex].volume,
@@ -415,7 +441,7 @@ void modbusResponseCallback(bool valid, uint16_t* data, uint32_t requestId) {
         if (gatewayConfig.ports[portIndex].logToSD && sdInfo.ready) {
             char csvLine[256];
             snprintf(csvLine, sizeof(csvLine),
-                    "%lu,%.3f,%.3f,%.3f,%.3f,%.2f,%.2f,%.2f,%.2f\n",
+                    "%" PRIu32 ",%.3f,%.3f,%.3f,%.3f,%.2f,%.2f,%.2f,%.2f\n",
                     flowCounterData[portIndex].timestamp,
                     flowCounterData[portIndex].volume,
                     flowCounterData[portIndex].volume_normalised,
@@ -436,15 +462,8 @@ void modbusResponseCallback(bool valid, uint16_t* data, uint32_t requestId) {
                 snprintf(filename, sizeof(filename), "/%s.csv", flowCounterData[portIndex].unit_ID);
             }
             
-            // Write header if file doesn't exist
-            bool fileExists = false;
-            if (!sdLocked) {
-                sdLocked = true;
-                fileExists = sd.exists(filename);
-                sdLocked = false;
-            }
-            
-            if (!fileExists) {
+            // Write header if file doesn't exist yet (size is tracked in RAM, no SD access)
+            if (getLogStreamSize(filename) == 0) {
                 const char* header = "Timestamp,Volume,Volume_Norm,Flow,Flow_Norm,Temperature,Pressure,PSU_Volts,Batt_Volts\n";
                 writeSensorData(header, filename, true);
             }
@@ -460,12 +479,13 @@ void modbusTempPressureCallback(bool valid, uint16_t* data, uint32_t requestId)
     uint8_t portIndex = (uint8_t)requestId;
     
     if (portIndex >= MAX_FLOW_COUNTERS) {
-        log(LOG_ERROR, false, "Invalid port index in temp/press callback: %d\n", portIndex);
+        LOG(LOG_ERROR, false, "Invalid port index in temp/press callback: %d\n", portIndex);
         return;
     }
+    recordModbusResult(portIndex, valid && data != nullptr);
     
     if (!valid || data == nullptr) {
-        log(LOG_WARNING, false, "Modbus temp/pressure read failed for port %d\n", portIndex + 1);
+        LOG_RATE_LIMITED_BY(portIndex, MAX_FLOW_COUNTERS, LOG_WARNING, false, "Modbus temp/pressure read failed for port %d\n", portIndex + 1);
         
         if (!flowCounterDataLocked) {
             flowCounterDataLocked = true;
@@ -475,6 +495,7 @@ void modbusTempPressureCallback(bool valid, uint16_t* data, uint32_t requestId)
                 flowCounterData[portIndex].commError = true;
             }
             flowCounterData[portIndex].modbusRequestPending = false;  // Clear pending flag
+            markPortDataChanged(portIndex);
             flowCounterDataLocked = false;
             
             // Set LED directly to red if this is a comm error, purple if never connected
@@ -525,20 +546,21 @@ void modbusTempPressureCallback(bool valid, uint16_t* data, uint32_t requestId)
         // Update lastUpdate timestamp
         flowCounterData[portIndex].lastUpdate = millis();
         
+        markPortDataChanged(portIndex);
         flowCounterDataLocked = false;
         
         // Set LED directly - green if we have data, purple if not yet fully connected
         if (flowCounterData[portIndex].dataValid) {
             leds.setPixelColor(portIndex + 2, LED_COLOR_GREEN);  // Green
             if (wasInError) {
-                log(LOG_INFO, true, "Port %d: Device recovered from error\n", portIndex + 1);
+                LOG(LOG_INFO, true, "Port %d: Device recovered from error\n", portIndex + 1);
             }
         } else {
             leds.setPixelColor(portIndex + 2, LED_COLOR_PURPLE);  // Purple - not yet fully connected
         }
         leds.show();
         
-        log(LOG_DEBUG, false, "Port %d PERIODIC: Current Temp %.1f->%.1f°C, Current Press %.1f->%.1fkPa | Snapshot: Vol=%.2f, Flow=%.2f, Temp=%.1f°C, Press=%.1fkPa (all unchanged)\n",
+        LOG_RATE_LIMITED(LOG_DEBUG, false, "Port %d PERIODIC: Current Temp %.1f->%.1f°C, Current Press %.1f->%.1fkPa | Snapshot: Vol=%.2f, Flow=%.2f, Temp=%.1f°C, Press=%.1fkPa (all unchanged)\n",
             portIndex + 1,
             oldCurrentTemp, flowCounterData[portIndex].currentTemperature,
             oldCurrentPressure, flowCounterData[portIndex].currentPressure,
@@ -546,37 +568,71 @@ void modbusTempPressureCallback(bool valid, uint16_t* data, uint32_t requestId)
     }
 }
 
-// Poll all configured devices on startup
-void pollAllConfiguredDevices() {
+// Startup discovery ------------------------------------------------------->
+
+// Read every enabled port once, starting each read as soon as the previous one completes.
+// Ports go ready as their first response arrives; silent ones (still powering up) are
+// retried until STARTUP_DISCOVERY_WINDOW, after which periodic polling takes over.
+void startStartupDiscovery() {
+    discoveryActive = true;
+    discoveryPort = -1;
+    discoveryStartTime = millis();
+    memset(discoveryAttempts, 0, sizeof(discoveryAttempts));
+    LOG(LOG_INFO, false, "Startup discovery started\n");
+}
+
+static void finishStartupDiscovery() {
+    discoveryActive = false;
+    uint8_t enabled = 0;
+    uint8_t ready = 0;
     for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
-        if (gatewayConfig.ports[i].enabled) {
-            readFlowCounter(i);
-            
-            // Wait for response before polling next device
-            // Allow up to 500ms for each device to respond
-            // IMPORTANT: Keep calling checkTriggers to maintain edge detection
-            uint32_t startTime = millis();
-            uint32_t lastTrigCheck = millis();
-            while (millis() - startTime < 500) {
-                modbusRTU.manage();
-                
-                // Check triggers every 10ms to keep edge detection in sync
-                if (millis() - lastTrigCheck >= TRIGGER_CHECK_INTERVAL) {
-                    lastTrigCheck = millis();
-                    checkTriggers();
-                }
-                
-                delay(1);  // Short delay to prevent tight loop
-            }
-            
-            // After each device poll, clear its trigger flag to prevent
-            // double-reading if a trigger occurred during the poll
-            // BUT: Make sure we still detect the rising edge to reset LED
-            if (triggerFlags[i]) {
-                triggerFlags[i] = false;
-            }
-        }
+        if (!gatewayConfig.ports[i].enabled) continue;
+        enabled++;
+        if (flowCounterData[i].dataValid) ready++;
+    }
+    if (bootDiscoveryDoneMs == 0) {
+        bootDiscoveryDoneMs = millis();
+        LOG(LOG_INFO, true, "Startup discovery complete: %d of %d ports ready in %lu ms\n",
+            ready, enabled, millis() - discoveryStartTime);
+        reportBootProfile();
+    }
+}
+
+static void manageStartupDiscovery() {
+    if (!discoveryActive) return;
+    uint32_t now = millis();
+
+    // One discovery read on the bus at a time
+    if (discoveryPort >= 0 && flowCounterData[discoveryPort].modbusRequestPending &&
+        now - discoveryRequestTime < (uint32_t)gatewayConfig.rs485.responseTimeout + STARTUP_DISCOVERY_SLACK) {
+        return;
+    }
+
+    bool windowOpen = now - discoveryStartTime < STARTUP_DISCOVERY_WINDOW;
+    bool portsLeft = false;
+    int8_t next = -1;
+    for (int k = 1; k <= MAX_FLOW_COUNTERS; k++) {
+        uint8_t i = (discoveryPort + k + MAX_FLOW_COUNTERS) % MAX_FLOW_COUNTERS;
+        if (!gatewayConfig.ports[i].enabled || flowCounterData[i].dataValid) continue;
+        // Every port gets its first read; retries only inside the window
+        if (discoveryAttempts[i] > 0 && !windowOpen) continue;
+        portsLeft = true;
+        if (discoveryAttempts[i] > 0 && now - discoveryLastAttempt[i] < STARTUP_DISCOVERY_RETRY_INTERVAL) continue;
+        if (flowCounterData[i].modbusRequestPending) continue;  // Trigger read already in flight
+        next = i;
+        break;
     }
+
+    if (next < 0) {
+        if (!portsLeft || !windowOpen) finishStartupDiscovery();
+        return;
+    }
+
+    discoveryPort = next;
+    discoveryAttempts[next]++;
+    discoveryLastAttempt[next] = now;
+    discoveryRequestTime = now;
+    readFlowCounter(next);
 }
 
 // Check offline devices periodically
@@ -590,7 +646,7 @@ void checkOfflineDevices() {
         if (gatewayConfig.ports[i].enabled && 
             (flowCounterData[i].commError || !flowCounterData[i].dataValid)) {
             
-            log(LOG_INFO, false, "Checking offline device on port %d (Slave ID: %d)\n", 
+            LOG_RATE_LIMITED(LOG_INFO, false, "Checking offline device on port %d (Slave ID: %d)\n", 
                 i + 1, gatewayConfig.ports[i].slaveId);
             
             readFlowCounter(i);
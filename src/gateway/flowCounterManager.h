@@ -7,15 +7,25 @@
 #define FC_REGISTER_COUNT 23  // Total registers to read
 #define FC_TEMP_PRESSURE_ADDRESS 8  // Temperature starts at register 8
 #define FC_TEMP_PRESSURE_COUNT 4    // Temperature (2 regs) + Pressure (2 regs)
+#define FC_UNIT_ID_ADDRESS 18       // unit_ID (5 regs), used by the bus scan probe
+#define FC_UNIT_ID_COUNT 5
+
+#define TRIGGER_CHECK_INTERVAL 10           // Check triggers every 10ms (scheduler task period)
+
+// Startup discovery
+#define STARTUP_DISCOVERY_WINDOW 3000       // Silent ports are retried for this long after boot
+#define STARTUP_DISCOVERY_RETRY_INTERVAL 250 // Min ms between reads of the same silent port
+#define STARTUP_DISCOVERY_SLACK 50          // Added to the response timeout before giving up on a read
 
 // Function prototypes
 void init_flowCounterManager();
 void reinit_modbusRTU();  // Reinitialize Modbus RTU with new settings
+void setRS485Transport(ModbusRTUTransport* transport);  // Bus transport for the next (re)init, nullptr = Serial1
 void manage_flowCounterManager();
 void checkTriggers();
 void readFlowCounter(uint8_t portIndex, bool fromTrigger = false);
 void readFlowCounterTempPressure(uint8_t portIndex);  // Read only temp/pressure for periodic updates
-void pollAllConfiguredDevices();        // Poll all enabled ports on startup
+void startStartupDiscovery();           // Read all enabled ports from the loop after boot
 void checkOfflineDevices();             // Periodically poll offline devices
 void periodicPollConfiguredDevices();   // Periodic poll of all configured devices (~1 minute)
 void modbusResponseCallback(bool valid, uint16_t* data, uint32_t requestId);
@@ -0,0 +1,338 @@
+#define LOG_MODULE LOG_MODULE_GATEWAY
+#include "serialDetectManager.h"
+#include "flowCounterManager.h"
+#include "busScanManager.h"
+#include "../network/network.h"
+#include <hardware/uart.h>
+
+#define UART_ERROR_BITS (UART_UARTRIS_FERIS_BITS | UART_UARTRIS_PERIS_BITS | UART_UARTRIS_BERIS_BITS)
+
+// Candidates: the configured setting first, then every baud rate (fastest first) with each framing.
+// Parity framings go before 8N2, which an 8N1 slave would also accept.
+static const uint32_t detectBaudRates[] = {115200, 57600, 38400, 19200, 9600, 4800, 2400, 1200};
+static const uint16_t detectFramings[] = {SERIAL_8N1, SERIAL_8E1, SERIAL_8O1, SERIAL_8N2};
+#define DETECT_BAUD_RATES (sizeof(detectBaudRates) / sizeof(detectBaudRates[0]))
+#define DETECT_FRAMINGS (sizeof(detectFramings) / sizeof(detectFramings[0]))
+#define DETECT_CANDIDATES (1 + DETECT_BAUD_RATES * DETECT_FRAMINGS)
+
+// Global variables
+volatile serialDetectState_t serialDetectState = SERIAL_DETECT_IDLE;
+
+// Requests from the API (core 0), picked up by manageSerialDetect() on core 1
+static volatile bool detectStartRequested = false;
+static volatile bool detectCancelRequested = false;
+static volatile uint8_t requestedSlaveId = 0;
+
+// Detection state - only written on core 1
+static uint8_t detectRun = 0;                // requestId of the probes, so replies to a cancelled run are ignored
+static uint8_t targets[SERIAL_DETECT_MAX_TARGETS];
+static uint8_t targetCount = 0;
+static uint32_t configuredBaud = DEFAULT_MODBUS_BAUD;
+static uint32_t configuredSerialConfig = DEFAULT_MODBUS_CONFIG;
+static uint8_t candidate = 0;
+static serialDetectScore_t scores[DETECT_CANDIDATES];
+static bool probePending = false;
+static uint32_t probeRxBytes = 0;
+static uint16_t probeBuffer[FC_UNIT_ID_COUNT];
+static volatile int16_t detectedCandidate = -1;  // -1 = nothing answered
+static bool detectedConsistent = false;
+static uint32_t detectStartTime = 0;
+static uint32_t detectFinishTime = 0;
+
+static uint32_t candidateBaud(uint8_t c) {
+    return c == 0 ? configuredBaud : detectBaudRates[(c - 1) / DETECT_FRAMINGS];
+}
+
+static uint32_t candidateSerialConfig(uint8_t c) {
+    return c == 0 ? configuredSerialConfig : detectFramings[(c - 1) % DETECT_FRAMINGS];
+}
+
+// Probes only have to wait for the slave's turnaround plus a few characters
+static uint16_t candidateProbeTimeout(uint8_t c) {
+    uint16_t timeout = gatewayConfig.rs485.responseTimeout < SERIAL_DETECT_TIMEOUT_MAX ?
+                       gatewayConfig.rs485.responseTimeout : SERIAL_DETECT_TIMEOUT_MAX;
+    return timeout + 44000 / candidateBaud(c) + 1;
+}
+
+static bool isConsistent(const serialDetectScore_t* score) {
+    return score->probes > 0 && score->valid == score->probes &&
+           score->garbled == 0 && score->uartErrors == 0;
+}
+
+// Detection control ------------------------------------------------------->
+
+void startSerialDetect(uint8_t slaveId) {
+    requestedSlaveId = slaveId;
+    detectStartRequested = true;
+}
+
+void cancelSerialDetect() {
+    detectCancelRequested = true;
+}
+
+bool serialDetectPausesPolling() {
+    return serialDetectState == SERIAL_DETECT_STARTING || serialDetectState == SERIAL_DETECT_RUNNING;
+}
+
+static void selectCandidate(uint8_t c) {
+    candidate = c;
+    modbusRTU.setSerialConfig(candidateBaud(c), candidateSerialConfig(c));
+    uart_get_hw(SERIAL_DETECT_UART)->icr = UART_ERROR_BITS;
+    LOG(LOG_DEBUG, false, "Serial detect: trying %" PRIu32 " baud, config 0x%X\n", candidateBaud(c), candidateSerialConfig(c));
+}
+
+static uint8_t nextCandidate(uint8_t c) {
+    for (c++; c < DETECT_CANDIDATES; c++) {
+        if (candidateBaud(c) != configuredBaud || candidateSerialConfig(c) != configuredSerialConfig) break;
+    }
+    return c;
+}
+
+static void beginDetect() {
+    detectRun++;
+    configuredBaud = gatewayConfig.rs485.baudRate;
+    configuredSerialConfig = gatewayConfig.rs485.serialConfig;
+    memset(scores, 0, sizeof(scores));
+    probePending = false;
+    detectedCandidate = -1;
+    detectedConsistent = false;
+    detectStartTime = millis();
+    detectFinishTime = 0;
+    serialDetectState = SERIAL_DETECT_RUNNING;
+    LOG(LOG_INFO, true, "Serial detect started (%d slave ID%s)\n", targetCount, targetCount == 1 ? "" : "s");
+    selectCandidate(0);
+}
+
+static void finishDetect(bool cancelled) {
+    // Back to the configured setting; the result is only used once it is applied
+    modbusRTU.setSerialConfig(gatewayConfig.rs485.baudRate, gatewayConfig.rs485.serialConfig);
+    serialDetectState = SERIAL_DETECT_DONE;
+    detectFinishTime = millis();
+
+    if (cancelled) {
+        LOG(LOG_INFO, true, "Serial detect cancelled\n");
+    } else if (detectedCandidate < 0) {
+        LOG(LOG_WARNING, true, "Serial detect: no valid replies at any setting in %" PRIu32 " ms\n",
+            detectFinishTime - detectStartTime);
+    } else {
+        LOG(LOG_INFO, true, "Serial detect: %" PRIu32 " baud, config 0x%X (%s) in %" PRIu32 " ms\n",
+            candidateBaud(detectedCandidate), candidateSerialConfig(detectedCandidate),
+            detectedConsistent ? "all replies valid" : "best partial match",
+            detectFinishTime - detectStartTime);
+    }
+}
+
+// No setting was fully consistent - settle for the most valid replies, then the fewest errors
+static void pickBestCandidate() {
+    int16_t best = -1;
+    for (uint8_t c = 0; c < DETECT_CANDIDATES; c++) {
+        if (scores[c].valid == 0) continue;
+        if (best < 0 || scores[c].valid > scores[best].valid ||
+            (scores[c].valid == scores[best].valid &&
+             scores[c].garbled + scores[c].uartErrors < scores[best].garbled + scores[best].uartErrors)) {
+            best = c;
+        }
+    }
+    detectedCandidate = best;
+}
+
+static void serialDetectCallback(bool valid, uint16_t* data, uint32_t requestId) {
+    if (requestId != detectRun) return;  // Reply to a cancelled run
+    probePending = false;
+
+    serialDetectScore_t* score = &scores[candidate];
+    uart_hw_t* uart = uart_get_hw(SERIAL_DETECT_UART);
+    uint32_t errors = uart->ris & UART_ERROR_BITS;
+    if (errors) {
+        score->uartErrors++;
+        uart->icr = errors;
+    }
+    if (valid) {
+        score->valid++;
+    } else if (modbusRTU.getRxByteCount() != probeRxBytes) {
+        score->garbled++;
+    }
+}
+
+static void collectTargets() {
+    targetCount = 0;
+    if (requestedSlaveId != 0) {
+        targets[targetCount++] = requestedSlaveId;
+        return;
+    }
+    for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
+        if (!gatewayConfig.ports[i].enabled) continue;
+        bool seen = false;
+        for (uint8_t t = 0; t < targetCount; t++) {
+            if (targets[t] == gatewayConfig.ports[i].slaveId) seen = true;
+        }
+        if (!seen) targets[targetCount++] = gatewayConfig.ports[i].slaveId;
+    }
+}
+
+// Called from manage_flowCounterManager() once startup discovery is done.
+// Polling is paused from the start request, and settings are only switched once the queue has
+// drained. Each setting is probed with a unit_ID read of every target and is skipped after
+// SERIAL_DETECT_SILENT_PROBES probes without a valid reply; the first setting where every
+// target replies with no garbled frames and no UART errors wins.
+void manageSerialDetect() {
+    if (detectCancelRequested) {
+        detectCancelRequested = false;
+        detectStartRequested = false;
+        if (serialDetectState == SERIAL_DETECT_STARTING) {
+            serialDetectState = SERIAL_DETECT_IDLE;
+        } else if (serialDetectState == SERIAL_DETECT_RUNNING) {
+            detectRun++;
+            finishDetect(true);
+        }
+    }
+    if (detectStartRequested) {
+        detectStartRequested = false;
+        collectTargets();
+        if (targetCount == 0) {
+            LOG(LOG_WARNING, false, "Serial detect: no enabled ports to probe\n");
+        } else {
+            serialDetectState = SERIAL_DETECT_STARTING;
+        }
+    }
+
+    if (serialDetectState == SERIAL_DETECT_STARTING) {
+        if (busScanState == BUS_SCAN_RUNNING || modbusRTU.getQueueCount() > 0) return;
+        beginDetect();
+    }
+    if (serialDetectState != SERIAL_DETECT_RUNNING || probePending) return;
+
+    serialDetectScore_t* score = &scores[candidate];
+    uint8_t silentLimit = targetCount < SERIAL_DETECT_SILENT_PROBES ? targetCount : SERIAL_DETECT_SILENT_PROBES;
+    bool silent = score->valid == 0 && score->probes >= silentLimit;
+    if (silent || score->probes >= targetCount) {
+        if (isConsistent(score)) {
+            detectedCandidate = candidate;
+            detectedConsistent = true;
+            finishDetect(false);
+            return;
+        }
+        uint8_t next = nextCandidate(candidate);
+        if (next >= DETECT_CANDIDATES) {
+            pickBestCandidate();
+            finishDetect(false);
+            return;
+        }
+        selectCandidate(next);
+        score = &scores[next];
+    }
+
+    probeRxBytes = modbusRTU.getRxByteCount();
+    if (modbusRTU.readHoldingRegisters(targets[score->probes], FC_UNIT_ID_ADDRESS, probeBuffer, FC_UNIT_ID_COUNT,
+                                       serialDetectCallback, detectRun, candidateProbeTimeout(candidate))) {
+        probePending = true;
+        score->probes++;
+    }
+}
+
+// Save the detected setting and switch the bus over to it
+bool applySerialDetectResult() {
+    if (serialDetectState != SERIAL_DETECT_DONE || detectedCandidate < 0) return false;
+
+    gatewayConfig.rs485.baudRate = candidateBaud(detectedCandidate);
+    gatewayConfig.rs485.serialConfig = candidateSerialConfig(detectedCandidate);
+    saveGatewayConfig();
+    LOG(LOG_INFO, true, "RS485 configuration changed by serial detect: baud=%d, config=0x%X\n",
+        gatewayConfig.rs485.baudRate, gatewayConfig.rs485.serialConfig);
+    reinit_modbusRTU();
+
+    if (!flowCounterDataLocked) {
+        flowCounterDataLocked = true;
+        for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
+            if (gatewayConfig.ports[i].enabled) flowCounterData[i].pendingInitialRead = true;
+        }
+        flowCounterDataLocked = false;
+    }
+    serialDetectState = SERIAL_DETECT_IDLE;
+    return true;
+}
+
+// Serialization ----------------------------------------------------------->
+
+void serializeSerialDetect(JsonObject obj) {
+    serialDetectState_t state = serialDetectState;
+    const char* stateNames[] = {"idle", "starting", "running", "done"};
+    obj["state"] = stateNames[state];
+    if (state == SERIAL_DETECT_IDLE || state == SERIAL_DETECT_STARTING) return;
+
+    obj["elapsed_ms"] = (state == SERIAL_DETECT_RUNNING ? millis() : detectFinishTime) - detectStartTime;
+    JsonArray slaveIds = obj.createNestedArray("slave_ids");
+    for (uint8_t t = 0; t < targetCount; t++) slaveIds.add(targets[t]);
+
+    if (state == SERIAL_DETECT_RUNNING) {
+        obj["baud_rate"] = candidateBaud(candidate);
+        obj["serial_config"] = candidateSerialConfig(candidate);
+    } else if (detectedCandidate >= 0) {
+        JsonObject detected = obj.createNestedObject("detected");
+        detected["baud_rate"] = candidateBaud(detectedCandidate);
+        detected["serial_config"] = candidateSerialConfig(detectedCandidate);
+        detected["consistent"] = detectedConsistent;
+    }
+
+    JsonArray tried = obj.createNestedArray("tried");
+    for (uint8_t c = 0; c < DETECT_CANDIDATES; c++) {
+        if (scores[c].probes == 0) continue;
+        JsonObject entry = tried.createNestedObject();
+        entry["baud_rate"] = candidateBaud(c);
+        entry["serial_config"] = candidateSerialConfig(c);
+        entry["probes"] = scores[c].probes;
+        entry["valid"] = scores[c].valid;
+        entry["garbled"] = scores[c].garbled;
+        entry["uart_errors"] = scores[c].uartErrors;
+    }
+}
+
+// API --------------------------------------------------------------------->
+
+void setupSerialDetectAPI() {
+    // Detection progress, scores so far and the result
+    server.on("/api/gateway/detect", HTTP_GET, []() {
+        static StaticJsonDocument<5120> doc;
+        doc.clear();
+        serializeSerialDetect(doc.to<JsonObject>());
+
+        sendJsonChunked(200, doc);
+    });
+
+    // ?action=start (default, optional slave_id), cancel or apply
+    server.on("/api/gateway/detect", HTTP_POST, []() {
+        String action = server.hasArg("action") ? server.arg("action") : "start";
+
+        if (action == "cancel") {
+            cancelSerialDetect();
+            server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"Serial detect cancelled\"}");
+        } else if (action == "apply") {
+            if (!applySerialDetectResult()) {
+                server.send(409, "application/json", "{\"error\":\"No detected setting to apply\"}");
+                return;
+            }
+            server.send(200, "application/json",
+                        "{\"status\":\"success\",\"message\":\"Configuration saved. RS485 interface reinitialized.\"}");
+        } else if (action == "start") {
+            int slaveId = server.hasArg("slave_id") ? server.arg("slave_id").toInt() : 0;
+            if (slaveId < 0 || slaveId > 247) {
+                server.send(400, "application/json", "{\"error\":\"Invalid slave ID\"}");
+                return;
+            }
+            bool anyEnabled = false;
+            for (int i = 0; i < MAX_FLOW_COUNTERS; i++) anyEnabled |= gatewayConfig.ports[i].enabled;
+            if (slaveId == 0 && !anyEnabled) {
+                server.send(400, "application/json", "{\"error\":\"No enabled ports - pass slave_id\"}");
+                return;
+            }
+            if (busScanState == BUS_SCAN_RUNNING) {
+                server.send(409, "application/json", "{\"error\":\"Bus scan running\"}");
+                return;
+            }
+            startSerialDetect(slaveId);
+            server.send(202, "application/json", "{\"status\":\"success\",\"message\":\"Serial detect started\"}");
+        } else {
+            server.send(400, "application/json", "{\"error\":\"Invalid action\"}");
+        }
+    });
+}
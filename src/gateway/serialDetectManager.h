@@ -0,0 +1,36 @@
+#pragma once
+
+#include "flowCounterConfig.h"
+
+// RS485 baud rate / framing detection
+#define SERIAL_DETECT_UART uart0             // Serial1, see init_flowCounterManager()
+#define SERIAL_DETECT_MAX_TARGETS MAX_FLOW_COUNTERS
+#define SERIAL_DETECT_SILENT_PROBES 3        // Probes without a valid reply before a setting is skipped
+#define SERIAL_DETECT_TIMEOUT_MAX 100        // Probe timeout cap (ms); the configured timeout is used if lower
+
+enum serialDetectState_t {
+    SERIAL_DETECT_IDLE,
+    SERIAL_DETECT_STARTING,                  // Waiting for the Modbus queue to drain
+    SERIAL_DETECT_RUNNING,
+    SERIAL_DETECT_DONE
+};
+
+// Score of one baud rate / framing candidate
+struct serialDetectScore_t {
+    uint8_t probes;
+    uint8_t valid;                           // Replies with a good CRC from the probed slave
+    uint8_t garbled;                         // Probes that got bytes back but no valid reply
+    uint8_t uartErrors;                      // Probes that raised UART framing, parity or break errors
+};
+
+// Function prototypes
+void startSerialDetect(uint8_t slaveId = 0);  // 0 = probe the slave IDs of enabled ports
+void cancelSerialDetect();
+void manageSerialDetect();
+bool serialDetectPausesPolling();            // Production reads hold off while settings are being tried
+bool applySerialDetectResult();              // Persist the detected setting
+void serializeSerialDetect(JsonObject obj);
+void setupSerialDetectAPI();
+
+// Global variables
+extern volatile serialDetectState_t serialDetectState;
@@ -0,0 +1,231 @@
+#define LOG_MODULE LOG_MODULE_NETWORK
+#include "eventManager.h"
+
+static EventClientConnection eventClients[MAX_EVENT_CLIENTS];
+static const char snapshotPrefix[] = "event: snapshot\ndata: ";
+static uint32_t lastStatusCheck = 0;
+static uint32_t lastStatusSent = 0;
+static uint32_t lastStatusHash = 0;
+static bool statusPending = false;   // Send status on the next pass regardless of changes
+static char eventBuffer[EVENT_BUFFER_SIZE];
+
+// FNV-1a, only used to spot status changes between heartbeats
+static uint32_t hashBuffer(const char* data, size_t length) {
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+static void dropEventClient(int slot, const char* reason) {
+    LOG(LOG_DEBUG, false, "Event client %d %s, dropping\n", slot, reason);
+    eventClients[slot].client.stop();
+    eventClients[slot].active = false;
+}
+
+// Write one event to a subscriber. A client whose socket can't take the whole event
+// is dropped rather than waited on; the browser reconnects and gets a fresh snapshot.
+static void sendEvent(int slot, const char* data, size_t length) {
+    if (eventClients[slot].client.availableForWrite() < (int)length) {
+        dropEventClient(slot, "too slow");
+        return;
+    }
+    eventClients[slot].client.write((const uint8_t*)data, length);
+}
+
+static void broadcastEvent(const char* data, size_t length) {
+    for (int i = 0; i < MAX_EVENT_CLIENTS; i++) {
+        if (eventClients[i].active && eventClients[i].snapshotDone) sendEvent(i, data, length);
+    }
+}
+
+// Frame a serialized JSON document as "event: <name>\ndata: <json>\n\n" in eventBuffer
+static size_t formatEvent(const char* name, JsonDocument& doc) {
+    int header = snprintf(eventBuffer, sizeof(eventBuffer), "event: %s\ndata: ", name);
+    size_t json = serializeJson(doc, eventBuffer + header, sizeof(eventBuffer) - header - 2);
+    if (header + json >= sizeof(eventBuffer) - 3) {
+        LOG(LOG_ERROR, false, "Event '%s' does not fit in the event buffer\n", name);
+        return 0;
+    }
+    eventBuffer[header + json] = '\n';
+    eventBuffer[header + json + 1] = '\n';
+    return header + json + 2;
+}
+
+static void handleEventsConnect(void) {
+    int slot = -1;
+    for (int i = 0; i < MAX_EVENT_CLIENTS; i++) {
+        if (!eventClients[i].active) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        server.send(503, "application/json", "{\"error\":\"Too many event clients\"}");
+        return;
+    }
+
+    // Keep our own reference to the socket; WebServer lets go of it when this handler returns
+    WiFiClient client = server.client();
+    client.setNoDelay(true);
+    client.print("HTTP/1.1 200 OK\r\n"
+                 "Content-Type: text/event-stream\r\n"
+                 "Cache-Control: no-cache\r\n"
+                 "Connection: keep-alive\r\n\r\n"
+                 "retry: 3000\n\n");
+
+    // Full picture first, deltas after - the snapshot is written out by manageEvents()
+    EventClientConnection* connection = &eventClients[slot];
+    connection->client = client;
+    connection->active = true;
+    connection->snapshotDone = false;
+    connection->snapshotSent = 0;
+    connection->connectTime = millis();
+    LOG(LOG_INFO, false, "Event client %d connected from %s\n", slot, client.remoteIP().toString().c_str());
+}
+
+void setupEventsAPI(void) {
+    server.on("/api/events", HTTP_GET, handleEventsConnect);
+}
+
+int getEventClientCount(void) {
+    int count = 0;
+    for (int i = 0; i < MAX_EVENT_CLIENTS; i++) {
+        if (eventClients[i].active) count++;
+    }
+    return count;
+}
+
+// Writes as much of the snapshot event as the socket takes without blocking. The snapshot
+// only starts from a body that is current, and the client's port generations are taken
+// before it so a change racing the build is sent again as a port event.
+static void sendSnapshot(int slot) {
+    EventClientConnection* connection = &eventClients[slot];
+    size_t length;
+    uint32_t generation;
+    const char* body;
+    if (connection->snapshotSent == 0) {
+        uint32_t portGeneration[MAX_FLOW_COUNTERS];
+        for (int i = 0; i < MAX_FLOW_COUNTERS; i++) portGeneration[i] = flowCounterPortGeneration[i];
+        body = getGatewayDataBody(&length, &generation);
+        if (body == nullptr || generation != flowCounterDataGeneration) return;  // Rebuild skipped, retry next pass
+        memcpy(connection->sentPortGeneration, portGeneration, sizeof(portGeneration));
+        connection->snapshotGeneration = generation;
+    } else {
+        body = peekGatewayDataBody(&length, &generation);
+        if (body == nullptr || generation != connection->snapshotGeneration) {
+            dropEventClient(slot, "snapshot rebuilt mid-write");
+            return;
+        }
+    }
+
+    // The event is prefix + body + "\n\n"; snapshotSent is the position in that whole
+    size_t prefixLength = sizeof(snapshotPrefix) - 1;
+    size_t total = prefixLength + length + 2;
+    while (connection->snapshotSent < total) {
+        int room = connection->client.availableForWrite();
+        if (room <= 0) return;
+        size_t offset = connection->snapshotSent;
+        const char* piece;
+        size_t pieceLength;
+        if (offset < prefixLength) {
+            piece = snapshotPrefix + offset;
+            pieceLength = prefixLength - offset;
+        } else if (offset < prefixLength + length) {
+            piece = body + (offset - prefixLength);
+            pieceLength = prefixLength + length - offset;
+        } else {
+            piece = "\n\n" + (offset - prefixLength - length);
+            pieceLength = total - offset;
+        }
+        if (pieceLength > (size_t)room) pieceLength = room;
+        size_t written = connection->client.write((const uint8_t*)piece, pieceLength);
+        if (written == 0) return;
+        connection->snapshotSent += written;
+    }
+    connection->snapshotDone = true;
+    statusPending = true;
+}
+
+// Push ports whose generation moved since each client last got them
+static void sendPortEvents(void) {
+    static StaticJsonDocument<768> doc;
+    for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
+        uint32_t generation = flowCounterPortGeneration[i];
+        bool pending = false;
+        for (int c = 0; c < MAX_EVENT_CLIENTS; c++) {
+            if (eventClients[c].active && eventClients[c].snapshotDone && eventClients[c].sentPortGeneration[i] != generation) pending = true;
+        }
+        if (!pending) continue;
+        if (flowCounterDataLocked) return;  // Core 1 is mid-update, pick it up next pass
+
+        flowCounterDataLocked = true;
+        generation = flowCounterPortGeneration[i];
+        doc.clear();
+        doc["current_millis"] = millis();
+        doc["millis_rollover_count"] = millisRolloverCount;
+        serializeFlowCounterPort(doc.createNestedObject("flow_counter"), i);
+        flowCounterDataLocked = false;
+
+        size_t length = formatEvent("port", doc);
+        if (length == 0) continue;
+        for (int c = 0; c < MAX_EVENT_CLIENTS; c++) {
+            EventClientConnection* connection = &eventClients[c];
+            if (!connection->active || !connection->snapshotDone || connection->sentPortGeneration[i] == generation) continue;
+            connection->sentPortGeneration[i] = generation;
+            sendEvent(c, eventBuffer, length);
+        }
+    }
+}
+
+// Status goes out when it changes (ignoring the clock fields) or as a heartbeat
+static void sendStatusEvent(void) {
+    if (!statusPending && millis() - lastStatusCheck < EVENT_STATUS_CHECK_INTERVAL) return;
+    lastStatusCheck = millis();
+
+    static StaticJsonDocument<768> doc;
+    doc.clear();
+    if (!buildSystemStatus(doc)) return;  // Busy - try again next check
+
+    doc.remove("uptime");
+    size_t length = serializeJson(doc, eventBuffer, sizeof(eventBuffer));
+    uint32_t hash = hashBuffer(eventBuffer, length);
+    if (!statusPending && hash == lastStatusHash && millis() - lastStatusSent < EVENT_HEARTBEAT_INTERVAL) return;
+
+    doc["uptime"] = millis() / 1000;
+    doc["current_millis"] = millis();
+    doc["millis_rollover_count"] = millisRolloverCount;
+    length = formatEvent("status", doc);
+    if (length > 0) broadcastEvent(eventBuffer, length);
+
+    lastStatusHash = hash;
+    lastStatusSent = millis();
+    statusPending = false;
+}
+
+void manageEvents(void) {
+    bool anyClient = false;
+    for (int i = 0; i < MAX_EVENT_CLIENTS; i++) {
+        if (!eventClients[i].active) continue;
+        if (!eventClients[i].client.connected()) {
+            eventClients[i].client.stop();
+            eventClients[i].active = false;
+            LOG(LOG_INFO, false, "Event client %d disconnected\n", i);
+            continue;
+        }
+        if (!eventClients[i].snapshotDone) {
+            if (millis() - eventClients[i].connectTime > EVENT_SNAPSHOT_TIMEOUT) {
+                dropEventClient(i, "did not take its snapshot");
+                continue;
+            }
+            sendSnapshot(i);
+        }
+        if (eventClients[i].active && eventClients[i].snapshotDone) anyClient = true;
+    }
+    if (!anyClient) return;
+
+    sendPortEvents();
+    sendStatusEvent();
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "../sys_init.h"
+#include <WiFiClient.h>
+
+// Server-sent events (/api/events) - pushes port changes and status to open dashboards
+#define MAX_EVENT_CLIENTS 4
+#define EVENT_STATUS_CHECK_INTERVAL 1000   // How often status is rebuilt to look for changes
+#define EVENT_HEARTBEAT_INTERVAL 5000      // Status is sent at least this often
+#define EVENT_BUFFER_SIZE 1024             // Largest single event (a port or the status)
+#define EVENT_SNAPSHOT_TIMEOUT 5000        // A client that hasn't taken its snapshot by then is dropped
+
+struct EventClientConnection {
+    WiFiClient client;
+    bool active;
+    bool snapshotDone;                  // Port and status events only follow a complete snapshot
+    size_t snapshotSent;                // Bytes of the snapshot event written so far
+    uint32_t snapshotGeneration;        // Gateway data generation the snapshot was built from
+    uint32_t connectTime;
+    uint32_t sentPortGeneration[MAX_FLOW_COUNTERS];   // Last port generation this client was sent
+};
+
+void setupEventsAPI(void);
+void manageEvents(void);
+int getEventClientCount(void);
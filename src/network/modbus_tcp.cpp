@@ -1,3 +1,4 @@
+#define LOG_MODULE LOG_MODULE_MODBUS_TCP
 #include "modbus_tcp.h"
 #include "network.h"
 #include "../gateway/flowCounterConfig.h"
@@ -6,7 +7,7 @@
 ModbusTCPServer modbusServer;
 ModbusTCPConfig modbusTCPConfig;
 
-ModbusTCPServer::ModbusTCPServer() : _server(nullptr), _running(false) {
+ModbusTCPServer::ModbusTCPServer() : _server(nullptr), _running(false), _totalRequests(0), _totalExceptions(0) {
     // Initialize client connections
     for (int i = 0; i < MAX_MODBUS_CLIENTS; i++) {
         _clients[i].active = false;
@@ -24,10 +25,10 @@ ModbusTCPServer::~ModbusTCPServer() {
 }
 
 bool ModbusTCPServer::begin(uint16_t port) {
-    log(LOG_INFO, true, "ModbusTCPServer::begin() called with port %d\n", port);
+    LOG(LOG_INFO, true, "ModbusTCPServer::begin() called with port %d\n", port);
     
     if (_running) {
-        log(LOG_INFO, true, "Server already running, stopping first\n");
+        LOG(LOG_INFO, true, "Server already running, stopping first\n");
         stop();
     }
     
@@ -35,14 +36,14 @@ bool ModbusTCPServer::begin(uint16_t port) {
     _server = new WiFiServer(port);
     
     if (!_server) {
-        log(LOG_ERROR, true, "Failed to create Modbus TCP server\n");
+        LOG(LOG_ERROR, true, "Failed to create Modbus TCP server\n");
         return false;
     }
     
     _server->begin();
     _running = true;
     
-    log(LOG_INFO, true, "Modbus TCP server started on port %d (config port: %d)\n", port, _config.port);
+    LOG(LOG_INFO, true, "Modbus TCP server started on port %d (config port: %d)\n", port, _config.port);
     return true;
 }
 
@@ -54,7 +55,7 @@ void ModbusTCPServer::stop() {
         _server = nullptr;
     }
     _running = false;
-    log(LOG_INFO, true, "Modbus TCP server stopped\n");
+    LOG(LOG_INFO, true, "Modbus TCP server stopped\n");
 }
 
 void ModbusTCPServer::poll() {
@@ -79,13 +80,15 @@ void ModbusTCPServer::acceptNewClients() {
             _clients[slot].lastActivity = millis();
             _clients[slot].connectionTime = millis();
             _clients[slot].clientIP = newClient.remoteIP().toString();
+            _clients[slot].requestCount = 0;
+            _clients[slot].exceptionCount = 0;
             
-            log(LOG_INFO, true, "Modbus TCP client connected from %s (slot %d)\n", 
+            LOG(LOG_INFO, true, "Modbus TCP client connected from %s (slot %d)\n", 
                 _clients[slot].clientIP.c_str(), slot);
         } else {
             // No free slots, reject the connection
             newClient.stop();
-            log(LOG_WARNING, true, "Modbus TCP client rejected - maximum connections reached\n");
+            LOG(LOG_WARNING, true, "Modbus TCP client rejected - maximum connections reached\n");
         }
     }
 }
@@ -108,7 +111,7 @@ void ModbusTCPServer::cleanupInactiveClients() {
         if (_clients[i].active) {
             // Check if client is still connected (primary disconnect detection)
             if (!_clients[i].client.connected()) {
-                log(LOG_INFO, true, "Modbus TCP client %s disconnected (slot %d, connected for %lu ms)\n", 
+                LOG(LOG_INFO, true, "Modbus TCP client %s disconnected (slot %d, connected for %" PRIu32 " ms)\n", 
                     _clients[i].clientIP.c_str(), i, currentTime - _clients[i].connectionTime);
                 _clients[i].client.stop();
                 _clients[i].active = false;
@@ -117,7 +120,7 @@ void ModbusTCPServer::cleanupInactiveClients() {
             }
             // Check for timeout (only if no activity for extended period)
             else if (currentTime - _clients[i].lastActivity > MODBUS_TCP_TIMEOUT) {
-                log(LOG_WARNING, true, "Modbus TCP client %s timed out after %lu ms of inactivity (slot %d)\n", 
+                LOG(LOG_WARNING, true, "Modbus TCP client %s timed out after %d ms of inactivity (slot %d)\n", 
                     _clients[i].clientIP.c_str(), MODBUS_TCP_TIMEOUT, i);
                 _clients[i].client.stop();
                 _clients[i].active = false;
@@ -151,6 +154,8 @@ bool ModbusTCPServer::processModbusRequest(ModbusClientConnection& client) {
     header.protocolId = (headerBytes[2] << 8) | headerBytes[3];
     header.length = (headerBytes[4] << 8) | headerBytes[5];
     header.unitId = headerBytes[6];
+    client.requestCount++;
+    _totalRequests++;
     
     // Validate protocol ID
     if (header.protocolId != 0) {
@@ -158,12 +163,12 @@ bool ModbusTCPServer::processModbusRequest(ModbusClientConnection& client) {
         return false;
     }
     
-    // Read PDU (Protocol Data Unit)
-    uint16_t pduLength = header.length - 1; // Subtract unit ID
-    if (pduLength > 253) { // Maximum PDU length
+    // Read PDU (Protocol Data Unit) - at least the function code, at most 253 bytes
+    if (header.length < 2 || header.length > 254) {
         sendModbusException(client, header.transactionId, header.unitId, 0, MODBUS_EXCEPTION_SLAVE_DEVICE_FAILURE);
         return false;
     }
+    uint16_t pduLength = header.length - 1; // Subtract unit ID
     
     uint8_t pdu[253];
     if (client.client.readBytes(pdu, pduLength) != pduLength) {
@@ -172,11 +177,15 @@ bool ModbusTCPServer::processModbusRequest(ModbusClientConnection& client) {
     
     // Forward to RTU if unit ID is not 0xFF (TCP broadcast)
     if (header.unitId != 0xFF && header.unitId != 0) {
-        uint8_t rtuResponse[256];
-        uint16_t rtuResponseLength;
         uint8_t pduResponse[256];
         uint16_t pduResponseLength;
         
+        // Function code, start address and quantity must all be in the PDU
+        if (pduLength < 5) {
+            sendModbusException(client, header.transactionId, header.unitId, pdu[0], MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+            return false;
+        }
+        
         // Handle read request using cached data
         if (handleReadRequest(header.unitId, pdu[0], (pdu[1] << 8) | pdu[2], (pdu[3] << 8) | pdu[4], pduResponse, pduResponseLength)) {
             // Send successful response back to TCP client
@@ -215,6 +224,8 @@ void ModbusTCPServer::sendModbusResponse(ModbusClientConnection& client, uint8_t
 
 void ModbusTCPServer::sendModbusException(ModbusClientConnection& client, uint16_t transactionId, uint8_t unitId, uint8_t functionCode, uint8_t exceptionCode) {
     uint8_t response[9];
+    client.exceptionCount++;
+    _totalExceptions++;
     
     // MBAP header
     response[0] = (transactionId >> 8) & 0xFF;
@@ -227,6 +238,9 @@ void ModbusTCPServer::sendModbusException(ModbusClientConnection& client, uint16
     
     // Exception response
     response[7] = functionCode | 0x80; // Set exception bit
+    response[8] = exceptionCode;
+
+    sendModbusResponse(client, response, sizeof(response));
 }
 
 bool ModbusTCPServer::handleReadRequest(uint8_t slaveId, uint8_t functionCode, uint16_t startAddress, 
@@ -257,7 +271,7 @@ bool ModbusTCPServer::handleReadRequest(uint8_t slaveId, uint8_t functionCode, u
         case 0x03: // Read Holding Registers
         case 0x04: { // Read Input Registers (treat same as holding for flow counters)
             // Extended register map: 0-22 (original data) + 30-33 (temp/pressure duplicate)
-            if (startAddress + quantity > 34) return false;  // Up to register 33 (34 total)
+            if (quantity == 0 || startAddress + quantity > 34) return false;  // Up to register 33 (34 total)
             response[1] = quantity * 2; // Byte count
             responseLength = 2 + response[1];
             
@@ -384,6 +398,13 @@ int ModbusTCPServer::getConnectedClientCount() {
     return count;
 }
 
+const ModbusClientConnection* ModbusTCPServer::getClient(int index) const {
+    if (index >= 0 && index < MAX_MODBUS_CLIENTS && _clients[index].active) {
+        return &_clients[index];
+    }
+    return nullptr;
+}
+
 String ModbusTCPServer::getClientInfo(int index) {
     if (index >= 0 && index < MAX_MODBUS_CLIENTS && _clients[index].active) {
         uint32_t connectionDuration = millis() - _clients[index].connectionTime;
@@ -413,15 +434,15 @@ void ModbusTCPServer::disconnectAllClients() {
 
 void ModbusTCPServer::setEnabled(bool enabled) {
     if (enabled != _config.enabled) {
-        log(LOG_INFO, true, "Modbus TCP enabled changing from %s to %s\n", 
+        LOG(LOG_INFO, true, "Modbus TCP enabled changing from %s to %s\n", 
             _config.enabled ? "true" : "false", enabled ? "true" : "false");
         _config.enabled = enabled;
         
         if (!enabled && _running) {
-            log(LOG_INFO, true, "Stopping Modbus TCP server (disabled)\n");
+            LOG(LOG_INFO, true, "Stopping Modbus TCP server (disabled)\n");
             stop();
         } else if (enabled && !_running) {
-            log(LOG_INFO, true, "Starting Modbus TCP server (enabled) on port %d\n", _config.port);
+            LOG(LOG_INFO, true, "Starting Modbus TCP server (enabled) on port %d\n", _config.port);
             begin(_config.port);
         }
     }
@@ -433,18 +454,18 @@ bool ModbusTCPServer::isEnabled() const {
 
 void ModbusTCPServer::setPort(uint16_t port) {
     if (port != _config.port) {
-        log(LOG_INFO, true, "Modbus TCP port changing from %d to %d\n", _config.port, port);
+        LOG(LOG_INFO, true, "Modbus TCP port changing from %d to %d\n", _config.port, port);
         _config.port = port;
         if (_running) {
             // Restart server with new port
-            log(LOG_INFO, true, "Restarting Modbus TCP server with new port %d\n", port);
+            LOG(LOG_INFO, true, "Restarting Modbus TCP server with new port %d\n", port);
             stop();
             begin(port);
         } else {
-            log(LOG_INFO, true, "Modbus TCP server not running, port will be applied on next start\n");
+            LOG(LOG_INFO, true, "Modbus TCP server not running, port will be applied on next start\n");
         }
     } else {
-        log(LOG_DEBUG, true, "Modbus TCP port unchanged: %d\n", port);
+        LOG(LOG_DEBUG, true, "Modbus TCP port unchanged: %d\n", port);
     }
 }
 
@@ -454,24 +475,24 @@ uint16_t ModbusTCPServer::getPort() const {
 
 // Global functions implementation
 void init_modbus_tcp() {
-    log(LOG_INFO, true, "Initializing Modbus TCP...\n");
+    LOG(LOG_INFO, true, "Initializing Modbus TCP...\n");
     
     // Use network configuration instead of separate Modbus TCP config
     modbusTCPConfig.port = networkConfig.modbusTcpPort;
     modbusTCPConfig.enabled = true; // Always enabled, controlled by network config
     
-    log(LOG_INFO, true, "Using network config: port=%d, enabled=%s\n", 
+    LOG(LOG_INFO, true, "Using network config: port=%d, enabled=%s\n", 
         modbusTCPConfig.port, modbusTCPConfig.enabled ? "true" : "false");
     
     if (modbusTCPConfig.enabled) {
-        log(LOG_INFO, true, "Starting Modbus TCP server on port %d\n", modbusTCPConfig.port);
+        LOG(LOG_INFO, true, "Starting Modbus TCP server on port %d\n", modbusTCPConfig.port);
         if (modbusServer.begin(modbusTCPConfig.port)) {
-            log(LOG_INFO, true, "Modbus TCP server initialized successfully on port %d\n", modbusTCPConfig.port);
+            LOG(LOG_INFO, true, "Modbus TCP server initialized successfully on port %d\n", modbusTCPConfig.port);
         } else {
-            log(LOG_ERROR, true, "Failed to initialize Modbus TCP server on port %d\n", modbusTCPConfig.port);
+            LOG(LOG_ERROR, true, "Failed to initialize Modbus TCP server on port %d\n", modbusTCPConfig.port);
         }
     } else {
-        log(LOG_INFO, true, "Modbus TCP server disabled in config\n");
+        LOG(LOG_INFO, true, "Modbus TCP server disabled in config\n");
     }
 }
 
@@ -484,98 +505,56 @@ bool loadModbusTCPConfig() {
     modbusTCPConfig.port = MODBUS_TCP_DEFAULT_PORT;
     modbusTCPConfig.enabled = true;
     
-    if (!LittleFS.begin()) {
-        log(LOG_WARNING, true, "Failed to mount LittleFS for Modbus TCP config\n");
-        return false;
-    }
-    
-    if (!LittleFS.exists("/modbus_tcp_config.json")) {
-        log(LOG_INFO, true, "Modbus TCP config file not found, using defaults\n");
-        LittleFS.end();
-        saveModbusTCPConfig(); // Create default config file
-        return true;
-    }
-    
-    File configFile = LittleFS.open("/modbus_tcp_config.json", "r");
-    if (!configFile) {
-        log(LOG_WARNING, true, "Failed to open Modbus TCP config file\n");
-        LittleFS.end();
-        return false;
-    }
-    
-    StaticJsonDocument<256> doc;
-    DeserializationError error = deserializeJson(doc, configFile);
-    configFile.close();
-    LittleFS.end();
-    
-    if (error) {
-        log(LOG_WARNING, true, "Failed to parse Modbus TCP config file: %s\n", error.c_str());
-        return false;
+    if (!loadConfigRecord(MODBUS_TCP_CONFIG_FILENAME, MODBUS_TCP_CONFIG_VERSION, &modbusTCPConfig, sizeof(modbusTCPConfig))) {
+        // Firmware before the binary record kept the config as JSON
+        StaticJsonDocument<256> doc;
+        if (readLegacyConfig(MODBUS_TCP_CONFIG_LEGACY_FILENAME, doc)) {
+            modbusTCPConfig.port = doc["port"] | MODBUS_TCP_DEFAULT_PORT;
+            modbusTCPConfig.enabled = doc["enabled"] | true;
+            LOG(LOG_INFO, true, "Modbus TCP config imported from %s\n", MODBUS_TCP_CONFIG_LEGACY_FILENAME);
+        } else {
+            LOG(LOG_INFO, true, "Modbus TCP config file not found, using defaults\n");
+        }
+        saveModbusTCPConfig(); // Create the config record
+        removeLegacyConfig(MODBUS_TCP_CONFIG_LEGACY_FILENAME);
     }
     
-    uint16_t configPort = doc["port"] | MODBUS_TCP_DEFAULT_PORT;
-    bool configEnabled = doc["enabled"] | true;
-    
-    log(LOG_INFO, true, "Modbus TCP config file values: port=%d, enabled=%s\n", 
-        configPort, configEnabled ? "true" : "false");
-    
-    modbusTCPConfig.port = configPort;
-    modbusTCPConfig.enabled = configEnabled;
-    
-    log(LOG_INFO, true, "Modbus TCP config loaded: port=%d, enabled=%s\n", 
+    LOG(LOG_INFO, true, "Modbus TCP config loaded: port=%d, enabled=%s\n", 
         modbusTCPConfig.port, modbusTCPConfig.enabled ? "true" : "false");
     
     return true;
 }
 
 void saveModbusTCPConfig() {
-    log(LOG_INFO, true, "Saving Modbus TCP config: port=%d, enabled=%s\n", 
+    LOG(LOG_INFO, true, "Saving Modbus TCP config: port=%d, enabled=%s\n", 
         modbusTCPConfig.port, modbusTCPConfig.enabled ? "true" : "false");
     
-    if (!LittleFS.begin()) {
-        log(LOG_WARNING, true, "Failed to mount LittleFS for saving Modbus TCP config\n");
-        return;
+    if (!saveConfigRecord(MODBUS_TCP_CONFIG_FILENAME, MODBUS_TCP_CONFIG_VERSION, &modbusTCPConfig, sizeof(modbusTCPConfig))) {
+        LOG(LOG_WARNING, true, "Failed to write Modbus TCP config file\n");
     }
-    
-    StaticJsonDocument<256> doc;
-    doc["port"] = modbusTCPConfig.port;
-    doc["enabled"] = modbusTCPConfig.enabled;
-    
-    File configFile = LittleFS.open("/modbus_tcp_config.json", "w");
-    if (!configFile) {
-        log(LOG_WARNING, true, "Failed to open Modbus TCP config file for writing\n");
-        LittleFS.end();
-        return;
-    }
-    
-    size_t bytesWritten = serializeJson(doc, configFile);
-    if (bytesWritten == 0) {
-        log(LOG_WARNING, true, "Failed to write Modbus TCP config file\n");
-    } else {
-        log(LOG_INFO, true, "Modbus TCP config saved successfully (%d bytes)\n", bytesWritten);
+}
+
+// Server state and connected clients as reported by /api/modbus-tcp/status
+void serializeModbusTCPStatus(JsonObject status) {
+    status["enabled"] = modbusTCPConfig.enabled;
+    status["port"] = networkConfig.modbusTcpPort; // Use network config port
+    status["running"] = modbusServer.isEnabled();
+    status["connectedClients"] = modbusServer.getConnectedClientCount();
+    
+    JsonArray clients = status.createNestedArray("clients");
+    for (int i = 0; i < MAX_MODBUS_CLIENTS; i++) {
+        String clientInfo = modbusServer.getClientInfo(i);
+        if (clientInfo.length() > 0) {
+            clients.add(clientInfo);
+        }
     }
-    
-    configFile.close();
-    LittleFS.end();
 }
 
 void setupModbusTCPAPI() {
     // Get Modbus TCP status
     server.on("/api/modbus-tcp/status", HTTP_GET, []() {
         StaticJsonDocument<512> doc;
-        
-        doc["enabled"] = modbusTCPConfig.enabled;
-        doc["port"] = networkConfig.modbusTcpPort; // Use network config port
-        doc["running"] = modbusServer.isEnabled();
-        doc["connectedClients"] = modbusServer.getConnectedClientCount();
-        
-        JsonArray clients = doc.createNestedArray("clients");
-        for (int i = 0; i < MAX_MODBUS_CLIENTS; i++) {
-            String clientInfo = modbusServer.getClientInfo(i);
-            if (clientInfo.length() > 0) {
-                clients.add(clientInfo);
-            }
-        }
+        serializeModbusTCPStatus(doc.to<JsonObject>());
         
         String response;
         serializeJson(doc, response);
@@ -600,24 +579,24 @@ void setupModbusTCPAPI() {
         // Update configuration
         if (doc.containsKey("port")) {
             uint16_t newPort = doc["port"];
-            log(LOG_INFO, true, "Modbus TCP config update: port change requested to %d\n", newPort);
+            LOG(LOG_INFO, true, "Modbus TCP config update: port change requested to %d\n", newPort);
             if (newPort >= 1 && newPort <= 65535) {
                 uint16_t oldPort = networkConfig.modbusTcpPort;
                 networkConfig.modbusTcpPort = newPort;
                 modbusTCPConfig.port = newPort; // Update local config too
-                log(LOG_INFO, true, "Modbus TCP config: port updated from %d to %d\n", oldPort, newPort);
+                LOG(LOG_INFO, true, "Modbus TCP config: port updated from %d to %d\n", oldPort, newPort);
                 modbusServer.setPort(newPort);
                 
                 // Save network configuration
                 saveNetworkConfig();
             } else {
-                log(LOG_WARNING, true, "Modbus TCP config: invalid port %d rejected\n", newPort);
+                LOG(LOG_WARNING, true, "Modbus TCP config: invalid port %d rejected\n", newPort);
             }
         }
         
         if (doc.containsKey("enabled")) {
             bool newEnabled = doc["enabled"];
-            log(LOG_INFO, true, "Modbus TCP config update: enabled change requested to %s\n", newEnabled ? "true" : "false");
+            LOG(LOG_INFO, true, "Modbus TCP config update: enabled change requested to %s\n", newEnabled ? "true" : "false");
             modbusTCPConfig.enabled = newEnabled;
             modbusServer.setEnabled(modbusTCPConfig.enabled);
         }
@@ -6,6 +6,9 @@
 
 // Modbus TCP configuration
 #define MODBUS_TCP_DEFAULT_PORT 502
+#define MODBUS_TCP_CONFIG_FILENAME "/modbus_tcp_config.bin"
+#define MODBUS_TCP_CONFIG_VERSION 1
+#define MODBUS_TCP_CONFIG_LEGACY_FILENAME "/modbus_tcp_config.json"   // Imported once, then removed
 #define MAX_MODBUS_CLIENTS 4
 #define MODBUS_TCP_TIMEOUT 300000 // 5 minutes (like reference implementation)
 
@@ -40,6 +43,8 @@ struct ModbusClientConnection {
     uint32_t connectionTime;
     bool active;
     String clientIP;
+    uint32_t requestCount;      // Requests since this client connected
+    uint32_t exceptionCount;    // Exception responses sent to it
 };
 
 // Modbus TCP configuration structure
@@ -61,8 +66,14 @@ public:
     // Client management
     int getConnectedClientCount();
     String getClientInfo(int index);
+    const ModbusClientConnection* getClient(int index) const;  // nullptr if the slot is free
+    uint32_t getTotalRequestCount() const { return _totalRequests; }
+    uint32_t getTotalExceptionCount() const { return _totalExceptions; }
     void disconnectAllClients();
     
+    // Reads and answers one request from the client's stream (public for fuzz/fuzzMbapRequest.cpp)
+    bool processModbusRequest(ModbusClientConnection& client);
+    
     // Configuration
     void setEnabled(bool enabled);
     bool isEnabled() const;
@@ -74,6 +85,8 @@ private:
     ModbusClientConnection _clients[MAX_MODBUS_CLIENTS];
     ModbusTCPConfig _config;
     bool _running;
+    uint32_t _totalRequests;
+    uint32_t _totalExceptions;
     
     // Client management
     void acceptNewClients();
@@ -82,7 +95,6 @@ private:
     int findFreeClientSlot();
     
     // Modbus protocol handling
-    bool processModbusRequest(ModbusClientConnection& client);
     void sendModbusResponse(ModbusClientConnection& client, uint8_t* response, uint16_t length);
     void sendModbusException(ModbusClientConnection& client, uint16_t transactionId, uint8_t unitId, uint8_t functionCode, uint8_t exceptionCode);
     
@@ -101,6 +113,7 @@ void manage_modbus_tcp();
 bool loadModbusTCPConfig();
 void saveModbusTCPConfig();
 void setupModbusTCPAPI();
+void serializeModbusTCPStatus(JsonObject status);
 
 // Global variables
 extern ModbusTCPServer modbusServer;
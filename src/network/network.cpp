@@ -1,5 +1,15 @@
+#define LOG_MODULE LOG_MODULE_NETWORK
 #include "network.h"
 #include "modbus_tcp.h"
+#include "eventManager.h"
+#include "sendJobManager.h"
+
+// Generated into the build directory by scripts/minify_web.py; without it everything comes from LittleFS
+#if __has_include("webAssets.h")
+#include "webAssets.h"
+#else
+#define WEB_ASSET_COUNT 0
+#endif
 
 // Global variables
 NetworkConfig networkConfig;
@@ -20,6 +30,8 @@ bool setStaticIPcmd = false;
 bool setDHCPcmd = false;
 unsigned long lastNetworkCheckTime = 0;
 
+static bool importLegacyNetworkConfig();
+
 // Network component initialisation functions ------------------------------>
 void init_network() {
     setupEthernet();
@@ -29,6 +41,11 @@ void init_network() {
     setupTimeAPI();
     setupModbusTCPAPI();
     setupGatewayConfigAPI();
+    setupBusScanAPI();
+    setupSerialDetectAPI();
+    setupMetricsAPI();
+    setupSchedulerAPI();
+    setupEventsAPI();
     
     // Initialize Modbus TCP server
     init_modbus_tcp();
@@ -37,26 +54,28 @@ void init_network() {
     // It will be called after all API endpoints are registered
 }
 
-void manageNetwork(void) {
-    // Periodic heap monitoring (every 30 seconds) - only log if usage >= 90%
-    static uint32_t lastHeapCheck = 0;
-    if (millis() - lastHeapCheck >= 30000) {
-        lastHeapCheck = millis();
-        uint32_t freeHeap = rp2040.getFreeHeap();
-        uint32_t totalHeap = rp2040.getTotalHeap();
-        uint32_t usedHeap = totalHeap - freeHeap;
-        float heapUsage = (float)usedHeap / totalHeap * 100.0f;
-        
-        // Only log if heap usage is at or above 90%
-        if (heapUsage >= 90.0f) {
-            log(LOG_WARNING, false, "WARNING: Heap usage critical: %d/%d bytes (%.1f%%), %d free\n", 
-                usedHeap, totalHeap, heapUsage, freeHeap);
-        }
-    }
+// Heap monitoring (scheduler task, every HEAP_CHECK_INTERVAL) - only log if usage >= 90%
+void checkHeapUsage(void) {
+    uint32_t freeHeap = rp2040.getFreeHeap();
+    uint32_t totalHeap = rp2040.getTotalHeap();
+    uint32_t usedHeap = totalHeap - freeHeap;
+    float heapUsage = (float)usedHeap / totalHeap * 100.0f;
     
+    // Only log if heap usage is at or above 90%
+    if (heapUsage >= 90.0f) {
+        LOG(LOG_WARNING, false, "WARNING: Heap usage critical: %d/%d bytes (%.1f%%), %d free\n", 
+            usedHeap, totalHeap, heapUsage, freeHeap);
+    }
+}
+
+void manageNetwork(void) {
     manageEthernet();
     if (networkConfig.ntpEnabled) handleNTPUpdates(false);
     manage_modbus_tcp();
+    if (ethernetConnected) {
+        manageEvents();
+        manageSendJobs();
+    }
 }
 
 void setupEthernet()
@@ -65,7 +84,7 @@ void setupEthernet()
   if (!loadNetworkConfig())
   {
     // Set default configuration if load fails
-    log(LOG_INFO, false, "Invalid network configuration, using defaults\n");
+    LOG(LOG_INFO, false, "Invalid network configuration, using defaults\n");
     networkConfig.ntpEnabled = false;
     networkConfig.useDHCP = true;
     networkConfig.ip = IPAddress(192, 168, 1, 100);
@@ -92,7 +111,7 @@ void setupEthernet()
   // Apply network configuration
   if (!applyNetworkConfig())
   {
-    log(LOG_WARNING, false, "Failed to apply network configuration\n");
+    LOG(LOG_WARNING, false, "Failed to apply network configuration\n");
   }
 
   else {
@@ -101,24 +120,16 @@ void setupEthernet()
     eth.macAddress(mac);
     snprintf(deviceMacAddress, sizeof(deviceMacAddress), "%02X:%02X:%02X:%02X:%02X:%02X",
              mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
-    log(LOG_INFO, false, "MAC Address: %s\n", deviceMacAddress);
-  }
-
-  // Wait for Ethernet to connect
-  uint32_t startTime = millis();
-  uint32_t timeout = 10000;
-  while (eth.linkStatus() == LinkOFF) {
-    if (millis() - startTime > timeout) {
-      break;
-    }
+    LOG(LOG_INFO, false, "MAC Address: %s\n", deviceMacAddress);
   }
 
+  // No waiting for the link - manageEthernet() brings the network up when it appears
   if (eth.linkStatus() == LinkOFF) {
-    log(LOG_WARNING, false, "Ethernet not connected\n");
+    LOG(LOG_WARNING, false, "Ethernet link not up yet\n");
     ethernetConnected = false;
   }
   else {
-    log(LOG_INFO, false, "Ethernet connected, IP address: %s, Gateway: %s\n",
+    LOG(LOG_INFO, false, "Ethernet connected, IP address: %s, Gateway: %s\n",
                 eth.localIP().toString().c_str(),
                 eth.gatewayIP().toString().c_str());
     ethernetConnected = true;
@@ -127,46 +138,46 @@ void setupEthernet()
 
 bool loadNetworkConfig()
 {
-  log(LOG_INFO, true, "Loading network configuration:\n");
-  
-  // Check if LittleFS is mounted
-  if (!LittleFS.begin()) {
-    log(LOG_WARNING, true, "Failed to mount LittleFS\n");
-    return false;
-  }
-
-  // Check if config file exists
-  if (!LittleFS.exists(CONFIG_FILENAME)) {
-    log(LOG_WARNING, true, "Config file not found\n");
-    LittleFS.end();
-    return false;
-  }
-
-  // Open config file
-  File configFile = LittleFS.open(CONFIG_FILENAME, "r");
-  if (!configFile) {
-    log(LOG_WARNING, true, "Failed to open config file\n");
-    LittleFS.end();
-    return false;
-  }
+  LOG(LOG_INFO, true, "Loading network configuration:\n");
+
+  NetworkConfigRecord record;
+  if (!loadConfigRecord(CONFIG_FILENAME, CONFIG_VERSION, &record, sizeof(record))) {
+    // Firmware before the binary record kept the config as JSON
+    if (!importLegacyNetworkConfig()) {
+      LOG(LOG_WARNING, true, "Config file not found\n");
+      return false;
+    }
+    saveNetworkConfig();
+    removeLegacyConfig(CONFIG_LEGACY_FILENAME);
+    LOG(LOG_INFO, true, "Network configuration imported from %s\n", CONFIG_LEGACY_FILENAME);
+    return true;
+  }
+
+  networkConfig.ip = IPAddress(record.ip);
+  networkConfig.subnet = IPAddress(record.subnet);
+  networkConfig.gateway = IPAddress(record.gateway);
+  networkConfig.dns = IPAddress(record.dns);
+  networkConfig.useDHCP = record.useDHCP;
+  strlcpy(networkConfig.hostname, record.hostname, sizeof(networkConfig.hostname));
+  strlcpy(networkConfig.ntpServer, record.ntpServer, sizeof(networkConfig.ntpServer));
+  networkConfig.ntpEnabled = record.ntpEnabled;
+  strlcpy(networkConfig.timezone, record.timezone, sizeof(networkConfig.timezone));
+  networkConfig.dstEnabled = record.dstEnabled;
+  networkConfig.modbusTcpPort = record.modbusTcpPort;
+  //debugPrintNetConfig(networkConfig);
+  return true;
+}
 
-  // Allocate a buffer to store contents of the file
+static bool importLegacyNetworkConfig()
+{
   StaticJsonDocument<512> doc;
-  DeserializationError error = deserializeJson(doc, configFile);
-  configFile.close();
-
-  if (error) {
-    log(LOG_WARNING, true, "Failed to parse config file: %s\n", error.c_str());
-    LittleFS.end();
-    return false;
-  }
+  if (!readLegacyConfig(CONFIG_LEGACY_FILENAME, doc)) return false;
 
   // Check magic number
   uint8_t magicNumber = doc["magic_number"] | 0;
-  log(LOG_INFO, true, "Magic number: %x\n", magicNumber);
+  LOG(LOG_INFO, true, "Magic number: %x\n", magicNumber);
   if (magicNumber != CONFIG_MAGIC_NUMBER) {
-    log(LOG_WARNING, true, "Invalid magic number\n");
-    LittleFS.end();
+    LOG(LOG_WARNING, true, "Invalid magic number\n");
     return false;
   }
 
@@ -191,65 +202,31 @@ bool loadNetworkConfig()
   
   // Parse Modbus TCP port
   networkConfig.modbusTcpPort = doc["modbus_tcp_port"] | 502;
-
-  LittleFS.end();
-  //debugPrintNetConfig(networkConfig);
   return true;
 }
 
 void saveNetworkConfig()
 {
-  log(LOG_INFO, true, "Saving network configuration:\n");
+  LOG(LOG_INFO, true, "Saving network configuration:\n");
   printNetConfig(networkConfig);
-  
-  // Check if LittleFS is mounted
-  if (!LittleFS.begin()) {
-    log(LOG_WARNING, true, "Failed to mount LittleFS\n");
-    return;
-  }
 
-  // Create JSON document
-  StaticJsonDocument<512> doc;
-  
-  // Store magic number
-  doc["magic_number"] = CONFIG_MAGIC_NUMBER;
-  
-  // Store network configuration
-  doc["use_dhcp"] = networkConfig.useDHCP;
-  
-  // Store IP addresses as strings
-  doc["ip"] = networkConfig.ip.toString();
-  doc["subnet"] = networkConfig.subnet.toString();
-  doc["gateway"] = networkConfig.gateway.toString();
-  doc["dns"] = networkConfig.dns.toString();
-  
-  // Store strings
-  doc["hostname"] = networkConfig.hostname;
-  doc["ntp_server"] = networkConfig.ntpServer;
-  doc["timezone"] = networkConfig.timezone;
-  
-  // Store booleans
-  doc["ntp_enabled"] = networkConfig.ntpEnabled;
-  doc["dst_enabled"] = networkConfig.dstEnabled;
-  
-  // Store Modbus TCP port
-  doc["modbus_tcp_port"] = networkConfig.modbusTcpPort;
-    
-  // Open file for writing
-  File configFile = LittleFS.open(CONFIG_FILENAME, "w");
-  if (!configFile) {
-    log(LOG_WARNING, true, "Failed to open config file for writing\n");
-    LittleFS.end();
-    return;
+  NetworkConfigRecord record;
+  memset(&record, 0, sizeof(record));  // Zero the padding so identical configs give identical records
+  record.ip = (uint32_t)networkConfig.ip;
+  record.subnet = (uint32_t)networkConfig.subnet;
+  record.gateway = (uint32_t)networkConfig.gateway;
+  record.dns = (uint32_t)networkConfig.dns;
+  record.useDHCP = networkConfig.useDHCP;
+  strlcpy(record.hostname, networkConfig.hostname, sizeof(record.hostname));
+  strlcpy(record.ntpServer, networkConfig.ntpServer, sizeof(record.ntpServer));
+  record.ntpEnabled = networkConfig.ntpEnabled;
+  strlcpy(record.timezone, networkConfig.timezone, sizeof(record.timezone));
+  record.dstEnabled = networkConfig.dstEnabled;
+  record.modbusTcpPort = networkConfig.modbusTcpPort;
+
+  if (!saveConfigRecord(CONFIG_FILENAME, CONFIG_VERSION, &record, sizeof(record))) {
+    LOG(LOG_WARNING, true, "Failed to write config file\n");
   }
-  
-  // Write to file
-  if (serializeJson(doc, configFile) == 0) {
-    log(LOG_WARNING, true, "Failed to write config file\n");
-  }
-  
-  // Close file
-  configFile.close();
 }
 
 bool applyNetworkConfig()
@@ -262,11 +239,11 @@ bool applyNetworkConfig()
     
     if (!eth.begin())
     {
-      log(LOG_WARNING, true, "Failed to configure Ethernet using DHCP, falling back to 192.168.1.100\n");
+      LOG(LOG_WARNING, true, "Failed to configure Ethernet using DHCP, falling back to 192.168.1.100\n");
       IPAddress defaultIP = {192, 168, 1, 100};
       eth.config(defaultIP);
       if (!eth.begin()) {
-        log(LOG_WARNING, true, "Failed to configure Ethernet using static IP, falling back to saved configuration\n");
+        LOG(LOG_WARNING, true, "Failed to configure Ethernet using static IP, falling back to saved configuration\n");
         return false;
       }
     }
@@ -281,20 +258,22 @@ bool applyNetworkConfig()
 
 void setStaticIP()
 {
-  log(LOG_INFO, true, "Setting static IP to 192.168.1.100\n");
+  LOG(LOG_INFO, true, "Setting static IP to 192.168.1.100\n");
   networkConfig.useDHCP = false;
   saveNetworkConfig();
-  log(LOG_INFO, true, "Restarting...\n");
+  LOG(LOG_INFO, true, "Restarting...\n");
+  flushLogs();
   delay(1000);
   rp2040.restart();
 }
 
 void setDHCP()
 {
-  log(LOG_INFO, true, "Setting DHCP\n");
+  LOG(LOG_INFO, true, "Setting DHCP\n");
   networkConfig.useDHCP = true;
   saveNetworkConfig();
-  log(LOG_INFO, true, "Restarting...\n");
+  LOG(LOG_INFO, true, "Restarting...\n");
+  flushLogs();
   delay(1000);
   rp2040.restart();
 }
@@ -403,7 +382,7 @@ void setupNetworkAPI()
               }
 
               // Log network configuration change
-              log(LOG_INFO, true, "Network configuration changed via API: mode=%s, hostname=%s\n",
+              LOG(LOG_INFO, true, "Network configuration changed via API: mode=%s, hostname=%s\n",
                   networkConfig.useDHCP ? "DHCP" : "Static", networkConfig.hostname);
 
               // Save configuration to storage
@@ -418,15 +397,122 @@ void setupNetworkAPI()
             });
 }
 
+// Take the status and flow counter data "locks" with a short retry period.
+// Callers that succeed must call releaseDataLocks().
+bool acquireDataLocks(void) {
+  int retries = 5;
+  while (retries > 0 && (statusLocked || flowCounterDataLocked || sdLocked)) {
+    delay(2);
+    retries--;
+  }
+  if (statusLocked || flowCounterDataLocked) return false;
+  statusLocked = true;
+  flowCounterDataLocked = true;
+  return true;
+}
+
+void releaseDataLocks(void) {
+  flowCounterDataLocked = false;
+  statusLocked = false;
+}
+
+// System status fields - caller holds the data locks
+void fillSystemStatus(JsonObject root) {
+  // Ethernet info
+  JsonObject ethernet = root.createNestedObject("ethernet");
+  ethernet["connected"] = ethernetConnected;
+  if (ethernetConnected) {
+    ethernet["ip"] = eth.localIP().toString();
+    ethernet["gateway"] = eth.gatewayIP().toString();
+    ethernet["subnet"] = eth.subnetMask().toString();
+    ethernet["dhcp"] = networkConfig.useDHCP;
+  }
+  
+  // System uptime and version
+  root["uptime"] = millis() / 1000;
+  root["version"] = VERSION;
+        
+  // SD card info
+  JsonObject sd = root.createNestedObject("sd");
+  if (!sdLocked) {
+    sdLocked = true;
+    sd["inserted"] = sdInfo.inserted;
+    sd["ready"] = sdInfo.ready;
+    
+    // Only include these if SD card is ready
+    if (sdInfo.ready) {
+      sd["capacityGB"] = sdInfo.cardSizeBytes / 1000000000.0;
+      sd["freeSpaceGB"] = sdInfo.cardFreeBytes / 1000000000.0;
+      sd["freeSpaceKnown"] = sdInfo.freeSpaceKnown;
+      sd["logFileSizeKB"] = sdInfo.logSizeBytes / 1000.0;
+      sd["sensorFileSizeKB"] = sdInfo.sensorSizeBytes / 1000.0;
+    }
+    sdLocked = false;
+  }
+  
+  // RS485 Modbus RTU status
+  JsonObject modbus = root.createNestedObject("modbus");
+  modbus["connected"] = status.modbusConnected;
+  
+  // Check for communication errors across all flow counters (now safely locked)
+  bool hasError = false;
+  int activeDevices = 0;
+  int errorDevices = 0;
+  for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
+    if (gatewayConfig.ports[i].enabled) {
+      activeDevices++;
+      if (flowCounterData[i].commError) {
+        hasError = true;
+        errorDevices++;
+      }
+    }
+  }
+  modbus["hasError"] = hasError;
+  modbus["activeDevices"] = activeDevices;
+  modbus["errorDevices"] = errorDevices;
+  
+  // Modbus TCP status
+  JsonObject modbusTcp = root.createNestedObject("modbusTcp");
+  modbusTcp["enabled"] = modbusTCPConfig.enabled;
+  modbusTcp["port"] = modbusTCPConfig.port > 0 ? modbusTCPConfig.port : MODBUS_TCP_DEFAULT_PORT;
+  modbusTcp["connectedClients"] = modbusServer.getConnectedClientCount();
+  
+  // Detailed client information
+  JsonArray clients = modbusTcp.createNestedArray("clients");
+  for (int i = 0; i < MAX_MODBUS_CLIENTS; i++) {
+    String clientInfo = modbusServer.getClientInfo(i);
+    if (clientInfo.length() > 0) {
+      clients.add(clientInfo);
+    }
+  }
+}
+
+// Fill doc with the system status (shared by /api/system/status and the event stream).
+// Returns false with only uptime/busy filled if the data stayed locked.
+bool buildSystemStatus(JsonDocument& doc) {
+  if (!acquireDataLocks()) {
+    // Return minimal response to keep client connection alive
+    doc["uptime"] = millis() / 1000;
+    doc["busy"] = true;
+    return false;
+  }
+  fillSystemStatus(doc.to<JsonObject>());
+  releaseDataLocks();
+  return true;
+}
+
 void setupWebServer()
 {
-  // Initialize LittleFS for serving web files
-  if (!LittleFS.begin())
+  // LittleFS (for web files not embedded in flash) was mounted at boot by init_configStore()
+  if (!configStoreMounted)
   {
-    log(LOG_ERROR, true, "LittleFS Mount Failed\n");
-    return;
+    LOG(LOG_ERROR, true, "LittleFS not mounted, web files only served from flash\n");
   }
 
+  // Request headers the handlers look at (WebServer drops all others)
+  static const char *collectedHeaders[] = {"If-None-Match", "Accept-Encoding", "Range"};
+  server.collectHeaders(collectedHeaders, sizeof(collectedHeaders) / sizeof(collectedHeaders[0]));
+
   // Route handlers
   server.on("/", HTTP_GET, handleRoot);
   server.on("/filemanager", HTTP_GET, handleFileManager);
@@ -436,105 +522,70 @@ void setupWebServer()
   server.on("/api/sd/download", HTTP_GET, handleSDDownloadFile);
   server.on("/api/sd/view", HTTP_GET, handleSDViewFile);
   server.on("/api/sd/delete", HTTP_DELETE, handleSDDeleteFile);
+  server.on("/api/sd/archive", HTTP_GET, handleSDArchive);
 
   // Comprehensive system status endpoint
   server.on("/api/system/status", HTTP_GET, []() {
-    StaticJsonDocument<768> doc;
-    
-    // Try to acquire locks with a short retry period
-    int retries = 5;
-    while (retries > 0 && (statusLocked || flowCounterDataLocked || sdLocked)) {
-      delay(2);
-      retries--;
-    }
-    
-    // If still locked after retries, return cached/partial data instead of error
-    if (statusLocked || flowCounterDataLocked) {
-      // Return minimal response to keep client connection alive
+    // Static so the document never lands on the core 0 stack; WebServer handles one request at a time
+    static StaticJsonDocument<768> doc;
+    doc.clear();
+    buildSystemStatus(doc);
+    sendJsonChunked(200, doc);
+  });
+
+  // Batched dashboard endpoint - every requested part from one locked snapshot, one response
+  server.on("/api/batch", HTTP_GET, []() {
+    String parts = server.hasArg("parts") ? server.arg("parts") : String("status,data");
+    parts = "," + parts + ",";
+    bool wantStatus = parts.indexOf(",status,") >= 0;
+    bool wantData = parts.indexOf(",data,") >= 0;
+    bool wantConfig = parts.indexOf(",config,") >= 0;
+    bool wantTcp = parts.indexOf(",tcp,") >= 0;
+
+    static StaticJsonDocument<2560> doc;
+    doc.clear();
+    if (!acquireDataLocks()) {
       doc["uptime"] = millis() / 1000;
       doc["busy"] = true;
-      String response;
-      serializeJson(doc, response);
-      server.send(200, "application/json", response);
+      sendJsonChunked(200, doc);
       return;
     }
-    
-    statusLocked = true;
-    flowCounterDataLocked = true;
-    
-    // Ethernet info
-    JsonObject ethernet = doc.createNestedObject("ethernet");
-    ethernet["connected"] = ethernetConnected;
-    if (ethernetConnected) {
-      ethernet["ip"] = eth.localIP().toString();
-      ethernet["gateway"] = eth.gatewayIP().toString();
-      ethernet["subnet"] = eth.subnetMask().toString();
-      ethernet["dhcp"] = networkConfig.useDHCP;
-    }
-    
-    // System uptime and version
-    doc["uptime"] = millis() / 1000;
-    doc["version"] = VERSION;
-          
-    // SD card info
-    JsonObject sd = doc.createNestedObject("sd");
-    if (!sdLocked) {
-      sdLocked = true;
-      sd["inserted"] = sdInfo.inserted;
-      sd["ready"] = sdInfo.ready;
-      
-      // Only include these if SD card is ready
-      if (sdInfo.ready) {
-        sd["capacityGB"] = sdInfo.cardSizeBytes / 1000000000.0;
-        sd["freeSpaceGB"] = sdInfo.cardFreeBytes / 1000000000.0;
-        sd["logFileSizeKB"] = sdInfo.logSizeBytes / 1000.0;
-        sd["sensorFileSizeKB"] = sdInfo.sensorSizeBytes / 1000.0;
-      }
-      sdLocked = false;
-    }
-    
-    // RS485 Modbus RTU status
-    JsonObject modbus = doc.createNestedObject("modbus");
-    modbus["connected"] = status.modbusConnected;
-    
-    // Check for communication errors across all flow counters (now safely locked)
-    bool hasError = false;
-    int activeDevices = 0;
-    int errorDevices = 0;
-    for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
-      if (gatewayConfig.ports[i].enabled) {
-        activeDevices++;
-        if (flowCounterData[i].commError) {
-          hasError = true;
-          errorDevices++;
-        }
-      }
+
+    doc["current_millis"] = millis();
+    doc["millis_rollover_count"] = millisRolloverCount;
+    if (wantStatus) fillSystemStatus(doc.createNestedObject("status"));
+    if (wantConfig) serializeGatewayConfig(doc.createNestedObject("config"));
+    if (wantTcp) serializeModbusTCPStatus(doc.createNestedObject("tcp"));
+
+    size_t dataLength = 0;
+    uint32_t dataGeneration;
+    const char* data = wantData ? getGatewayDataBody(&dataLength, &dataGeneration, true) : nullptr;
+    releaseDataLocks();
+
+    // The data part is the cached /api/gateway/data body, spliced in before the closing brace
+    static char head[3072];
+    size_t headLength = serializeJson(doc, head, sizeof(head));
+    if (headLength >= sizeof(head) - 1) {
+      server.send(500, "application/json", "{\"error\":\"Response too large\"}");
+      return;
     }
-    modbus["hasError"] = hasError;
-    modbus["activeDevices"] = activeDevices;
-    modbus["errorDevices"] = errorDevices;
-    
-    // Modbus TCP status
-    JsonObject modbusTcp = doc.createNestedObject("modbusTcp");
-    modbusTcp["enabled"] = modbusTCPConfig.enabled;
-    modbusTcp["port"] = modbusTCPConfig.port > 0 ? modbusTCPConfig.port : MODBUS_TCP_DEFAULT_PORT;
-    modbusTcp["connectedClients"] = modbusServer.getConnectedClientCount();
-    
-    // Detailed client information
-    JsonArray clients = modbusTcp.createNestedArray("clients");
-    for (int i = 0; i < MAX_MODBUS_CLIENTS; i++) {
-      String clientInfo = modbusServer.getClientInfo(i);
-      if (clientInfo.length() > 0) {
-        clients.add(clientInfo);
-      }
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/json", "");
+    server.sendContent(head, headLength - 1);
+    if (data != nullptr) {
+      server.sendContent(",\"data\":");
+      server.sendContent(data, dataLength);
     }
-    
-    flowCounterDataLocked = false;
-    statusLocked = false;
-    
-    String response;
-    serializeJson(doc, response);
-    server.send(200, "application/json", response);
+    server.sendContent("}");
+    server.sendContent("");  // Terminating chunk
+  });
+
+  // Boot profile endpoint
+  server.on("/api/system/boot", HTTP_GET, []() {
+    // Static like /api/system/status - 1.5KB is too much for the core 0 handler stack
+    static StaticJsonDocument<1536> doc;
+    serializeBootProfile(doc.to<JsonObject>());
+    sendJsonChunked(200, doc);
   });
 
   // System version endpoint
@@ -551,6 +602,57 @@ void setupWebServer()
     server.send(200, "application/json", response);
   });
 
+  // Log level endpoints (runtime level per module)
+  server.on("/api/system/log-level", HTTP_GET, []() {
+    StaticJsonDocument<384> doc;
+    JsonObject modules = doc.createNestedObject("modules");
+    for (uint8_t i = 0; i < LOG_MODULE_COUNT; i++) {
+      modules[getLogModuleName(i)] = getLogLevelName(getLogModuleLevel(i));
+    }
+    doc["compileLevel"] = getLogLevelName(LOG_COMPILE_LEVEL);
+    doc["droppedCore0"] = logStats.dropped[0];
+    doc["droppedCore1"] = logStats.dropped[1];
+    doc["droppedSD"] = logStats.sdDropped;
+
+    String response;
+    serializeJson(doc, response);
+    server.send(200, "application/json", response);
+  });
+
+  server.on("/api/system/log-level", HTTP_POST, []() {
+    if (!server.hasArg("plain")) {
+      server.send(400, "application/json", "{\"error\":\"No data received\"}");
+      return;
+    }
+
+    StaticJsonDocument<128> doc;
+    DeserializationError error = deserializeJson(doc, server.arg("plain"));
+    if (error) {
+      server.send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+      return;
+    }
+
+    // {"module":"gateway","level":"debug"} - module "all" sets every module
+    const char* moduleName = doc["module"] | "all";
+    int8_t level = findLogLevel(doc["level"] | "");
+    if (level < 0) {
+      server.send(400, "application/json", "{\"error\":\"Invalid level\"}");
+      return;
+    }
+    if (strcmp(moduleName, "all") == 0) {
+      for (uint8_t i = 0; i < LOG_MODULE_COUNT; i++) setLogModuleLevel(i, level);
+    } else {
+      int8_t module = findLogModule(moduleName);
+      if (module < 0) {
+        server.send(400, "application/json", "{\"error\":\"Invalid module\"}");
+        return;
+      }
+      setLogModuleLevel(module, level);
+    }
+    LOG(LOG_INFO, false, "Log level for %s set to %s via API\n", moduleName, getLogLevelName(level));
+    server.send(200, "application/json", "{\"success\":true}");
+  });
+
   // System reboot endpoint
   server.on("/api/system/reboot", HTTP_POST, []() {
     // Send response first before rebooting
@@ -560,7 +662,8 @@ void setupWebServer()
     delay(100);
     
     // Trigger system reboot
-    log(LOG_INFO, true, "System reboot requested via API\n");
+    LOG(LOG_INFO, true, "System reboot requested via API\n");
+    flushLogs();
     rp2040.restart();
   });
 
@@ -569,16 +672,16 @@ void setupWebServer()
                     { handleFile(server.uri().c_str()); });
 
   // NOTE: server.begin() is now moved to startWebServer() function
-  log(LOG_INFO, true, "Web server configured, but not yet started\n");
+  LOG(LOG_INFO, true, "Web server configured, but not yet started\n");
 }
 
 // Start the web server after all API endpoints have been registered
 void startWebServer() {
-  log(LOG_INFO, true, "Starting web server...\n");
+  LOG(LOG_INFO, true, "Starting web server...\n");
   
   // Start the server
   server.begin();
-  log(LOG_INFO, true, "HTTP server started\n");
+  LOG(LOG_INFO, true, "HTTP server started\n");
   
   // Set Webserver Status
   if (!statusLocked) {
@@ -629,7 +732,7 @@ void manageEthernet(void)
         status.updated = true;
         statusLocked = false;
       }
-      log(LOG_INFO, true, "Ethernet disconnected, waiting for reconnect\n");
+      LOG(LOG_INFO, true, "Ethernet disconnected, waiting for reconnect\n");
     } else {
       if (setStaticIPcmd) {
         setStaticIP();
@@ -643,10 +746,10 @@ void manageEthernet(void)
   else if (eth.linkStatus() == LinkON) {
     ethernetConnected = true;
     if(!applyNetworkConfig()) {
-      log(LOG_ERROR, true, "Failed to apply network configuration!\n");
+      LOG(LOG_ERROR, true, "Failed to apply network configuration!\n");
     }
     else {
-      log(LOG_INFO, true, "Ethernet re-connected, IP address: %s, Gateway: %s\n",
+      LOG(LOG_INFO, true, "Ethernet re-connected, IP address: %s, Gateway: %s\n",
                   eth.localIP().toString().c_str(),
                   eth.gatewayIP().toString().c_str());
     }
@@ -690,6 +793,18 @@ void handleFileManagerPage(void) {
   handleRoot();
 }
 
+char ChunkedJsonWriter::buffer[JSON_CHUNK_SIZE];
+
+// Serialize straight into the response with chunked transfer encoding - no String copy of the body
+void sendJsonChunked(int code, JsonDocument& doc) {
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(code, "application/json", "");
+  ChunkedJsonWriter writer;
+  serializeJson(doc, writer);
+  writer.flush();
+  server.sendContent("");  // Terminating chunk
+}
+
 // Handle file requests - retrieve from LittleFS and send to client
 void handleFile(const char *path)
 {
@@ -711,6 +826,65 @@ void handleFile(const char *path)
     statusLocked = false;
   }
   
+  // Build file path
+  String filePath = path;
+  if (filePath.endsWith("/"))
+    filePath += "index.html";
+  if (!filePath.startsWith("/"))
+    filePath = "/" + filePath;
+
+  // Embedded assets are served straight from flash, pre-compressed
+  const WebAsset *asset = findWebAsset(filePath.c_str());
+  // Gzip or plain depending on Accept-Encoding, so caches must keep the two apart
+  if (asset != nullptr) server.sendHeader("Vary", "Accept-Encoding");
+  if (asset != nullptr && server.hasHeader("Accept-Encoding") && server.header("Accept-Encoding").indexOf("gzip") >= 0) {
+    sendWebAsset(asset);
+  }
+  else {
+    sendLittleFSFile(filePath);
+  }
+  
+  if (!statusLocked) {
+    statusLocked = true;
+    status.webserverBusy = false;
+    status.webserverUp = true;
+    status.updated = true;
+    statusLocked = false;
+  }
+}
+
+const WebAsset *findWebAsset(const char *path)
+{
+#if WEB_ASSET_COUNT > 0
+  for (int i = 0; i < WEB_ASSET_COUNT; i++) {
+    if (strcmp(webAssets[i].path, path) == 0) return &webAssets[i];
+  }
+#else
+  (void)path;
+#endif
+  return nullptr;
+}
+
+// Strong ETag from the content hash; versioned assets are immutable, pages are always revalidated
+void sendWebAsset(const WebAsset *asset)
+{
+  server.sendHeader("ETag", asset->etag);
+  server.sendHeader("Cache-Control", asset->immutable ? "public, max-age=31536000, immutable" : "no-cache");
+  if (server.hasHeader("If-None-Match") && server.header("If-None-Match") == asset->etag) {
+    server.send(304, asset->contentType, "");
+    return;
+  }
+  server.sendHeader("Content-Encoding", "gzip");
+  server.setContentLength(asset->length);
+  server.send(200, asset->contentType, "");
+  server.sendContent((const char *)asset->data, asset->length);
+}
+
+// Fallback for files that are not embedded (or clients without gzip)
+void sendLittleFSFile(const String &filePath)
+{
+  const char *path = filePath.c_str();
+
   // Determine content type
   String contentType;
   if (strstr(path, ".html"))
@@ -730,37 +904,6 @@ void handleFile(const char *path)
   else
     contentType = "text/plain";
 
-  // Build file path
-  String filePath = path;
-  if (filePath.endsWith("/"))
-    filePath += "index.html";
-  if (!filePath.startsWith("/"))
-    filePath = "/" + filePath;
-
-  // CRITICAL: Check if LittleFS is mounted before accessing
-  // This prevents crashes if filesystem becomes corrupted
-  FSInfo fs_info;
-  if (!LittleFS.info(fs_info)) {
-    log(LOG_ERROR, false, "LittleFS filesystem error - attempting remount\n");
-    server.send(503, "text/plain", "Filesystem error");
-    
-    // Try to remount LittleFS
-    LittleFS.end();
-    delay(100);
-    if (!LittleFS.begin()) {
-      log(LOG_ERROR, false, "Failed to remount LittleFS!\n");
-    } else {
-      log(LOG_INFO, false, "LittleFS successfully remounted\n");
-    }
-    
-    if (!statusLocked) {
-      statusLocked = true;
-      status.webserverBusy = false;
-      statusLocked = false;
-    }
-    return;
-  }
-
   // Check if file exists
   if (LittleFS.exists(filePath))
   {
@@ -768,13 +911,13 @@ void handleFile(const char *path)
     
     // Verify file opened successfully
     if (!file) {
-      log(LOG_ERROR, false, "Failed to open file: %s\n", filePath.c_str());
+      LOG(LOG_ERROR, false, "Failed to open file: %s\n", filePath.c_str());
       server.send(500, "text/plain", "Failed to open file");
     } else {
       // Check file size is reasonable (prevent serving corrupted files)
       size_t fileSize = file.size();
       if (fileSize == 0 || fileSize > 512000) { // Max 500KB for web assets
-        log(LOG_WARNING, false, "Suspicious file size for %s: %d bytes\n", filePath.c_str(), fileSize);
+        LOG(LOG_WARNING, false, "Suspicious file size for %s: %d bytes\n", filePath.c_str(), (int)fileSize);
       }
       
       size_t sent = server.streamFile(file, contentType);
@@ -782,26 +925,20 @@ void handleFile(const char *path)
       
       // Verify all bytes were sent
       if (sent != fileSize) {
-        log(LOG_WARNING, false, "File %s: sent %d of %d bytes\n", filePath.c_str(), sent, fileSize);
+        LOG(LOG_WARNING, false, "File %s: sent %d of %d bytes\n", filePath.c_str(), (int)sent, (int)fileSize);
       }
     }
   }
   else
   {
-    log(LOG_DEBUG, false, "File not found: %s\n", filePath.c_str());
+    LOG(LOG_DEBUG, false, "File not found: %s\n", filePath.c_str());
     server.send(404, "text/plain", "File not found");
   }
-  
-  if (!statusLocked) {
-    statusLocked = true;
-    status.webserverBusy = false;
-    status.webserverUp = true;
-    status.updated = true;
-    statusLocked = false;
-  }
 }
 
-void handleSDDownloadFile(void) {
+// Shared by download and view: validates the request, sends the headers and hands the open
+// file to a send job so the body goes out over the following loop passes
+void sendSDFile(bool asAttachment) {
   if (sdLocked) {
     server.send(423, "application/json", "{\"error\":\"SD card is locked\"}");
     return;
@@ -812,6 +949,11 @@ void handleSDDownloadFile(void) {
     return;
   }
   
+  if (!sendJobSlotAvailable()) {
+    server.send(503, "application/json", "{\"error\":\"Too many transfers in progress\"}");
+    return;
+  }
+  
   // Get the requested file path from the query parameter
   String path = server.hasArg("path") ? server.arg("path") : "";
   
@@ -851,19 +993,30 @@ void handleSDDownloadFile(void) {
   }
   
   // Get file size
-  size_t fileSize = file.size();
-  
-  // Check file size limit
-  if (fileSize > MAX_DOWNLOAD_SIZE) {
-    file.close();
-    sdLocked = false;
-    char errorMsg[128];
-    snprintf(errorMsg, sizeof(errorMsg), 
-             "{\"error\":\"File is too large for download (%u bytes). Maximum size is %u bytes.\"}",
-             fileSize, MAX_DOWNLOAD_SIZE);
-    server.send(413, "application/json", errorMsg);
-    return;
+  uint64_t fileSize = file.size();
+  
+  // Single byte range (resume / fetch in pieces), otherwise the whole file
+  uint64_t start = 0;
+  uint64_t end = fileSize > 0 ? fileSize - 1 : 0;
+  bool partial = false;
+  rangeResult_t range = RANGE_IGNORE;
+  if (server.hasHeader("Range") && server.header("Range").length() > 0) {
+    range = parseRangeHeader(server.header("Range"), fileSize, &start, &end);
+  }
+  if (range != RANGE_IGNORE) {
+    if (range == RANGE_UNSATISFIABLE || !file.seekSet(start)) {
+      file.close();
+      sdLocked = false;
+      char contentRange[40];
+      snprintf(contentRange, sizeof(contentRange), "bytes */%" PRIu64, fileSize);
+      server.sendHeader("Content-Range", contentRange);
+      server.send(416, "application/json", "{\"error\":\"Range not satisfiable\"}");
+      return;
+    }
+    partial = true;
   }
+  uint64_t length = fileSize > 0 ? end - start + 1 : 0;
+  sdLocked = false;
   
   // Get the filename from the path
   String fileName = path;
@@ -872,158 +1025,78 @@ void handleSDDownloadFile(void) {
     fileName = fileName.substring(lastSlash + 1);
   }
   
-  // Enhanced headers to force download with the correct filename
-  String contentDisposition = "attachment; filename=\"" + fileName + "\"; filename*=UTF-8''" + fileName;
-  
-  // Use simpler header approach to avoid memory issues
-  server.sendHeader("Content-Type", "application/octet-stream");
-  server.sendHeader("Content-Disposition", contentDisposition);
+  String contentType = "text/plain";
+  if (asAttachment) {
+    // Enhanced headers to force download with the correct filename
+    String contentDisposition = "attachment; filename=\"" + fileName + "\"; filename*=UTF-8''" + fileName;
+    server.sendHeader("Content-Disposition", contentDisposition);
+    contentType = "application/octet-stream";
+  }
+  else if (fileName.endsWith(".html") || fileName.endsWith(".htm")) contentType = "text/html";
+  else if (fileName.endsWith(".css")) contentType = "text/css";
   server.sendHeader("Cache-Control", "no-cache");
-  
-  // Set a watchdog timer and timeout to prevent system hangs
-  uint32_t startTime = millis();
-  uint32_t lastProgressTime = startTime;
-  const uint32_t timeout = 30000; // 30 second timeout
-  
-  WiFiClient client = server.client();
-  
-  // Stream the file in chunks with timeout checks
-  const size_t bufferSize = 1024; // Smaller buffer size for better reliability
-  uint8_t buffer[bufferSize];
-  size_t bytesRead;
-  size_t totalBytesRead = 0;
-  bool timeoutOccurred = false;
-  
-  server.setContentLength(fileSize);
-  server.send(200, "application/octet-stream", ""); // Send headers only
-  
-  // Stream file with careful progress monitoring
-  while (totalBytesRead < fileSize) {
-    // Check for timeout
-    if (millis() - lastProgressTime > timeout) {
-      log(LOG_WARNING, true, "Timeout occurred during file download\n");
-      timeoutOccurred = true;
-      break;
-    }
-    
-    // Read a chunk from the file
-    bytesRead = file.read(buffer, min(bufferSize, fileSize - totalBytesRead));
-    
-    if (bytesRead == 0) {
-      // End of file or error condition
-      break;
-    }
-    
-    // Write chunk to client
-    if (client.write(buffer, bytesRead) != bytesRead) {
-      // Client disconnected or write error
-      log(LOG_WARNING, true, "Client write error during file download\n");
-      break;
-    }
-    
-    totalBytesRead += bytesRead;
-    lastProgressTime = millis(); // Update progress timer
-    
-    // Allow other processes to run
-    yield();
+  server.sendHeader("Accept-Ranges", "bytes");
+  if (partial) {
+    char contentRange[64];
+    snprintf(contentRange, sizeof(contentRange), "bytes %" PRIu64 "-%" PRIu64 "/%" PRIu64, start, end, fileSize);
+    server.sendHeader("Content-Range", contentRange);
   }
   
-  // Clean up
-  file.close();
-  sdLocked = false;
-  
-  if (timeoutOccurred) {
-    log(LOG_ERROR, true, "File download timed out after %u bytes\n", totalBytesRead);
-  } else if (totalBytesRead == fileSize) {
-    log(LOG_INFO, true, "File download completed successfully: %s (%u bytes)\n", 
-        fileName.c_str(), totalBytesRead);
-  } else {
-    log(LOG_WARNING, true, "File download incomplete: %u of %u bytes transferred\n", 
-        totalBytesRead, fileSize);
+  server.setContentLength(length);
+  server.send(partial ? 206 : 200, contentType, ""); // Send headers only
+  startFileSendJob(server.client(), file, start, length, fileName.c_str());
+}
+
+// Decimal digits only; a value too large for 64 bits saturates
+static bool parseRangeNumber(const String &text, uint64_t *value) {
+  if (text.length() == 0) return false;
+  *value = 0;
+  for (unsigned int i = 0; i < text.length(); i++) {
+    char c = text[i];
+    if (c < '0' || c > '9') return false;
+    uint64_t digit = c - '0';
+    *value = *value > (UINT64_MAX - digit) / 10 ? UINT64_MAX : *value * 10 + digit;
   }
+  return true;
+}
+
+// "bytes=a-b", "bytes=a-" or "bytes=-n" (last n bytes). Multiple ranges are not supported and,
+// like a malformed header, are ignored so the whole file is sent (RFC 9110 section 14.2)
+rangeResult_t parseRangeHeader(const String &range, uint64_t fileSize, uint64_t *start, uint64_t *end) {
+  if (!range.startsWith("bytes=") || range.indexOf(',') >= 0) return RANGE_IGNORE;
+  int dash = range.indexOf('-');
+  if (dash < 0) return RANGE_IGNORE;
+  String first = range.substring(6, dash);
+  String last = range.substring(dash + 1);
+  first.trim();
+  last.trim();
+
+  uint64_t firstPos;
+  uint64_t lastPos;
+  if (first.length() == 0) {
+    // Suffix range
+    if (!parseRangeNumber(last, &lastPos)) return RANGE_IGNORE;
+    if (lastPos == 0 || fileSize == 0) return RANGE_UNSATISFIABLE;
+    *start = lastPos >= fileSize ? 0 : fileSize - lastPos;
+    *end = fileSize - 1;
+    return RANGE_SATISFIABLE;
+  }
+
+  if (!parseRangeNumber(first, &firstPos)) return RANGE_IGNORE;
+  if (last.length() == 0) lastPos = UINT64_MAX;
+  else if (!parseRangeNumber(last, &lastPos) || lastPos < firstPos) return RANGE_IGNORE;
+  if (firstPos >= fileSize) return RANGE_UNSATISFIABLE;
+  *start = firstPos;
+  *end = lastPos >= fileSize ? fileSize - 1 : lastPos;
+  return RANGE_SATISFIABLE;
+}
+
+void handleSDDownloadFile(void) {
+  sendSDFile(true);
 }
 
 void handleSDViewFile(void) {
-  if (sdLocked) {
-    server.send(423, "application/json", "{\"error\":\"SD card is locked\"}");
-    return;
-  }
-  
-  if (!sdInfo.ready) {
-    server.send(503, "application/json", "{\"error\":\"SD card not available\"}");
-    return;
-  }
-  
-  // Get the requested file path from the query parameter
-  String path = server.hasArg("path") ? server.arg("path") : "";
-  
-  if (path.length() == 0) {
-    server.send(400, "application/json", "{\"error\":\"File path not specified\"}");
-    return;
-  }
-  
-  // Make sure path starts with a forward slash
-  if (!path.startsWith("/")) {
-    path = "/" + path;
-  }
-  
-  sdLocked = true;
-  
-  // Check if the file exists
-  if (!sd.exists(path.c_str())) {
-    sdLocked = false;
-    server.send(404, "application/json", "{\"error\":\"File not found\"}");
-    return;
-  }
-  
-  // Open the file
-  FsFile file = sd.open(path.c_str(), O_RDONLY);
-  
-  if (!file) {
-    sdLocked = false;
-    server.send(500, "application/json", "{\"error\":\"Failed to open file\"}");
-    return;
-  }
-  
-  if (file.isDirectory()) {
-    file.close();
-    sdLocked = false;
-    server.send(400, "application/json", "{\"error\":\"Path is a directory, not a file\"}");
-    return;
-  }
-  
-  // Get file size
-  size_t fileSize = file.size();
-  
-  // Get the filename from the path
-  String fileName = path;
-  int lastSlash = fileName.lastIndexOf('/');
-  if (lastSlash >= 0) {
-    fileName = fileName.substring(lastSlash + 1);
-  }
-  
-  // Determine content type based on file extension
-  String contentType = "text/plain";
-  if (fileName.endsWith(".html") || fileName.endsWith(".htm")) contentType = "text/html";
-  else if (fileName.endsWith(".css")) contentType = "text/css";
-  
-  // Stream the file to the client
-  WiFiClient client = server.client();
-  
-  // Use a buffer for more efficient file transfer
-  const size_t bufferSize = 2048;
-  uint8_t buffer[bufferSize];
-  size_t bytesRead;
-  
-  do {
-    bytesRead = file.read(buffer, bufferSize);
-    if (bytesRead > 0) {
-      client.write(buffer, bytesRead);
-    }
-  } while (bytesRead == bufferSize);
-  
-  file.close();
-  sdLocked = false;
+  sendSDFile(false);
 }
 
 void handleSDDeleteFile(void) {
@@ -1060,7 +1133,7 @@ void handleSDDeleteFile(void) {
   }
   
   // Attempt to delete the file
-  if (!sd.remove(path.c_str())) {
+  if (!removeSDFile(path.c_str())) {
     sdLocked = false;
     server.send(500, "application/json", "{\"error\":\"Failed to delete file\"}");
     return;
@@ -1068,7 +1141,7 @@ void handleSDDeleteFile(void) {
   
   sdLocked = false;
   
-  log(LOG_INFO, false, "File deleted: %s\n", path.c_str());
+  LOG(LOG_INFO, false, "File deleted: %s\n", path.c_str());
   server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"File deleted\"}");
 }
 
@@ -1088,7 +1161,7 @@ void ntpUpdate(void) {
   if (!eth.linkStatus()) return;
 
   if (!timeClient.update()) {
-    log(LOG_WARNING, true, "Failed to get time from NTP server, retrying\n");
+    LOG(LOG_WARNING, true, "Failed to get time from NTP server, retrying\n");
     bool updateSuccessful = false;
     for (int i = 0; i < 3; i++) {
       if (timeClient.update()) {
@@ -1098,7 +1171,7 @@ void ntpUpdate(void) {
       delay(10);
    }
     if (!updateSuccessful) {
-      log(LOG_ERROR, true, "Failed to get time from NTP server, giving up\n");
+      LOG(LOG_ERROR, true, "Failed to get time from NTP server, giving up\n");
       return;
     }
   }
@@ -1114,18 +1187,18 @@ void ntpUpdate(void) {
   epochTime += (tzHours * 3600 + tzMinutes * 60 + tzDSToffset);
 
   // Gateway does not have RTC - NTP time update disabled
-  log(LOG_INFO, true, "NTP time received but no RTC to update\n");
+  LOG(LOG_INFO, true, "NTP time received but no RTC to update\n");
   lastNTPUpdateTime = millis(); // Record the time of successful update
   
   /* Convert to DateTime and update using thread-safe function
   DateTime newTime = epochToDateTime(epochTime);
   if (!updateGlobalDateTime(newTime))
   {
-    log(LOG_ERROR, true, "Failed to update time from NTP\n");
+    LOG(LOG_ERROR, true, "Failed to update time from NTP\n");
   }
   else
   {
-    log(LOG_INFO, true, "Time updated from NTP server\n");
+    LOG(LOG_INFO, true, "Time updated from NTP server\n");
     lastNTPUpdateTime = millis(); // Record the time of successful update
   }
   */
@@ -1139,7 +1212,7 @@ void handleNTPUpdates(bool forceUpdate) {
   if (ntpUpdateRequested || timeSinceLastUpdate > NTP_UPDATE_INTERVAL || forceUpdate)
   {
     if (timeSinceLastUpdate < NTP_MIN_SYNC_INTERVAL) {
-      log(LOG_INFO, true, "Time since last NTP update: %ds - skipping\n", timeSinceLastUpdate/1000);
+      LOG(LOG_INFO, true, "Time since last NTP update: %ds - skipping\n", timeSinceLastUpdate/1000);
       return;
     }
     ntpUpdate();
@@ -1149,6 +1222,22 @@ void handleNTPUpdates(bool forceUpdate) {
 }
 
 // SD Card File Manager API functions -------------------------------------->
+
+// Takes sdLocked back after it was let go mid-request, waiting briefly for core 1.
+// False if the card stays busy or is no longer ready (the lock is then not held).
+static bool relockSD(void) {
+  for (int retries = 0; sdLocked; retries++) {
+    if (retries == SD_RELOCK_RETRIES) return false;
+    delay(1);
+  }
+  sdLocked = true;
+  if (!sdInfo.ready) {
+    sdLocked = false;
+    return false;
+  }
+  return true;
+}
+
 void handleSDListDirectory(void) {
   if (sdLocked) {
     server.send(423, "application/json", "{\"error\":\"SD card is locked\"}");
@@ -1186,107 +1275,209 @@ void handleSDListDirectory(void) {
     return;
   }
   
-  // Create a JSON document for the response
-  DynamicJsonDocument doc(16384); // Adjust size based on expected directory size
-  
-  doc["path"] = path;
-  JsonArray files = doc.createNestedArray("files");
-  JsonArray directories = doc.createNestedArray("directories");
-  
-  // Read all files and directories in the requested path
-  dir.rewindDirectory();
-  
-  FsFile file;
+  // Paging, filtering and ordering - entries are numbered directories first, then files
+  uint32_t offset = server.hasArg("offset") ? strtoul(server.arg("offset").c_str(), nullptr, 10) : 0;
+  uint32_t limit = server.hasArg("limit") ? strtoul(server.arg("limit").c_str(), nullptr, 10) : 0;  // 0 = no limit
+  uint32_t last = (limit == 0 || limit > UINT32_MAX - offset) ? UINT32_MAX : offset + limit;  // One past the last entry sent
+  String glob = server.hasArg("glob") ? server.arg("glob") : "";
+  String sort = server.hasArg("sort") ? server.arg("sort") : "";
+  bool descending = server.hasArg("order") && server.arg("order") == "desc";
+  sdSortKey_t sortKey = SD_SORT_NONE;
+  if (sort == "name") sortKey = SD_SORT_NAME;
+  else if (sort == "size") sortKey = SD_SORT_SIZE;
+  else if (sort == "modified") sortKey = SD_SORT_MODIFIED;
+
+  // Sorted listings come from the cached index; directories too big for it fall back to directory order
+  uint16_t indexCount = 0;
+  const sdIndexEntry_t *index = nullptr;
+  if (sortKey != SD_SORT_NONE) index = getSDIndex(path.c_str(), glob.c_str(), sortKey, descending, &indexCount);
+
+  // Entries are streamed one at a time, so memory use doesn't depend on the directory size.
+  // The card is only locked while an entry is read, never while it is sent, so core 1's
+  // sensor and log writes go through during long listings.
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  ChunkedJsonWriter writer;
+  StaticJsonDocument<512> entryDoc;
+  entryDoc.set(path.c_str());
+  writer.print("{\"path\":");
+  serializeJson(entryDoc, writer);
+  writer.print(",\"directories\":[");
+
+  bool inFiles = false;
+  bool firstEntry = true;
+  bool complete = true;
+  uint32_t position = 0;
   char filename[256];
-  while (file.openNext(&dir)) {
-    file.getName(filename, sizeof(filename));
-    
-    // Skip hidden files and . and ..
-    if (filename[0] == '.') {
-      file.close();
-      continue;
-    }
-    
-    // Create a JSON object for the file or directory
-    if (file.isDirectory()) {
-      JsonObject dirObj = directories.createNestedObject();
-      dirObj["name"] = filename;
-      
-      // Calculate full path for this directory
-      String fullPath = path;
-      if (!path.endsWith("/")) fullPath += "/";
-      fullPath += filename;
-      dirObj["path"] = fullPath;
-    } else {
-      JsonObject fileObj = files.createNestedObject();
-      fileObj["name"] = filename;
-      fileObj["size"] = file.size();
-      
-      // Calculate full path for this file
-      String fullPath = path;
-      if (!path.endsWith("/")) fullPath += "/";
-      fullPath += filename;
-      fileObj["path"] = fullPath;
-      
-      // Add last modified date
+  char fullPath[320];
+  const char *separator = path.endsWith("/") ? "" : "/";
+
+  // Copies the entry's details into entryDoc (the card is locked), returns whether it is a directory
+  auto readEntry = [&](FsFile &entry) {
+    bool isDirectory = entry.isDirectory();
+    snprintf(fullPath, sizeof(fullPath), "%s%s%s", path.c_str(), separator, filename);
+    entryDoc.clear();
+    entryDoc["name"] = (const char *)filename;
+    entryDoc["path"] = (const char *)fullPath;
+    if (!isDirectory) {
+      entryDoc["size"] = entry.fileSize();
       uint16_t fileDate, fileTime;
-      file.getModifyDateTime(&fileDate, &fileTime);
-      
-      int year = FS_YEAR(fileDate);
-      int month = FS_MONTH(fileDate);
-      int day = FS_DAY(fileDate);
-      int hour = FS_HOUR(fileTime);
-      int minute = FS_MINUTE(fileTime);
-      int second = FS_SECOND(fileTime);
-      
+      entry.getModifyDateTime(&fileDate, &fileTime);
       char dateTimeStr[32];
-      snprintf(dateTimeStr, sizeof(dateTimeStr), "%04d-%02d-%02d %02d:%02d:%02d", 
-               year, month, day, hour, minute, second);
-      fileObj["modified"] = dateTimeStr;
+      snprintf(dateTimeStr, sizeof(dateTimeStr), "%04d-%02d-%02d %02d:%02d:%02d",
+               FS_YEAR(fileDate), FS_MONTH(fileDate), FS_DAY(fileDate),
+               FS_HOUR(fileTime), FS_MINUTE(fileTime), FS_SECOND(fileTime));
+      entryDoc["modified"] = dateTimeStr;
+    }
+    return isDirectory;
+  };
+
+  // Sends entryDoc with the card unlocked, then takes the card back for the next entry
+  auto sendEntry = [&](bool isDirectory) {
+    sdLocked = false;
+    if (!isDirectory && !inFiles) {
+      writer.print("],\"files\":[");
+      inFiles = true;
+      firstEntry = true;
+    }
+    if (!firstEntry) writer.print(",");
+    firstEntry = false;
+    serializeJson(entryDoc, writer);
+    complete = relockSD();
+    return complete;
+  };
+
+  FsFile entry;
+  if (index != nullptr) {
+    uint32_t end = last < indexCount ? last : indexCount;
+    for (uint32_t i = offset; i < end; i++) {
+      // Skip anything removed since the index was built; size and time are read again here
+      if (!entry.open(&dir, index[i].dirIndex, O_RDONLY)) continue;
+      entry.getName(filename, sizeof(filename));
+      bool isDirectory = readEntry(entry);
+      entry.close();
+      if (!sendEntry(isDirectory)) break;
+    }
+    position = indexCount;
+  } else {
+    // Two passes in directory order: directories, then files
+    for (uint8_t pass = 0; pass < 2 && complete; pass++) {
+      dir.rewindDirectory();
+      while (entry.openNext(&dir, O_RDONLY)) {
+        entry.getName(filename, sizeof(filename));
+        // Skip hidden files and . and ..
+        if (filename[0] == '.' || entry.isDirectory() != (pass == 0) ||
+            (glob.length() > 0 && !matchGlob(glob.c_str(), filename))) {
+          entry.close();
+          continue;
+        }
+        bool send = position >= offset && position < last;
+        position++;
+        bool isDirectory = send && readEntry(entry);
+        entry.close();
+        if (send && !sendEntry(isDirectory)) break;
+      }
     }
-    
-    file.close();
   }
-  
+  // Closing a directory doesn't touch the card, so it is also fine for a listing cut short
+  // without the lock (the card stayed busy or went away)
   dir.close();
-  
-  // Add system log file info if listing root directory
+  if (complete) sdLocked = false;
+
+  if (!inFiles) writer.print("],\"files\":[");
+  char tail[160];
+  snprintf(tail, sizeof(tail), "],\"offset\":%" PRIu32 ",\"limit\":%" PRIu32 ",\"total\":%" PRIu32 ",\"sorted\":%s%s",
+           offset, limit, position, index != nullptr ? "true" : "false", complete ? "" : ",\"incomplete\":true");
+  writer.print(tail);
+  // System log file info if listing root directory
   if (path == "/") {
-    if (sd.exists("/logs/system.txt")) {
-      FsFile logFile = sd.open("/logs/system.txt");
-      if (logFile) {
-        doc["system_log_size"] = (uint32_t)logFile.size();
-        logFile.close();
-      }
-    }
+    snprintf(tail, sizeof(tail), ",\"system_log_size\":%" PRIu32, (uint32_t)sdInfo.logSizeBytes);
+    writer.print(tail);
+  }
+  writer.print("}");
+  writer.flush();
+  server.sendContent("");  // Terminating chunk
+}
+
+// Stream every file in a directory (optionally matching glob) as one tar, gzipped with gzip=1
+void handleSDArchive(void) {
+  if (sdLocked) {
+    server.send(423, "application/json", "{\"error\":\"SD card is locked\"}");
+    return;
   }
   
-  sdLocked = false;
+  if (!sdInfo.ready) {
+    server.send(503, "application/json", "{\"error\":\"SD card not available\"}");
+    return;
+  }
+
+  if (!archiveJobAvailable()) {
+    server.send(503, "application/json", "{\"error\":\"Too many transfers in progress\"}");
+    return;
+  }
   
-  // Send the JSON response
-  String response;
-  serializeJson(doc, response);
-  server.send(200, "application/json", response);
+  String path = server.hasArg("path") ? server.arg("path") : "/";
+  if (!path.startsWith("/")) {
+    path = "/" + path;
+  }
+  String glob = server.hasArg("glob") ? server.arg("glob") : "";
+  if (glob.length() >= SD_INDEX_GLOB_LEN) {
+    server.send(400, "application/json", "{\"error\":\"Pattern too long\"}");
+    return;
+  }
+  bool gzip = server.hasArg("gzip") && server.arg("gzip") != "0";
+  
+  sdLocked = true;
+  FsFile dir = sd.open(path.c_str(), O_RDONLY);
+  if (!dir || !dir.isDirectory()) {
+    if (dir) dir.close();
+    sdLocked = false;
+    server.send(404, "application/json", "{\"error\":\"Directory not found\"}");
+    return;
+  }
+  sdLocked = false;
+
+  // Archive is named after the directory
+  String baseName = path.substring(path.lastIndexOf('/') + 1);
+  if (baseName.length() == 0) baseName = "sd";
+  char fileName[64];
+  snprintf(fileName, sizeof(fileName), "%s.%s", baseName.c_str(), gzip ? "tar.gz" : "tar");
+
+  // The size isn't known up front (and live files keep growing), so the headers go out
+  // directly and the body ends when the send job closes the connection
+  char head[256];
+  int headLength = snprintf(head, sizeof(head),
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: %s\r\n"
+    "Content-Disposition: attachment; filename=\"%s\"\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: close\r\n\r\n",
+    gzip ? "application/gzip" : "application/x-tar", fileName);
+  WiFiClient client = server.client();
+  client.write((const uint8_t *)head, headLength);
+  startArchiveSendJob(client, dir, glob.c_str(), gzip, fileName);
+  LOG(LOG_INFO, true, "Archive transfer started: %s%s%s\n", path.c_str(),
+      glob.length() > 0 ? " matching " : "", glob.c_str());
 }
 
 // Debug functions --------------------------------------------------------->
 void printNetConfig(NetworkConfig config)
 {
-  log(LOG_INFO, true, "Mode: %s\n", config.useDHCP ? "DHCP" : "Static");
+  LOG(LOG_INFO, true, "Mode: %s\n", config.useDHCP ? "DHCP" : "Static");
   if (config.useDHCP) {
-    log(LOG_INFO, true, "IP: %s\n", eth.localIP().toString().c_str());
-    log(LOG_INFO, true, "Subnet: %s\n", eth.subnetMask().toString().c_str());
-    log(LOG_INFO, true, "Gateway: %s\n", eth.gatewayIP().toString().c_str());
-    log(LOG_INFO, true, "DNS: %s\n", eth.dnsIP().toString().c_str());
+    LOG(LOG_INFO, true, "IP: %s\n", eth.localIP().toString().c_str());
+    LOG(LOG_INFO, true, "Subnet: %s\n", eth.subnetMask().toString().c_str());
+    LOG(LOG_INFO, true, "Gateway: %s\n", eth.gatewayIP().toString().c_str());
+    LOG(LOG_INFO, true, "DNS: %s\n", eth.dnsIP().toString().c_str());
   } else {
-    log(LOG_INFO, true, "IP: %s\n", config.ip.toString().c_str());
-    log(LOG_INFO, true, "Subnet: %s\n", config.subnet.toString().c_str());
-    log(LOG_INFO, true, "Gateway: %s\n", config.gateway.toString().c_str());
-    log(LOG_INFO, true, "DNS: %s\n", config.dns.toString().c_str());
-  }
-  log(LOG_INFO, true, "Timezone: %s\n", config.timezone);
-  log(LOG_INFO, true, "Hostname: %s\n", config.hostname);
-  log(LOG_INFO, true, "NTP Server: %s\n", config.ntpServer);
-  log(LOG_INFO, true, "NTP Enabled: %s\n", config.ntpEnabled ? "true" : "false");
-  log(LOG_INFO, true, "DST Enabled: %s\n", config.dstEnabled ? "true" : "false");
+    LOG(LOG_INFO, true, "IP: %s\n", config.ip.toString().c_str());
+    LOG(LOG_INFO, true, "Subnet: %s\n", config.subnet.toString().c_str());
+    LOG(LOG_INFO, true, "Gateway: %s\n", config.gateway.toString().c_str());
+    LOG(LOG_INFO, true, "DNS: %s\n", config.dns.toString().c_str());
+  }
+  LOG(LOG_INFO, true, "Timezone: %s\n", config.timezone);
+  LOG(LOG_INFO, true, "Hostname: %s\n", config.hostname);
+  LOG(LOG_INFO, true, "NTP Server: %s\n", config.ntpServer);
+  LOG(LOG_INFO, true, "NTP Enabled: %s\n", config.ntpEnabled ? "true" : "false");
+  LOG(LOG_INFO, true, "DST Enabled: %s\n", config.dstEnabled ? "true" : "false");
 }
\ No newline at end of file
@@ -2,8 +2,10 @@
 
 #include "../sys_init.h"
 
-// LittleFS configuration
-#define CONFIG_FILENAME "/network_config.json"
+// LittleFS configuration record (see configStore.h)
+#define CONFIG_FILENAME "/network_config.bin"
+#define CONFIG_VERSION 1
+#define CONFIG_LEGACY_FILENAME "/network_config.json"   // Imported once, then removed
 #define CONFIG_MAGIC_NUMBER 0x55
 
 // Timing defines
@@ -16,11 +18,18 @@
 #define NTP_STATUS_STALE 1
 #define NTP_STATUS_FAILED 2
 
-// Maximum file size for downloads (5MB to be safe)
-#define MAX_DOWNLOAD_SIZE 5242880
+// JSON API responses are streamed to the client in chunks of this size
+#define JSON_CHUNK_SIZE 512
+
+// A handler that let go of the SD card mid-response waits up to this many ms to get it back
+#define SD_RELOCK_RETRIES 20
+
+#define HEAP_CHECK_INTERVAL 30000     // ms
+
 
 void init_network(void);
 void manageNetwork(void);
+void checkHeapUsage(void);
 
 // Modbus TCP functions
 void init_modbus_tcp(void);
@@ -50,17 +59,47 @@ void handleNetworkManager(void);
 void handleWebServer(void);
 void handleRoot(void);
 void handleFile(const char *path);
+void sendJsonChunked(int code, JsonDocument& doc);
+bool buildSystemStatus(JsonDocument& doc);
+void fillSystemStatus(JsonObject root);
+bool acquireDataLocks(void);
+void releaseDataLocks(void);
 void handleNTPUpdates(bool forceUpdate);
 void ntpUpdate(void);
 
+// Outcome of a download's Range header
+enum rangeResult_t {
+  RANGE_IGNORE,           // Absent, malformed or multi-range - send the whole file with 200
+  RANGE_SATISFIABLE,      // Send the range with 206
+  RANGE_UNSATISFIABLE     // Starts past the end - 416
+};
+
 // File manager API functions
 void handleFileManager(void);
 void handleSDListDirectory(void);
+void handleSDArchive(void);
+void sendSDFile(bool asAttachment);
+rangeResult_t parseRangeHeader(const String &range, uint64_t fileSize, uint64_t *start, uint64_t *end);
 void handleSDDownloadFile(void);
 void handleSDViewFile(void);
 void handleSDDeleteFile(void);
 void handleFileManagerPage(void);
 
+// Web asset embedded in flash by scripts/minify_web.py (gzipped)
+struct WebAsset
+{
+    const char *path;
+    const char *contentType;
+    const uint8_t *data;
+    uint32_t length;
+    const char *etag;       // Quoted content hash
+    bool immutable;         // Referenced with ?v=<hash>, so it can be cached forever
+};
+
+const WebAsset *findWebAsset(const char *path);
+void sendWebAsset(const WebAsset *asset);
+void sendLittleFSFile(const String &filePath);
+
 // Network configuration structure
 struct NetworkConfig
 {
@@ -77,6 +116,22 @@ struct NetworkConfig
     uint16_t modbusTcpPort; // Modbus TCP port
 };
 
+// Persisted form of NetworkConfig - IPAddress is a class, so addresses are stored as uint32_t
+struct NetworkConfigRecord
+{
+    uint32_t ip;
+    uint32_t subnet;
+    uint32_t gateway;
+    uint32_t dns;
+    bool useDHCP;
+    char hostname[32];
+    char ntpServer[64];
+    bool ntpEnabled;
+    char timezone[8];
+    bool dstEnabled;
+    uint16_t modbusTcpPort;
+};
+
 void printNetConfig(NetworkConfig config);
 
 // Global variables
@@ -91,4 +146,45 @@ extern uint32_t lastNTPUpdateTime; // Last successful NTP update time
 
 extern bool ethernetConnected;
 extern bool setStaticIPcmd;
-extern bool setDHCPcmd;
\ No newline at end of file
+extern bool setDHCPcmd;
+
+// Writer that sends a chunked response body in JSON_CHUNK_SIZE pieces (ArduinoJson can
+// serialize straight into it). The buffer is shared, so one response at a time.
+class ChunkedJsonWriter {
+public:
+  size_t write(uint8_t c) {
+    buffer[length++] = c;
+    if (length == JSON_CHUNK_SIZE) flush();
+    return 1;
+  }
+
+  size_t write(const uint8_t *data, size_t size) {
+    for (size_t i = 0; i < size; i++) write(data[i]);
+    return size;
+  }
+
+  size_t print(const char *text) {
+    return write((const uint8_t *)text, strlen(text));
+  }
+
+  // Formatted text through a small stack buffer - lines longer than 160 bytes are cut
+  __attribute__((format(printf, 2, 3))) size_t printf(const char *format, ...) {
+    char line[160];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (n < 0) return 0;
+    return write((const uint8_t *)line, (size_t)n < sizeof(line) ? n : sizeof(line) - 1);
+  }
+
+  void flush() {
+    if (length == 0) return;
+    server.sendContent(buffer, length);
+    length = 0;
+  }
+
+private:
+  static char buffer[JSON_CHUNK_SIZE];
+  size_t length = 0;
+};
@@ -0,0 +1,302 @@
+#define LOG_MODULE LOG_MODULE_NETWORK
+#include "sendJobManager.h"
+
+static SendJob sendJobs[MAX_SEND_JOBS];
+static uint8_t sendJobBuffer[SEND_JOB_CHUNK_SIZE] __attribute__((aligned(4)));
+
+static ArchiveState archiveState;
+static gzipStream_t archiveGzip;
+static uint8_t archiveGzipBuffer[GZIP_OUTPUT_BOUND(GZIP_MAX_INPUT)];
+
+bool sendJobSlotAvailable(void) {
+    for (int i = 0; i < MAX_SEND_JOBS; i++) {
+        if (!sendJobs[i].active) return true;
+    }
+    return false;
+}
+
+static SendJob* claimSendJob(WiFiClient& client, const char* name) {
+    for (int i = 0; i < MAX_SEND_JOBS; i++) {
+        if (sendJobs[i].active) continue;
+        sendJobs[i].client = client;
+        sendJobs[i].remaining = 0;
+        sendJobs[i].sent = 0;
+        sendJobs[i].offset = 0;
+        sendJobs[i].archive = false;
+        sendJobs[i].lastProgress = millis();
+        sendJobs[i].startTime = millis();
+        strlcpy(sendJobs[i].name, name, sizeof(sendJobs[i].name));
+        return &sendJobs[i];
+    }
+    return nullptr;
+}
+
+// Takes over the open file (the caller must not close it) and the client connection.
+// The caller has already sent the response headers and positioned the file at offset.
+bool startFileSendJob(WiFiClient client, FsFile& file, uint64_t offset, uint64_t length, const char* name) {
+    SendJob* job = claimSendJob(client, name);
+    if (job == nullptr) return false;
+    job->file = file;
+    job->remaining = length;
+    job->offset = offset;
+    job->active = true;
+    return true;
+}
+
+bool archiveJobAvailable(void) {
+    return !archiveState.active && sendJobSlotAvailable();
+}
+
+// Takes over the open directory and the client connection. The caller has already
+// sent the response headers; the body ends when the connection closes.
+bool startArchiveSendJob(WiFiClient client, FsFile& dir, const char* glob, bool gzip, const char* name) {
+    if (archiveState.active) return false;
+    SendJob* job = claimSendJob(client, name);
+    if (job == nullptr) return false;
+
+    archiveState.dir = dir;
+    archiveState.dir.rewindDirectory();
+    strlcpy(archiveState.glob, glob, sizeof(archiveState.glob));
+    archiveState.gzip = gzip;
+    archiveState.headerLeft = 0;
+    archiveState.dataLeft = 0;
+    archiveState.zeroLeft = 0;
+    archiveState.lastEntry = false;
+    archiveState.finished = false;
+    archiveState.fileCount = 0;
+    archiveState.active = true;
+    if (gzip) gzipBegin(&archiveGzip);
+
+    job->archive = true;
+    job->active = true;
+    return true;
+}
+
+int getActiveSendJobCount(void) {
+    int count = 0;
+    for (int i = 0; i < MAX_SEND_JOBS; i++) {
+        if (sendJobs[i].active) count++;
+    }
+    return count;
+}
+
+static bool sendJobComplete(SendJob& job) {
+    return job.archive ? archiveState.finished : job.remaining == 0;
+}
+
+static void finishSendJob(SendJob& job) {
+    // The file handles are only touched under sdLocked, so wait for core 1 to let go
+    if (job.file.isOpen() || (job.archive && archiveState.active)) {
+        if (sdLocked) return;
+        sdLocked = true;
+        if (job.file.isOpen()) job.file.close();
+        if (job.archive) {
+            if (archiveState.entry.isOpen()) archiveState.entry.close();
+            archiveState.dir.close();
+            archiveState.active = false;
+        }
+        sdLocked = false;
+    }
+
+    if (sendJobComplete(job)) {
+        uint32_t elapsed = millis() - job.startTime;
+        LOG(LOG_INFO, true, "File transfer completed: %s (%" PRIu64 " bytes in %" PRIu32 " ms, %" PRIu64 " B/s)\n",
+            job.name, job.sent, elapsed, elapsed > 0 ? job.sent * 1000 / elapsed : job.sent);
+    } else if (job.archive) {
+        LOG(LOG_WARNING, true, "Archive transfer incomplete: %s (%" PRIu64 " bytes sent, %" PRIu32 " files)\n",
+            job.name, job.sent, archiveState.fileCount);
+    } else {
+        LOG(LOG_WARNING, true, "File transfer incomplete: %s (%" PRIu64 " bytes sent, %" PRIu64 " left)\n",
+            job.name, job.sent, job.remaining);
+    }
+    job.client.flush();
+    job.client.stop();
+    job.active = false;
+}
+
+static void sendFileChunk(SendJob& job, int writable) {
+    size_t chunk = SEND_JOB_CHUNK_SIZE;
+    if ((size_t)writable < chunk) chunk = writable;
+
+    // Stop at the next sector boundary so the following reads are whole aligned sectors
+    size_t toBoundary = SEND_JOB_SECTOR_SIZE - (job.offset % SEND_JOB_SECTOR_SIZE);
+    if (chunk > toBoundary) chunk = toBoundary + ((chunk - toBoundary) / SEND_JOB_SECTOR_SIZE) * SEND_JOB_SECTOR_SIZE;
+    if (job.remaining < chunk) chunk = job.remaining;
+
+    sdLocked = true;
+    int bytesRead = job.file.read(sendJobBuffer, chunk);
+    sdLocked = false;
+
+    if (bytesRead <= 0) {
+        LOG(LOG_WARNING, true, "Read error during file transfer: %s\n", job.name);
+        finishSendJob(job);
+        return;
+    }
+
+    size_t written = job.client.write(sendJobBuffer, bytesRead);
+    if (written != (size_t)bytesRead) {
+        LOG(LOG_WARNING, true, "Client write error during file transfer: %s\n", job.name);
+        finishSendJob(job);
+        return;
+    }
+
+    job.sent += written;
+    job.offset += written;
+    job.remaining -= written;
+    job.lastProgress = millis();
+}
+
+// Archive generator (caller must hold sdLocked) --------------------------->
+
+// FAT date/time (local, no RTC) to seconds since 1970 for the tar header
+static uint32_t fatToUnixTime(uint16_t date, uint16_t time) {
+    int32_t year = FS_YEAR(date);
+    uint32_t month = FS_MONTH(date);
+    uint32_t day = FS_DAY(date);
+    year -= month <= 2;
+    int32_t era = year / 400;
+    uint32_t yearOfEra = year - era * 400;
+    uint32_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    uint32_t days = era * 146097 + dayOfEra - 719468;
+    return days * 86400 + FS_HOUR(time) * 3600 + FS_MINUTE(time) * 60 + FS_SECOND(time);
+}
+
+// ustar header for a regular file
+static void buildTarHeader(uint8_t* header, const char* name, uint64_t size, uint32_t mtime) {
+    char* h = (char*)header;
+    memset(header, 0, TAR_BLOCK_SIZE);
+    memcpy(h, name, strnlen(name, TAR_NAME_LEN));   // Field is not NUL terminated when full
+    snprintf(h + 100, 8, "%07o", 0644);
+    snprintf(h + 108, 8, "%07o", 0);
+    snprintf(h + 116, 8, "%07o", 0);
+    snprintf(h + 124, 12, "%011" PRIo64, size);
+    snprintf(h + 136, 12, "%011" PRIo32, mtime);
+    h[156] = '0';
+    memcpy(h + 257, "ustar", 6);
+    memcpy(h + 263, "00", 2);
+
+    // Checksum is computed with its own field set to spaces
+    memset(h + 148, ' ', 8);
+    uint32_t checksum = 0;
+    for (int i = 0; i < TAR_BLOCK_SIZE; i++) checksum += header[i];
+    snprintf(h + 148, 7, "%06" PRIo32, checksum);
+}
+
+// Open the next matching file and queue its header, data and padding
+static bool nextArchiveEntry(void) {
+    char name[256];
+    while (archiveState.entry.openNext(&archiveState.dir, O_RDONLY)) {
+        archiveState.entry.getName(name, sizeof(name));
+        uint64_t size = archiveState.entry.fileSize();
+        // Only files directly in the directory; tar's 11 octal digits cap sizes at 8GB
+        if (name[0] == '.' || archiveState.entry.isDirectory() || strlen(name) >= TAR_NAME_LEN ||
+            size > 077777777777ULL || (archiveState.glob[0] != '\0' && !matchGlob(archiveState.glob, name))) {
+            archiveState.entry.close();
+            continue;
+        }
+
+        uint16_t fileDate, fileTime;
+        archiveState.entry.getModifyDateTime(&fileDate, &fileTime);
+        buildTarHeader(archiveState.header, name, size, fatToUnixTime(fileDate, fileTime));
+        archiveState.headerLeft = TAR_BLOCK_SIZE;
+        archiveState.dataLeft = size;
+        archiveState.zeroLeft = (TAR_BLOCK_SIZE - size % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE;
+        archiveState.fileCount++;
+        if (size == 0) archiveState.entry.close();
+        return true;
+    }
+    return false;
+}
+
+// Fill out with the next space bytes of the tar stream
+static size_t fillArchive(uint8_t* out, size_t space) {
+    size_t used = 0;
+    while (used < space && !archiveState.finished) {
+        size_t room = space - used;
+        if (archiveState.headerLeft > 0) {
+            size_t n = room < archiveState.headerLeft ? room : archiveState.headerLeft;
+            memcpy(out + used, archiveState.header + TAR_BLOCK_SIZE - archiveState.headerLeft, n);
+            archiveState.headerLeft -= n;
+            used += n;
+        } else if (archiveState.dataLeft > 0) {
+            size_t n = room < archiveState.dataLeft ? room : archiveState.dataLeft;
+            int bytesRead = archiveState.entry.read(out + used, n);
+            if (bytesRead <= 0) {
+                // The header already promised the size - pad so the archive stays readable
+                LOG(LOG_WARNING, true, "Read error while archiving, entry %" PRIu32 " zero filled\n", archiveState.fileCount);
+                archiveState.zeroLeft += archiveState.dataLeft;
+                archiveState.dataLeft = 0;
+            } else {
+                archiveState.dataLeft -= bytesRead;
+                used += bytesRead;
+            }
+            if (archiveState.dataLeft == 0) archiveState.entry.close();
+        } else if (archiveState.zeroLeft > 0) {
+            size_t n = room < archiveState.zeroLeft ? room : archiveState.zeroLeft;
+            memset(out + used, 0, n);
+            archiveState.zeroLeft -= n;
+            used += n;
+        } else if (archiveState.lastEntry) {
+            archiveState.finished = true;
+        } else if (!nextArchiveEntry()) {
+            // Two zero blocks end the archive
+            archiveState.zeroLeft = 2 * TAR_BLOCK_SIZE;
+            archiveState.lastEntry = true;
+        }
+    }
+    return used;
+}
+
+static void sendArchiveChunk(SendJob& job, int writable) {
+    if (writable < SEND_JOB_MIN_WRITE) return;
+    size_t chunk = SEND_JOB_CHUNK_SIZE;
+    if ((size_t)writable < chunk) chunk = writable;
+    if (archiveState.gzip) {
+        // Leave room for the worst case expansion of incompressible data
+        size_t limit = (writable - 32) * 8 / 9;
+        if (chunk > limit) chunk = limit;
+        if (chunk > GZIP_MAX_INPUT) chunk = GZIP_MAX_INPUT;
+    }
+
+    sdLocked = true;
+    size_t length = fillArchive(sendJobBuffer, chunk);
+    sdLocked = false;
+
+    const uint8_t* data = sendJobBuffer;
+    if (archiveState.gzip) {
+        length = gzipCompress(&archiveGzip, sendJobBuffer, length, archiveGzipBuffer, archiveState.finished);
+        data = archiveGzipBuffer;
+    }
+    if (length == 0) return;
+
+    size_t written = job.client.write(data, length);
+    if (written != length) {
+        LOG(LOG_WARNING, true, "Client write error during archive transfer: %s\n", job.name);
+        archiveState.finished = false;
+        finishSendJob(job);
+        return;
+    }
+    job.sent += written;
+    job.lastProgress = millis();
+}
+
+// Move at most one chunk per job - never waits on the client or the card
+void manageSendJobs(void) {
+    for (int i = 0; i < MAX_SEND_JOBS; i++) {
+        SendJob& job = sendJobs[i];
+        if (!job.active) continue;
+
+        if (sendJobComplete(job) || !job.client.connected() || !sdInfo.ready ||
+            millis() - job.lastProgress > SEND_JOB_TIMEOUT) {
+            finishSendJob(job);
+            continue;
+        }
+
+        // Only read what the socket can take right now
+        int writable = job.client.availableForWrite();
+        if (writable <= 0 || sdLocked) continue;
+        if (job.archive) sendArchiveChunk(job, writable);
+        else sendFileChunk(job, writable);
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../sys_init.h"
+#include <WiFiClient.h>
+#include "../utils/gzipStream.h"
+
+// Long HTTP responses (SD file downloads/views) are sent as jobs: the handler sends the headers
+// and returns, then manageSendJobs() moves one chunk per job per network loop pass
+#define MAX_SEND_JOBS 3
+#define SEND_JOB_CHUNK_SIZE 4096        // Max bytes per job per pass - whole sectors, about one socket TX window
+#define SEND_JOB_SECTOR_SIZE 512        // Reads are kept sector aligned so SdFat reads straight into the buffer
+#define SEND_JOB_TIMEOUT 30000          // Drop a job whose client hasn't accepted data for this long
+#define SEND_JOB_MIN_WRITE 128          // Archive jobs wait for at least this much socket space
+
+// Archive jobs stream a tar of one directory (optionally gzipped) - one at a time
+#define TAR_BLOCK_SIZE 512
+#define TAR_NAME_LEN 100
+
+struct SendJob {
+    bool active;
+    WiFiClient client;
+    FsFile file;
+    uint64_t remaining;
+    uint64_t sent;
+    uint32_t lastProgress;
+    uint32_t startTime;
+    uint64_t offset;    // File position of the next read
+    bool archive;       // Body comes from the archive generator instead of file
+    char name[64];      // For the completion log
+};
+
+struct ArchiveState {
+    bool active;
+    FsFile dir;
+    FsFile entry;
+    char glob[SD_INDEX_GLOB_LEN];
+    bool gzip;
+    uint8_t header[TAR_BLOCK_SIZE];
+    uint16_t headerLeft;    // Header bytes of the current entry still to send
+    uint64_t dataLeft;      // File bytes of the current entry still to send
+    uint32_t zeroLeft;      // Padding (or end of archive) bytes still to send
+    bool lastEntry;         // No more entries - the end of archive blocks are queued
+    bool finished;          // Generator has produced everything
+    uint32_t fileCount;
+};
+
+void manageSendJobs(void);
+bool sendJobSlotAvailable(void);
+bool startFileSendJob(WiFiClient client, FsFile& file, uint64_t offset, uint64_t length, const char* name);
+bool startArchiveSendJob(WiFiClient client, FsFile& dir, const char* glob, bool gzip, const char* name);
+bool archiveJobAvailable(void);
+int getActiveSendJobCount(void);
@@ -0,0 +1,95 @@
+#define LOG_MODULE LOG_MODULE_SYSTEM
+#include "configStore.h"
+
+bool configStoreMounted = false;
+
+static uint8_t configScratch[CONFIG_RECORD_MAX_SIZE];
+
+void init_configStore(void) {
+    configStoreMounted = LittleFS.begin();
+    if (!configStoreMounted) {
+        LOG(LOG_ERROR, true, "LittleFS mount failed, configuration will not persist\n");
+        return;
+    }
+    LOG(LOG_INFO, false, "LittleFS mounted\n");
+}
+
+static uint32_t configCrc32(const uint8_t* data, size_t length) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+
+// Copies the record into data only if magic, version, length and CRC all match
+bool loadConfigRecord(const char* path, uint16_t version, void* data, size_t length) {
+    if (!configStoreMounted || length > CONFIG_RECORD_MAX_SIZE) return false;
+    if (!LittleFS.exists(path)) return false;
+
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        LOG(LOG_WARNING, true, "Failed to open %s\n", path);
+        return false;
+    }
+    configRecordHeader_t header;
+    bool ok = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+              header.magic == CONFIG_RECORD_MAGIC && header.version == version && header.length == length &&
+              file.read(configScratch, length) == length && configCrc32(configScratch, length) == header.crc;
+    file.close();
+
+    if (!ok) {
+        LOG(LOG_WARNING, true, "Config record %s is invalid or from another version\n", path);
+        return false;
+    }
+    memcpy(data, configScratch, length);
+    return true;
+}
+
+bool saveConfigRecord(const char* path, uint16_t version, const void* data, size_t length) {
+    if (!configStoreMounted || length > CONFIG_RECORD_MAX_SIZE) return false;
+
+    configRecordHeader_t header;
+    header.magic = CONFIG_RECORD_MAGIC;
+    header.version = version;
+    header.length = length;
+    header.crc = configCrc32((const uint8_t*)data, length);
+
+    char tempPath[48];
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+    File file = LittleFS.open(tempPath, "w");
+    if (!file) {
+        LOG(LOG_WARNING, true, "Failed to open %s for writing\n", tempPath);
+        return false;
+    }
+    bool ok = file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+              file.write((const uint8_t*)data, length) == length;
+    file.close();
+
+    // LittleFS renames atomically, replacing the old record in one step
+    if (!ok || !LittleFS.rename(tempPath, path)) {
+        LOG(LOG_WARNING, true, "Failed to save %s\n", path);
+        LittleFS.remove(tempPath);
+        return false;
+    }
+    return true;
+}
+
+// Parse a config file written by firmware that stored JSON
+bool readLegacyConfig(const char* path, JsonDocument& doc) {
+    if (!configStoreMounted || !LittleFS.exists(path)) return false;
+    File file = LittleFS.open(path, "r");
+    if (!file) return false;
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+    if (error) {
+        LOG(LOG_WARNING, true, "Failed to parse %s: %s\n", path, error.c_str());
+        return false;
+    }
+    return true;
+}
+
+void removeLegacyConfig(const char* path) {
+    if (configStoreMounted && LittleFS.exists(path)) LittleFS.remove(path);
+}
@@ -0,0 +1,29 @@
+/* Description: Persistent configuration records on LittleFS
+ * LittleFS is mounted once at boot by init_configStore() and stays mounted for the
+ * web server. Each config struct is stored as one binary record: a header with a
+ * version and CRC32, then the struct itself. Saves write a temporary file and rename
+ * it over the old one, so a reset mid-save leaves the previous record intact.
+ * JSON only exists at the API boundary (and for the one-off import of old JSON files).
+ */
+
+#pragma once
+
+#include "../sys_init.h"
+
+#define CONFIG_RECORD_MAGIC 0x47464347      // "GCFG"
+#define CONFIG_RECORD_MAX_SIZE 512          // Largest config struct a record can hold
+
+struct configRecordHeader_t {
+  uint32_t magic;
+  uint16_t version;     // Bump the owner's version when its struct layout changes
+  uint16_t length;      // sizeof the struct that was saved
+  uint32_t crc;         // CRC32 of the struct bytes
+};
+
+void init_configStore(void);
+bool loadConfigRecord(const char* path, uint16_t version, void* data, size_t length);
+bool saveConfigRecord(const char* path, uint16_t version, const void* data, size_t length);
+bool readLegacyConfig(const char* path, JsonDocument& doc);
+void removeLegacyConfig(const char* path);
+
+extern bool configStoreMounted;
@@ -1,11 +1,48 @@
+#define LOG_MODULE LOG_MODULE_SD
 #include "sdManager.h"
 
 SdFs sd;
 FsFile file;
 
 sdInfo_t sdInfo;
-uint32_t sdTS;
 volatile bool sdLocked = false;
+volatile uint32_t sdDirGeneration = 0;   // Bumped whenever a directory entry is added, renamed or removed
+volatile uint32_t sdDataGeneration = 0;  // Bumped whenever a file grows (sizes and modify times change)
+
+// Log stream table - avoids exists()/open() probing on every write
+static sdLogStream_t logStreams[SD_MAX_LOG_STREAMS];
+static uint8_t logStreamCount = 0;
+static bool logStreamTableComplete = false;  // False if a stream was dropped or evicted since mount
+static uint32_t archiveSeqFloor = 0;         // Larger than any archive sequence seen on the card
+
+static void scanLogStreams(const char* dirPath);
+static sdLogStream_t* findLogStream(const char* path, bool create);
+static bool rotateLogStream(sdLogStream_t* stream);
+static bool appendLogStream(sdLogStream_t* stream, const char* data);
+static uint32_t countScannedClusters(uint32_t firstSector, uint32_t skip);
+
+// Free space accounting - one incremental FAT scan after mount, then kept up
+// to date from our own allocations and deletions
+static bool freeScanActive = false;
+static uint32_t freeScanSector = 0;      // Next FAT sector to read
+static uint32_t freeScanEntry = 0;       // FAT entry index at the start of that sector
+static uint32_t freeScanCount = 0;       // Free clusters counted so far
+static int32_t freeScanDelta = 0;        // Allocations/deletions behind the scan while it runs
+static uint32_t freeClusters = 0;
+static uint8_t freeScanBuffer[SD_FREE_SCAN_SECTORS * 512];
+static uint8_t fatChainBuffer[512];     // One FAT sector for walking a file's cluster chain
+static uint32_t fatChainSector = 0;     // Sector held in fatChainBuffer, 0 for none
+
+// Sorted listing index - one directory at a time, rebuilt when the request or the card changes
+static sdIndexEntry_t sdIndex[SD_INDEX_MAX_ENTRIES];
+static uint16_t sdIndexCount = 0;
+static bool sdIndexValid = false;
+static char sdIndexPath[SD_LOG_STREAM_PATH_LEN];
+static char sdIndexGlob[SD_INDEX_GLOB_LEN];
+static sdSortKey_t sdIndexSortKey;
+static bool sdIndexDescending;
+static uint32_t sdIndexGeneration;
+static uint32_t sdIndexDataGeneration;
 
 void init_sdManager(void) {
     SPI1.setMISO(PIN_SD_MISO);
@@ -14,14 +51,10 @@ void init_sdManager(void) {
     
     FsDateTime::setCallback(dateTimeCallback);
     
-    sdTS = millis();
-    log(LOG_INFO, false, "SD card manager initialised\n");
+    LOG(LOG_INFO, false, "SD card manager initialised\n");
 }
 
 void manageSD(void) {
-    if (millis() - sdTS < SD_MANAGE_INTERVAL) return;
-    sdTS = millis();
-    
     if (!sdInfo.ready && !digitalRead(PIN_SD_CD)) {
         mountSD();
     } else {
@@ -39,7 +72,7 @@ void manageSD(void) {
 void mountSD(void) {
     // Check if SD card is inserted
     if (digitalRead(PIN_SD_CD)) {
-        log(LOG_WARNING, false,"SD card not inserted\n");
+        LOG(LOG_WARNING, false,"SD card not inserted\n");
         if (sdLocked) return;
         sdLocked = true;
         sdInfo.inserted = false;
@@ -59,32 +92,43 @@ void mountSD(void) {
     if (sdLocked) return;
     sdLocked = true;
     sdInfo.inserted = true;
-    log(LOG_INFO, false, "SD card inserted, mounting FS\n");
+    LOG(LOG_INFO, false, "SD card inserted, mounting FS\n");
     if (!sd.begin(SDIO_CONFIG)) {
-        log(LOG_ERROR, false, "Attempt 1 failed, retrying\n");
+        LOG(LOG_ERROR, false, "Attempt 1 failed, retrying\n");
         delay(100);
         if (!sd.begin(SDIO_CONFIG)) {
-            log(LOG_ERROR, false, "SD card initialisation with SDIO config failed, attempting SPI config\n");
+            LOG(LOG_ERROR, false, "SD card initialisation with SDIO config failed, attempting SPI config\n");
             if (!sd.begin(SdSpiConfig(PIN_SD_CS, DEDICATED_SPI, SD_SCK_MHZ(40), &SPI1))) {
                 if (sd.card()->errorCode()) {
-                    log(LOG_ERROR, false, "SD card initialisation failed with error code %d\n", sd.card()->errorCode());
+                    LOG(LOG_ERROR, false, "SD card initialisation failed with error code %d\n", sd.card()->errorCode());
                 }
             } else sdSPIinitialised = true;
         }
     } else sdSDIOinitialised = true;
     if (sdSPIinitialised || sdSDIOinitialised) {
-        log(LOG_INFO, true, "SD card initialisation successful, using %s\n", sdSPIinitialised ? "SPI" : "SDIO");
+        LOG(LOG_INFO, true, "SD card initialisation successful, using %s\n", sdSPIinitialised ? "SPI" : "SDIO");
         // Check for correct folder structure and create if missing
         if (!sd.exists("/sensors")) sd.mkdir("/sensors");
         if (!sd.exists("/logs")) sd.mkdir("/logs");
         // Check for log files and create if missing
-        if (!sd.exists("/logs/system.txt")) {
-            FsFile logFile = sd.open("/logs/system.txt", O_CREAT | O_WRITE);
+        if (!sd.exists(SD_SYSTEM_LOG_PATH)) {
+            FsFile logFile = sd.open(SD_SYSTEM_LOG_PATH, O_CREAT | O_WRITE);
             logFile.close();
         }
+        // Recover live file sizes and archive sequence numbers once, so
+        // writes and rotations need no further metadata lookups
+        logStreamCount = 0;
+        archiveSeqFloor = 0;
+        logStreamTableComplete = true;
+        scanLogStreams("/logs");
+        scanLogStreams("/");
+        LOG(LOG_INFO, false, "SD log streams recovered: %d tracked, next archive #%" PRIu32 "\n",
+            logStreamCount, archiveSeqFloor);
+        startFreeSpaceScan();
+        sdDirGeneration++;
         sdInfo.ready = true;
     }
-    if (sdInfo.ready) log(LOG_INFO, true, "SD card mounted and ready\n");
+    if (sdInfo.ready) LOG(LOG_INFO, true, "SD card mounted and ready\n");
     if (!statusLocked) {
         statusLocked = true;
         status.sdCardOK = true;
@@ -100,9 +144,12 @@ void maintainSD(void) {
     if (sdLocked) return;
     sdLocked = true;
     if (digitalRead(PIN_SD_CD) && sdInfo.inserted) {
-        log(LOG_WARNING, false, "SD card removed\n");
+        LOG(LOG_WARNING, false, "SD card removed\n");
         sdInfo.inserted = false;
         sdInfo.ready = false;
+        logStreamCount = 0;
+        freeScanActive = false;
+        sdInfo.freeSpaceKnown = false;
         if (!statusLocked) {
             statusLocked = true;
             status.sdCardOK = false;
@@ -132,25 +179,23 @@ void printSDInfo(void) {
     if (sdLocked) return;
     sdLocked = true;
     if (!sdInfo.ready) {
-        if (digitalRead(PIN_SD_CD)) log(LOG_INFO, false, "SD card not inserted\n");
-        else log(LOG_INFO, false, "SD card not ready\n");
+        if (digitalRead(PIN_SD_CD)) LOG(LOG_INFO, false, "SD card not inserted\n");
+        else LOG(LOG_INFO, false, "SD card not ready\n");
         sdLocked = false;
         return;
     }
 
+    // Free space comes from the background scan - never call freeClusterCount() here
     sdInfo.cardSizeBytes = (uint64_t)sd.card()->sectorCount() * 512;
-    sdInfo.cardFreeBytes = (uint64_t)sd.vol()->bytesPerCluster() * (uint64_t)sd.freeClusterCount();
-    sdLocked = false;
-    uint64_t logFileSize = getFileSize("/logs/system.txt");
-    uint64_t sensorFileSize = getFileSize("/sensors/sensors.csv");
-    sdLocked = true;
+    sdLogStream_t* logStream = findLogStream(SD_SYSTEM_LOG_PATH, false);
+    uint64_t logFileSize = logStream ? logStream->sizeBytes : 0;
     sdInfo.logSizeBytes = logFileSize;
-    sdInfo.sensorSizeBytes = sensorFileSize;
     
-    log(LOG_INFO, false, "SD card size: %0.1f GB\n", sdInfo.cardSizeBytes * 0.000000001);
-    log(LOG_INFO, false, "Free space: %0.1f GB\n", sdInfo.cardFreeBytes * 0.000000001);
-    log(LOG_INFO, false, "Volume is FAT%d\n", sd.vol()->fatType());
-    log(LOG_INFO, false, "Log file size: %0.1f kbytes\n", 0.001 * (float)logFileSize);
+    LOG(LOG_INFO, false, "SD card size: %0.1f GB\n", sdInfo.cardSizeBytes * 0.000000001);
+    if (sdInfo.freeSpaceKnown) LOG(LOG_INFO, false, "Free space: %0.1f GB\n", sdInfo.cardFreeBytes * 0.000000001);
+    else LOG(LOG_INFO, false, "Free space: calculating\n");
+    LOG(LOG_INFO, false, "Volume is FAT%d\n", sd.vol()->fatType());
+    LOG(LOG_INFO, false, "Log file size: %0.1f kbytes\n", 0.001 * (float)logFileSize);
     
     sdLocked = false;
 }
@@ -162,62 +207,27 @@ void dateTimeCallback(uint16_t* date, uint16_t* time) {
     *time = FS_TIME(0, 0, 0);
 }
 
-bool writeLog(const char *message) {
+// Append already timestamped lines (the logger batches them) to the system log
+bool writeLog(const char *lines) {
     if (sdLocked) return false;
     sdLocked = true;
     if (!sdInfo.ready) {
         sdLocked = false;
         return false;
     }
-    sdLocked = false;
-    
-    // Use uptime instead of RTC timestamp
-    uint32_t uptime = millis() / 1000;
-    char dateTimeStr[20];
-    snprintf(dateTimeStr, sizeof(dateTimeStr), "[%lu]", uptime);
 
-    char buf[strlen(dateTimeStr) + strlen(message) + 10];
-    snprintf(buf, sizeof(buf), "[%s]\t\t%s", dateTimeStr, message);
-
-    // Log file size check
-    uint64_t logFileSize = getFileSize("/logs/system.txt");
-    sdLocked = true;
-    sdInfo.logSizeBytes = logFileSize;
-    if (logFileSize > SD_LOG_MAX_SIZE) {
-        // Rename the existing log file and create a new one
-        uint32_t uptime = millis() / 1000;
-        char fNameBuf[50];
-        snprintf(fNameBuf, sizeof(fNameBuf), "/logs/system-log-archive-%lu", uptime);
-        
-        if (!sd.exists(fNameBuf)) {
-            for (int i = 0; i < 100; i++) {
-                char tempBuf[50];
-                snprintf(tempBuf, sizeof(tempBuf), "%s-%d.txt", fNameBuf, i);
-                if (!sd.exists(tempBuf)) {
-                        strcpy(fNameBuf, tempBuf);
-                        break;
-                    }
-                }
-            }
-            if (sd.exists("/logs/system.txt")) {
-                sd.rename("/logs/system.txt", fNameBuf);
-            }
-            file = sd.open("/logs/system.txt", O_CREAT | O_RDWR | O_APPEND);
-            if (file) {
-                file.print(buf);
-                file.close();
-            }
+    sdLogStream_t* stream = findLogStream(SD_SYSTEM_LOG_PATH, true);
+    if (stream == nullptr) {
         sdLocked = false;
-        return true;
-    }
-    // Otherwise just write to the existing log file
-    file = sd.open("/logs/system.txt", O_CREAT | O_RDWR | O_APPEND);
-    if (file) {
-        file.print(buf);
-        file.close();
+        return false;
     }
+    
+    // Rename the existing log file and start a new one once it is full
+    if (stream->sizeBytes > SD_LOG_MAX_SIZE) rotateLogStream(stream);
+    bool ok = appendLogStream(stream, lines);
+    sdInfo.logSizeBytes = stream->sizeBytes;
     sdLocked = false;
-    return true;
+    return ok;
 }
 
 bool writeSensorData(const char* data, const char* fileName, bool isHeader) {
@@ -227,55 +237,449 @@ bool writeSensorData(const char* data, const char* fileName, bool isHeader) {
         sdLocked = false;
         return false;
     }
-    sdLocked = false;
 
     // Note: Flow counter provides timestamp, so we don't prepend our own
-    char buf[500];
+    // fileName already has full path
+    sdLogStream_t* stream = findLogStream(fileName, true);
+    if (stream == nullptr) {
+        sdLocked = false;
+        return false;
+    }
+    
+    // Rename the existing sensor file and start a new one once it is full
+    if (!isHeader && stream->sizeBytes > SD_SENSOR_MAX_SIZE) rotateLogStream(stream);
+    bool ok = appendLogStream(stream, data);
+    sdInfo.sensorSizeBytes = stream->sizeBytes;
+    sdLocked = false;
+    return ok;
+}
 
-    // Check if data is header
-    if (isHeader) snprintf(buf, sizeof(buf), "%s", data);        
-    else snprintf(buf, sizeof(buf), "%s", data);  // Data already has timestamp from flow counter
+// Size of a live log/sensor file from the stream table (0 if it does not exist yet)
+uint64_t getLogStreamSize(const char* path) {
+    if (sdLocked) return 0;
+    sdLocked = true;
+    if (!sdInfo.ready) {
+        sdLocked = false;
+        return 0;
+    }
+    sdLogStream_t* stream = findLogStream(path, true);
+    uint64_t size = stream ? stream->sizeBytes : 0;
+    sdLocked = false;
+    return size;
+}
+
+// Call after a file is deleted or replaced outside the log writers
+// Caller must hold sdLocked
+void invalidateLogStream(const char* path) {
+    sdLogStream_t* stream = findLogStream(path, false);
+    if (stream) stream->sizeBytes = 0;
+}
+
+// Delete a file and keep the stream table and free space count in step
+// Caller must hold sdLocked
+bool removeSDFile(const char* path) {
+    uint64_t size = 0;
+    uint32_t firstSector = 0;
+    FsFile f;
+    if (f.open(path, O_RDONLY)) {
+        size = f.fileSize();
+        firstSector = f.firstSector();
+        f.close();
+    }
+    // While the FAT scan runs, clusters it hasn't reached yet will be counted free by the scan itself
+    uint32_t scannedClusters = freeScanActive ? countScannedClusters(firstSector, 0) : 0;
+    if (!sd.remove(path)) return false;
+    sdDirGeneration++;
+    invalidateLogStream(path);
+    uint32_t bytesPerCluster = sd.vol()->bytesPerCluster();
+    if (freeScanActive) adjustFreeClusters((int32_t)scannedClusters);
+    else if (bytesPerCluster) adjustFreeClusters((int32_t)((size + bytesPerCluster - 1) / bytesPerCluster));
+    return true;
+}
+
+// Free space accounting (caller must hold sdLocked) ----------------------->
 
-    char fileNameBuf[100];
-    snprintf(fileNameBuf, sizeof(fileNameBuf), "%s", fileName);  // fileName already has full path
+void startFreeSpaceScan(void) {
+    uint8_t fatType = sd.vol()->fatType();
+    freeScanDelta = 0;
+    sdInfo.freeSpaceKnown = false;
+    if (fatType != 16 && fatType != 32) {
+        // exFAT keeps a 1 bit per cluster bitmap and FAT12 volumes are tiny, so
+        // SdFat's own count is quick there
+        int32_t count = sd.freeClusterCount();
+        freeScanActive = false;
+        if (count >= 0) {
+            freeClusters = count;
+            sdInfo.cardFreeBytes = (uint64_t)sd.vol()->bytesPerCluster() * freeClusters;
+            sdInfo.freeSpaceKnown = true;
+        }
+        return;
+    }
+    freeScanSector = sd.vol()->fatStartSector();
+    freeScanEntry = 0;
+    freeScanCount = 0;
+    freeScanActive = true;
+}
 
-    // Log file size check
-    uint64_t fileSize = getFileSize(fileNameBuf);
+// Counts free FAT entries a few sectors at a time so core 1 is never blocked
+// for more than one short multi-sector read
+void manageFreeSpaceScan(void) {
+    if (!freeScanActive || !sdInfo.ready || sdLocked) return;
     sdLocked = true;
-    sdInfo.sensorSizeBytes = fileSize;
-    if (fileSize > SD_LOG_MAX_SIZE) {
-        // Rename the existing sensor file and create a new one
-        uint32_t uptime = millis() / 1000;
-        char fNameBuf[100];
-        snprintf(fNameBuf, sizeof(fNameBuf), "%s-archive-%lu", fileName, uptime);
-        
-        if (!sd.exists(fNameBuf)) {
-            for (int i = 0; i < 100; i++) {
-                char tempBuf[100];
-                snprintf(tempBuf, sizeof(tempBuf), "%s-%d.csv", fNameBuf, i);
-                if (!sd.exists(tempBuf)) {
-                        strcpy(fNameBuf, tempBuf);
-                        break;
-                    }
-                }
-            }
-            if (sd.exists(fileNameBuf)) {
-                sd.rename(fileNameBuf, fNameBuf);
-            }
-            file = sd.open(fileNameBuf, O_CREAT | O_RDWR | O_APPEND);
-            if (file) {
-                file.print(buf);
-                file.close();
-            }
+
+    bool fat32 = sd.vol()->fatType() == 32;
+    uint32_t entriesPerSector = fat32 ? 128 : 256;
+    uint32_t lastEntry = sd.vol()->clusterCount() + 2;  // Clusters are numbered from 2
+    uint32_t sectorsLeft = (lastEntry - freeScanEntry + entriesPerSector - 1) / entriesPerSector;
+    uint32_t sectors = sectorsLeft < SD_FREE_SCAN_SECTORS ? sectorsLeft : SD_FREE_SCAN_SECTORS;
+
+    if (!sd.card()->readSectors(freeScanSector, freeScanBuffer, sectors)) {
+        LOG(LOG_WARNING, false, "SD free space scan failed at sector %" PRIu32 "\n", freeScanSector);
+        freeScanActive = false;
         sdLocked = false;
-        return true;
+        return;
+    }
+
+    uint32_t entries = sectors * entriesPerSector;
+    for (uint32_t i = 0; i < entries; i++) {
+        uint32_t entry = freeScanEntry + i;
+        if (entry < 2) continue;
+        if (entry >= lastEntry) break;
+        uint32_t value;
+        if (fat32) {
+            memcpy(&value, &freeScanBuffer[i * 4], 4);
+            value &= 0x0FFFFFFF;
+        } else {
+            value = freeScanBuffer[i * 2] | (freeScanBuffer[i * 2 + 1] << 8);
+        }
+        if (value == 0) freeScanCount++;
     }
-    // Otherwise just write to the existing log file
-    file = sd.open(fileNameBuf, O_CREAT | O_RDWR | O_APPEND);
-    if (file) {
-        file.print(buf);
-        file.close();
+    freeScanSector += sectors;
+    freeScanEntry += entries;
+
+    if (freeScanEntry >= lastEntry) {
+        freeScanActive = false;
+        int32_t total = (int32_t)freeScanCount + freeScanDelta;
+        freeClusters = total > 0 ? total : 0;
+        sdInfo.cardFreeBytes = (uint64_t)sd.vol()->bytesPerCluster() * freeClusters;
+        sdInfo.freeSpaceKnown = true;
+        LOG(LOG_INFO, false, "SD free space scan complete: %0.1f GB free\n", sdInfo.cardFreeBytes * 0.000000001);
     }
     sdLocked = false;
+}
+
+// Next cluster from the first FAT copy; the sector read last is kept for the following entry
+static bool readFatEntry(uint32_t cluster, uint32_t* next) {
+    bool fat32 = sd.vol()->fatType() == 32;
+    uint32_t entriesPerSector = fat32 ? 128 : 256;
+    uint32_t sector = sd.vol()->fatStartSector() + cluster / entriesPerSector;
+    if (sector != fatChainSector) {
+        if (!sd.card()->readSectors(sector, fatChainBuffer, 1)) {
+            fatChainSector = 0;
+            return false;
+        }
+        fatChainSector = sector;
+    }
+    uint32_t i = cluster % entriesPerSector;
+    if (fat32) {
+        memcpy(next, &fatChainBuffer[i * 4], 4);
+        *next &= 0x0FFFFFFF;
+    } else {
+        *next = fatChainBuffer[i * 2] | (fatChainBuffer[i * 2 + 1] << 8);
+    }
+    return true;
+}
+
+// Clusters of a file, from the skip'th on, that lie in the part of the FAT the scan has
+// already counted. Changes to those are missing from the scan; the rest it will see itself.
+static uint32_t countScannedClusters(uint32_t firstSector, uint32_t skip) {
+    if (firstSector == 0) return 0;
+    uint32_t lastEntry = sd.vol()->clusterCount() + 2;
+    uint32_t cluster = (firstSector - sd.vol()->dataStartSector()) / sd.vol()->sectorsPerCluster() + 2;
+    uint32_t count = 0;
+    fatChainSector = 0;  // The FAT may have changed since the last walk
+    // End of chain and bad cluster marks are all above lastEntry; n guards against a looped chain
+    for (uint32_t n = 0; cluster >= 2 && cluster < lastEntry && n < lastEntry; n++) {
+        if (n >= skip && cluster < freeScanEntry) count++;
+        if (!readFatEntry(cluster, &cluster)) break;
+    }
+    return count;
+}
+
+// Positive for clusters released, negative for clusters allocated
+void adjustFreeClusters(int32_t clusters) {
+    if (freeScanActive) {
+        freeScanDelta += clusters;
+        return;
+    }
+    if (!sdInfo.freeSpaceKnown) return;
+    int32_t total = (int32_t)freeClusters + clusters;
+    freeClusters = total > 0 ? total : 0;
+    sdInfo.cardFreeBytes = (uint64_t)sd.vol()->bytesPerCluster() * freeClusters;
+}
+
+// Directory listing helpers ----------------------------------------------->
+
+// Shell style match - '*' any run of characters, '?' any one character
+bool matchGlob(const char* pattern, const char* name) {
+    const char* star = nullptr;
+    const char* resume = nullptr;
+    while (*name) {
+        if (*pattern == '*') {
+            star = pattern++;
+            resume = name;
+        } else if (*pattern == '?' || tolower(*pattern) == tolower(*name)) {
+            pattern++;
+            name++;
+        } else if (star) {
+            pattern = star + 1;
+            name = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (*pattern == '*') pattern++;
+    return *pattern == '\0';
+}
+
+static sdSortKey_t compareSortKey;
+static bool compareDescending;
+
+// Compares runs of digits by value so "archive-10" sorts after "archive-9"
+static int compareNatural(const char* a, const char* b) {
+    while (*a && *b) {
+        if (isdigit(*a) && isdigit(*b)) {
+            while (*a == '0') a++;
+            while (*b == '0') b++;
+            const char* digitsA = a;
+            const char* digitsB = b;
+            while (isdigit(*a)) a++;
+            while (isdigit(*b)) b++;
+            if (a - digitsA != b - digitsB) return (a - digitsA) < (b - digitsB) ? -1 : 1;
+            int cmp = strncmp(digitsA, digitsB, a - digitsA);
+            if (cmp != 0) return cmp;
+            continue;
+        }
+        int diff = tolower(*a) - tolower(*b);
+        if (diff != 0) return diff;
+        a++;
+        b++;
+    }
+    return (unsigned char)*a - (unsigned char)*b;
+}
+
+static int compareIndexEntries(const void* left, const void* right) {
+    const sdIndexEntry_t* a = (const sdIndexEntry_t*)left;
+    const sdIndexEntry_t* b = (const sdIndexEntry_t*)right;
+    // Directories always come first, as in the listing response
+    if (a->isDirectory != b->isDirectory) return a->isDirectory ? -1 : 1;
+
+    int cmp = 0;
+    switch (compareSortKey) {
+        case SD_SORT_SIZE:
+            cmp = (a->size > b->size) - (a->size < b->size);
+            break;
+        case SD_SORT_MODIFIED: {
+            uint32_t stampA = ((uint32_t)a->date << 16) | a->time;
+            uint32_t stampB = ((uint32_t)b->date << 16) | b->time;
+            cmp = (stampA > stampB) - (stampA < stampB);
+            break;
+        }
+        default:
+            break;
+    }
+    if (cmp == 0) cmp = compareNatural(a->key, b->key);
+    if (cmp == 0) cmp = (a->dirIndex > b->dirIndex) - (a->dirIndex < b->dirIndex);
+    return compareDescending ? -cmp : cmp;
+}
+
+// Sorted entries of path matching glob, from the cache when nothing changed on the card.
+// A size or modified order is also rebuilt when a file has grown since, so it never sorts
+// on stale values; a name order survives that.
+// Returns nullptr if the directory can't be opened or has more entries than the index holds.
+// Caller must hold sdLocked
+const sdIndexEntry_t* getSDIndex(const char* path, const char* glob, sdSortKey_t sortKey, bool descending, uint16_t* count) {
+    bool dataCurrent = sortKey == SD_SORT_NAME || sdIndexDataGeneration == sdDataGeneration;
+    if (sdIndexValid && sdIndexGeneration == sdDirGeneration && dataCurrent && sdIndexSortKey == sortKey &&
+        sdIndexDescending == descending && strcmp(sdIndexPath, path) == 0 && strcmp(sdIndexGlob, glob) == 0) {
+        *count = sdIndexCount;
+        return sdIndex;
+    }
+    if (strlen(path) >= sizeof(sdIndexPath) || strlen(glob) >= sizeof(sdIndexGlob)) return nullptr;
+
+    sdIndexValid = false;
+    FsFile dir = sd.open(path, O_RDONLY);
+    if (!dir || !dir.isDirectory()) return nullptr;
+
+    FsFile entry;
+    char name[256];
+    uint16_t entries = 0;
+    bool overflow = false;
+    while (entry.openNext(&dir, O_RDONLY)) {
+        entry.getName(name, sizeof(name));
+        if (name[0] == '.' || (glob[0] != '\0' && !matchGlob(glob, name))) {
+            entry.close();
+            continue;
+        }
+        if (entries == SD_INDEX_MAX_ENTRIES) {
+            entry.close();
+            overflow = true;
+            break;
+        }
+        sdIndexEntry_t& item = sdIndex[entries++];
+        strlcpy(item.key, name, sizeof(item.key));
+        item.dirIndex = entry.dirIndex();
+        item.isDirectory = entry.isDirectory();
+        uint64_t size = item.isDirectory ? 0 : entry.fileSize();
+        item.size = size > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)size;
+        entry.getModifyDateTime(&item.date, &item.time);
+        entry.close();
+    }
+    dir.close();
+    if (overflow) return nullptr;
+
+    compareSortKey = sortKey;
+    compareDescending = descending;
+    qsort(sdIndex, entries, sizeof(sdIndexEntry_t), compareIndexEntries);
+
+    strlcpy(sdIndexPath, path, sizeof(sdIndexPath));
+    strlcpy(sdIndexGlob, glob, sizeof(sdIndexGlob));
+    sdIndexSortKey = sortKey;
+    sdIndexDescending = descending;
+    sdIndexGeneration = sdDirGeneration;
+    sdIndexDataGeneration = sdDataGeneration;
+    sdIndexCount = entries;
+    sdIndexValid = true;
+    *count = entries;
+    return sdIndex;
+}
+
+// Log stream helpers (caller must hold sdLocked) -------------------------->
+
+// Build "/dir/name-archive-<seq>.ext" from "/dir/name.ext"
+static void archiveName(const char* path, uint32_t seq, char* out, size_t outLen) {
+    const char* slash = strrchr(path, '/');
+    const char* dot = strrchr(path, '.');
+    if (dot == nullptr || (slash != nullptr && dot < slash)) dot = path + strlen(path);
+    snprintf(out, outLen, "%.*s-archive-%" PRIu32 "%s", (int)(dot - path), path, seq, dot);
+}
+
+// Single pass over a directory: live .csv/.txt files give their size, archives
+// named "<stem>-archive-<seq>.<ext>" give the next sequence number for <stem>.<ext>
+static void scanLogStreams(const char* dirPath) {
+    FsFile dir = sd.open(dirPath, O_RDONLY);
+    if (!dir || !dir.isDirectory()) return;
+
+    FsFile entry;
+    char name[SD_LOG_STREAM_PATH_LEN];
+    char livePath[SD_LOG_STREAM_PATH_LEN];
+    const char* sep = (strcmp(dirPath, "/") == 0) ? "" : "/";
+    while (entry.openNext(&dir, O_RDONLY)) {
+        if (entry.isDirectory() || entry.getName(name, sizeof(name)) == 0) {
+            entry.close();
+            continue;
+        }
+        const char* ext = strrchr(name, '.');
+        if (ext == nullptr || (strcmp(ext, ".csv") != 0 && strcmp(ext, ".txt") != 0)) {
+            entry.close();
+            continue;
+        }
+
+        char* tag = strstr(name, "-archive-");
+        if (tag != nullptr) {
+            char* end;
+            uint32_t seq = strtoul(tag + 9, &end, 10);
+            // Older uptime-based archive names don't match this pattern and are left alone;
+            // a path too long for the stream table is not tracked
+            if (end != tag + 9 && end == ext) {
+                int length = snprintf(livePath, sizeof(livePath), "%s%s%.*s%s", dirPath, sep, (int)(tag - name), name, ext);
+                sdLogStream_t* stream = length < (int)sizeof(livePath) ? findLogStream(livePath, true) : nullptr;
+                if (stream && seq + 1 > stream->nextArchiveSeq) stream->nextArchiveSeq = seq + 1;
+                if (seq + 1 > archiveSeqFloor) archiveSeqFloor = seq + 1;
+            }
+        } else {
+            int length = snprintf(livePath, sizeof(livePath), "%s%s%s", dirPath, sep, name);
+            sdLogStream_t* stream = length < (int)sizeof(livePath) ? findLogStream(livePath, true) : nullptr;
+            if (stream) stream->sizeBytes = entry.fileSize();
+        }
+        entry.close();
+    }
+    dir.close();
+}
+
+static sdLogStream_t* findLogStream(const char* path, bool create) {
+    for (uint8_t i = 0; i < logStreamCount; i++) {
+        if (strcmp(logStreams[i].path, path) == 0) {
+            logStreams[i].lastUsed = millis();
+            return &logStreams[i];
+        }
+    }
+    if (!create || strlen(path) >= SD_LOG_STREAM_PATH_LEN) return nullptr;
+
+    sdLogStream_t* stream;
+    if (logStreamCount < SD_MAX_LOG_STREAMS) {
+        stream = &logStreams[logStreamCount++];
+    } else {
+        // Table full - evict the least recently used stream
+        stream = &logStreams[0];
+        for (uint8_t i = 1; i < SD_MAX_LOG_STREAMS; i++) {
+            if (logStreams[i].lastUsed < stream->lastUsed) stream = &logStreams[i];
+        }
+        logStreamTableComplete = false;
+    }
+    strlcpy(stream->path, path, sizeof(stream->path));
+    stream->sizeBytes = 0;
+    stream->nextArchiveSeq = archiveSeqFloor;  // Can't collide with any archive seen since mount
+    stream->lastUsed = millis();
+
+    // Only when the table lost track of a file does a new stream cost an open()
+    if (!logStreamTableComplete) {
+        FsFile f;
+        if (f.open(path, O_RDONLY)) {
+            stream->sizeBytes = f.fileSize();
+            f.close();
+        }
+    }
+    return stream;
+}
+
+// One rename plus one create, no exists() probing
+static bool rotateLogStream(sdLogStream_t* stream) {
+    char archivePath[SD_LOG_STREAM_PATH_LEN + 20];
+    archiveName(stream->path, stream->nextArchiveSeq, archivePath, sizeof(archivePath));
+    if (!sd.rename(stream->path, archivePath)) {
+        LOG(LOG_WARNING, false, "Failed to archive %s\n", stream->path);
+        return false;
+    }
+    stream->nextArchiveSeq++;
+    if (stream->nextArchiveSeq > archiveSeqFloor) archiveSeqFloor = stream->nextArchiveSeq;
+    stream->sizeBytes = 0;
+    sdDirGeneration++;
     return true;
-}
\ No newline at end of file
+}
+
+static bool appendLogStream(sdLogStream_t* stream, const char* data) {
+    uint32_t startUs = micros();
+    file = sd.open(stream->path, O_CREAT | O_RDWR | O_APPEND);
+    if (!file) return false;
+    size_t written = file.print(data);
+    uint32_t firstSector = file.firstSector();
+    file.close();
+    metricsObserve(&sdWriteLatency, micros() - startUs);
+    if (stream->sizeBytes == 0) sdDirGeneration++;  // May have just created the file
+    sdDataGeneration++;
+
+    // Account for any clusters this append allocated
+    uint32_t bytesPerCluster = sd.vol()->bytesPerCluster();
+    if (bytesPerCluster) {
+        uint64_t oldClusters = (stream->sizeBytes + bytesPerCluster - 1) / bytesPerCluster;
+        uint64_t newClusters = (stream->sizeBytes + written + bytesPerCluster - 1) / bytesPerCluster;
+        if (newClusters > oldClusters) {
+            // While the FAT scan runs, only new clusters behind it are missing from its count
+            uint32_t allocated = freeScanActive ? countScannedClusters(firstSector, oldClusters) : newClusters - oldClusters;
+            adjustFreeClusters(-(int32_t)allocated);
+        }
+    }
+    stream->sizeBytes += written;
+    return written > 0;
+}
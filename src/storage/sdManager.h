@@ -14,6 +14,16 @@
 
 #define SD_MANAGE_INTERVAL 1000
 
+#define SD_SYSTEM_LOG_PATH "/logs/system.txt"
+#define SD_MAX_LOG_STREAMS 24           // Live log/sensor files tracked in RAM
+#define SD_LOG_STREAM_PATH_LEN 64
+
+#define SD_FREE_SCAN_SECTORS 4          // FAT sectors read per sdscan task run (manageFreeSpaceScan)
+
+#define SD_INDEX_MAX_ENTRIES 320        // Entries a sorted directory listing can hold
+#define SD_INDEX_KEY_LEN 28             // Name prefix kept per entry for name sorting
+#define SD_INDEX_GLOB_LEN 32
+
 void init_sdManager(void);
 void manageSD(void);
 void mountSD(void);
@@ -21,19 +31,57 @@ void maintainSD(void);
 void printSDInfo(void);
 uint64_t getFileSize(const char* path);
 void dateTimeCallback(uint16_t* date, uint16_t* time);
-bool writeLog(const char *message);
+bool writeLog(const char *lines);
 bool writeSensorData(const char* data, const char* fileName, bool isHeader);
+uint64_t getLogStreamSize(const char* path);
+void invalidateLogStream(const char* path);
+bool removeSDFile(const char* path);
+void startFreeSpaceScan(void);
+void manageFreeSpaceScan(void);
+void adjustFreeClusters(int32_t clusters);
+bool matchGlob(const char* pattern, const char* name);
 
 struct sdInfo_t {
   bool inserted;
   bool ready;
   uint64_t cardSizeBytes;
   uint64_t cardFreeBytes;
+  bool freeSpaceKnown;      // False until the background FAT scan completes
   uint64_t logSizeBytes;
   uint64_t sensorSizeBytes;
 };
 
+// Live append-only file (system log or sensor CSV) with its size and next
+// archive sequence number cached in RAM, recovered once at mount
+struct sdLogStream_t {
+  char path[SD_LOG_STREAM_PATH_LEN];
+  uint64_t sizeBytes;
+  uint32_t nextArchiveSeq;
+  uint32_t lastUsed;
+};
+
+enum sdSortKey_t {
+  SD_SORT_NONE,
+  SD_SORT_NAME,
+  SD_SORT_SIZE,
+  SD_SORT_MODIFIED
+};
+
+// One directory entry in the listing index - the name is fetched again by
+// dirIndex when the entry is sent
+struct sdIndexEntry_t {
+  char key[SD_INDEX_KEY_LEN];
+  uint32_t dirIndex;
+  uint32_t size;
+  uint16_t date;
+  uint16_t time;
+  bool isDirectory;
+};
+
+const sdIndexEntry_t* getSDIndex(const char* path, const char* glob, sdSortKey_t sortKey, bool descending, uint16_t* count);
+
 extern SdFs sd;
 extern volatile bool sdLocked;
 extern sdInfo_t sdInfo;
-extern uint32_t sdTS;
+extern volatile uint32_t sdDirGeneration;
+extern volatile uint32_t sdDataGeneration;
@@ -1,9 +1,17 @@
 #include "sys_init.h"
+#include <pico/mutex.h>
 
 // Object definitions
 
 bool core0setupComplete = false;
 bool core1setupComplete = false;
+volatile bool core0ConfigLoaded = false;    // Gateway config is in RAM - core 1 can start the RS485 side
+
+bootStep_t bootSteps[BOOT_MAX_STEPS];
+uint8_t bootStepCount = 0;
+volatile uint32_t bootFirstDataMs = 0;
+volatile uint32_t bootDiscoveryDoneMs = 0;
+auto_init_mutex(bootProfileMutex);
 
 // Ensure both cores have an 8k stack size (default is to split 8k accross both cores)
 bool core1_separate_stack = true;
@@ -13,41 +21,99 @@ bool debug = true;
 // Millis rollover tracking (millis() rolls over every ~49.7 days)
 volatile uint32_t millisRolloverCount = 0;
 static uint32_t lastMillis = 0;
+static void trackMillisRollover(void);
 
 void init_core0(void);
 
 void init_core1(void);
 
 void init_core0(void) {
-    init_logger();
-    init_gatewayConfig();
-    init_network();
-    setupWebServer(); // Setup the web server routes but don't start it yet
+    BOOT_STEP(init_logger());
+    BOOT_STEP(init_metricsManager());
+    BOOT_STEP(init_configStore());
+    BOOT_STEP(init_gatewayConfig());
+    core0ConfigLoaded = true;
+    BOOT_STEP(init_network());
+    BOOT_STEP(setupWebServer()); // Setup the web server routes
+    BOOT_STEP(startWebServer()); // Start the web server now all API endpoints are registered
+
+    // Core 0 tasks: name, function, period (us, 0 = every pass), priority, budget (us)
+    schedAddTask(0, "network", manageNetwork, 0, 0, 10000);
+    schedAddTask(0, "heap", checkHeapUsage, HEAP_CHECK_INTERVAL * 1000UL, 3, 200);
 }
 
 void init_core1(void) {
-    init_statusManager();
-    init_terminalManager();
-    while (!core0setupComplete) delay(100); // Wait for core0 setup to complete
-    init_sdManager();
-    init_flowCounterManager();
-    startWebServer();       // Now start the web server after all APIs are registered
+    BOOT_STEP(init_statusManager());
+    BOOT_STEP(init_terminalManager());
+    while (!core0ConfigLoaded) delay(1); // RS485 setup needs the gateway config, not the network
+    BOOT_STEP(init_sdManager());
+    BOOT_STEP(init_flowCounterManager()); // Starts discovery - ports come up from the core 1 loop
+
+    // Core 1 tasks: name, function, period (us, 0 = every pass), priority, budget (us)
+    schedAddTask(1, "triggers", checkTriggers, TRIGGER_CHECK_INTERVAL * 1000UL, 0, 200);
+    schedAddTask(1, "modbus", manage_flowCounterManager, 0, 1, 1000);
+    schedAddTask(1, "logger", manageLogger, 0, 2, 5000);
+    schedAddTask(1, "status", manageStatus, LED_UPDATE_PERIOD * 1000UL, 3, 2000);
+    schedAddTask(1, "terminal", manageTerminal, TERMINAL_POLL_INTERVAL * 1000UL, 3, 5000);
+    schedAddTask(1, "sdscan", manageFreeSpaceScan, 0, 4, 2000);
+    schedAddTask(1, "sd", manageSD, SD_MANAGE_INTERVAL * 1000UL, 4, 50000);
+    schedAddTask(1, "clock", trackMillisRollover, 1000000UL, 5, 50);
 }
 
-void manage_core0(void) {
-    manageNetwork();
+// Boot profile ------------------------------------------------------------>
+
+void recordBootStep(const char* name, uint32_t startUs) {
+    uint32_t duration = micros() - startUs;
+    mutex_enter_blocking(&bootProfileMutex);
+    if (bootStepCount < BOOT_MAX_STEPS) {
+        bootSteps[bootStepCount].name = name;
+        bootSteps[bootStepCount].core = get_core_num();
+        bootSteps[bootStepCount].startUs = startUs;
+        bootSteps[bootStepCount].durationUs = duration;
+        bootStepCount++;
+    }
+    mutex_exit(&bootProfileMutex);
 }
 
-void manage_core1(void) {
-    // Track millis rollover
+// Called once startup discovery finishes
+void reportBootProfile(void) {
+    LOG(LOG_INFO, true, "Boot profile (ms since power-on):\n");
+    for (uint8_t i = 0; i < bootStepCount; i++) {
+        LOG(LOG_INFO, true, "  core %d  %6.1f  +%6.1f  %s\n", bootSteps[i].core,
+            bootSteps[i].startUs / 1000.0f, bootSteps[i].durationUs / 1000.0f, bootSteps[i].name);
+    }
+    if (bootFirstDataMs) LOG(LOG_INFO, true, "  first flow counter data at %" PRIu32 " ms\n", bootFirstDataMs);
+    LOG(LOG_INFO, true, "  startup discovery done at %" PRIu32 " ms\n", bootDiscoveryDoneMs);
+}
+
+void serializeBootProfile(JsonObject boot) {
+    JsonArray steps = boot.createNestedArray("steps");
+    for (uint8_t i = 0; i < bootStepCount; i++) {
+        JsonObject step = steps.createNestedObject();
+        step["name"] = bootSteps[i].name;
+        step["core"] = bootSteps[i].core;
+        step["startMs"] = bootSteps[i].startUs / 1000.0f;
+        step["durationMs"] = bootSteps[i].durationUs / 1000.0f;
+    }
+    boot["firstDataMs"] = bootFirstDataMs;
+    boot["discoveryDoneMs"] = bootDiscoveryDoneMs;
+}
+
+// Track millis rollover (millis() rolls over every ~49.7 days)
+static void trackMillisRollover(void) {
     uint32_t currentMillis = millis();
     if (currentMillis < lastMillis) {
         millisRolloverCount++;
     }
     lastMillis = currentMillis;
-    
-    manageStatus();
-    manageTerminal();
-    manageSD();
-    manage_flowCounterManager();
+}
+
+void manage_core0(void) {
+    recordLoopIteration(0);
+    schedRun(0);
+}
+
+void manage_core1(void) {
+    recordLoopIteration(1);
+    schedRun(1);
 }
@@ -23,6 +23,7 @@
 
 // Include libraries
 #include <Arduino.h>
+#include <inttypes.h>
 #include <W5500lwIP.h>
 #include <WebServer.h>
 #include <NTPClient.h>
@@ -31,6 +32,7 @@
 #include <SPI.h>
 #include "Adafruit_Neopixel.h"
 #include "modbus-rtu-master.h"
+#include "modbus-rtu-dma-transport.h"
 
 // Include program files
 #include "hardware/pins.h"
@@ -42,26 +44,46 @@
 #include "utils/terminalManager.h"
 
 #include "storage/sdManager.h"
+#include "storage/configStore.h"
 
 #include "gateway/flowCounterConfig.h"
 #include "gateway/flowCounterManager.h"
+#include "gateway/busScanManager.h"
+#include "gateway/serialDetectManager.h"
+
+#include "utils/metricsManager.h"
+#include "utils/taskScheduler.h"
 
 void init_core0(void);
 void init_core1(void);
 void manage_core0(void);
 void manage_core1(void);
 
-// Task handler prototypes
-void handleSDManager(void);
-void handleLEDManager(void);
-void handleTerminalManager(void);
-void handleIpcManager(void);
-void handleNetworkManager(void);
-
 // Object definitions
 
 extern bool core0setupComplete;
 extern bool core1setupComplete;
+extern volatile bool core0ConfigLoaded;
+
+// Boot profile - how long each init step took, and when the first fresh data arrived
+#define BOOT_MAX_STEPS 16
+#define BOOT_STEP(call) do { uint32_t bootStepStart = micros(); call; recordBootStep(#call, bootStepStart); } while (0)
+
+struct bootStep_t {
+    const char* name;
+    uint8_t core;
+    uint32_t startUs;       // micros() since power-on
+    uint32_t durationUs;
+};
+
+void recordBootStep(const char* name, uint32_t startUs);
+void reportBootProfile(void);
+void serializeBootProfile(JsonObject boot);
+
+extern bootStep_t bootSteps[BOOT_MAX_STEPS];
+extern uint8_t bootStepCount;
+extern volatile uint32_t bootFirstDataMs;       // First valid flow counter response (0 = none yet)
+extern volatile uint32_t bootDiscoveryDoneMs;   // Startup discovery finished (0 = still running)
 
 extern bool debug;
 
@@ -0,0 +1,170 @@
+#include "gzipStream.h"
+
+#define GZIP_MIN_MATCH 3
+#define GZIP_MAX_MATCH 258
+
+static const uint16_t lengthBase[29] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t lengthExtra[29] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t distanceBase[30] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t distanceExtra[30] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+static const uint32_t crcNibble[16] = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+// Bit output (deflate packs from the least significant bit) ---------------->
+
+static void putBits(gzipStream_t* stream, uint8_t*& out, uint32_t value, uint8_t bits) {
+  stream->bitBuffer |= value << stream->bitCount;
+  stream->bitCount += bits;
+  while (stream->bitCount >= 8) {
+    *out++ = stream->bitBuffer & 0xFF;
+    stream->bitBuffer >>= 8;
+    stream->bitCount -= 8;
+  }
+}
+
+// Huffman codes are defined most significant bit first
+static void putCode(gzipStream_t* stream, uint8_t*& out, uint32_t code, uint8_t bits) {
+  uint32_t reversed = 0;
+  for (uint8_t i = 0; i < bits; i++) {
+    reversed = (reversed << 1) | (code & 1);
+    code >>= 1;
+  }
+  putBits(stream, out, reversed, bits);
+}
+
+static void putSymbol(gzipStream_t* stream, uint8_t*& out, uint16_t symbol) {
+  if (symbol < 144) putCode(stream, out, 0x30 + symbol, 8);
+  else if (symbol < 256) putCode(stream, out, 0x190 + symbol - 144, 9);
+  else if (symbol < 280) putCode(stream, out, symbol - 256, 7);
+  else putCode(stream, out, 0xC0 + symbol - 280, 8);
+}
+
+static void putMatch(gzipStream_t* stream, uint8_t*& out, uint16_t length, uint16_t distance) {
+  uint8_t code = 28;
+  while (lengthBase[code] > length) code--;
+  putSymbol(stream, out, 257 + code);
+  putBits(stream, out, length - lengthBase[code], lengthExtra[code]);
+
+  code = 29;
+  while (distanceBase[code] > distance) code--;
+  putCode(stream, out, code, 5);
+  putBits(stream, out, distance - distanceBase[code], distanceExtra[code]);
+}
+
+static void putLE32(uint8_t*& out, uint32_t value) {
+  for (uint8_t i = 0; i < 4; i++) *out++ = (value >> (8 * i)) & 0xFF;
+}
+
+static inline uint16_t hash3(const uint8_t* p) {
+  return ((p[0] << 6) ^ (p[1] << 3) ^ p[2]) & (GZIP_HASH_SIZE - 1);
+}
+
+// Public functions -------------------------------------------------------->
+
+void gzipBegin(gzipStream_t* stream) {
+  memset(stream->head, 0, sizeof(stream->head));
+  stream->bufferStart = 0;
+  stream->bufferLength = 0;
+  stream->crc = 0xFFFFFFFF;
+  stream->totalIn = 0;
+  stream->bitBuffer = 0;
+  stream->bitCount = 0;
+  stream->headerWritten = false;
+}
+
+size_t gzipCompress(gzipStream_t* stream, const uint8_t* in, size_t inLength, uint8_t* out, bool finish) {
+  uint8_t* start = out;
+  if (inLength > GZIP_MAX_INPUT) inLength = GZIP_MAX_INPUT;
+
+  if (!stream->headerWritten) {
+    static const uint8_t header[10] = {0x1F, 0x8B, 0x08, 0, 0, 0, 0, 0, 0, 0xFF};
+    memcpy(out, header, sizeof(header));
+    out += sizeof(header);
+    // One fixed Huffman block for the whole stream, closed by an empty final block
+    putBits(stream, out, 0, 1);
+    putBits(stream, out, 1, 2);
+    stream->headerWritten = true;
+  }
+
+  // Keep at most a window of history in front of the new input
+  if (stream->bufferLength + inLength > sizeof(stream->buffer)) {
+    uint32_t keep = stream->bufferLength < GZIP_WINDOW_SIZE ? stream->bufferLength : GZIP_WINDOW_SIZE;
+    uint32_t shift = stream->bufferLength - keep;
+    memmove(stream->buffer, stream->buffer + shift, keep);
+    stream->bufferStart += shift;
+    stream->bufferLength = keep;
+  }
+  memcpy(stream->buffer + stream->bufferLength, in, inLength);
+  uint32_t position = stream->bufferLength;
+  stream->bufferLength += inLength;
+
+  for (size_t i = 0; i < inLength; i++) {
+    uint8_t c = in[i];
+    stream->crc = crcNibble[(stream->crc ^ c) & 0x0F] ^ (stream->crc >> 4);
+    stream->crc = crcNibble[(stream->crc ^ (c >> 4)) & 0x0F] ^ (stream->crc >> 4);
+  }
+  stream->totalIn += inLength;
+
+  const uint8_t* buffer = stream->buffer;
+  uint32_t end = stream->bufferLength;
+  while (position < end) {
+    uint32_t available = end - position;
+    uint16_t matchLength = 0;
+    uint32_t matchDistance = 0;
+
+    if (available >= GZIP_MIN_MATCH) {
+      uint16_t h = hash3(buffer + position);
+      uint32_t candidate = stream->head[h];
+      stream->head[h] = stream->bufferStart + position + 1;
+      if (candidate > stream->bufferStart) {
+        uint32_t candidatePos = candidate - 1 - stream->bufferStart;
+        uint32_t maxLength = available < GZIP_MAX_MATCH ? available : GZIP_MAX_MATCH;
+        uint32_t length = 0;
+        while (length < maxLength && buffer[candidatePos + length] == buffer[position + length]) length++;
+        if (length >= GZIP_MIN_MATCH) {
+          matchLength = length;
+          matchDistance = position - candidatePos;
+        }
+      }
+    }
+
+    if (matchLength == 0) {
+      putSymbol(stream, out, buffer[position]);
+      position++;
+      continue;
+    }
+
+    putMatch(stream, out, matchLength, matchDistance);
+    // Index the positions inside the match too, for later matches
+    for (uint32_t skip = 1; skip < matchLength; skip++) {
+      uint32_t p = position + skip;
+      if (end - p >= GZIP_MIN_MATCH) stream->head[hash3(buffer + p)] = stream->bufferStart + p + 1;
+    }
+    position += matchLength;
+  }
+
+  if (finish) {
+    putSymbol(stream, out, 256);   // End of block
+    putBits(stream, out, 1, 1);    // Final, empty block
+    putBits(stream, out, 1, 2);
+    putSymbol(stream, out, 256);
+    if (stream->bitCount > 0) putBits(stream, out, 0, 8 - stream->bitCount);
+    putLE32(out, stream->crc ^ 0xFFFFFFFF);
+    putLE32(out, stream->totalIn);
+  }
+  return out - start;
+}
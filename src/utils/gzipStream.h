@@ -0,0 +1,31 @@
+/* Description: Streaming gzip encoder for responses generated on the fly
+ * LZ77 over a small sliding window with the fixed deflate Huffman codes, so the
+ * whole state is a few KB of static RAM and nothing is allocated.
+ * Call gzipBegin() once, then gzipCompress() with each block of input; pass
+ * finish = true with the last block to write the end of stream and gzip trailer.
+ * out must hold at least GZIP_OUTPUT_BOUND(inLength) bytes.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#define GZIP_WINDOW_SIZE 2048           // History kept for matches
+#define GZIP_MAX_INPUT 2048             // Largest input block per gzipCompress() call
+#define GZIP_HASH_SIZE 1024             // Match candidates, one per 3-byte hash
+#define GZIP_OUTPUT_BOUND(n) ((n) + (n) / 8 + 32)
+
+struct gzipStream_t {
+  uint8_t buffer[GZIP_WINDOW_SIZE + GZIP_MAX_INPUT];
+  uint32_t head[GZIP_HASH_SIZE];        // Absolute position + 1 of the last occurrence, 0 = none
+  uint32_t bufferStart;                 // Absolute stream position of buffer[0]
+  uint32_t bufferLength;
+  uint32_t crc;
+  uint32_t totalIn;
+  uint32_t bitBuffer;
+  uint8_t bitCount;
+  bool headerWritten;
+};
+
+void gzipBegin(gzipStream_t* stream);
+size_t gzipCompress(gzipStream_t* stream, const uint8_t* in, size_t inLength, uint8_t* out, bool finish);
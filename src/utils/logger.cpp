@@ -1,4 +1,5 @@
 #include "logger.h"
+#include <pico/mutex.h>
 
 // Critical section for controlling access to Serial
 bool serialBusy = false;
@@ -8,22 +9,78 @@ bool serialLocked = false;
 // Log entry types
 const char *logType[] = {"INFO", "WARNING", "ERROR", "DEBUG"};
 
+logStats_t logStats;
+
+// Runtime level per module, stored as verbosity rank so LOG_ENABLED() is one compare
+uint8_t logModuleVerbosity[LOG_MODULE_COUNT] = {
+    LOG_VERBOSITY(LOG_DEFAULT_LEVEL), LOG_VERBOSITY(LOG_DEFAULT_LEVEL), LOG_VERBOSITY(LOG_DEFAULT_LEVEL),
+    LOG_VERBOSITY(LOG_DEFAULT_LEVEL), LOG_VERBOSITY(LOG_DEFAULT_LEVEL), LOG_VERBOSITY(LOG_DEFAULT_LEVEL)
+};
+const char *logModuleNames[LOG_MODULE_COUNT] = {"system", "network", "modbustcp", "gateway", "sd", "terminal"};
+const char *logLevelNames[] = {"info", "warning", "error", "debug"};
+
+// Record layout in the ring: header followed by the formatted text (not null terminated),
+// padded to 8 bytes so a header never straddles the end of the ring
+struct LogRecordHeader {
+    uint16_t length;      // Text length, or LOG_RECORD_PAD for the wrap filler
+    uint8_t level;
+    uint8_t toSD;
+    uint32_t timestamp;   // millis() when logged
+};
+#define LOG_RECORD_PAD 0xFFFF
+#define LOG_RECORD_ALIGN 8
+
+// Single producer (the owning core) / single consumer (the drain) ring per core
+struct LogRing {
+    uint8_t data[LOG_RING_SIZE] __attribute__((aligned(LOG_RECORD_ALIGN)));
+    volatile uint32_t head;   // Only written by the producer core
+    volatile uint32_t tail;   // Only written by the drain
+};
+
+static LogRing logRings[2];
+static char formatBuffer[2][DEBUG_PRINTF_BUFFER_SIZE];  // One per core, so no sharing between cores
+static char serialBatch[LOG_SERIAL_BATCH_SIZE];
+static char sdBatch[LOG_SD_BATCH_SIZE];
+static uint16_t sdBatchLength = 0;
+static uint32_t sdBatchTS = 0;
+static uint32_t reportedDrops[2] = {0, 0};
+static bool pipelineRunning = false;    // Set once core 1's loop drains the rings
+auto_init_mutex(logDrainMutex);
+
+static bool pushRecord(uint8_t core, uint8_t level, bool toSD, const char* text, uint16_t length);
+static void drainLogs(void);
+static void flushSDBatch(bool force);
+
 void init_logger(void) {
     Serial.begin(115200);
-    uint32_t terminalTimout = millis() + 5000;
-    while (!Serial) {
-        if (millis() > terminalTimout) {
-            break;
-        }
+    // Boot doesn't wait for a USB host unless asked to (to catch the first messages when debugging)
+    uint32_t terminalTimout = millis() + LOG_SERIAL_WAIT;
+    while (!Serial && millis() < terminalTimout) {
+        delay(1);
     }
     serialReady = true;
-    log(LOG_INFO, false, "Modbus IO Control System v%s\n", VERSION);
-    log(LOG_INFO, false, "Starting system...\n");
+    LOG(LOG_INFO, false, "Modbus IO Control System v%s\n", VERSION);
+    LOG(LOG_INFO, false, "Starting system...\n");
+}
+
+// Called from the core 1 loop - moves queued records to Serial and the SD buffer
+void manageLogger(void) {
+    pipelineRunning = true;
+    drainLogs();
+}
+
+// Drain everything now (e.g. before a reboot). Safe from either core.
+void flushLogs(void) {
+    drainLogs();
+    if (mutex_try_enter(&logDrainMutex, nullptr)) {
+        flushSDBatch(true);
+        mutex_exit(&logDrainMutex);
+    }
 }
 
 void log(uint8_t logLevel, bool logToSD, const char* format, ...) {
-    // Create a buffer to store the output
-    static char buffer[DEBUG_PRINTF_BUFFER_SIZE];
+    uint8_t core = rp2040.cpuid() ? 1 : 0;
+    char* buffer = formatBuffer[core];
       
     // Prepare the log level string.
     const char* logLevelStr = (logLevel < sizeof(logType) / sizeof(logType[0])) ? logType[logLevel] : "UNKNOWN";
@@ -35,18 +92,202 @@ void log(uint8_t logLevel, bool logToSD, const char* format, ...) {
 
     if (len < DEBUG_PRINTF_BUFFER_SIZE) {
         len += vsnprintf(buffer + len, DEBUG_PRINTF_BUFFER_SIZE - len, format, args);
-    } else {
-        len = DEBUG_PRINTF_BUFFER_SIZE; //Ensure we don't write past buffer
+    }
+    if (len >= DEBUG_PRINTF_BUFFER_SIZE) {
+        len = DEBUG_PRINTF_BUFFER_SIZE - 1; //Ensure we don't read past buffer
     }
 
     va_end(args);
     
     if(len > 0) {
-        if (logToSD) writeLog(buffer);
-        if (!serialLocked) {
-            serialLocked = true;
-            Serial.print(buffer);
-            serialLocked = false;
+        pushRecord(core, logLevel, logToSD, buffer, len);
+        // Until core 1's loop is running nobody else drains, so do it here (boot only)
+        if (!pipelineRunning) drainLogs();
+    }
+}
+
+// Rate limiter for a single call site. Returns false while the site is over its burst;
+// the first call after the window closes logs how many were skipped.
+bool logRateAllow(logLimiter_t* limiter, uint8_t logLevel, bool logToSD, const char* format) {
+    uint32_t suppressed, seconds;
+    bool allow = logRateCheck(limiter, &suppressed, &seconds);
+    if (suppressed > 0) {
+        size_t fmtLen = strlen(format);
+        if (fmtLen > 0 && format[fmtLen - 1] == '\n') fmtLen--;
+        log(logLevel, logToSD, "Suppressed %" PRIu32 " similar messages in %" PRIu32 "s: %.*s\n",
+            suppressed, seconds, (int)fmtLen, format);
+    }
+    return allow;
+}
+
+// Counts a message against its limiter; suppressed is set to the count of the window that
+// just closed (0 while the window is still open)
+bool logRateCheck(logLimiter_t* limiter, uint32_t* suppressed, uint32_t* windowSeconds) {
+    uint32_t now = millis();
+    *suppressed = 0;
+    *windowSeconds = 0;
+    if (limiter->count == 0 || now - limiter->windowStart >= LOG_RATE_WINDOW) {
+        *suppressed = limiter->suppressed;
+        *windowSeconds = (now - limiter->windowStart) / 1000;
+        limiter->suppressed = 0;
+        limiter->windowStart = now;
+        limiter->count = 0;
+    }
+    if (limiter->count < LOG_RATE_BURST) {
+        limiter->count++;
+        return true;
+    }
+    limiter->suppressed++;
+    return false;
+}
+
+const char* getLogModuleName(uint8_t module) {
+    return (module < LOG_MODULE_COUNT) ? logModuleNames[module] : "unknown";
+}
+
+const char* getLogLevelName(uint8_t logLevel) {
+    return (logLevel <= LOG_DEBUG) ? logLevelNames[logLevel] : "unknown";
+}
+
+int8_t findLogModule(const char* name) {
+    for (uint8_t i = 0; i < LOG_MODULE_COUNT; i++) {
+        if (strcasecmp(name, logModuleNames[i]) == 0) return i;
+    }
+    return -1;
+}
+
+int8_t findLogLevel(const char* name) {
+    for (uint8_t i = 0; i <= LOG_DEBUG; i++) {
+        if (strcasecmp(name, logLevelNames[i]) == 0) return i;
+    }
+    return -1;
+}
+
+bool setLogModuleLevel(uint8_t module, uint8_t logLevel) {
+    if (module >= LOG_MODULE_COUNT || logLevel > LOG_DEBUG) return false;
+    logModuleVerbosity[module] = LOG_VERBOSITY(logLevel);
+    return true;
+}
+
+uint8_t getLogModuleLevel(uint8_t module) {
+    static const uint8_t levelByVerbosity[] = {LOG_ERROR, LOG_WARNING, LOG_INFO, LOG_DEBUG};
+    return (module < LOG_MODULE_COUNT) ? levelByVerbosity[logModuleVerbosity[module]] : LOG_INFO;
+}
+
+// Producer side - a memcpy into this core's ring, never blocks
+static bool pushRecord(uint8_t core, uint8_t level, bool toSD, const char* text, uint16_t length) {
+    LogRing& ring = logRings[core];
+    uint32_t head = ring.head;
+    uint32_t tail = __atomic_load_n(&ring.tail, __ATOMIC_ACQUIRE);
+    uint32_t need = (sizeof(LogRecordHeader) + length + LOG_RECORD_ALIGN - 1) & ~(LOG_RECORD_ALIGN - 1);
+    uint32_t offset = head & (LOG_RING_SIZE - 1);
+    uint32_t contiguous = LOG_RING_SIZE - offset;
+    uint32_t pad = (contiguous < need) ? contiguous : 0;
+
+    if (LOG_RING_SIZE - (head - tail) < need + pad) {
+        logStats.dropped[core]++;
+        return false;
+    }
+
+    if (pad) {
+        LogRecordHeader* filler = (LogRecordHeader*)&ring.data[offset];
+        filler->length = LOG_RECORD_PAD;
+        head += pad;
+        offset = 0;
+    }
+
+    LogRecordHeader* header = (LogRecordHeader*)&ring.data[offset];
+    header->length = length;
+    header->level = level;
+    header->toSD = toSD;
+    header->timestamp = millis();
+    memcpy(&ring.data[offset + sizeof(LogRecordHeader)], text, length);
+    head += need;
+
+    if (head - tail > logStats.ringHighWater[core]) logStats.ringHighWater[core] = head - tail;
+    __atomic_store_n(&ring.head, head, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Append one line to the SD buffer with the uptime prefix the system log has always used
+static void queueSDLine(uint32_t timestamp, const char* text, uint16_t length) {
+    char prefix[24];
+    int prefixLen = snprintf(prefix, sizeof(prefix), "[[%" PRIu32 "]]\t\t", timestamp / 1000);
+    if (sdBatchLength + prefixLen + length >= LOG_SD_BATCH_SIZE) flushSDBatch(true);
+    if (sdBatchLength + prefixLen + length >= LOG_SD_BATCH_SIZE) {
+        logStats.sdDropped++;
+        return;
+    }
+    if (sdBatchLength == 0) sdBatchTS = millis();
+    memcpy(&sdBatch[sdBatchLength], prefix, prefixLen);
+    memcpy(&sdBatch[sdBatchLength + prefixLen], text, length);
+    sdBatchLength += prefixLen + length;
+}
+
+// Consumer side - batches ring contents into single Serial writes and SD appends
+static void drainLogs(void) {
+    if (!mutex_try_enter(&logDrainMutex, nullptr)) return;
+
+    uint16_t serialLength = 0;
+    for (uint8_t core = 0; core < 2; core++) {
+        LogRing& ring = logRings[core];
+        uint32_t tail = ring.tail;
+        uint32_t head = __atomic_load_n(&ring.head, __ATOMIC_ACQUIRE);
+
+        while (tail != head) {
+            uint32_t offset = tail & (LOG_RING_SIZE - 1);
+            LogRecordHeader* header = (LogRecordHeader*)&ring.data[offset];
+            if (header->length == LOG_RECORD_PAD) {
+                tail += LOG_RING_SIZE - offset;
+                continue;
+            }
+            const char* text = (const char*)&ring.data[offset + sizeof(LogRecordHeader)];
+            uint16_t length = header->length;
+
+            if (serialLength + length > LOG_SERIAL_BATCH_SIZE) {
+                if (!serialLocked) Serial.write((const uint8_t*)serialBatch, serialLength);
+                serialLength = 0;
+            }
+            if (length <= LOG_SERIAL_BATCH_SIZE) {
+                memcpy(&serialBatch[serialLength], text, length);
+                serialLength += length;
+            }
+            if (header->toSD) queueSDLine(header->timestamp, text, length);
+
+            tail += (sizeof(LogRecordHeader) + length + LOG_RECORD_ALIGN - 1) & ~(LOG_RECORD_ALIGN - 1);
+        }
+        __atomic_store_n(&ring.tail, tail, __ATOMIC_RELEASE);
+
+        // Report overflow once the ring has room again
+        uint32_t dropped = logStats.dropped[core];
+        if (dropped != reportedDrops[core]) {
+            char msg[80];
+            int msgLen = snprintf(msg, sizeof(msg), "[WARNING] Log buffer full on core %d, %" PRIu32 " messages dropped\n",
+                                  core, dropped - reportedDrops[core]);
+            reportedDrops[core] = dropped;
+            if (serialLength + msgLen > LOG_SERIAL_BATCH_SIZE) {
+                if (!serialLocked) Serial.write((const uint8_t*)serialBatch, serialLength);
+                serialLength = 0;
+            }
+            memcpy(&serialBatch[serialLength], msg, msgLen);
+            serialLength += msgLen;
+            queueSDLine(millis(), msg, msgLen);
         }
     }
-}
\ No newline at end of file
+    if (serialLength > 0 && !serialLocked) Serial.write((const uint8_t*)serialBatch, serialLength);
+
+    flushSDBatch(false);
+    mutex_exit(&logDrainMutex);
+}
+
+// One SD open/append/close per batch instead of per message
+static void flushSDBatch(bool force) {
+    if (sdBatchLength == 0) return;
+    if (!sdInfo.ready) {
+        sdBatchLength = 0;  // No card - SD logging is skipped, as before
+        return;
+    }
+    if (!force && sdBatchLength < LOG_SD_BATCH_SIZE * 3 / 4 && millis() - sdBatchTS < LOG_SD_FLUSH_INTERVAL) return;
+    sdBatch[sdBatchLength] = '\0';
+    if (writeLog(sdBatch)) sdBatchLength = 0;  // Otherwise SD is busy - retry on the next drain
+}
@@ -5,18 +5,108 @@
 // Buffer sizes
 #define DEBUG_PRINTF_BUFFER_SIZE 500
 
+// Log pipeline - log() formats and copies into a per-core ring, manageLogger() drains to Serial/SD
+#define LOG_RING_SIZE 4096              // Bytes per core, must be a power of 2
+#define LOG_SERIAL_BATCH_SIZE 512       // Bytes written to Serial per call
+#define LOG_SD_BATCH_SIZE 2048          // Bytes buffered before an SD append
+#define LOG_SD_FLUSH_INTERVAL 1000      // Max ms an SD log line waits in the buffer
+
+// Max ms boot waits for a USB serial host (build flag, default 0 - set e.g. 5000 to catch boot messages)
+#ifndef LOG_SERIAL_WAIT
+#define LOG_SERIAL_WAIT 0
+#endif
+
 // Log entry types
 #define LOG_INFO 0
 #define LOG_WARNING 1
 #define LOG_ERROR 2
 #define LOG_DEBUG 3
 
+// Verbosity rank of a log type (ERROR is the least verbose, DEBUG the most)
+#define LOG_VERBOSITY(level) ((level) == LOG_ERROR ? 0 : (level) == LOG_WARNING ? 1 : (level) == LOG_INFO ? 2 : 3)
+
+// Build-time minimum - LOG() calls more verbose than this compile away, arguments and all
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_DEBUG
+#endif
+
+// Runtime level per module, default for modules until changed from the terminal/API
+#define LOG_DEFAULT_LEVEL LOG_INFO
+
+// Log modules - a source file selects its module by defining LOG_MODULE before its includes
+#define LOG_MODULE_SYSTEM 0
+#define LOG_MODULE_NETWORK 1
+#define LOG_MODULE_MODBUS_TCP 2
+#define LOG_MODULE_GATEWAY 3
+#define LOG_MODULE_SD 4
+#define LOG_MODULE_TERMINAL 5
+#define LOG_MODULE_COUNT 6
+
+#ifndef LOG_MODULE
+#define LOG_MODULE LOG_MODULE_SYSTEM
+#endif
+
+// Rate limiting for repetitive messages (per call site)
+#define LOG_RATE_WINDOW 10000       // ms
+#define LOG_RATE_BURST 5            // Messages let through per window, the rest are counted
+
+#define LOG_ENABLED(level) \
+    (LOG_VERBOSITY(level) <= LOG_VERBOSITY(LOG_COMPILE_LEVEL) && LOG_VERBOSITY(level) <= logModuleVerbosity[LOG_MODULE])
+
+#define LOG(level, toSD, ...) \
+    do { if (LOG_ENABLED(level)) log(level, toSD, __VA_ARGS__); } while (0)
+
+// For per-edge/per-poll lines - emits a "suppressed N" summary when the next window opens
+#define LOG_RATE_LIMITED(level, toSD, format, ...) \
+    do { \
+        static logLimiter_t _logLimiter; \
+        if (LOG_ENABLED(level) && logRateAllow(&_logLimiter, level, toSD, format)) log(level, toSD, format, ##__VA_ARGS__); \
+    } while (0)
+
+// Same with one limiter per key (e.g. per port), so a noisy key doesn't hide the others. The
+// summary is printed with the arguments of the message that opens the next window, so it
+// names the key.
+#define LOG_RATE_LIMITED_BY(key, keys, level, toSD, format, ...) \
+    do { \
+        static logLimiter_t _logLimiters[keys]; \
+        uint32_t _suppressed, _seconds; \
+        if (LOG_ENABLED(level) && logRateCheck(&_logLimiters[key], &_suppressed, &_seconds)) { \
+            if (_suppressed > 0) \
+                log(level, toSD, "Suppressed %" PRIu32 " similar messages in %" PRIu32 "s: " format, _suppressed, _seconds, ##__VA_ARGS__); \
+            log(level, toSD, format, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+struct logLimiter_t {
+    uint32_t windowStart;
+    uint16_t count;
+    uint32_t suppressed;
+};
+
 void init_logger(void);
+void manageLogger(void);
+void flushLogs(void);
+bool logRateAllow(logLimiter_t* limiter, uint8_t logLevel, bool logToSD, const char* format);
+bool logRateCheck(logLimiter_t* limiter, uint32_t* suppressed, uint32_t* windowSeconds);
+const char* getLogModuleName(uint8_t module);
+const char* getLogLevelName(uint8_t logLevel);
+int8_t findLogModule(const char* name);
+int8_t findLogLevel(const char* name);
+bool setLogModuleLevel(uint8_t module, uint8_t logLevel);
+uint8_t getLogModuleLevel(uint8_t module);
 
 // Debug functions
-void log(uint8_t logLevel, bool logToSD,const char* format, ...);
+void log(uint8_t logLevel, bool logToSD, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+struct logStats_t {
+    uint32_t dropped[2];        // Messages lost because a core's ring was full
+    uint32_t sdDropped;         // SD lines lost because the SD buffer was full
+    uint32_t ringHighWater[2];  // Max bytes queued per ring
+};
 
 // Serial port mutex
 
 extern bool serialReady;
 extern bool serialLocked;
+extern logStats_t logStats;
+extern uint8_t logModuleVerbosity[LOG_MODULE_COUNT];
@@ -0,0 +1,210 @@
+#include "metricsManager.h"
+#include "../network/network.h"
+#include "../network/modbus_tcp.h"
+#include "taskScheduler.h"
+
+// Bucket upper bounds in microseconds
+static const uint32_t rttBounds[METRICS_BUCKETS] = {5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000};
+static const uint32_t sdWriteBounds[METRICS_BUCKETS] = {1000, 2000, 5000, 10000, 20000, 50000, 100000, 250000};
+static const uint32_t loopBounds[METRICS_BUCKETS] = {50, 100, 250, 500, 1000, 2500, 5000, 10000};
+
+// Global variables
+portMetrics_t portMetrics[MAX_FLOW_COUNTERS];
+metricsHistogram_t sdWriteLatency;
+
+static metricsHistogram_t loopTime[2];
+static uint32_t loopLastUs[2] = {0, 0};
+static uint32_t loopMaxUs[2] = {0, 0};       // Longest iteration since the last scrape
+
+void init_metricsManager() {
+  memset(portMetrics, 0, sizeof(portMetrics));
+  for (int i = 0; i < MAX_FLOW_COUNTERS; i++) portMetrics[i].rtt.bounds = rttBounds;
+  memset(&sdWriteLatency, 0, sizeof(sdWriteLatency));
+  sdWriteLatency.bounds = sdWriteBounds;
+  memset(loopTime, 0, sizeof(loopTime));
+  loopTime[0].bounds = loopBounds;
+  loopTime[1].bounds = loopBounds;
+}
+
+void metricsObserve(metricsHistogram_t* histogram, uint32_t valueUs) {
+  uint8_t bucket = 0;
+  while (bucket < METRICS_BUCKETS && valueUs > histogram->bounds[bucket]) bucket++;
+  histogram->buckets[bucket]++;
+  histogram->sumUs += valueUs;
+  histogram->count++;
+}
+
+void recordModbusResult(uint8_t portIndex, bool valid) {
+  if (portIndex >= MAX_FLOW_COUNTERS) return;
+  portMetrics_t* port = &portMetrics[portIndex];
+  if (valid) {
+    port->success++;
+    metricsObserve(&port->rtt, modbusRTU.getLastRoundTrip());
+    return;
+  }
+  switch (modbusRTU.getLastResult()) {
+    case MODBUS_RESULT_CRC_ERROR: port->crcErrors++; break;
+    case MODBUS_RESULT_EXCEPTION: port->exceptions++; break;
+    default: port->timeouts++; break;
+  }
+}
+
+// Time between successive calls on the same core, i.e. one full loop iteration
+void recordLoopIteration(uint8_t core) {
+  uint32_t now = micros();
+  if (loopLastUs[core] != 0) {
+    uint32_t elapsed = now - loopLastUs[core];
+    metricsObserve(&loopTime[core], elapsed);
+    if (elapsed > loopMaxUs[core]) loopMaxUs[core] = elapsed;
+  }
+  loopLastUs[core] = now;
+}
+
+// Rendering --------------------------------------------------------------->
+
+static void printFamily(ChunkedJsonWriter& out, const char* name, const char* type, const char* help) {
+  out.printf("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+// Microseconds as seconds without floating point formatting
+static void printSeconds(ChunkedJsonWriter& out, uint64_t us) {
+  out.printf("%lu.%06lu", (unsigned long)(us / 1000000), (unsigned long)(us % 1000000));
+}
+
+// labels is either empty or `key="value"` pairs without braces
+static void printHistogram(ChunkedJsonWriter& out, const char* name, const char* labels, const metricsHistogram_t* h) {
+  const char* sep = labels[0] ? "," : "";
+  uint32_t cumulative = 0;
+  for (uint8_t b = 0; b < METRICS_BUCKETS; b++) {
+    cumulative += h->buckets[b];
+    out.printf("%s_bucket{%s%sle=\"", name, labels, sep);
+    printSeconds(out, h->bounds[b]);
+    out.printf("\"} %lu\n", (unsigned long)cumulative);
+  }
+  out.printf("%s_bucket{%s%sle=\"+Inf\"} %lu\n", name, labels, sep, (unsigned long)(cumulative + h->buckets[METRICS_BUCKETS]));
+  if (labels[0]) out.printf("%s_sum{%s} ", name, labels);
+  else out.printf("%s_sum ", name);
+  printSeconds(out, h->sumUs);
+  if (labels[0]) out.printf("\n%s_count{%s} %lu\n", name, labels, (unsigned long)h->count);
+  else out.printf("\n%s_count %lu\n", name, (unsigned long)h->count);
+}
+
+static void renderMetrics(ChunkedJsonWriter& out) {
+  char labels[48];
+
+  printFamily(out, "gateway_uptime_seconds", "gauge", "Time since boot");
+  out.printf("gateway_uptime_seconds %lu\n", (unsigned long)(millis() / 1000));
+  printFamily(out, "gateway_heap_free_bytes", "gauge", "Free heap");
+  out.printf("gateway_heap_free_bytes %lu\n", (unsigned long)rp2040.getFreeHeap());
+  printFamily(out, "gateway_heap_total_bytes", "gauge", "Total heap");
+  out.printf("gateway_heap_total_bytes %lu\n", (unsigned long)rp2040.getTotalHeap());
+
+  // Per port
+  printFamily(out, "gateway_port_up", "gauge", "1 if the port has data and its last read succeeded");
+  for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
+    out.printf("gateway_port_up{port=\"%d\",enabled=\"%d\"} %d\n", i + 1, gatewayConfig.ports[i].enabled,
+               flowCounterData[i].dataValid && !flowCounterData[i].commError);
+  }
+  printFamily(out, "gateway_port_triggers_total", "counter", "Trigger reads completed");
+  for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
+    out.printf("gateway_port_triggers_total{port=\"%d\"} %lu\n", i + 1, (unsigned long)flowCounterData[i].triggerCount);
+  }
+  printFamily(out, "gateway_rtu_requests_total", "counter", "Modbus RTU reads queued");
+  for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
+    out.printf("gateway_rtu_requests_total{port=\"%d\"} %lu\n", i + 1, (unsigned long)portMetrics[i].requests);
+  }
+  printFamily(out, "gateway_rtu_responses_total", "counter", "Modbus RTU read outcomes");
+  for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
+    const portMetrics_t* port = &portMetrics[i];
+    out.printf("gateway_rtu_responses_total{port=\"%d\",result=\"success\"} %lu\n", i + 1, (unsigned long)port->success);
+    out.printf("gateway_rtu_responses_total{port=\"%d\",result=\"timeout\"} %lu\n", i + 1, (unsigned long)port->timeouts);
+    out.printf("gateway_rtu_responses_total{port=\"%d\",result=\"crc_error\"} %lu\n", i + 1, (unsigned long)port->crcErrors);
+    out.printf("gateway_rtu_responses_total{port=\"%d\",result=\"exception\"} %lu\n", i + 1, (unsigned long)port->exceptions);
+  }
+  printFamily(out, "gateway_rtu_rtt_seconds", "histogram", "Modbus RTU round trip of successful reads");
+  for (int i = 0; i < MAX_FLOW_COUNTERS; i++) {
+    snprintf(labels, sizeof(labels), "port=\"%d\"", i + 1);
+    printHistogram(out, "gateway_rtu_rtt_seconds", labels, &portMetrics[i].rtt);
+  }
+
+  // Modbus RTU queue
+  printFamily(out, "gateway_rtu_queue_depth", "gauge", "Requests in the Modbus RTU queue");
+  out.printf("gateway_rtu_queue_depth %d\n", modbusRTU.getQueueCount());
+  printFamily(out, "gateway_rtu_queue_high_water", "gauge", "Most requests ever queued at once");
+  out.printf("gateway_rtu_queue_high_water %d\n", modbusRTU.getQueueHighWater());
+
+  // SD card
+  printFamily(out, "gateway_sd_write_seconds", "histogram", "SD log and sensor append latency (open, write, close)");
+  printHistogram(out, "gateway_sd_write_seconds", "", &sdWriteLatency);
+
+  // Modbus TCP
+  printFamily(out, "gateway_tcp_requests_total", "counter", "Modbus TCP requests received");
+  out.printf("gateway_tcp_requests_total %lu\n", (unsigned long)modbusServer.getTotalRequestCount());
+  printFamily(out, "gateway_tcp_exceptions_total", "counter", "Modbus TCP exception responses sent");
+  out.printf("gateway_tcp_exceptions_total %lu\n", (unsigned long)modbusServer.getTotalExceptionCount());
+  printFamily(out, "gateway_tcp_clients", "gauge", "Connected Modbus TCP clients");
+  out.printf("gateway_tcp_clients %d\n", modbusServer.getConnectedClientCount());
+  printFamily(out, "gateway_tcp_client_requests_total", "counter", "Modbus TCP requests per connected client (resets on reconnect)");
+  for (int i = 0; i < MAX_MODBUS_CLIENTS; i++) {
+    const ModbusClientConnection* client = modbusServer.getClient(i);
+    if (client == nullptr) continue;
+    out.printf("gateway_tcp_client_requests_total{slot=\"%d\",client=\"%s\"} %lu\n",
+               i, client->clientIP.c_str(), (unsigned long)client->requestCount);
+  }
+
+  // Loop iteration time
+  printFamily(out, "gateway_loop_seconds", "histogram", "Main loop iteration time");
+  for (uint8_t core = 0; core < 2; core++) {
+    snprintf(labels, sizeof(labels), "core=\"%d\"", core);
+    printHistogram(out, "gateway_loop_seconds", labels, &loopTime[core]);
+  }
+  printFamily(out, "gateway_loop_max_seconds", "gauge", "Longest loop iteration since the previous scrape");
+  for (uint8_t core = 0; core < 2; core++) {
+    out.printf("gateway_loop_max_seconds{core=\"%d\"} ", core);
+    printSeconds(out, loopMaxUs[core]);
+    out.print("\n");
+    loopMaxUs[core] = 0;
+  }
+
+  // Scheduler tasks
+  printFamily(out, "gateway_task_overruns_total", "counter", "Task runs over their time budget");
+  for (uint8_t core = 0; core < SCHED_CORES; core++) {
+    for (uint8_t i = 0; i < schedTaskCount(core); i++) {
+      const schedTask_t* task = schedGetTask(core, i);
+      out.printf("gateway_task_overruns_total{core=\"%d\",task=\"%s\"} %lu\n", core, task->name, (unsigned long)task->overruns);
+    }
+  }
+  printFamily(out, "gateway_task_run_max_seconds", "gauge", "Longest task run since the stats were reset");
+  for (uint8_t core = 0; core < SCHED_CORES; core++) {
+    for (uint8_t i = 0; i < schedTaskCount(core); i++) {
+      const schedTask_t* task = schedGetTask(core, i);
+      out.printf("gateway_task_run_max_seconds{core=\"%d\",task=\"%s\"} ", core, task->name);
+      printSeconds(out, task->maxRunUs);
+      out.print("\n");
+    }
+  }
+  printFamily(out, "gateway_task_late_max_seconds", "gauge", "Latest start of a periodic task since the stats were reset");
+  for (uint8_t core = 0; core < SCHED_CORES; core++) {
+    for (uint8_t i = 0; i < schedTaskCount(core); i++) {
+      const schedTask_t* task = schedGetTask(core, i);
+      if (task->periodUs == 0) continue;
+      out.printf("gateway_task_late_max_seconds{core=\"%d\",task=\"%s\"} ", core, task->name);
+      printSeconds(out, task->maxLateUs);
+      out.print("\n");
+    }
+  }
+}
+
+// API --------------------------------------------------------------------->
+
+void setupMetricsAPI() {
+  // Prometheus text exposition format, streamed in chunks
+  server.on("/metrics", HTTP_GET, []() {
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "text/plain; version=0.0.4; charset=utf-8", "");
+    ChunkedJsonWriter writer;
+    renderMetrics(writer);
+    writer.flush();
+    server.sendContent("");  // Terminating chunk
+  });
+}
@@ -0,0 +1,39 @@
+/* Description: Counters and histograms for the /metrics endpoint (Prometheus text format)
+ * Everything is static; the page is rendered line by line into the chunked response writer,
+ * so a scrape allocates nothing. Counters are single words written by one core, so a scrape
+ * taken mid-update can at worst see a histogram whose buckets and count differ by one.
+ */
+
+#pragma once
+
+#include "../gateway/flowCounterConfig.h"
+
+#define METRICS_BUCKETS 8               // Finite buckets per histogram (+Inf is implicit)
+
+struct metricsHistogram_t {
+  const uint32_t* bounds;               // METRICS_BUCKETS ascending upper bounds in microseconds
+  uint32_t buckets[METRICS_BUCKETS + 1];  // Per-bucket counts (not cumulative), last is +Inf
+  uint32_t count;
+  uint64_t sumUs;
+};
+
+// Per flow counter port Modbus RTU statistics
+struct portMetrics_t {
+  uint32_t requests;                    // Reads queued
+  uint32_t success;
+  uint32_t timeouts;
+  uint32_t crcErrors;
+  uint32_t exceptions;
+  metricsHistogram_t rtt;               // Successful reads only
+};
+
+// Function prototypes
+void init_metricsManager();
+void metricsObserve(metricsHistogram_t* histogram, uint32_t valueUs);
+void recordModbusResult(uint8_t portIndex, bool valid);  // Call from the response callback
+void recordLoopIteration(uint8_t core);  // Call once per loop on each core
+void setupMetricsAPI();
+
+// Global variables
+extern portMetrics_t portMetrics[MAX_FLOW_COUNTERS];
+extern metricsHistogram_t sdWriteLatency;
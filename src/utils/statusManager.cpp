@@ -9,7 +9,6 @@ Adafruit_NeoPixel leds(TOTAL_LEDS, PIN_LED_DAT, NEO_GRB + NEO_KHZ800);
 StatusVariables status;
 bool statusLocked = false;
 static bool blinkState = false;
-static uint32_t ledTS = 0;
 
 void init_statusManager() {
   leds.begin();
@@ -18,13 +17,11 @@ void init_statusManager() {
   leds.setPixelColor(LED_SYSTEM_STATUS, LED_STATUS_STARTUP);
   leds.show();
   status.ledPulseTS = millis();
-  log(LOG_INFO, false, "Status manager started\n");
-  ledTS = millis();
+  LOG(LOG_INFO, false, "Status manager started\n");
 }
 
 void manageStatus(void)
 {
-  if (millis() - ledTS < LED_UPDATE_PERIOD) return;
   if (statusLocked) return;
   statusLocked = true;
   
@@ -0,0 +1,207 @@
+#define LOG_MODULE LOG_MODULE_SYSTEM
+#include "taskScheduler.h"
+#include "../network/network.h"
+
+struct schedCore_t {
+  schedTask_t tasks[SCHED_MAX_TASKS];
+  uint8_t count;
+  uint32_t passes;
+  volatile bool resetRequested;
+};
+
+static schedCore_t sched[SCHED_CORES];
+
+bool schedAddTask(uint8_t core, const char* name, schedFunction_t function,
+                  uint32_t periodUs, uint8_t priority, uint32_t budgetUs) {
+  if (core >= SCHED_CORES || sched[core].count >= SCHED_MAX_TASKS) {
+    LOG(LOG_ERROR, false, "Scheduler: no slot for task %s on core %d\n", name, core);
+    return false;
+  }
+  schedTask_t* task = &sched[core].tasks[sched[core].count++];
+  memset(task, 0, sizeof(schedTask_t));
+  task->name = name;
+  task->function = function;
+  task->periodUs = periodUs;
+  task->priority = priority;
+  task->budgetUs = budgetUs;
+  return true;
+}
+
+static void clearStats(schedCore_t* c) {
+  c->passes = 0;
+  for (uint8_t i = 0; i < c->count; i++) {
+    schedTask_t* task = &c->tasks[i];
+    task->runs = 0;
+    task->overruns = 0;
+    task->missed = 0;
+    task->maxRunUs = 0;
+    task->totalRunUs = 0;
+    task->maxLateUs = 0;
+    task->totalLateUs = 0;
+    task->maxLateCause = nullptr;
+  }
+}
+
+void schedResetStats(uint8_t core) {
+  if (core < SCHED_CORES) sched[core].resetRequested = true;
+}
+
+// Earliest deadline first, then priority
+static bool runsBefore(const schedTask_t* a, const schedTask_t* b) {
+  int32_t diff = (int32_t)(a->nextDueUs - b->nextDueUs);
+  return diff < 0 || (diff == 0 && a->priority < b->priority);
+}
+
+static void runTask(schedCore_t* c, schedTask_t* task, uint32_t start) {
+  if (task->periodUs) {
+    uint32_t late = start - task->nextDueUs;
+    task->totalLateUs += late;
+    if (late > task->maxLateUs) {
+      task->maxLateUs = late;
+      task->maxLateCause = task->blockedBy;
+    }
+  }
+  task->blockedBy = nullptr;
+
+  task->function();
+
+  uint32_t end = micros();
+  uint32_t runUs = end - start;
+  task->runs++;
+  task->totalRunUs += runUs;
+  if (runUs > task->maxRunUs) task->maxRunUs = runUs;
+  if (task->budgetUs && runUs > task->budgetUs) task->overruns++;
+
+  if (task->periodUs) {
+    task->nextDueUs += task->periodUs;
+    if ((int32_t)(start - task->nextDueUs) >= 0) {
+      // Started a whole period late - drop the backlog rather than running back to back
+      task->missed++;
+      task->nextDueUs = start + task->periodUs;
+    }
+  } else {
+    task->nextDueUs = start;
+  }
+
+  // Periodic tasks that fell due during this run were held up by it
+  for (uint8_t i = 0; i < c->count; i++) {
+    schedTask_t* other = &c->tasks[i];
+    if (other->periodUs == 0 || other->blockedBy != nullptr) continue;
+    if ((int32_t)(other->nextDueUs - start) >= 0 && (int32_t)(end - other->nextDueUs) > 0) {
+      other->blockedBy = task->name;
+    }
+  }
+}
+
+void schedRun(uint8_t core) {
+  schedCore_t* c = &sched[core];
+  uint32_t now = micros();
+
+  if (c->passes == 0) {
+    // First pass - boot time is not lateness
+    for (uint8_t i = 0; i < c->count; i++) c->tasks[i].nextDueUs = now;
+  }
+  if (c->resetRequested) {
+    clearStats(c);
+    c->resetRequested = false;
+  }
+  c->passes++;
+
+  // Each due task runs at most once per pass
+  uint32_t ranMask = 0;
+  while (true) {
+    int8_t next = -1;
+    for (uint8_t i = 0; i < c->count; i++) {
+      if (ranMask & (1UL << i)) continue;
+      if ((int32_t)(now - c->tasks[i].nextDueUs) < 0) continue;
+      if (next < 0 || runsBefore(&c->tasks[i], &c->tasks[next])) next = i;
+    }
+    if (next < 0) break;
+    ranMask |= 1UL << next;
+    runTask(c, &c->tasks[next], now);
+    now = micros();
+  }
+}
+
+uint8_t schedTaskCount(uint8_t core) {
+  return core < SCHED_CORES ? sched[core].count : 0;
+}
+
+const schedTask_t* schedGetTask(uint8_t core, uint8_t index) {
+  if (core >= SCHED_CORES || index >= sched[core].count) return nullptr;
+  return &sched[core].tasks[index];
+}
+
+// Reporting --------------------------------------------------------------->
+
+void serializeSchedulerStats(JsonObject obj) {
+  JsonArray cores = obj.createNestedArray("cores");
+  for (uint8_t core = 0; core < SCHED_CORES; core++) {
+    const schedCore_t* c = &sched[core];
+    JsonObject coreObj = cores.createNestedObject();
+    coreObj["core"] = core;
+    coreObj["passes"] = c->passes;
+    JsonArray tasks = coreObj.createNestedArray("tasks");
+    for (uint8_t i = 0; i < c->count; i++) {
+      const schedTask_t* task = &c->tasks[i];
+      uint32_t runs = task->runs ? task->runs : 1;
+      JsonObject entry = tasks.createNestedObject();
+      entry["name"] = task->name;
+      entry["period_us"] = task->periodUs;
+      entry["priority"] = task->priority;
+      entry["budget_us"] = task->budgetUs;
+      entry["runs"] = task->runs;
+      entry["overruns"] = task->overruns;
+      entry["missed"] = task->missed;
+      entry["max_run_us"] = task->maxRunUs;
+      entry["avg_run_us"] = (uint32_t)(task->totalRunUs / runs);
+      if (task->periodUs) {
+        entry["max_late_us"] = task->maxLateUs;
+        entry["avg_late_us"] = (uint32_t)(task->totalLateUs / runs);
+        entry["max_late_cause"] = task->maxLateCause;
+      }
+    }
+  }
+}
+
+void printSchedulerStats(void) {
+  for (uint8_t core = 0; core < SCHED_CORES; core++) {
+    const schedCore_t* c = &sched[core];
+    log(LOG_INFO, false, "Core %d: %" PRIu32 " passes\n", core, c->passes);
+    for (uint8_t i = 0; i < c->count; i++) {
+      const schedTask_t* task = &c->tasks[i];
+      uint32_t runs = task->runs ? task->runs : 1;
+      char late[72] = "";
+      if (task->periodUs) {
+        snprintf(late, sizeof(late), ", late max/avg %" PRIu32 "/%" PRIu32 " us (%s), missed %" PRIu32,
+                 task->maxLateUs, (uint32_t)(task->totalLateUs / runs),
+                 task->maxLateCause ? task->maxLateCause : "-", task->missed);
+      }
+      log(LOG_INFO, false, "  %-9s run max/avg %" PRIu32 "/%" PRIu32 " us, over budget %" PRIu32 " of %" PRIu32 "%s\n",
+          task->name, task->maxRunUs, (uint32_t)(task->totalRunUs / runs), task->overruns, task->runs, late);
+    }
+  }
+}
+
+// API --------------------------------------------------------------------->
+
+void setupSchedulerAPI(void) {
+  // Per-task runtime, overrun and jitter stats for both cores
+  server.on("/api/system/tasks", HTTP_GET, []() {
+    static StaticJsonDocument<4096> doc;
+    doc.clear();
+    serializeSchedulerStats(doc.to<JsonObject>());
+    sendJsonChunked(200, doc);
+  });
+
+  // Clear the stats with ?action=reset
+  server.on("/api/system/tasks", HTTP_POST, []() {
+    if (!server.hasArg("action") || server.arg("action") != "reset") {
+      server.send(400, "application/json", "{\"error\":\"Unknown action\"}");
+      return;
+    }
+    schedResetStats(0);
+    schedResetStats(1);
+    server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"Task stats reset\"}");
+  });
+}
@@ -0,0 +1,47 @@
+/* Description: Per-core cooperative scheduler
+ * Each core registers its manage functions once at boot with a period, a priority and a time
+ * budget. Every loop pass runs the tasks that are due, earliest deadline first (priority breaks
+ * ties), and records how long each run took and how late it started. Stats are written only by
+ * the owning core; the other core may read them (single words, at worst one run out of date).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#define SCHED_CORES 2
+#define SCHED_MAX_TASKS 8               // Per core
+
+typedef void (*schedFunction_t)(void);
+
+struct schedTask_t {
+  const char* name;
+  schedFunction_t function;
+  uint32_t periodUs;                    // 0 = every pass
+  uint32_t budgetUs;                    // Runs longer than this count as overruns
+  uint8_t priority;                     // 0 = highest, only breaks deadline ties
+  uint32_t nextDueUs;
+  const char* blockedBy;                // Task that was running when this one fell due
+
+  // Stats
+  uint32_t runs;
+  uint32_t overruns;                    // Runs over budget
+  uint32_t missed;                      // Periods skipped because a run started a full period late
+  uint32_t maxRunUs;
+  uint64_t totalRunUs;
+  uint32_t maxLateUs;                   // Start jitter, periodic tasks only
+  uint64_t totalLateUs;
+  const char* maxLateCause;             // Task that was running when the worst late start fell due
+};
+
+// Function prototypes
+bool schedAddTask(uint8_t core, const char* name, schedFunction_t function,
+                  uint32_t periodUs, uint8_t priority, uint32_t budgetUs);
+void schedRun(uint8_t core);            // One pass, call from the core's loop
+void schedResetStats(uint8_t core);     // Safe from either core, applied on the next pass
+uint8_t schedTaskCount(uint8_t core);
+const schedTask_t* schedGetTask(uint8_t core, uint8_t index);
+void serializeSchedulerStats(JsonObject obj);
+void printSchedulerStats(void);          // Terminal "tasks" reply, printed whatever the log levels
+void setupSchedulerAPI(void);
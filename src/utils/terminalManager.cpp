@@ -1,3 +1,4 @@
+#define LOG_MODULE LOG_MODULE_TERMINAL
 #include "terminalManager.h"
 
 bool terminalReady = false;
@@ -7,7 +8,7 @@ void init_terminalManager(void) {
     delay(10);
   }
   terminalReady = true;
-  log(LOG_INFO, false, "Terminal task started\n");
+  LOG(LOG_INFO, false, "Terminal task started\n");
 }
 
 void manageTerminal(void)
@@ -16,17 +17,20 @@ void manageTerminal(void)
   serialLocked = true;
   if (Serial.available())
   {
-    char serialString[10];  // Buffer for incoming serial data
+    char serialString[32];  // Buffer for incoming serial data
     memset(serialString, 0, sizeof(serialString));
     int bytesRead = Serial.readBytesUntil('\n', serialString, sizeof(serialString) - 1); // Leave room for null terminator
     serialLocked = false;
     if (bytesRead > 0 ) {
       serialString[bytesRead] = '\0'; // Add null terminator
-      log(LOG_INFO, true,"Received:  %s\n", serialString);
+      LOG(LOG_INFO, true,"Received:  %s\n", serialString);
+
+      // Command replies use log() rather than LOG(), so "log terminal error" can't hide them
 
       // Reboot ---------------------------------------------->
       if (strcmp(serialString, "reboot") == 0) {
         log(LOG_INFO, true, "Rebooting now...\n");
+        flushLogs();
         rp2040.restart();
       }
 
@@ -77,9 +81,40 @@ void manageTerminal(void)
           }
         }
       }
+      // Log levels ------------------------------------------>
+      else if (strncmp(serialString, "log", 3) == 0 && (serialString[3] == '\0' || serialString[3] == ' ')) {
+        char moduleName[16] = "";
+        char levelName[16] = "";
+        if (sscanf(serialString + 3, "%15s %15s", moduleName, levelName) == 2) {
+          int8_t level = findLogLevel(levelName);
+          int8_t module = findLogModule(moduleName);
+          if (level < 0 || (module < 0 && strcmp(moduleName, "all") != 0)) {
+            log(LOG_INFO, false, "Usage: log <module|all> <error|warning|info|debug>\n");
+          } else {
+            for (uint8_t i = 0; i < LOG_MODULE_COUNT; i++) {
+              if (module < 0 || module == i) setLogModuleLevel(i, level);
+            }
+            log(LOG_INFO, false, "Log level for %s set to %s\n", moduleName, levelName);
+          }
+        } else {
+          for (uint8_t i = 0; i < LOG_MODULE_COUNT; i++) {
+            log(LOG_INFO, false, "%s: %s\n", getLogModuleName(i), getLogLevelName(getLogModuleLevel(i)));
+          }
+          log(LOG_INFO, false, "Dropped: core0 %" PRIu32 ", core1 %" PRIu32 ", sd %" PRIu32 "\n", logStats.dropped[0], logStats.dropped[1], logStats.sdDropped);
+        }
+      }
+      // Scheduler task stats ----------------------------------->
+      else if (strcmp(serialString, "tasks") == 0) {
+        printSchedulerStats();
+      }
+      else if (strcmp(serialString, "tasks reset") == 0) {
+        schedResetStats(0);
+        schedResetStats(1);
+        log(LOG_INFO, false, "Task stats reset\n");
+      }
       else {
         log(LOG_INFO, false, "Unknown command: %s\n", serialString);
-        log(LOG_INFO, false, "Available commands: \n\t- ip \t\t(print IP address)\n\t- ipstatic \t(assign 192.168.1.100)\n\t- ipdhcp \t(assign DHCP)\n\t- sd \t\t(print SD card info)\n\t- status \t(print system status)\n\t- config \t(print gateway configuration)\n\t- reboot \t(reboot system)\n");
+        log(LOG_INFO, false, "Available commands: \n\t- ip \t\t(print IP address)\n\t- ipstatic \t(assign 192.168.1.100)\n\t- ipdhcp \t(assign DHCP)\n\t- sd \t\t(print SD card info)\n\t- status \t(print system status)\n\t- config \t(print gateway configuration)\n\t- log [module level] \t(show/set log levels)\n\t- tasks [reset] \t(show/clear scheduler task stats)\n\t- reboot \t(reboot system)\n");
       }
     }
     // Clear the serial buffer each loop.
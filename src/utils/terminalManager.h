@@ -2,6 +2,8 @@
 
 #include "../sys_init.h"
 
+#define TERMINAL_POLL_INTERVAL 20     // ms between serial input checks (scheduler task period)
+
 void init_terminalManager(void);
 void manageTerminal(void);
 
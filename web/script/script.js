@@ -1,6 +1,11 @@
 // Modbus RTU-TCP Gateway Web Interface
 
 let updateInterval;
+let gatewayDataCache = null;  // Latest flow counter data (snapshot + pushed port updates)
+let eventSource = null;
+let eventStreamFailed = false; // Fall back to polling for the rest of the session
+let clockInterval;
+let deviceClock = { millis: 0, rollover: 0, receivedAt: 0 };
 const SERIAL_CONFIG_MAP = {
     '0': 'SERIAL_8N1',
     '2': 'SERIAL_8E1', 
@@ -13,11 +18,10 @@ document.addEventListener('DOMContentLoaded', () => {
     initializeForms();
     loadNetworkConfig();
     loadGatewayConfig();
-    loadModbusTCPStatus();
+    pollBusScan();
     
-    // Start polling for updates (includes version info)
-    updateDashboard();
-    setInterval(updateDashboard, 2000); // Update every 2 seconds
+    // Start live updates (event stream, or polling if unavailable)
+    startAutoUpdate();
 });
 
 // Tab switching
@@ -58,6 +62,16 @@ function initializeForms() {
         await savePortConfig();
     });
 
+    // Serial settings detection
+    document.getElementById('detect-serial-btn').addEventListener('click', async () => {
+        await startSerialDetect();
+    });
+
+    // Bus scan
+    document.getElementById('scan-bus-btn').addEventListener('click', async () => {
+        await startBusScan();
+    });
+
     // Network Configuration
     document.getElementById('network-form').addEventListener('submit', async (e) => {
         e.preventDefault();
@@ -95,116 +109,178 @@ async function loadSystemInfo() {
     }
 }
 
-// Load and update dashboard data
+// Poll dashboard data (fallback when the event stream is unavailable)
 async function updateDashboard() {
     try {
-        // System status
-        const statusResponse = await fetch('/api/system/status');
+        // Status, flow counter data and Modbus TCP from one snapshot
+        const response = await fetch('/api/batch?parts=status,data,tcp');
         
         // Check if response is OK
-        if (!statusResponse.ok) {
-            console.warn('System status request failed:', statusResponse.status);
+        if (!response.ok) {
+            console.warn('Dashboard request failed:', response.status);
             return; // Keep existing UI state on error
         }
         
-        const statusData = await statusResponse.json();
-
-        // If server is busy, just update uptime and skip other updates
-        if (statusData.busy) {
-            const uptime = statusData.uptime;
-            const hours = Math.floor(uptime / 3600);
-            const minutes = Math.floor((uptime % 3600) / 60);
-            document.getElementById('system-uptime').textContent = `Uptime: ${hours}h ${minutes}m`;
-            return; // Skip other updates to preserve current UI state
+        const batch = await response.json();
+        if (batch.busy) {
+            updateSystemStatus(batch);
+            return;
         }
+        updateSystemStatus(batch.status);
+        renderModbusTCPStatus(batch.tcp);
+        if (batch.data) gatewayDataCache = batch.data;
+        setDeviceClock(batch.current_millis, batch.millis_rollover_count);
+        renderFlowCounters();
+
+    } catch (error) {
+        console.error('Failed to update dashboard:', error);
+    }
+}
 
-        // Update uptime and version
+// Update the status cards from /api/system/status (or a status event)
+function updateSystemStatus(statusData) {
+    // If server is busy, just update uptime and skip other updates
+    if (statusData.busy) {
         const uptime = statusData.uptime;
         const hours = Math.floor(uptime / 3600);
         const minutes = Math.floor((uptime % 3600) / 60);
         document.getElementById('system-uptime').textContent = `Uptime: ${hours}h ${minutes}m`;
-        
-        if (statusData.version) {
-            document.getElementById('system-version').textContent = `Version ${statusData.version}`;
-        }
+        return; // Skip other updates to preserve current UI state
+    }
 
-        // Ethernet status - only update if we have valid data
-        if (statusData.ethernet) {
-            if (statusData.ethernet.connected) {
-                document.getElementById('eth-status').textContent = statusData.ethernet.dhcp ? 'DHCP' : 'Static';
-                document.getElementById('eth-status').className = 'badge success';
-                document.getElementById('eth-ip').textContent = statusData.ethernet.ip;
-            } else {
-                document.getElementById('eth-status').textContent = 'Disconnected';
-                document.getElementById('eth-status').className = 'badge error';
-                document.getElementById('eth-ip').textContent = '--';
-            }
+    // Update uptime and version
+    const uptime = statusData.uptime;
+    const hours = Math.floor(uptime / 3600);
+    const minutes = Math.floor((uptime % 3600) / 60);
+    document.getElementById('system-uptime').textContent = `Uptime: ${hours}h ${minutes}m`;
+    
+    if (statusData.version) {
+        document.getElementById('system-version').textContent = `Version ${statusData.version}`;
+    }
+
+    // Ethernet status - only update if we have valid data
+    if (statusData.ethernet) {
+        if (statusData.ethernet.connected) {
+            document.getElementById('eth-status').textContent = statusData.ethernet.dhcp ? 'DHCP' : 'Static';
+            document.getElementById('eth-status').className = 'badge success';
+            document.getElementById('eth-ip').textContent = statusData.ethernet.ip;
+        } else {
+            document.getElementById('eth-status').textContent = 'Disconnected';
+            document.getElementById('eth-status').className = 'badge error';
+            document.getElementById('eth-ip').textContent = '--';
         }
+    }
 
-        // SD Card status
-        if (statusData.sd) {
-            if (statusData.sd.ready) {
-                const inserted = statusData.sd.inserted ? 'Inserted' : 'Not Inserted';
-                document.getElementById('sd-status').textContent = inserted;
-                document.getElementById('sd-status').className = 'badge success';
-                document.getElementById('sd-size').textContent = 
-                    `${statusData.sd.capacityGB.toFixed(1)} GB (${statusData.sd.freeSpaceGB.toFixed(1)} GB free)`;
-            } else if (statusData.sd.inserted) {
-                document.getElementById('sd-status').textContent = 'Error';
-                document.getElementById('sd-status').className = 'badge error';
-                document.getElementById('sd-size').textContent = '--';
-            } else {
-                document.getElementById('sd-status').textContent = 'Not Inserted';
-                document.getElementById('sd-status').className = 'badge info';
-                document.getElementById('sd-size').textContent = '--';
-            }
+    // SD Card status
+    if (statusData.sd) {
+        if (statusData.sd.ready) {
+            const inserted = statusData.sd.inserted ? 'Inserted' : 'Not Inserted';
+            document.getElementById('sd-status').textContent = inserted;
+            document.getElementById('sd-status').className = 'badge success';
+            const freeText = statusData.sd.freeSpaceKnown === false
+                ? 'calculating free space'
+                : `${statusData.sd.freeSpaceGB.toFixed(1)} GB free`;
+            document.getElementById('sd-size').textContent = 
+                `${statusData.sd.capacityGB.toFixed(1)} GB (${freeText})`;
+        } else if (statusData.sd.inserted) {
+            document.getElementById('sd-status').textContent = 'Error';
+            document.getElementById('sd-status').className = 'badge error';
+            document.getElementById('sd-size').textContent = '--';
+        } else {
+            document.getElementById('sd-status').textContent = 'Not Inserted';
+            document.getElementById('sd-status').className = 'badge info';
+            document.getElementById('sd-size').textContent = '--';
         }
+    }
 
-        // RS485 status
-        if (statusData.modbus) {
-            if (statusData.modbus.hasError) {
-                document.getElementById('rs485-status').textContent = 'Comm Error';
-                document.getElementById('rs485-status').className = 'badge error';
-            } else if (statusData.modbus.activeDevices > 0) {
-                document.getElementById('rs485-status').textContent = 'OK';
-                document.getElementById('rs485-status').className = 'badge success';
-            } else {
-                document.getElementById('rs485-status').textContent = 'No Devices';
-                document.getElementById('rs485-status').className = 'badge info';
-            }
-            
-            const deviceText = statusData.modbus.errorDevices > 0 
-                ? `${statusData.modbus.activeDevices} (${statusData.modbus.errorDevices} errors)`
-                : `${statusData.modbus.activeDevices}`;
-            document.getElementById('rs485-devices').textContent = deviceText;
+    // RS485 status
+    if (statusData.modbus) {
+        if (statusData.modbus.hasError) {
+            document.getElementById('rs485-status').textContent = 'Comm Error';
+            document.getElementById('rs485-status').className = 'badge error';
+        } else if (statusData.modbus.activeDevices > 0) {
+            document.getElementById('rs485-status').textContent = 'OK';
+            document.getElementById('rs485-status').className = 'badge success';
+        } else {
+            document.getElementById('rs485-status').textContent = 'No Devices';
+            document.getElementById('rs485-status').className = 'badge info';
         }
+        
+        const deviceText = statusData.modbus.errorDevices > 0 
+            ? `${statusData.modbus.activeDevices} (${statusData.modbus.errorDevices} errors)`
+            : `${statusData.modbus.activeDevices}`;
+        document.getElementById('rs485-devices').textContent = deviceText;
+    }
 
-        // Modbus TCP
-        if (statusData.modbusTcp) {
-            document.getElementById('modbus-port').textContent = statusData.modbusTcp.port;
-            document.getElementById('modbus-clients').textContent = statusData.modbusTcp.connectedClients;
-            
-            // Client list
-            const clientList = document.getElementById('modbus-client-list');
-            if (statusData.modbusTcp.clients && statusData.modbusTcp.clients.length > 0) {
-                clientList.innerHTML = statusData.modbusTcp.clients.map(client => 
-                    `<div class="client-info"><i class="mdi mdi-lan-connect"></i> ${client}</div>`
-                ).join('');
-            } else {
-                clientList.innerHTML = '<div class="client-info no-clients">No connected clients</div>';
-            }
+    // Modbus TCP
+    if (statusData.modbusTcp) {
+        document.getElementById('modbus-port').textContent = statusData.modbusTcp.port;
+        document.getElementById('modbus-clients').textContent = statusData.modbusTcp.connectedClients;
+        
+        // Client list
+        const clientList = document.getElementById('modbus-client-list');
+        if (statusData.modbusTcp.clients && statusData.modbusTcp.clients.length > 0) {
+            clientList.innerHTML = statusData.modbusTcp.clients.map(client => 
+                `<div class="client-info"><i class="mdi mdi-lan-connect"></i> ${client}</div>`
+            ).join('');
+        } else {
+            clientList.innerHTML = '<div class="client-info no-clients">No connected clients</div>';
         }
+    }
+}
 
-        // Flow counter data
-        const gatewayResponse = await fetch('/api/gateway/data');
-        const gatewayData = await gatewayResponse.json();
-        updateFlowCounterGrid(gatewayData.flow_counters, gatewayData.current_millis, gatewayData.millis_rollover_count);
+// Device millis() as of the last response/event, advanced by local time since then
+function setDeviceClock(millis, rollover) {
+    deviceClock = { millis: millis, rollover: rollover, receivedAt: performance.now() };
+}
 
-    } catch (error) {
-        console.error('Failed to update dashboard:', error);
+function deviceMillisNow() {
+    return (deviceClock.millis + Math.floor(performance.now() - deviceClock.receivedAt)) >>> 0;
+}
+
+function renderFlowCounters() {
+    if (gatewayDataCache) {
+        updateFlowCounterGrid(gatewayDataCache.flow_counters, deviceMillisNow(), deviceClock.rollover);
     }
 }
 
+// Live updates over /api/events: a snapshot on connect, then per-port deltas and status heartbeats
+function startEventStream() {
+    eventSource = new EventSource('/api/events');
+
+    eventSource.addEventListener('snapshot', (e) => {
+        gatewayDataCache = JSON.parse(e.data);
+        renderFlowCounters();
+    });
+
+    eventSource.addEventListener('port', (e) => {
+        const update = JSON.parse(e.data);
+        setDeviceClock(update.current_millis, update.millis_rollover_count);
+        if (gatewayDataCache) {
+            gatewayDataCache.flow_counters[update.flow_counter.port - 1] = update.flow_counter;
+            renderFlowCounters();
+        }
+    });
+
+    eventSource.addEventListener('status', (e) => {
+        const statusData = JSON.parse(e.data);
+        setDeviceClock(statusData.current_millis, statusData.millis_rollover_count);
+        updateSystemStatus(statusData);
+    });
+
+    // The browser reconnects on its own; a closed stream (e.g. all event slots taken) means poll instead
+    eventSource.onerror = () => {
+        if (eventSource && eventSource.readyState === EventSource.CLOSED) {
+            stopAutoUpdate();
+            eventStreamFailed = true;
+            startAutoUpdate();
+        }
+    };
+
+    // Keep "time since" current between events
+    clockInterval = setInterval(renderFlowCounters, 1000);
+}
+
 // Format UNIX timestamp to friendly date/time
 // The flow counter timestamps are already in local time, not UTC
 // We use UTC methods to extract the date components without timezone conversion
@@ -333,27 +409,31 @@ function updateFlowCounterGrid(flowCounters, currentMillis, rolloverCount) {
     }).join('');
 }
 
-// Load gateway configuration
+// Config tab data - gateway config and Modbus TCP status in one request
 async function loadGatewayConfig() {
     try {
-        const response = await fetch('/api/gateway/config');
-        const data = await response.json();
-
-        // RS485 config
-        document.getElementById('baud-rate').value = data.rs485.baud_rate;
-        const { parity, stopBits } = parseSerialConfig(data.rs485.serial_config);
-        document.getElementById('parity').value = parity;
-        document.getElementById('stop-bits').value = stopBits;
-        document.getElementById('timeout').value = data.rs485.response_timeout;
-
-        // Port config
-        renderPortConfig(data.ports);
-
+        const response = await fetch('/api/batch?parts=config,tcp');
+        const batch = await response.json();
+        if (batch.busy) return;
+        renderGatewayConfig(batch.config);
+        renderModbusTCPStatus(batch.tcp);
     } catch (error) {
         console.error('Failed to load gateway config:', error);
     }
 }
 
+function renderGatewayConfig(data) {
+    // RS485 config
+    document.getElementById('baud-rate').value = data.rs485.baud_rate;
+    const { parity, stopBits } = parseSerialConfig(data.rs485.serial_config);
+    document.getElementById('parity').value = parity;
+    document.getElementById('stop-bits').value = stopBits;
+    document.getElementById('timeout').value = data.rs485.response_timeout;
+
+    // Port config
+    renderPortConfig(data.ports);
+}
+
 // Parse serial config to extract parity and stop bits
 function parseSerialConfig(serialConfig) {
     // Arduino/RP2040 SERIAL_* constants (bitwise OR of components):
@@ -507,6 +587,153 @@ async function savePortConfig() {
     }
 }
 
+// Start baud rate / framing detection and follow it until it finishes
+async function startSerialDetect() {
+    try {
+        const response = await fetch('/api/gateway/detect', { method: 'POST' });
+        const result = await response.json();
+        if (!response.ok) {
+            showToast(result.error || 'Failed to start detection', 'error');
+            return;
+        }
+        showToast('Serial detection started', 'info');
+        setTimeout(pollSerialDetect, 500);
+    } catch (error) {
+        showToast('Failed to start detection', 'error');
+        console.error(error);
+    }
+}
+
+async function pollSerialDetect() {
+    try {
+        const response = await fetch('/api/gateway/detect');
+        const data = await response.json();
+        renderSerialDetect(data);
+        if (data.state === 'starting' || data.state === 'running') {
+            setTimeout(pollSerialDetect, 500);
+        }
+    } catch (error) {
+        console.error('Failed to load serial detection:', error);
+    }
+}
+
+function formatSerialSetting(baudRate, serialConfig) {
+    const { parity, stopBits } = parseSerialConfig(serialConfig);
+    return `${baudRate} 8${parity[0].toUpperCase()}${stopBits}`;
+}
+
+function renderSerialDetect(data) {
+    const container = document.getElementById('serial-detect-container');
+    if (data.state === 'idle') {
+        container.innerHTML = '';
+        return;
+    }
+    if (data.state === 'starting') {
+        container.innerHTML = '<p>Waiting for the bus to go idle...</p>';
+        return;
+    }
+
+    const seconds = (data.elapsed_ms / 1000).toFixed(1);
+    if (data.state === 'running') {
+        container.innerHTML = `<p>Detecting... trying ${formatSerialSetting(data.baud_rate, data.serial_config)} (${seconds}s)</p>`;
+        return;
+    }
+
+    if (!data.detected) {
+        container.innerHTML = `<p>No valid replies at any setting (${seconds}s). Check wiring and slave IDs.</p>`;
+        return;
+    }
+    const setting = formatSerialSetting(data.detected.baud_rate, data.detected.serial_config);
+    const quality = data.detected.consistent ? 'all replies valid' : 'best partial match';
+    container.innerHTML = `
+        <p>Detected ${setting} (${quality}, ${seconds}s)
+            <button class="btn btn-primary" onclick="applySerialDetect()">Use ${setting}</button>
+        </p>`;
+}
+
+// Persist the detected setting
+async function applySerialDetect() {
+    try {
+        const response = await fetch('/api/gateway/detect?action=apply', { method: 'POST' });
+        const result = await response.json();
+        showToast(result.message || result.error, response.ok ? 'success' : 'error');
+        loadGatewayConfig();
+        pollSerialDetect();
+    } catch (error) {
+        showToast('Failed to apply detected setting', 'error');
+        console.error(error);
+    }
+}
+
+// Start a bus scan and follow it until it finishes
+async function startBusScan() {
+    try {
+        await fetch('/api/gateway/scan', { method: 'POST' });
+        showToast('Bus scan started', 'info');
+        setTimeout(pollBusScan, 500);
+    } catch (error) {
+        showToast('Failed to start bus scan', 'error');
+        console.error(error);
+    }
+}
+
+async function pollBusScan() {
+    try {
+        const response = await fetch('/api/gateway/scan');
+        const data = await response.json();
+        renderBusScan(data);
+        if (data.state === 'running') {
+            setTimeout(pollBusScan, 500);
+        }
+    } catch (error) {
+        console.error('Failed to load bus scan:', error);
+    }
+}
+
+function renderBusScan(data) {
+    const container = document.getElementById('bus-scan-container');
+    const seconds = ((data.elapsed_ms || 0) / 1000).toFixed(1);
+    const summary = data.state === 'running'
+        ? `Scanning... ${data.probed}/${data.total} IDs, ${data.responders.length} found (${seconds}s)`
+        : `${data.responders.length} device(s) found in ${seconds}s (probe timeout ${data.probe_timeout_ms} ms)`;
+
+    const portOptions = (selected) => Array.from({ length: 12 }, (_, i) =>
+        `<option value="${i + 1}" ${i + 1 === selected ? 'selected' : ''}>Port ${i + 1}</option>`).join('');
+
+    container.innerHTML = `<p>${summary}</p>` + data.responders.map(r => `
+        <div class="port-config">
+            <div class="port-fields">
+                <span>Slave ID ${r.slave_id}</span>
+                <span>Unit ${r.unit_id || '--'}</span>
+                <span>RTT ${(r.rtt_us / 1000).toFixed(1)} ms</span>
+                ${r.bound_port
+                    ? `<span class="badge success">Port ${r.bound_port}</span>`
+                    : `<select id="scan-port-${r.slave_id}">${portOptions(0)}</select>
+                       <button class="btn btn-primary" onclick="bindScanResult(${r.slave_id})">Bind</button>`}
+            </div>
+        </div>
+    `).join('');
+}
+
+// Bind a scanned slave ID to a port (enables the port and saves the config)
+async function bindScanResult(slaveId) {
+    const port = parseInt(document.getElementById(`scan-port-${slaveId}`).value);
+    try {
+        const response = await fetch('/api/gateway/scan/bind', {
+            method: 'POST',
+            headers: { 'Content-Type': 'application/json' },
+            body: JSON.stringify({ bindings: [{ port: port, slave_id: slaveId }] })
+        });
+        const result = await response.json();
+        showToast(result.message || result.error, response.ok ? 'success' : 'error');
+        loadGatewayConfig();
+        pollBusScan();
+    } catch (error) {
+        showToast('Failed to bind port', 'error');
+        console.error(error);
+    }
+}
+
 // Load network configuration
 async function loadNetworkConfig() {
     try {
@@ -567,36 +794,45 @@ async function saveNetworkConfig() {
     }
 }
 
-// Load Modbus TCP status
-async function loadModbusTCPStatus() {
-    try {
-        const response = await fetch('/api/modbus-tcp/status');
-        const data = await response.json();
-
-        document.getElementById('modbus-status').textContent = data.running ? 'Running' : 'Stopped';
-        document.getElementById('modbus-status').className = data.running ? 'badge success' : 'badge error';
-        document.getElementById('modbus-port-detail').textContent = data.port;
-        document.getElementById('modbus-connections').textContent = data.connectedClients;
+// Modbus TCP status card (config tab)
+function renderModbusTCPStatus(data) {
+    document.getElementById('modbus-status').textContent = data.running ? 'Running' : 'Stopped';
+    document.getElementById('modbus-status').className = data.running ? 'badge success' : 'badge error';
+    document.getElementById('modbus-port-detail').textContent = data.port;
+    document.getElementById('modbus-connections').textContent = data.connectedClients;
+
+    // Update client list
+    const clientsList = document.getElementById('modbus-clients-list');
+    if (data.clients && data.clients.length > 0) {
+        clientsList.innerHTML = '<h4 style="margin-bottom: 10px;">Connected Clients:</h4>' +
+            data.clients.map(client => `<div class="client-item">${client}</div>`).join('');
+    } else {
+        clientsList.innerHTML = '<p style="color: var(--text-secondary);">No connected clients</p>';
+    }
+}
 
-        // Update client list
-        const clientsList = document.getElementById('modbus-clients-list');
-        if (data.clients && data.clients.length > 0) {
-            clientsList.innerHTML = '<h4 style="margin-bottom: 10px;">Connected Clients:</h4>' +
-                data.clients.map(client => `<div class="client-item">${client}</div>`).join('');
+// List a directory a page at a time, so the gateway never streams a whole directory at once
+async function fetchDirectory(path) {
+    const pageSize = 50;
+    let listing = null;
+    for (let offset = 0; ; offset += pageSize) {
+        const response = await fetch(`/api/sd/list?path=${encodeURIComponent(path)}&offset=${offset}&limit=${pageSize}`);
+        const page = await response.json();
+        if (page.error) return page;
+        if (listing === null) {
+            listing = page;
         } else {
-            clientsList.innerHTML = '<p style="color: var(--text-secondary);">No connected clients</p>';
+            listing.directories.push(...page.directories);
+            listing.files.push(...page.files);
         }
-
-    } catch (error) {
-        console.error('Failed to load Modbus TCP status:', error);
+        if (page.incomplete || offset + pageSize >= page.total) return listing;
     }
 }
 
 // Load file list
 async function loadFileList() {
     try {
-        const response = await fetch('/api/sd/list?path=/');
-        const data = await response.json();
+        const data = await fetchDirectory('/');
 
         const fileList = document.getElementById('file-list');
         const sdInfo = document.getElementById('sd-info');
@@ -636,6 +872,18 @@ async function loadFileList() {
         // Add recording files section if any exist
         if (data.files && data.files.length > 0) {
             html += '<div class="file-section" style="margin-top: 16px;"><h4 style="color: var(--text-secondary); font-size: 0.9em; margin: 0 0 8px 0;">Recording Files</h4>';
+            html += `
+            <div class="file-item">
+                <div class="file-info">
+                    <span class="file-name"><i class="mdi mdi-folder-zip"></i> All recordings</span>
+                    <span class="file-size">.tar.gz</span>
+                </div>
+                <div class="file-actions">
+                    <button class="btn btn-secondary btn-icon" onclick="downloadArchive('/', '*.csv')" title="Download all">
+                        <i class="mdi mdi-download-box"></i>
+                    </button>
+                </div>
+            </div>`;
             html += data.files.map(file => `
             <div class="file-item">
                 <div class="file-info">
@@ -676,6 +924,15 @@ function downloadFile(path, name) {
     document.body.removeChild(a);
 }
 
+// Download every file in a directory as one gzipped tar
+function downloadArchive(path, glob) {
+    const a = document.createElement('a');
+    a.href = `/api/sd/archive?path=${encodeURIComponent(path)}&glob=${encodeURIComponent(glob)}&gzip=1`;
+    document.body.appendChild(a);
+    a.click();
+    document.body.removeChild(a);
+}
+
 // Preview file
 function previewFile(path, name) {
     const url = `/api/sd/view?path=${encodeURIComponent(path)}`;
@@ -769,16 +1026,29 @@ function showToast(message, type = 'info') {
 
 // Auto-update dashboard
 function startAutoUpdate() {
+    if (window.EventSource && !eventStreamFailed) {
+        startEventStream();
+        return;
+    }
     updateDashboard();
     updateInterval = setInterval(() => {
         updateDashboard();
     }, 2000); // Update every 2 seconds
 }
 
+function stopAutoUpdate() {
+    if (eventSource) {
+        eventSource.close();
+        eventSource = null;
+    }
+    clearInterval(updateInterval);
+    clearInterval(clockInterval);
+}
+
 // Stop auto-update when page is hidden
 document.addEventListener('visibilitychange', () => {
     if (document.hidden) {
-        clearInterval(updateInterval);
+        stopAutoUpdate();
     } else {
         startAutoUpdate();
     }